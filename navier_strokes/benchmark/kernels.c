@@ -0,0 +1,213 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <time.h>
+#include <argparse.h>
+#include "ns/kernels.h"
+
+// Field alignment in bytes (cache line)
+#define BENCHMARK_ALIGNMENT 64
+// Field alignment in cells
+#define BENCHMARK_ALIGNMENT_CELLS (BENCHMARK_ALIGNMENT / sizeof(ns_real_t))
+
+static const char *description = "\nRow kernels microbenchmark, cells per second of every kernel with every instruction set";
+static const char *const usage[] = {
+        "./kernels_benchmark",
+        "./kernels_benchmark --width=1024 --height=1024 --repetitions=20",
+        NULL
+};
+
+// Arguments
+static struct {
+    int width;
+    int height;
+    int repetitions;
+} args = {
+        .width = 1024,
+        .height = 1024,
+        .repetitions = 20
+};
+
+// Benchmark data
+typedef struct benchmark_t {
+    uint64_t width;
+    uint64_t height;
+    uint64_t pitch;
+    ns_real_t *target;
+    ns_real_t *source;
+    ns_real_t *u;
+    ns_real_t *v;
+} benchmark_t;
+
+// Kernels
+typedef enum benchmark_kernel_t {
+    BENCHMARK_KERNEL_ADD_SCALED,
+    BENCHMARK_KERNEL_DIFFUSE,
+    BENCHMARK_KERNEL_PROJECT,
+    BENCHMARK_KERNEL_DIVERGENCE,
+    BENCHMARK_KERNEL_GRADIENT,
+    BENCHMARK_KERNEL_ADVECT
+} benchmark_kernel_t;
+
+// Kernel names
+static const char *kernel_strings[] = {
+        "add_scaled", "diffuse_red_black", "project_red_black", "divergence", "gradient", "advect"
+};
+
+static void make_args(int argc, const char **argv);
+
+static ns_real_t *field_alloc(const benchmark_t *benchmark);
+
+static void run(const benchmark_t *benchmark, const ns_kernels_t *kernels, benchmark_kernel_t kernel);
+
+static double now(void);
+
+int main(int argc, const char **argv) {
+    benchmark_t benchmark;
+    int status = EXIT_SUCCESS;
+
+    make_args(argc, argv);
+
+    benchmark.width = (uint64_t) args.width;
+    benchmark.height = (uint64_t) args.height;
+    // Rows aligned to the cache line as in the solver
+    benchmark.pitch = (benchmark.width + 2 + BENCHMARK_ALIGNMENT_CELLS - 1) / BENCHMARK_ALIGNMENT_CELLS
+                      * BENCHMARK_ALIGNMENT_CELLS;
+    benchmark.target = field_alloc(&benchmark);
+    benchmark.source = field_alloc(&benchmark);
+    benchmark.u = field_alloc(&benchmark);
+    benchmark.v = field_alloc(&benchmark);
+
+    if (benchmark.target == NULL || benchmark.source == NULL || benchmark.u == NULL || benchmark.v == NULL) {
+        fprintf(stderr, "Unable to allocate %lux%lu fields\n", benchmark.width, benchmark.height);
+        status = EXIT_FAILURE;
+    } else {
+        printf("%s precision fields\n", NS_REAL_PRECISION);
+        printf("%-20s %-8s %16s\n", "kernel", "isa", "cells/s");
+
+        for (int kernel = BENCHMARK_KERNEL_ADD_SCALED; kernel <= BENCHMARK_KERNEL_ADVECT; ++kernel) {
+            for (int isa = NS_KERNELS_ISA_SCALAR; isa <= NS_KERNELS_ISA_AVX512; ++isa) {
+                const ns_kernels_t *kernels = ns_kernels_get((ns_kernels_isa_t) isa);
+
+                if (kernels == NULL) {
+                    printf("%-20s %-8s %16s\n", kernel_strings[kernel], ns_kernels_isa_string((ns_kernels_isa_t) isa),
+                           "unsupported");
+                    continue;
+                }
+
+                run(&benchmark, kernels, (benchmark_kernel_t) kernel);
+            }
+        }
+    }
+
+    free(benchmark.target);
+    free(benchmark.source);
+    free(benchmark.u);
+    free(benchmark.v);
+
+    return status;
+}
+
+static void make_args(int argc, const char **argv) {
+    struct argparse argparse;
+    struct argparse_option options[] = {
+            OPT_HELP(),
+            OPT_INTEGER('\0', "width", &args.width, "World width", NULL, 0, 0),
+            OPT_INTEGER('\0', "height", &args.height, "World height", NULL, 0, 0),
+            OPT_INTEGER('\0', "repetitions", &args.repetitions, "Repetitions of every kernel", NULL, 0, 0),
+            OPT_END(),
+    };
+
+    argparse_init(&argparse, options, usage, 0);
+    argparse_describe(&argparse, description, NULL);
+    argparse_parse(&argparse, argc, argv);
+
+    if (args.width <= 0 || args.height <= 0 || args.repetitions <= 0) {
+        fprintf(stderr, "Width, height and repetitions must be > 0\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static ns_real_t *field_alloc(const benchmark_t *benchmark) {
+    const uint64_t cells = benchmark->pitch * (benchmark->height + 2);
+    ns_real_t *field = (ns_real_t *) aligned_alloc(BENCHMARK_ALIGNMENT, cells * sizeof(ns_real_t));
+
+    if (field == NULL) return NULL;
+
+    // Small values, so that departure points stay close to their cells
+    for (uint64_t i = 0; i < cells; ++i) {
+        field[i] = (ns_real_t) ((double) rand() / RAND_MAX * 0.01);
+    }
+
+    return field;
+}
+
+static void run(const benchmark_t *benchmark, const ns_kernels_t *kernels, benchmark_kernel_t kernel) {
+    const uint64_t pitch = benchmark->pitch;
+    const ns_real_t h = (ns_real_t) (1.0 / (double) benchmark->width);
+    const ns_kernels_advect_t advect = {
+            .dt0_width = (ns_real_t) (0.1 * (double) benchmark->width),
+            .dt0_height = (ns_real_t) (0.1 * (double) benchmark->height),
+            .world_width = benchmark->width,
+            .world_height = benchmark->height,
+            .window = benchmark->source,
+            .window_x = 0,
+            .window_y = 0,
+            .window_pitch = pitch,
+            .window_size = pitch * (benchmark->height + 2)
+    };
+    double start, seconds;
+
+    start = now();
+    for (int r = 0; r < args.repetitions; ++r) {
+        for (uint64_t y = 1; y <= benchmark->height; ++y) {
+            ns_real_t *const target = &benchmark->target[y * pitch];
+            const ns_real_t *const source = &benchmark->source[y * pitch];
+
+            switch (kernel) {
+                case BENCHMARK_KERNEL_ADD_SCALED: {
+                    kernels->add_scaled(&target[1], &source[1], NS_REAL(0.1), benchmark->width);
+                    break;
+                }
+                case BENCHMARK_KERNEL_DIFFUSE: {
+                    // Both colors, so that every cell is relaxed once
+                    kernels->diffuse_red_black_row(target, source, pitch, NS_REAL(0.5), 1 + (y & 1), benchmark->width);
+                    kernels->diffuse_red_black_row(target, source, pitch, NS_REAL(0.5), 2 - (y & 1), benchmark->width);
+                    break;
+                }
+                case BENCHMARK_KERNEL_PROJECT: {
+                    kernels->project_red_black_row(target, source, pitch, 1 + (y & 1), benchmark->width);
+                    kernels->project_red_black_row(target, source, pitch, 2 - (y & 1), benchmark->width);
+                    break;
+                }
+                case BENCHMARK_KERNEL_DIVERGENCE: {
+                    kernels->divergence_row(target, &benchmark->u[y * pitch], source, &benchmark->v[y * pitch],
+                                            pitch, h, benchmark->width);
+                    break;
+                }
+                case BENCHMARK_KERNEL_GRADIENT: {
+                    kernels->gradient_row(&benchmark->u[y * pitch], &benchmark->v[y * pitch], source, pitch, h,
+                                          benchmark->width);
+                    break;
+                }
+                case BENCHMARK_KERNEL_ADVECT: {
+                    kernels->advect_row(target, &benchmark->u[y * pitch], &benchmark->v[y * pitch], &advect, 0, y,
+                                        benchmark->width);
+                    break;
+                }
+            }
+        }
+    }
+    seconds = now() - start;
+
+    printf("%-20s %-8s %16.0f\n", kernel_strings[kernel], ns_kernels_isa_string(kernels->isa),
+           (double) benchmark->width * (double) benchmark->height * args.repetitions / seconds);
+}
+
+static double now(void) {
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return (double) time.tv_sec + (double) time.tv_nsec / 1e9;
+}
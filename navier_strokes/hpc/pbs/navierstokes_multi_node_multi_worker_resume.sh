@@ -0,0 +1,19 @@
+#!/bin/bash
+
+#PBS -l nodes=8:ppn=1
+#PBS -q short_cpuQ
+
+# Current working directory
+# See https://unix.stackexchange.com/questions/207205/current-directory-in-qsub
+cd "$PBS_O_WORKDIR" || exit $?
+
+readonly NUMBER_PROCESSES=8
+readonly CHECKPOINTS=../checkpoints
+
+# Submit again until the run completes, every job continues from the checkpoints of the previous one
+RESUME=""
+if [ -d "${CHECKPOINTS}" ]; then RESUME="--resume"; else mkdir -p "${CHECKPOINTS}" || exit $?; fi
+
+module load mpich-3.2
+mpirun.actual -np "${NUMBER_PROCESSES}" ../navierstokes --simulations=../simulations.json --results=../results \
+  --checkpoints="${CHECKPOINTS}" --checkpoint-interval=300 ${RESUME}
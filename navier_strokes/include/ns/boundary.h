@@ -0,0 +1,143 @@
+#ifndef _NS_BOUNDARY_H
+#define _NS_BOUNDARY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ns/halo.h"
+#include "ns/real.h"
+
+// Number of world edges
+#define NS_BOUNDARY_EDGES 4
+
+// World edge
+typedef enum ns_boundary_edge_t {
+    NS_BOUNDARY_EDGE_LEFT,
+    NS_BOUNDARY_EDGE_RIGHT,
+    NS_BOUNDARY_EDGE_TOP,
+    NS_BOUNDARY_EDGE_BOTTOM
+} ns_boundary_edge_t;
+
+// Boundary type of an edge
+typedef enum ns_boundary_type_t {
+    // Closed: no flow across the edge, tangential velocity and scalars mirrored
+    NS_BOUNDARY_TYPE_WALL,
+    // Wraps around to the opposite edge, which must be periodic too
+    NS_BOUNDARY_TYPE_PERIODIC,
+    // Fixed velocity and density entering the world
+    NS_BOUNDARY_TYPE_INFLOW,
+    // Open: every field leaves with zero gradient
+    NS_BOUNDARY_TYPE_OUTFLOW
+} ns_boundary_type_t;
+
+// Field whose ghost cells are set, the first three are the historical modes 0, 1 and 2
+typedef enum ns_boundary_field_t {
+    // Pressure and divergence
+    NS_BOUNDARY_FIELD_SCALAR,
+    // Horizontal velocity
+    NS_BOUNDARY_FIELD_U,
+    // Vertical velocity
+    NS_BOUNDARY_FIELD_V,
+    // Density
+    NS_BOUNDARY_FIELD_DENSITY
+} ns_boundary_field_t;
+
+// Boundary of an edge
+typedef struct ns_boundary_t {
+    ns_boundary_type_t type;
+    // Inflow values (only with inflow type)
+    double u;
+    double v;
+    double density;
+} ns_boundary_t;
+
+// Boundaries of the world edges, indexed by ns_boundary_edge_t
+typedef struct ns_boundaries_t {
+    ns_boundary_t edges[NS_BOUNDARY_EDGES];
+} ns_boundaries_t;
+
+/**
+ * Return the name of edge.
+ *
+ * @param edge World edge
+ * @return Edge name, NULL if invalid
+ */
+const char *ns_boundary_edge_string(ns_boundary_edge_t edge);
+
+/**
+ * Return the name of type.
+ *
+ * @param type Boundary type
+ * @return Boundary type name, NULL if invalid
+ */
+const char *ns_boundary_type_string(ns_boundary_type_t type);
+
+/**
+ * Return the boundary type with name type.
+ *
+ * @param type Boundary type name
+ * @return Boundary type, -1 if invalid
+ */
+int ns_boundary_type_int(const char *type);
+
+/**
+ * Initialize boundaries with walls on every edge.
+ *
+ * @param boundaries Boundaries to initialize
+ */
+void ns_boundaries_init(ns_boundaries_t *boundaries);
+
+/**
+ * Check that periodic edges come in opposite pairs.
+ *
+ * @param boundaries Boundaries to check
+ * @return true if valid, false otherwise
+ */
+bool ns_boundaries_check(const ns_boundaries_t *boundaries);
+
+/**
+ * Return true if any edge is periodic.
+ *
+ * @param boundaries Boundaries
+ * @return true if periodic, false otherwise
+ */
+bool ns_boundaries_periodic(const ns_boundaries_t *boundaries);
+
+/**
+ * Set the left and right ghost cells of a row whose interior cells are final.
+ * Only the tile sides on the global boundary are set.
+ *
+ * @param boundaries Boundaries of the world edges
+ * @param field Field kind
+ * @param tile Tile the row belongs to
+ * @param row Row, cell 0 is the left ghost cell
+ */
+void ns_boundary_set_row(const ns_boundaries_t *boundaries, ns_boundary_field_t field, const ns_halo_tile_t *tile,
+                         ns_real_t *row);
+
+/**
+ * Set the top and bottom ghost rows and the corner cells of a field
+ * whose rows already have their left and right ghost cells set.
+ * Only the tile sides on the global boundary are set.
+ *
+ * @param boundaries Boundaries of the world edges
+ * @param field Field kind
+ * @param tile Tile of target
+ * @param target Tile field with one ghost cell on each side
+ * @param pitch Row stride in cells of target
+ */
+void ns_boundary_set_rows(const ns_boundaries_t *boundaries, ns_boundary_field_t field, const ns_halo_tile_t *tile,
+                          ns_real_t *target, uint64_t pitch);
+
+/**
+ * Set every ghost cell of a field on the global boundary, in time linear in the tile perimeter.
+ *
+ * @param boundaries Boundaries of the world edges
+ * @param field Field kind
+ * @param tile Tile of target
+ * @param target Tile field with one ghost cell on each side
+ * @param pitch Row stride in cells of target
+ */
+void ns_boundary_set(const ns_boundaries_t *boundaries, ns_boundary_field_t field, const ns_halo_tile_t *tile,
+                     ns_real_t *target, uint64_t pitch);
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef _NS_HALO_H
+#define _NS_HALO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <mpi.h>
+#include "ns/real.h"
+
+// Halo data wrapper (opaque)
+typedef struct ns_halo_t ns_halo_t;
+
+// Tile of a decomposed world
+typedef struct ns_halo_tile_t {
+    // Global coordinates of the first interior cell are (x + 1, y + 1)
+    uint64_t x;
+    uint64_t y;
+    // Interior size
+    uint64_t width;
+    uint64_t height;
+    // Tile touches the global boundary (left: x = 0, top: y = 0)
+    bool left;
+    bool right;
+    bool top;
+    bool bottom;
+} ns_halo_tile_t;
+
+/**
+ * Decompose a world_width x world_height world in 2D tiles across the ranks of comm.
+ * Collective over comm.
+ * Remember to free with ns_halo_free.
+ *
+ * @param comm Communicator of the ranks sharing the world
+ * @param world_width World width
+ * @param world_height World height
+ * @param tile Tile of the calling rank
+ * @return Reference to halo data wrapper, NULL otherwise
+ */
+ns_halo_t *ns_halo_create(MPI_Comm comm, uint64_t world_width, uint64_t world_height, ns_halo_tile_t *tile);
+
+/**
+ * Free the halo data wrapper.
+ *
+ * @param halo Reference to halo data wrapper
+ */
+void ns_halo_free(ns_halo_t *halo);
+
+/**
+ * Return true if the calling rank is the root of the decomposition.
+ *
+ * @param halo Reference to halo data wrapper
+ * @return true if root, false otherwise
+ */
+bool ns_halo_is_root(const ns_halo_t *halo);
+
+/**
+ * Start the non-blocking exchange of the ghost rows and columns of field with the neighbour tiles.
+ * Neither the ghost cells nor the tile border of field may be touched until ns_halo_exchange_finish.
+ *
+ * @param halo Reference to halo data wrapper
+ * @param field Tile field with one ghost cell on each side
+ * @param pitch Row stride in cells of field
+ */
+void ns_halo_exchange_start(ns_halo_t *halo, ns_real_t *field, uint64_t pitch);
+
+/**
+ * Complete the exchange started with ns_halo_exchange_start, writing the ghost rows and columns of field.
+ *
+ * @param halo Reference to halo data wrapper
+ * @param field Tile field with one ghost cell on each side
+ * @param pitch Row stride in cells of field
+ */
+void ns_halo_exchange_finish(ns_halo_t *halo, ns_real_t *field, uint64_t pitch);
+
+/**
+ * Sum value across all ranks.
+ * Collective over the decomposition.
+ *
+ * @param halo Reference to halo data wrapper
+ * @param value Local value
+ * @return Global sum
+ */
+double ns_halo_sum(const ns_halo_t *halo, double value);
+
+/**
+ * Gather the global cells in the inclusive box [x_min, x_max] x [y_min, y_max] of field
+ * from the ranks owning them. Collective over the decomposition.
+ * The returned window is owned by halo and valid until the next call.
+ *
+ * @param halo Reference to halo data wrapper
+ * @param field Tile field with one ghost cell on each side
+ * @param pitch Row stride in cells of field
+ * @param box Global box {x_min, x_max, y_min, y_max}
+ * @return Window with row stride x_max - x_min + 1, NULL otherwise
+ */
+const ns_real_t *
+ns_halo_gather_window(ns_halo_t *halo, const ns_real_t *field, uint64_t pitch, const uint64_t box[4]);
+
+/**
+ * Gather the whole field, global boundary included, on the root.
+ * Collective over the decomposition.
+ *
+ * @param halo Reference to halo data wrapper
+ * @param field Tile field with one ghost cell on each side
+ * @param pitch Row stride in cells of field
+ * @param world Destination of (world_width + 2) x (world_height + 2) cells, used only on the root
+ * @param world_pitch Row stride in cells of world
+ * @return true if gathered, false otherwise
+ */
+bool ns_halo_gather_world(ns_halo_t *halo, const ns_real_t *field, uint64_t pitch, ns_real_t *world,
+                          uint64_t world_pitch);
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef _NS_KERNELS_H
+#define _NS_KERNELS_H
+
+#include <stdint.h>
+#include "ns/real.h"
+
+// Instruction set of the kernels
+typedef enum ns_kernels_isa_t {
+    NS_KERNELS_ISA_SCALAR,
+    NS_KERNELS_ISA_AVX2,
+    NS_KERNELS_ISA_AVX512
+} ns_kernels_isa_t;
+
+// Advection of a row from a window of the source field
+typedef struct ns_kernels_advect_t {
+    // Time step times world width and height
+    ns_real_t dt0_width;
+    ns_real_t dt0_height;
+    // World width and height
+    uint64_t world_width;
+    uint64_t world_height;
+    // Source cells, the cell at window[0] is the global cell (window_x, window_y)
+    const ns_real_t *window;
+    uint64_t window_x;
+    uint64_t window_y;
+    uint64_t window_pitch;
+    // Window size in cells
+    uint64_t window_size;
+} ns_kernels_advect_t;
+
+// Row kernels, every implementation gives bitwise identical results
+typedef struct ns_kernels_t {
+    ns_kernels_isa_t isa;
+
+    /**
+     * target[i] += factor * source[i] for i in [0, n).
+     */
+    void (*add_scaled)(ns_real_t *target, const ns_real_t *source, ns_real_t factor, uint64_t n);
+
+    /**
+     * Red-black diffuse relaxation of cells x_first, x_first + 2, ... up to x_last of row.
+     */
+    void (*diffuse_red_black_row)(ns_real_t *row, const ns_real_t *source_row, uint64_t pitch, ns_real_t a,
+                                  uint64_t x_first, uint64_t x_last);
+
+    /**
+     * Red-black pressure relaxation of cells x_first, x_first + 2, ... up to x_last of row p.
+     */
+    void (*project_red_black_row)(ns_real_t *p, const ns_real_t *div, uint64_t pitch, uint64_t x_first,
+                                  uint64_t x_last);
+
+    /**
+     * Divergence of (u, v) in cells 1 to width of row div, zeroing the same cells of row p.
+     */
+    void (*divergence_row)(ns_real_t *div, ns_real_t *p, const ns_real_t *u, const ns_real_t *v, uint64_t pitch,
+                           ns_real_t h, uint64_t width);
+
+    /**
+     * Subtract the gradient of p from (u, v) in cells 1 to width of the row.
+     */
+    void (*gradient_row)(ns_real_t *u, ns_real_t *v, const ns_real_t *p, uint64_t pitch, ns_real_t h, uint64_t width);
+
+    /**
+     * Advect cells 1 to width of row d, whose cell 0 is the global cell (x, y), along the velocity (u, v).
+     */
+    void (*advect_row)(ns_real_t *d, const ns_real_t *u, const ns_real_t *v, const ns_kernels_advect_t *advect,
+                       uint64_t x, uint64_t y, uint64_t width);
+} ns_kernels_t;
+
+/**
+ * Return the name of isa.
+ *
+ * @param isa Instruction set
+ * @return Instruction set name, NULL if invalid
+ */
+const char *ns_kernels_isa_string(ns_kernels_isa_t isa);
+
+/**
+ * Return the instruction set with name isa.
+ *
+ * @param isa Instruction set name
+ * @return Instruction set, -1 if invalid
+ */
+int ns_kernels_isa_int(const char *isa);
+
+/**
+ * Return the kernels implemented with isa.
+ *
+ * @param isa Instruction set
+ * @return Kernels, NULL if isa is not supported by the compiler, the CPU or the field precision
+ */
+const ns_kernels_t *ns_kernels_get(ns_kernels_isa_t isa);
+
+/**
+ * Return the kernels implemented with the widest instruction set supported by the CPU.
+ *
+ * @return Kernels
+ */
+const ns_kernels_t *ns_kernels_best(void);
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef _NS_MULTIGRID_H
+#define _NS_MULTIGRID_H
+
+#include <stdint.h>
+#include "ns/real.h"
+
+// Multigrid data wrapper (opaque)
+typedef struct ns_multigrid_t ns_multigrid_t;
+
+// Multigrid cycle type
+typedef enum ns_multigrid_cycle_t {
+    NS_MULTIGRID_CYCLE_V,
+    NS_MULTIGRID_CYCLE_F
+} ns_multigrid_cycle_t;
+
+/**
+ * Return the name of cycle.
+ *
+ * @param cycle Multigrid cycle type
+ * @return Cycle name, NULL if invalid
+ */
+const char *ns_multigrid_cycle_string(ns_multigrid_cycle_t cycle);
+
+/**
+ * Return the cycle with name cycle.
+ *
+ * @param cycle Cycle name
+ * @return Multigrid cycle type, -1 if invalid
+ */
+int ns_multigrid_cycle_int(const char *cycle);
+
+/**
+ * Create a multigrid hierarchy for a width x height interior grid
+ * surrounded by one ghost cell on each side and with row stride pitch.
+ * Remember to free with ns_multigrid_free.
+ *
+ * @param width Interior width of the finest grid
+ * @param height Interior height of the finest grid
+ * @param pitch Row stride in cells of the finest grid
+ * @return Reference to multigrid data wrapper, NULL otherwise
+ */
+ns_multigrid_t *ns_multigrid_create(uint64_t width, uint64_t height, uint64_t pitch);
+
+/**
+ * Free the multigrid hierarchy.
+ *
+ * @param multigrid Reference to multigrid data wrapper
+ */
+void ns_multigrid_free(ns_multigrid_t *multigrid);
+
+/**
+ * Solve the pressure Poisson equation 4p - (p_W + p_E + p_N + p_S) = rhs
+ * with Neumann boundaries on the finest grid, starting from p.
+ * The mean of rhs is removed so that the singular system is compatible.
+ * Ghost cells of p are left consistent with the Neumann boundaries.
+ *
+ * @param multigrid Reference to multigrid data wrapper
+ * @param p Solution, initial guess on entry
+ * @param rhs Right hand side
+ * @param cycle Cycle type
+ * @param tolerance Stop when the residual norm is below tolerance times the right hand side norm
+ * @param max_cycles Maximum number of cycles
+ * @return Number of cycles executed
+ */
+uint64_t ns_multigrid_solve(ns_multigrid_t *multigrid, ns_real_t *p, const ns_real_t *rhs,
+                            ns_multigrid_cycle_t cycle, double tolerance, uint64_t max_cycles);
+
+#endif
@@ -4,13 +4,37 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <mpi.h>
+#include "ns/utils/snapshot.h"
+#include "ns/utils/parser.h"
+
+// Tag of the container messages, the tasks and their completions use tag 0
+#define COM_CONTAINER_TAG 1
+// Tag of the creation of the communicator of a decomposed simulation, apart from the tasks sent by the master rank
+#define COM_GROUP_TAG 2
+// Tag of a batch of simulations requested by a sub-master with its completion messages, and of the reply
+#define COM_BATCH_TAG 3
+// Tag of a batch requested by a sub-master to another one, empty, and of the stolen simulations
+#define COM_STEAL_TAG 4
+#define COM_STOLEN_TAG 5
+// Tag of a sub-master whose node is done, empty, and of the stop sent back once every node is done
+#define COM_DONE_TAG 6
 
 /**
  * Message type.
  */
 typedef struct com_message_t {
     bool terminate;
+    // Worker could not compute the simulation, in its completion message
+    bool failed;
     uint64_t simulation_id;
+    // Ranks running the simulation, if > 1 the ranks of the group (MPI_INT) follow
+    uint64_t ranks;
+    // Seconds the worker spent on the simulation, in its completion message
+    double elapsed;
+    // Times the simulation has been dispatched before, > 0 if re-dispatched
+    uint64_t attempt;
+    // Simulation in the simulations file, if streamed
+    ns_parse_location_t location;
 } com_message_t;
 
 /**
@@ -20,4 +44,54 @@ typedef struct com_message_t {
  */
 void com_message_MPI_datatype(MPI_Datatype *message_type);
 
+/**
+ * Container message type, sent by a worker to reserve the byte range of a result in the container,
+ * and once it saved every result, even without container.
+ * The master replies to a reservation with the offset of the range (MPI_UINT64_T).
+ */
+typedef struct com_container_message_t {
+    // Worker saved every result, no reply
+    bool done;
+    uint64_t simulation_id;
+    snapshot_format_t format;
+    // Result length in bytes, the result metadata (MPI_CHAR) follows
+    uint64_t length;
+} com_container_message_t;
+
+/**
+ * Define MPI container message datatype.
+ *
+ * @param message_type MPI container message datatype
+ */
+void com_container_message_MPI_datatype(MPI_Datatype *message_type);
+
+/**
+ * Gather on every rank the node of every rank, identified by the lowest rank of the node.
+ * Collective over MPI_COMM_WORLD.
+ *
+ * @param nodes Node of every rank
+ */
+void com_gather_nodes(int *nodes);
+
+/**
+ * Share the packed simulations of root with every rank, collective over MPI_COMM_WORLD.
+ * The image is broadcast once to the lowest rank of every node and shared by the ranks of the node in a window.
+ * Root must be the lowest rank of its node.
+ * Remember to free with com_simulations_free.
+ *
+ * @param root Rank holding the packed simulations
+ * @param image Packed simulations on root, ignored on the other ranks
+ * @param length Image length in bytes, set on the other ranks
+ * @param window Shared memory window holding the image
+ * @return Image shared by the ranks of the node
+ */
+const uint8_t *com_share_simulations(int root, const uint8_t *image, uint64_t *length, MPI_Win *window);
+
+/**
+ * Free the image shared with com_share_simulations, collective over MPI_COMM_WORLD.
+ *
+ * @param window Shared memory window holding the image
+ */
+void com_simulations_free(MPI_Win *window);
+
 #endif
@@ -0,0 +1,144 @@
+#ifndef _NS_NODES_DISPATCHER_H
+#define _NS_NODES_DISPATCHER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <mpi.h>
+#include "ns/nodes/com/message.h"
+
+// Tasks sent to a worker ahead of the one it computes
+#define DISPATCHER_QUEUED_TASKS 1
+
+// Workers served by the master, or by the sub-master of a node, with the tasks sent to each one
+typedef struct dispatcher_t dispatcher_t;
+
+/**
+ * Create a dispatcher of the given workers.
+ * Remember to free with dispatcher_free.
+ *
+ * @param ranks Rank of every worker, in order of preference among the idle ones
+ * @param nodes Node of every rank, identified by the lowest rank of the node
+ * @param workers_length Number of workers
+ * @return Dispatcher, NULL if something goes wrong
+ */
+dispatcher_t *dispatcher_create(const int *ranks, const int *nodes, unsigned int workers_length);
+
+/**
+ * Return the number of workers, lost ones excluded.
+ *
+ * @param dispatcher Dispatcher
+ * @return Number of workers
+ */
+unsigned int dispatcher_workers(const dispatcher_t *dispatcher);
+
+/**
+ * Return the number of nodes of the workers.
+ *
+ * @param dispatcher Dispatcher
+ * @return Number of nodes
+ */
+unsigned int dispatcher_nodes(const dispatcher_t *dispatcher);
+
+/**
+ * Return the number of workers with room for a task, the ones with at most DISPATCHER_QUEUED_TASKS tasks.
+ *
+ * @param dispatcher Dispatcher
+ * @return Number of available workers
+ */
+unsigned int dispatcher_available(const dispatcher_t *dispatcher);
+
+/**
+ * Return the number of tasks sent and not completed yet.
+ *
+ * @param dispatcher Dispatcher
+ * @return Number of tasks
+ */
+unsigned int dispatcher_tasks(const dispatcher_t *dispatcher);
+
+/**
+ * Select a group of available workers and count a task to each one.
+ * Idle workers first, then the first ones, of the least loaded nodes if balancing.
+ * Remember to free with free, unless sent with dispatcher_send.
+ *
+ * @param dispatcher Dispatcher
+ * @param ranks Number of workers, at most dispatcher_available
+ * @param balance Prefer the workers of the least loaded nodes
+ * @return Ranks of the group, NULL if something goes wrong
+ */
+int *dispatcher_select(dispatcher_t *dispatcher, uint64_t ranks, bool balance);
+
+/**
+ * Send a message to a group of workers without waiting, the ranks of the group follow if shared.
+ * The dispatcher owns the group until its sends complete.
+ *
+ * @param dispatcher Dispatcher
+ * @param message Message
+ * @param group Ranks of the group
+ * @param group_length Number of ranks of the group
+ * @param limit Seconds a worker may spend on the task once started, 0 for no limit
+ * @param message_type MPI message datatype
+ */
+void dispatcher_send(dispatcher_t *dispatcher, com_message_t message, int *group, uint64_t group_length,
+                     double limit, MPI_Datatype message_type);
+
+/**
+ * Send the termination message to every worker not lost, received after its last task.
+ *
+ * @param dispatcher Dispatcher
+ * @param message_type MPI message datatype
+ */
+void dispatcher_terminate(dispatcher_t *dispatcher, MPI_Datatype message_type);
+
+/**
+ * Count the completion of a task of a worker, the worker starts its next one.
+ *
+ * @param dispatcher Dispatcher
+ * @param rank Rank of the worker
+ * @return true if the rank is a worker not lost with a task, false otherwise
+ */
+bool dispatcher_complete(dispatcher_t *dispatcher, int rank);
+
+/**
+ * Return a worker running a task for longer than its limit.
+ * A decomposed task runs once every rank of its group has started it.
+ *
+ * @param dispatcher Dispatcher
+ * @return Rank of the worker, -1 if none
+ */
+int dispatcher_stalled(const dispatcher_t *dispatcher);
+
+/**
+ * Lose a worker, it receives no more tasks and its completions are not counted.
+ *
+ * @param dispatcher Dispatcher
+ * @param rank Rank of the worker
+ * @param messages Messages of the tasks of the worker, at most DISPATCHER_QUEUED_TASKS + 1
+ * @return Number of tasks of the worker
+ */
+unsigned int dispatcher_lose(dispatcher_t *dispatcher, int rank, com_message_t *messages);
+
+/**
+ * Return true if the worker is lost.
+ *
+ * @param dispatcher Dispatcher
+ * @param rank Rank of the worker
+ * @return true if lost, false otherwise
+ */
+bool dispatcher_lost(const dispatcher_t *dispatcher, int rank);
+
+/**
+ * Free the buffers of the completed sends.
+ *
+ * @param dispatcher Dispatcher
+ * @param wait Wait every send to complete
+ */
+void dispatcher_progress(dispatcher_t *dispatcher, bool wait);
+
+/**
+ * Free dispatcher, waiting the pending sends.
+ *
+ * @param dispatcher Dispatcher
+ */
+void dispatcher_free(dispatcher_t *dispatcher);
+
+#endif
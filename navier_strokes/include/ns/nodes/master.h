@@ -1,18 +1,48 @@
 #ifndef _NS_NODES_MASTER_H
 #define _NS_NODES_MASTER_H
 
+#include <stdbool.h>
+#include <mpi.h>
+#include "ns/nodes/worker.h"
+
 /**
  * Master node arguments.
  */
 typedef struct node_master_args_t {
     const char *simulations_path;
+    // Parse the simulations file while dispatching, the workers parse their simulations from it too
+    bool stream;
+    // Container of the results, NULL if every result is saved in its own file
+    const char *container_path;
+    // Folder of the checkpoints, NULL if simulations are not checkpointed
+    const char *checkpoint_path;
+    // Skip the simulations marked done in the checkpoints folder
+    bool resume;
+    // Folder of the result cache, NULL if results are not cached. Hits are saved with the options of worker_args
+    const char *cache_path;
+    // Dispatch the large simulations to the workers of the least loaded nodes
+    bool balance_nodes;
+    // Hand out batches of simulations to a sub-master for every node instead of dispatching to every worker
+    bool node_masters;
+    // Time limit of a simulation, in multiples of its predicted time, before its worker is lost, 0 for none
+    double deadline;
+    // Node of every rank, identified by the lowest rank of the node
+    const int *nodes;
+    // Communicator of the messages sent to the master, or to the sub-masters
+    MPI_Comm master_comm;
+    // Communicator of the container messages, and of the batch messages, sent to the master
+    MPI_Comm container_comm;
+    // Arguments of the worker running on the master rank, NULL if the master only dispatches
+    const node_worker_args_t *worker_args;
 } node_master_args_t;
 
 /**
  * Execute master operations.
+ * A simulation failed, or stalled past its deadline, is dispatched again, up to a few times.
  *
  * @param args Master arguments
+ * @return true if every simulation completed, false otherwise
  */
-void do_master(const node_master_args_t *args);
+bool do_master(const node_master_args_t *args);
 
 #endif
@@ -0,0 +1,90 @@
+#ifndef _NS_NODES_SCHEDULER_H
+#define _NS_NODES_SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ns/utils/parser.h"
+
+// Order in which the master dispatches the simulations, longest predicted first
+typedef struct scheduler_t scheduler_t;
+
+/**
+ * Create a scheduler of simulations, estimating the cost of every simulation.
+ * Remember to free with scheduler_free.
+ *
+ * @param simulations Simulations to dispatch
+ * @param workers Available workers, the most ranks a simulation can use
+ * @return Scheduler, NULL if something goes wrong
+ */
+scheduler_t *scheduler_create(const ns_simulations_t *simulations, uint64_t workers);
+
+/**
+ * Add the simulations parsed since the scheduler was created or last updated, estimating their cost.
+ *
+ * @param scheduler Scheduler
+ * @param simulations Simulations to dispatch, the ones of the scheduler first
+ * @return true if updated, false if something goes wrong
+ */
+bool scheduler_update(scheduler_t *scheduler, const ns_simulations_t *simulations);
+
+/**
+ * Return the number of remaining simulations.
+ *
+ * @param scheduler Scheduler
+ * @return Remaining simulations
+ */
+uint64_t scheduler_pending(const scheduler_t *scheduler);
+
+/**
+ * Take the remaining simulation with the longest predicted time.
+ *
+ * @param scheduler Scheduler
+ * @param simulation_id Id of the simulation to dispatch
+ * @return true if a simulation remains, false otherwise
+ */
+bool scheduler_next(scheduler_t *scheduler, uint64_t *simulation_id);
+
+/**
+ * Return true if the simulation is large, its estimated cost of a rank is higher than the mean one.
+ *
+ * @param scheduler Scheduler
+ * @param simulation_id Simulation id
+ * @return true if large, false otherwise
+ */
+bool scheduler_large(const scheduler_t *scheduler, uint64_t simulation_id);
+
+/**
+ * Return the predicted seconds a rank spends on the simulation.
+ *
+ * @param scheduler Scheduler
+ * @param simulation_id Simulation id
+ * @return Predicted seconds, 0 until a simulation completes
+ */
+double scheduler_predict(const scheduler_t *scheduler, uint64_t simulation_id);
+
+/**
+ * Give back a simulation taken with scheduler_next, it is taken again before the cheaper simulations of its solver.
+ *
+ * @param scheduler Scheduler
+ * @param simulation_id Id of the simulation to dispatch again
+ */
+void scheduler_retry(scheduler_t *scheduler, uint64_t simulation_id);
+
+/**
+ * Refine the predicted time of the remaining simulations with the time a rank spent on a completed simulation.
+ * Every rank of a decomposed simulation reports its own time.
+ *
+ * @param scheduler Scheduler
+ * @param simulation_id Id of the completed simulation
+ * @param elapsed Seconds spent by the rank
+ */
+void scheduler_complete(scheduler_t *scheduler, uint64_t simulation_id, double elapsed);
+
+/**
+ * Free scheduler.
+ *
+ * @param scheduler Scheduler
+ */
+void scheduler_free(scheduler_t *scheduler);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef _NS_NODES_SUBMASTER_H
+#define _NS_NODES_SUBMASTER_H
+
+#include <mpi.h>
+#include "ns/nodes/worker.h"
+
+/**
+ * Sub-master node arguments, the lowest rank of every node.
+ */
+typedef struct node_submaster_args_t {
+    // Node of every rank, identified by the lowest rank of the node
+    const int *nodes;
+    // Container of the results, NULL if every result is saved in its own file
+    const char *container_path;
+    // Communicator of the messages sent to the sub-masters
+    MPI_Comm master_comm;
+    // Communicator of the container messages, and of the batch messages, sent to the master
+    MPI_Comm container_comm;
+    // Arguments of the worker running on the sub-master rank
+    const node_worker_args_t *worker_args;
+    // State of the master if the sub-master runs on its rank, NULL otherwise
+    const node_worker_local_t *local;
+} node_submaster_args_t;
+
+/**
+ * Execute sub-master operations.
+ * Dispatch the batches of simulations received from the master to the workers of the node, stealing from the other
+ * nodes once the master has none left.
+ *
+ * @param args Sub-master arguments
+ */
+void do_submaster(const node_submaster_args_t *args);
+
+#endif
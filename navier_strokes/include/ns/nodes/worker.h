@@ -1,11 +1,58 @@
 #ifndef _NS_NODES_WORKER_H
 #define _NS_NODES_WORKER_H
 
+#include <stdint.h>
+#include <stdbool.h>
+#include <mpi.h>
+#include "ns/utils/snapshot.h"
+#include "ns/utils/container.h"
+
+/**
+ * State of the master, or of a sub-master, shared with the worker running on its rank.
+ */
+typedef struct node_worker_local_t {
+    // Container opened by the rank, NULL if every result is saved in its own file
+    container_t *container;
+    // Packed simulations shared with the rank, NULL if the simulations file is streamed
+    const uint8_t *simulations_image;
+    uint64_t simulations_image_length;
+} node_worker_local_t;
+
 /**
  * Worker node arguments.
  */
 typedef struct node_worker_args_t {
+    // Simulations file streamed by the master, a task holds the location of its simulation. NULL if not streamed
+    const char *simulations_path;
     char *results_path;
+    // Folder of reference results to compare the results with, NULL to skip validation
+    char *validate_path;
+    // Format of the result files
+    snapshot_format_t format;
+    // Compression of the binary result files
+    snapshot_compression_t compression;
+    // Absolute error tolerance of the lossy compression
+    double tolerance;
+    // Container of the results, NULL to save every result in its own file
+    const char *container_path;
+    // Folder of the checkpoints, NULL to never checkpoint
+    const char *checkpoint_path;
+    // Seconds between two checkpoints of a simulation
+    double checkpoint_interval;
+    // Restore every simulation from its last checkpoint, not only the ones dispatched again
+    bool resume;
+    // Start time of the job, in seconds since the epoch
+    uint64_t job;
+    // Folder of the result cache, NULL if results are not cached
+    const char *cache_path;
+    // Rank dispatching the tasks of the worker, the master or the sub-master of its node
+    int master_rank;
+    // Communicator of the messages sent to the rank dispatching the tasks
+    MPI_Comm master_comm;
+    // Communicator of the container messages sent to the master
+    MPI_Comm container_comm;
+    // State of the rank dispatching the tasks if the worker runs on it, NULL otherwise
+    const node_worker_local_t *local;
 } node_worker_args_t;
 
 /**
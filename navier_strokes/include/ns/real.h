@@ -0,0 +1,24 @@
+#ifndef _NS_REAL_H
+#define _NS_REAL_H
+
+#include "ns/config.h"
+
+// Field cell value, accumulations (norms, residuals, sums) are always double
+#ifdef SINGLE_PRECISION
+typedef float ns_real_t;
+// MPI datatype of ns_real_t
+#define NS_REAL_MPI MPI_FLOAT
+// Precision name
+#define NS_REAL_PRECISION "single"
+#else
+typedef double ns_real_t;
+// MPI datatype of ns_real_t
+#define NS_REAL_MPI MPI_DOUBLE
+// Precision name
+#define NS_REAL_PRECISION "double"
+#endif
+
+// Constant of type ns_real_t
+#define NS_REAL(value) ((ns_real_t) (value))
+
+#endif
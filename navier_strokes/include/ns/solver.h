@@ -3,6 +3,10 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <mpi.h>
+#include "ns/multigrid.h"
+#include "ns/boundary.h"
+#include "ns/real.h"
 
 // Maximum force velocity
 #define NS_MAX_FORCE_VELOCITY 120.0
@@ -10,22 +14,70 @@
 // Data wrapper (opaque)
 typedef struct ns_t ns_t;
 
-// Single cell containing u,v and density
-typedef struct ns_cell_t {
-    double *u;
-    double *v;
-    double *density;
-} ns_cell_t;
+// Relaxation ordering of the iterative sweeps in diffuse and project
+typedef enum ns_relaxation_t {
+    // In place Gauss-Seidel in row order (serial)
+    NS_RELAXATION_LEXICOGRAPHIC,
+    // Checkerboard Gauss-Seidel, each color updated in parallel
+    NS_RELAXATION_RED_BLACK
+} ns_relaxation_t;
 
-// World data snapshot
+// Pressure solver used in project
+typedef enum ns_pressure_solver_t {
+    // Fixed number of relaxation sweeps
+    NS_PRESSURE_SOLVER_RELAXATION,
+    // Geometric multigrid cycles until tolerance
+    NS_PRESSURE_SOLVER_MULTIGRID
+} ns_pressure_solver_t;
+
+// Multigrid pressure solver configuration
+typedef struct ns_solver_multigrid_config_t {
+    ns_multigrid_cycle_t cycle;
+    // Relative residual tolerance
+    double tolerance;
+    uint64_t max_cycles;
+} ns_solver_multigrid_config_t;
+
+// Solver configuration
+typedef struct ns_solver_config_t {
+    ns_relaxation_t relaxation;
+    // Maximum relaxation sweeps of each diffuse and relaxation pressure solve
+    uint64_t max_iterations;
+    // Relative residual tolerance of the relaxation sweeps
+    double tolerance;
+    // Check the residual every check_every sweeps, 0 to always do max_iterations sweeps
+    uint64_t check_every;
+    ns_pressure_solver_t pressure;
+    ns_solver_multigrid_config_t multigrid;
+} ns_solver_config_t;
+
+// Iterations used by the iterative solvers during the last tick
+typedef struct ns_tick_stats_t {
+    // Relaxation sweeps of the three diffuse solves
+    uint64_t diffuse_iterations;
+    // Relaxation sweeps or multigrid cycles of the two pressure solves
+    uint64_t pressure_iterations;
+} ns_tick_stats_t;
+
+// World data snapshot, a view of field planes with the global boundary included
 typedef struct ns_world_t {
     uint64_t world_width;
     uint64_t world_width_bounds;
     uint64_t world_height;
     uint64_t world_height_bounds;
-    ns_cell_t **world;
+    // Ticks done when the snapshot was taken
+    uint64_t tick;
+    // Row stride in cells of every plane (>= world_width_bounds)
+    uint64_t pitch;
+    // Planes of world_height_bounds rows, cell (x, y) is at NS_WORLD_IDX(world, x, y)
+    const ns_real_t *u;
+    const ns_real_t *v;
+    const ns_real_t *density;
 } ns_world_t;
 
+// Index of cell (x, y) in the planes of a world snapshot
+#define NS_WORLD_IDX(world, x, y) ((y) * (world)->pitch + (x))
+
 /**
  * Create a new Navier Stokes world scenario.
  * Remember to free with ns_free.
@@ -42,6 +94,26 @@ ns_t *ns_create(uint64_t world_width, uint64_t world_height,
                 double viscosity, double density, double diffusion,
                 double time_step);
 
+/**
+ * Create a new Navier Stokes world scenario decomposed in tiles across the ranks of comm.
+ * Every rank stores only its tile, ticks exchange the tile borders with the neighbour tiles.
+ * All the functions taking the returned wrapper are collective over comm,
+ * except ns_get_tick_stats and ns_get_world.
+ * Remember to free with ns_free.
+ *
+ * @param comm Communicator of the ranks sharing the world
+ * @param world_width World width
+ * @param world_height World height
+ * @param viscosity Fluid viscosity
+ * @param density Fluid density
+ * @param diffusion Fluid diffusion
+ * @param time_step Tick time step
+ * @return Reference to Navier Stokes data wrapper, NULL otherwise
+ */
+ns_t *ns_create_distributed(MPI_Comm comm, uint64_t world_width, uint64_t world_height,
+                            double viscosity, double density, double diffusion,
+                            double time_step);
+
 /**
  * Free the Navier Stokes world scenario.
  *
@@ -49,6 +121,69 @@ ns_t *ns_create(uint64_t world_width, uint64_t world_height,
  */
 void ns_free(ns_t *ns);
 
+/**
+ * Return the name of relaxation.
+ *
+ * @param relaxation Relaxation ordering
+ * @return Relaxation name, NULL if invalid
+ */
+const char *ns_relaxation_string(ns_relaxation_t relaxation);
+
+/**
+ * Return the relaxation with name relaxation.
+ *
+ * @param relaxation Relaxation name
+ * @return Relaxation ordering, -1 if invalid
+ */
+int ns_relaxation_int(const char *relaxation);
+
+/**
+ * Return the name of pressure solver.
+ *
+ * @param pressure Pressure solver
+ * @return Pressure solver name, NULL if invalid
+ */
+const char *ns_pressure_solver_string(ns_pressure_solver_t pressure);
+
+/**
+ * Return the pressure solver with name pressure.
+ *
+ * @param pressure Pressure solver name
+ * @return Pressure solver, -1 if invalid
+ */
+int ns_pressure_solver_int(const char *pressure);
+
+/**
+ * Initialize config with the default solver configuration:
+ * lexicographic relaxation with 20 sweeps and no residual check,
+ * relaxation pressure solver.
+ *
+ * @param config Solver configuration
+ */
+void ns_solver_config_init(ns_solver_config_t *config);
+
+/**
+ * Set the solver configuration.
+ * A decomposed world always relaxes in red-black order with the relaxation pressure solver.
+ * The multigrid pressure solver has closed pressure boundaries, it is not set if an edge is periodic.
+ *
+ * @param ns Reference to Navier Stokes data wrapper
+ * @param config Solver configuration
+ * @return true if set, false otherwise
+ */
+bool ns_set_solver_config(ns_t *ns, const ns_solver_config_t *config);
+
+/**
+ * Set the boundaries of the world edges, walls by default.
+ * Periodic edges of a decomposed world are not set when their axis is split across tiles.
+ * Periodic edges are not set with the multigrid pressure solver, it has closed pressure boundaries.
+ *
+ * @param ns Reference to Navier Stokes data wrapper
+ * @param boundaries Boundaries of the world edges
+ * @return true if set, false otherwise
+ */
+bool ns_set_boundaries(ns_t *ns, const ns_boundaries_t *boundaries);
+
 /**
  * Do a time tick of duration time step.
  *
@@ -56,6 +191,14 @@ void ns_free(ns_t *ns);
  */
 void ns_tick(ns_t *ns);
 
+/**
+ * Return the iterations used by the iterative solvers during the last tick.
+ *
+ * @param ns Reference to Navier Stokes data wrapper
+ * @return Tick stats
+ */
+ns_tick_stats_t ns_get_tick_stats(const ns_t *ns);
+
 /**
  * Increase fluid density in cell (x, y).
  *
@@ -79,19 +222,71 @@ bool ns_increase_density(ns_t *ns, uint64_t x, uint64_t y);
 bool ns_apply_force(ns_t *ns, uint64_t x, uint64_t y, double v_x, double v_y);
 
 /**
- * Create a Navier Stokes world snapshot.
- * Remember to free with ns_free_world.
+ * Gather the tiles of a decomposed world on the root of its communicator.
+ * Does nothing if the world is not decomposed.
  *
  * @param ns Reference to Navier Stokes data wrapper
- * @return Reference to Navier Stokes world snapshot data
+ * @return true if gathered, false otherwise
+ */
+bool ns_gather_world(ns_t *ns);
+
+/**
+ * Return the number of cells of a copy of the solver state of the calling rank,
+ * the six fields of its tile with the ghost cells.
+ *
+ * @param ns Reference to Navier Stokes data wrapper
+ * @return Number of cells of the state
+ */
+uint64_t ns_state_size(const ns_t *ns);
+
+/**
+ * Copy the solver state of the calling rank into buffer, the fields one after the other with row stride
+ * tile width + 2: u, u_prev, v, v_prev, density and density_prev.
+ * Restored with ns_set_state on a wrapper of the same world, decomposed across the same number of ranks.
+ *
+ * @param ns Reference to Navier Stokes data wrapper
+ * @param buffer Destination of ns_state_size(ns) cells, owned by the caller
+ * @return Ticks done
+ */
+uint64_t ns_get_state(const ns_t *ns, ns_real_t *buffer);
+
+/**
+ * Restore the solver state of the calling rank copied with ns_get_state.
+ *
+ * @param ns Reference to Navier Stokes data wrapper
+ * @param tick Ticks done
+ * @param buffer State of ns_state_size(ns) cells
+ */
+void ns_set_state(ns_t *ns, uint64_t tick, const ns_real_t *buffer);
+
+/**
+ * Take a Navier Stokes world snapshot, viewing the field buffers without copying them.
+ * The view is valid until the next call modifying ns or ns_free.
+ * The cells of a decomposed world are the ones gathered with ns_gather_world,
+ * only on the root of its communicator.
+ *
+ * @param ns Reference to Navier Stokes data wrapper
+ * @param world Navier Stokes world snapshot
+ * @return true if taken, false on the other ranks of a decomposed world
+ */
+bool ns_get_world(const ns_t *ns, ns_world_t *world);
+
+/**
+ * Return the number of cells of a copy of a Navier Stokes world snapshot.
+ *
+ * @param world Navier Stokes world snapshot
+ * @return Number of cells of the copy
  */
-ns_world_t *ns_get_world(const ns_t *ns);
+uint64_t ns_world_copy_size(const ns_world_t *world);
 
 /**
- *  Free the Navier Stokes world snapshot.
+ * Copy a Navier Stokes world snapshot into a contiguous buffer, which outlives the view.
+ * The planes are stored one after the other with row stride world_width_bounds.
  *
- * @param world Reference to Navier Stokes world snapshot data
+ * @param world Navier Stokes world snapshot
+ * @param buffer Destination of ns_world_copy_size(world) cells, owned by the caller
+ * @param copy Navier Stokes world snapshot viewing buffer
  */
-void ns_free_world(ns_world_t *world);
+void ns_world_copy(const ns_world_t *world, ns_real_t *buffer, ns_world_t *copy);
 
 #endif
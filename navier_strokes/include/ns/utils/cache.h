@@ -0,0 +1,83 @@
+#ifndef _NS_UTILS_CACHE_H
+#define _NS_UTILS_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ns/utils/parser.h"
+#include "ns/utils/snapshot.h"
+
+// Files of an entry in the cache folder, named by the hash of its key
+typedef enum cache_file_t {
+    // Complete result of a simulation
+    CACHE_FILE_RESULT,
+    // Marker of a cached result, a checkpoint without state holding the key and the simulation id of the result
+    CACHE_FILE_MARKER,
+    // Solver state of a rank after the last tick of a simulation, its parameters are the prefix key
+    CACHE_FILE_STATE,
+    // Journal of the snapshots of the cached state
+    CACHE_FILE_JOURNAL
+} cache_file_t;
+
+/**
+ * Return the key of simulation, the simulation packed with the options of its result.
+ * The prefix key leaves out the ticks and the result options, it matches every simulation with the same setup.
+ * Remember to free with free.
+ *
+ * @param simulation Simulation
+ * @param prefix true for the prefix key, false for the result key
+ * @param format Format of the result
+ * @param compression Compression of the binary result
+ * @param tolerance Tolerance of the lossy compression
+ * @param length Key length in bytes
+ * @return Key, NULL if something goes wrong
+ */
+uint8_t *cache_key(const ns_simulation_t *simulation, bool prefix, snapshot_format_t format,
+                   snapshot_compression_t compression, double tolerance, uint64_t *length);
+
+/**
+ * Return the location of a file of an entry in the cache folder.
+ * Remember to free with free.
+ *
+ * @param directory Cache folder
+ * @param file File of the entry
+ * @param key Key of the entry
+ * @param key_length Key length in bytes
+ * @param rank Rank of the state, ignored by the other files
+ * @param format Format of the result, ignored by the other files
+ * @return File location, NULL if something goes wrong
+ */
+char *cache_file_path(const char *directory, cache_file_t file, const uint8_t *key, uint64_t key_length,
+                      uint64_t rank, snapshot_format_t format);
+
+/**
+ * Save the result of the simulation with key to result_path, if cached.
+ * The cached file is linked if it holds the same simulation id, otherwise it is copied with the id replaced.
+ *
+ * @param directory Cache folder
+ * @param key Result key of the simulation
+ * @param key_length Key length in bytes
+ * @param format Format of the result
+ * @param simulation_id Simulation id
+ * @param result_path Result location
+ * @param error Error if something goes wrong or the result is not cached, NULL otherwise
+ * @return true if saved, false otherwise
+ */
+bool cache_fetch(const char *directory, const uint8_t *key, uint64_t key_length, snapshot_format_t format,
+                 uint64_t simulation_id, const char *result_path, char *error);
+
+/**
+ * Add the complete result at result_path to the cache, linked.
+ *
+ * @param directory Cache folder
+ * @param key Result key of the simulation
+ * @param key_length Key length in bytes
+ * @param format Format of the result
+ * @param simulation_id Simulation id of the result
+ * @param result_path Result location
+ * @param error Error if something goes wrong, NULL otherwise
+ * @return true if added, false otherwise
+ */
+bool cache_store(const char *directory, const uint8_t *key, uint64_t key_length, snapshot_format_t format,
+                 uint64_t simulation_id, const char *result_path, char *error);
+
+#endif
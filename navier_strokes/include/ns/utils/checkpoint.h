@@ -0,0 +1,125 @@
+#ifndef _NS_UTILS_CHECKPOINT_H
+#define _NS_UTILS_CHECKPOINT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ns/solver.h"
+
+// Magic of the checkpoint files
+#define CHECKPOINT_MAGIC "NSCHECKP"
+#define CHECKPOINT_MAGIC_LENGTH 8
+// Version of the checkpoint files
+#define CHECKPOINT_VERSION 1
+
+// Files of a simulation in the checkpoints folder
+typedef enum checkpoint_file_t {
+    // Solver state of a rank, replaced at every checkpoint
+    CHECKPOINT_FILE_STATE,
+    // Binary result file of the snapshots saved so far, replayed into the result of a restored simulation
+    CHECKPOINT_FILE_JOURNAL,
+    // Marker of a completed simulation, a checkpoint without state
+    CHECKPOINT_FILE_DONE
+} checkpoint_file_t;
+
+// Run of a simulation, the files of different runs never collide
+typedef struct checkpoint_run_t {
+    // Start time of the job, in seconds since the epoch
+    uint64_t job;
+    // Times the simulation has been dispatched before in the job
+    uint64_t attempt;
+} checkpoint_run_t;
+
+// Solver state of a rank of a simulation after a tick
+typedef struct checkpoint_t {
+    uint64_t simulation_id;
+    // Packed simulation, a checkpoint is restored only with the same parameters
+    uint8_t *parameters;
+    uint64_t parameters_length;
+    // Ranks of the simulation and rank of the state among them
+    uint64_t ranks;
+    uint64_t rank;
+    // Ticks done
+    uint64_t tick;
+    // Iterations used to compute the ticks since the last saved snapshot
+    ns_tick_stats_t stats;
+    // Solver state copied with ns_get_state, NULL for a done marker
+    ns_real_t *state;
+    uint64_t state_length;
+} checkpoint_t;
+
+/**
+ * Return the location of a file of a simulation in the checkpoints folder.
+ * Remember to free with free.
+ *
+ * @param directory Checkpoints folder
+ * @param file File of the simulation
+ * @param simulation_id Simulation id
+ * @param run Run of the simulation, ignored by the done marker
+ * @param rank Rank of the state among the ranks of the simulation, ignored by the other files
+ * @return File location, NULL if something goes wrong
+ */
+char *checkpoint_file_path(const char *directory, checkpoint_file_t file, uint64_t simulation_id,
+                           const checkpoint_run_t *run, uint64_t rank);
+
+/**
+ * Write checkpoint to file_path, replacing the previous file only once written.
+ *
+ * @param file_path File location
+ * @param checkpoint Checkpoint
+ * @param error Error if something goes wrong, NULL otherwise
+ * @return true if written, false otherwise
+ */
+bool checkpoint_write(const char *file_path, const checkpoint_t *checkpoint, char *error);
+
+/**
+ * Read the checkpoint at file_path.
+ * The file must be saved with the field precision of this build.
+ * Remember to free with checkpoint_free.
+ *
+ * @param file_path File location
+ * @param error Error if something goes wrong, NULL otherwise
+ * @return Checkpoint, NULL if something goes wrong
+ */
+checkpoint_t *checkpoint_read(const char *file_path, char *error);
+
+/**
+ * Return true if checkpoint belongs to the simulation with the given packed parameters.
+ *
+ * @param checkpoint Checkpoint
+ * @param parameters Packed simulation
+ * @param parameters_length Packed simulation length in bytes
+ * @return true if matching, false otherwise
+ */
+bool checkpoint_matches(const checkpoint_t *checkpoint, const uint8_t *parameters, uint64_t parameters_length);
+
+/**
+ * Find the checkpoint with the most ticks of the first rank of a simulation among every run.
+ * Remember to free with checkpoint_free.
+ *
+ * @param directory Checkpoints folder
+ * @param simulation_id Simulation id
+ * @param parameters Packed simulation
+ * @param parameters_length Packed simulation length in bytes
+ * @param ranks Ranks of the simulation
+ * @param run Run of the found checkpoint
+ * @return Checkpoint, NULL if none
+ */
+checkpoint_t *checkpoint_latest(const char *directory, uint64_t simulation_id, const uint8_t *parameters,
+                                uint64_t parameters_length, uint64_t ranks, checkpoint_run_t *run);
+
+/**
+ * Delete the states and the journals of every run of a simulation, the done marker is kept.
+ *
+ * @param directory Checkpoints folder
+ * @param simulation_id Simulation id
+ */
+void checkpoint_remove(const char *directory, uint64_t simulation_id);
+
+/**
+ * Free checkpoint.
+ *
+ * @param checkpoint Checkpoint
+ */
+void checkpoint_free(checkpoint_t *checkpoint);
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef _NS_UTILS_COMPRESS_H
+#define _NS_UTILS_COMPRESS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Return the maximum compressed size of length bytes.
+ *
+ * @param length Input bytes
+ * @return Maximum compressed size in bytes
+ */
+uint64_t compress_bound(uint64_t length);
+
+/**
+ * Compress length bytes of input to output with an LZ77 codec
+ * (sequences of literals and back references of up to 65535 bytes).
+ *
+ * @param input Input bytes
+ * @param length Input length
+ * @param output Output of at least compress_bound(length) bytes
+ * @return Compressed length, 0 if something goes wrong
+ */
+uint64_t compress_lz(const uint8_t *input, uint64_t length, uint8_t *output);
+
+/**
+ * Decompress length bytes of input, compressed with compress_lz, to output.
+ *
+ * @param input Compressed bytes
+ * @param length Compressed length
+ * @param output Output bytes
+ * @param output_length Decompressed length
+ * @return true if decompressed to exactly output_length bytes, false otherwise
+ */
+bool decompress_lz(const uint8_t *input, uint64_t length, uint8_t *output, uint64_t output_length);
+
+/**
+ * Shuffle count values of size bytes, grouping the i-th byte of every value together.
+ *
+ * @param input Values
+ * @param count Number of values
+ * @param size Bytes of a value
+ * @param output Shuffled bytes
+ */
+void compress_shuffle(const uint8_t *input, uint64_t count, size_t size, uint8_t *output);
+
+/**
+ * Restore count values of size bytes shuffled with compress_shuffle.
+ *
+ * @param input Shuffled bytes
+ * @param count Number of values
+ * @param size Bytes of a value
+ * @param output Values
+ */
+void compress_unshuffle(const uint8_t *input, uint64_t count, size_t size, uint8_t *output);
+
+#endif
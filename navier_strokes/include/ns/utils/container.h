@@ -0,0 +1,119 @@
+#ifndef _NS_UTILS_CONTAINER_H
+#define _NS_UTILS_CONTAINER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <mpi.h>
+#include "ns/utils/snapshot.h"
+
+// Magic of the container, at the start and at the end of the file
+#define CONTAINER_MAGIC "NSCONTNR"
+#define CONTAINER_MAGIC_LENGTH 8
+// Version of the container
+#define CONTAINER_VERSION 1
+// Offset of the first result, after the magic and the version
+#define CONTAINER_HEADER_LENGTH (CONTAINER_MAGIC_LENGTH + sizeof(uint64_t))
+
+// Result saved in a container, entry of its table of contents
+typedef struct container_entry_t {
+    uint64_t simulation_id;
+    // Rank of the worker that saved the result
+    int rank;
+    snapshot_format_t format;
+    // Byte range of the result
+    uint64_t offset;
+    uint64_t length;
+    // Result metadata, JSON text
+    char *metadata;
+} container_entry_t;
+
+// Single file holding the results of every simulation of a run, written by every rank
+typedef struct container_t container_t;
+
+/**
+ * Create the container at file_path, collective over comm.
+ * An existing file is truncated and rank 0 of comm writes the header.
+ * Remember to close with container_close.
+ *
+ * @param comm Communicator of the ranks writing the container
+ * @param file_path File location
+ * @param error Error if something goes wrong, NULL otherwise
+ * @return Container, NULL if something goes wrong
+ */
+container_t *container_open(MPI_Comm comm, const char *file_path, char *error);
+
+/**
+ * Start writing length bytes of content at offset of container without waiting the write.
+ * The container takes the ownership of content, freed with free once written.
+ *
+ * @param container Container
+ * @param offset Offset of the byte range reserved to content
+ * @param content Content
+ * @param length Content length in bytes
+ * @param error Error if something goes wrong, NULL otherwise
+ * @return true if the write started, false otherwise
+ */
+bool container_write(container_t *container, uint64_t offset, void *content, uint64_t length, char *error);
+
+/**
+ * Write the table of contents of container at offset, after every result, and the trailer.
+ *
+ * @param container Container
+ * @param offset Offset of the end of the results
+ * @param entries Saved results
+ * @param entries_length Number of saved results
+ * @param error Error if something goes wrong, NULL otherwise
+ * @return true if written, false otherwise
+ */
+bool container_write_toc(container_t *container, uint64_t offset, const container_entry_t *entries,
+                         uint64_t entries_length, char *error);
+
+/**
+ * Wait the pending writes of container.
+ *
+ * @param container Container
+ * @param error Error if something goes wrong, NULL otherwise
+ * @return true if written, false otherwise
+ */
+bool container_flush(container_t *container, char *error);
+
+/**
+ * Wait the pending writes of container, close its file and free container, collective over its communicator.
+ *
+ * @param container Container
+ * @param error Error if something goes wrong, NULL otherwise
+ * @return true if closed, false otherwise
+ */
+bool container_close(container_t *container, char *error);
+
+/**
+ * Read the table of contents of the container at file_path.
+ * Remember to free with container_entries_free.
+ *
+ * @param file_path File location
+ * @param entries_length Number of saved results
+ * @param error Error if something goes wrong, NULL otherwise
+ * @return Saved results, NULL if something goes wrong
+ */
+container_entry_t *container_read_toc(const char *file_path, uint64_t *entries_length, char *error);
+
+/**
+ * Read the result of entry from the container at file_path.
+ * Remember to free with free.
+ *
+ * @param file_path File location
+ * @param entry Saved result
+ * @param error Error if something goes wrong, NULL otherwise
+ * @return Result content of entry->length bytes, NULL if something goes wrong
+ */
+uint8_t *container_read_result(const char *file_path, const container_entry_t *entry, char *error);
+
+/**
+ * Free entries read with container_read_toc.
+ *
+ * @param entries Saved results
+ * @param entries_length Number of saved results
+ */
+void container_entries_free(container_entry_t *entries, uint64_t entries_length);
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef _NS_UTILS_FILE_H
 #define _NS_UTILS_FILE_H
 
+#include <stdint.h>
 #include <stdbool.h>
 
 /**
@@ -14,6 +15,26 @@
  */
 char *read_file(const char *file_path, char *error);
 
+/**
+ * Map the file at file_path read-only, pages are loaded as they are read.
+ * The content is not terminated.
+ * Remember to free with unmap_file.
+ *
+ * @param file_path File location
+ * @param length File length in bytes
+ * @param error Error if something goes wrong, NULL otherwise
+ * @return File content
+ */
+const char *map_file(const char *file_path, uint64_t *length, char *error);
+
+/**
+ * Unmap a file mapped with map_file.
+ *
+ * @param content File content
+ * @param length File length in bytes
+ */
+void unmap_file(const char *content, uint64_t length);
+
 /**
  * Write content to file at file_path.
  * If the file does not exists, it will be create
@@ -0,0 +1,62 @@
+#ifndef _NS_UTILS_PACK_H
+#define _NS_UTILS_PACK_H
+
+#include <stdint.h>
+#include "parser.h"
+
+// Version of the packed simulation layout
+#define NS_PACK_VERSION 1
+
+/**
+ * Encode a simulation into a compact binary buffer, decoded with ns_unpack_simulation.
+ * Values are in the native representation of the host, ranks must share it.
+ * Remember to free with free.
+ *
+ * @param simulation Simulation to encode
+ * @param length Buffer length in bytes
+ * @return Buffer, NULL if something goes wrong
+ */
+uint8_t *ns_pack_simulation(const ns_simulation_t *simulation, uint64_t *length);
+
+/**
+ * Decode a simulation encoded with ns_pack_simulation.
+ * Remember to free with ns_parse_simulation_free.
+ *
+ * @param buffer Buffer
+ * @param length Buffer length in bytes
+ * @return Simulation, NULL if the buffer is not a valid packed simulation
+ */
+ns_simulation_t *ns_unpack_simulation(const uint8_t *buffer, uint64_t length);
+
+/**
+ * Encode every simulation into a compact binary image, a simulation is decoded on demand with ns_unpack_simulation_at.
+ * A sweep is encoded as its base and axes, its points are expanded on decode.
+ * Remember to free with free.
+ *
+ * @param simulations Simulations to encode
+ * @param length Image length in bytes
+ * @return Image, NULL if something goes wrong
+ */
+uint8_t *ns_pack_simulations(const ns_simulations_t *simulations, uint64_t *length);
+
+/**
+ * Return the number of simulations of an image encoded with ns_pack_simulations, the points of the sweeps included.
+ *
+ * @param image Image
+ * @param length Image length in bytes
+ * @return Number of simulations, 0 if the image is not valid
+ */
+uint64_t ns_packed_simulations_length(const uint8_t *image, uint64_t length);
+
+/**
+ * Decode a single simulation of an image encoded with ns_pack_simulations.
+ * Remember to free with ns_parse_simulation_free.
+ *
+ * @param image Image
+ * @param length Image length in bytes
+ * @param simulation_id Simulation id, as numbered by ns_parse_simulations_at
+ * @return Simulation, NULL if not found or not valid
+ */
+ns_simulation_t *ns_unpack_simulation_at(const uint8_t *image, uint64_t length, uint64_t simulation_id);
+
+#endif
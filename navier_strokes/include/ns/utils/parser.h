@@ -2,6 +2,9 @@
 #define _NS_UTILS_PARSER_H
 
 #include <stdint.h>
+#include <stdbool.h>
+#include "ns/solver.h"
+#include "ns/utils/snapshot.h"
 
 typedef struct ns_parse_simulation_world_t {
     uint64_t width;
@@ -48,14 +51,87 @@ typedef struct ns_simulation_t {
     // Fluid
     ns_parse_simulation_fluid_t fluid;
 
+    // Solver
+    ns_solver_config_t solver;
+
+    // Boundaries of the world edges
+    ns_boundaries_t boundaries;
+
+    // Ranks sharing the world (decomposed in tiles if > 1)
+    uint64_t ranks;
+
+    // Saved snapshots
+    snapshot_output_t output;
+
     // Mods
     ns_parse_simulation_mod_t **mods;
     uint64_t mods_length;
 } ns_simulation_t;
 
+// Parameters of a simulation set by a sweep axis, as a mask
+typedef enum ns_parse_sweep_parameter_t {
+    NS_PARSE_SWEEP_TIME_STEP = 1u << 0,
+    NS_PARSE_SWEEP_TICKS = 1u << 1,
+    NS_PARSE_SWEEP_RANKS = 1u << 2,
+    NS_PARSE_SWEEP_WORLD_WIDTH = 1u << 3,
+    NS_PARSE_SWEEP_WORLD_HEIGHT = 1u << 4,
+    NS_PARSE_SWEEP_FLUID_VISCOSITY = 1u << 5,
+    NS_PARSE_SWEEP_FLUID_DENSITY = 1u << 6,
+    NS_PARSE_SWEEP_FLUID_DIFFUSION = 1u << 7,
+    NS_PARSE_SWEEP_SOLVER_MAX_ITERATIONS = 1u << 8,
+    NS_PARSE_SWEEP_SOLVER_TOLERANCE = 1u << 9
+} ns_parse_sweep_parameter_t;
+
+// Number of parameters a sweep axis can set
+#define NS_PARSE_SWEEP_PARAMETERS 10
+
+typedef struct ns_parse_sweep_axis_t {
+    // Parameters set to the value of the axis
+    unsigned int parameters;
+    // Listed values, NULL if spaced from `from` to `to`
+    double *values;
+    uint64_t values_length;
+    double from;
+    double to;
+    // Spaced by a constant ratio instead of a constant step
+    bool logarithmic;
+} ns_parse_sweep_axis_t;
+
+typedef struct ns_parse_sweep_t {
+    // Simulation every point starts from
+    ns_simulation_t *base;
+    // Output region set by the base, otherwise every point saves its whole world
+    bool region;
+    ns_parse_sweep_axis_t **axes;
+    uint64_t axes_length;
+    // Points of the sweep, every combination of the values of the axes
+    uint64_t points_length;
+} ns_parse_sweep_t;
+
+// Location of a simulation in the text of a streamed simulations file
+typedef struct ns_parse_location_t {
+    // Byte range of the simulation object, or of the sweep object of a point
+    uint64_t offset;
+    uint64_t length;
+    // Point of the sweep
+    uint64_t point;
+    bool sweep;
+} ns_parse_location_t;
+
+// Scanning state of a streamed simulations text
+typedef struct ns_parse_stream_t ns_parse_stream_t;
+
 typedef struct ns_simulations_t {
+    // Listed simulations, their ids come first
     ns_simulation_t **simulations;
     uint64_t simulations_length;
+
+    // Sweeps, the ids of their points follow in order
+    ns_parse_sweep_t **sweeps;
+    uint64_t sweeps_length;
+
+    // Text parsed a few simulations at a time, NULL if parsed at once
+    ns_parse_stream_t *stream;
 } ns_simulations_t;
 
 /**
@@ -76,6 +152,97 @@ ns_simulation_t *ns_parse_simulation(const char *text);
  */
 ns_simulations_t *ns_parse_simulations(const char *text);
 
+/**
+ * Start parsing text string into simulations struct, a few simulations at a time with ns_parse_simulations_next.
+ * Only the byte ranges of the top-level arrays are scanned, every simulation is parsed on its own.
+ * The listed simulations are not kept, only their location, the text must outlive the simulations.
+ * Remember to free with ns_parse_simulations_free.
+ *
+ * @param text Text string to parse, usually a mapped file
+ * @param length Text length in bytes
+ * @return Simulations struct without simulations, NULL if the text is not a JSON object
+ */
+ns_simulations_t *ns_parse_simulations_stream(const char *text, uint64_t length);
+
+/**
+ * Parse up to count more listed simulations of a streamed text.
+ * The points of the sweeps follow once every listed simulation is parsed.
+ *
+ * @param simulations Streamed simulations
+ * @param count Listed simulations to parse
+ * @return true if parsed, or if the whole text is parsed already, false if the text is not valid
+ */
+bool ns_parse_simulations_next(ns_simulations_t *simulations, uint64_t count);
+
+/**
+ * Return true if every simulation is parsed, always for a text parsed at once.
+ *
+ * @param simulations Parsed simulations
+ * @return true if complete, false otherwise
+ */
+bool ns_parse_simulations_complete(const ns_simulations_t *simulations);
+
+/**
+ * Obtain the location of the simulation with id in a streamed text.
+ *
+ * @param simulations Streamed simulations
+ * @param simulation_id Simulation id
+ * @param location Location in the text
+ * @return true if found, false otherwise
+ */
+bool ns_parse_simulations_location(const ns_simulations_t *simulations, uint64_t simulation_id,
+                                   ns_parse_location_t *location);
+
+/**
+ * Parse the simulation at location of text string, a sweep point is expanded.
+ * Remember to free with ns_parse_simulation_free.
+ *
+ * @param text Text string of the streamed simulations
+ * @param length Text length in bytes
+ * @param location Location of the simulation
+ * @return Parsed simulation, NULL otherwise
+ */
+ns_simulation_t *ns_parse_simulation_at(const char *text, uint64_t length, const ns_parse_location_t *location);
+
+/**
+ * Return the number of simulations, the listed ones and the points of every sweep.
+ *
+ * @param simulations Parsed simulations
+ * @return Number of simulations
+ */
+uint64_t ns_parse_simulations_length(const ns_simulations_t *simulations);
+
+/**
+ * Obtain the simulation with id, a sweep point is expanded on demand.
+ * The simulation shares the mods of the parsed simulations, do not free it.
+ * A listed simulation of a streamed text is parsed again, valid until the next call.
+ *
+ * @param simulations Parsed simulations
+ * @param simulation_id Simulation id
+ * @param simulation Simulation
+ * @return true if found, false otherwise
+ */
+bool ns_parse_simulations_at(const ns_simulations_t *simulations, uint64_t simulation_id, ns_simulation_t *simulation);
+
+/**
+ * Return the value of axis at index.
+ *
+ * @param axis Sweep axis
+ * @param index Index of the value, lower than the values length
+ * @return Value
+ */
+double ns_parse_sweep_value(const ns_parse_sweep_axis_t *axis, uint64_t index);
+
+/**
+ * Assign the values of a point of sweep to simulation, a copy of the sweep base.
+ * The last axis varies fastest.
+ *
+ * @param sweep Sweep
+ * @param point Point index, lower than the points length
+ * @param simulation Copy of the sweep base
+ */
+void ns_parse_sweep_assign(const ns_parse_sweep_t *sweep, uint64_t point, ns_simulation_t *simulation);
+
 /**
  * Free the parsed simulation.
  *
@@ -0,0 +1,298 @@
+#ifndef _NS_UTILS_SNAPSHOT_H
+#define _NS_UTILS_SNAPSHOT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ns/solver.h"
+
+// Magic of the binary format, at the start and at the end of the file
+#define SNAPSHOT_MAGIC "NSSNAPSH"
+#define SNAPSHOT_MAGIC_LENGTH 8
+// Version of the binary format
+#define SNAPSHOT_VERSION 3
+// Every SNAPSHOT_KEYFRAME_INTERVAL snapshots one is compressed without the previous one
+#define SNAPSHOT_KEYFRAME_INTERVAL 32
+
+// Snapshot fields, flags of snapshot_output_t fields
+#define SNAPSHOT_FIELD_U (1u << 0)
+#define SNAPSHOT_FIELD_V (1u << 1)
+#define SNAPSHOT_FIELD_DENSITY (1u << 2)
+#define SNAPSHOT_FIELDS (SNAPSHOT_FIELD_U | SNAPSHOT_FIELD_V | SNAPSHOT_FIELD_DENSITY)
+
+// Format of the simulation result files
+typedef enum snapshot_format_t {
+    // One JSON object with a cell object for every cell of every snapshot
+    SNAPSHOT_FORMAT_JSON,
+    // Metadata header, then the raw field planes of every snapshot and an index of the snapshot offsets
+    SNAPSHOT_FORMAT_BINARY
+} snapshot_format_t;
+
+// Compression of the snapshot planes of the binary format
+typedef enum snapshot_compression_t {
+    // Raw planes
+    SNAPSHOT_COMPRESSION_NONE,
+    // XOR with the previous snapshot, byte shuffle and LZ codec, bitwise exact
+    SNAPSHOT_COMPRESSION_LOSSLESS,
+    // Quantization within the tolerance, difference with the previous snapshot, byte shuffle and LZ codec
+    SNAPSHOT_COMPRESSION_LOSSY
+} snapshot_compression_t;
+
+// Snapshots of a binary result file
+typedef struct snapshot_layout_t {
+    uint64_t width;
+    uint64_t height;
+    // Saved fields, SNAPSHOT_FIELD_* flags
+    unsigned int fields;
+    snapshot_compression_t compression;
+    // Maximum absolute error of a value with the lossy compression
+    double tolerance;
+} snapshot_layout_t;
+
+// Snapshots saved of a simulation and their content
+typedef struct snapshot_output_t {
+    // Save the snapshot of every `every` ticks
+    uint64_t every;
+    // Region of interest, in cells of the world with the global boundary
+    uint64_t x;
+    uint64_t y;
+    uint64_t width;
+    uint64_t height;
+    // Saved fields, SNAPSHOT_FIELD_* flags
+    unsigned int fields;
+    // Side of the blocks of cells averaged into a single cell
+    uint64_t downsample;
+} snapshot_output_t;
+
+// Binary result file writer, one snapshot at a time
+typedef struct snapshot_writer_t snapshot_writer_t;
+
+// Binary result file reader, one snapshot at a time
+typedef struct snapshot_reader_t snapshot_reader_t;
+
+/**
+ * Return the name of format.
+ *
+ * @param format Result file format
+ * @return Format name, NULL if invalid
+ */
+const char *snapshot_format_string(snapshot_format_t format);
+
+/**
+ * Return the format with name format.
+ *
+ * @param format Format name
+ * @return Result file format, -1 if invalid
+ */
+int snapshot_format_int(const char *format);
+
+/**
+ * Return the file extension of format, without the dot.
+ *
+ * @param format Result file format
+ * @return Format file extension, NULL if invalid
+ */
+const char *snapshot_format_extension(snapshot_format_t format);
+
+/**
+ * Return the name of compression.
+ *
+ * @param compression Snapshot compression
+ * @return Compression name, NULL if invalid
+ */
+const char *snapshot_compression_string(snapshot_compression_t compression);
+
+/**
+ * Return the compression with name compression.
+ *
+ * @param compression Compression name
+ * @return Snapshot compression, -1 if invalid
+ */
+int snapshot_compression_int(const char *compression);
+
+/**
+ * Return the name of field, as in the result cells.
+ *
+ * @param field Snapshot field, one SNAPSHOT_FIELD_* flag
+ * @return Field name, NULL if invalid
+ */
+const char *snapshot_field_string(unsigned int field);
+
+/**
+ * Return the field with name field.
+ *
+ * @param field Field name
+ * @return Snapshot field, 0 if invalid
+ */
+unsigned int snapshot_field_int(const char *field);
+
+/**
+ * Initialize output with the default snapshot output:
+ * every tick, whole world with the global boundary, every field, no downsampling.
+ *
+ * @param output Snapshot output
+ * @param world_width_bounds Width of the world with the global boundary
+ * @param world_height_bounds Height of the world with the global boundary
+ */
+void snapshot_output_init(snapshot_output_t *output, uint64_t world_width_bounds, uint64_t world_height_bounds);
+
+/**
+ * Check the output of a world of size world_width_bounds x world_height_bounds.
+ *
+ * @param output Snapshot output
+ * @param world_width_bounds Width of the world with the global boundary
+ * @param world_height_bounds Height of the world with the global boundary
+ * @return true if valid, false otherwise
+ */
+bool snapshot_output_check(const snapshot_output_t *output, uint64_t world_width_bounds,
+                           uint64_t world_height_bounds);
+
+/**
+ * Return the width of the snapshots saved with output.
+ *
+ * @param output Snapshot output
+ * @return Snapshot width in cells
+ */
+uint64_t snapshot_output_width(const snapshot_output_t *output);
+
+/**
+ * Return the height of the snapshots saved with output.
+ *
+ * @param output Snapshot output
+ * @return Snapshot height in cells
+ */
+uint64_t snapshot_output_height(const snapshot_output_t *output);
+
+/**
+ * Return the number of values of a snapshot saved with output.
+ *
+ * @param output Snapshot output
+ * @return Number of values of the saved fields
+ */
+uint64_t snapshot_output_size(const snapshot_output_t *output);
+
+/**
+ * Reduce world to the snapshot saved with output, a view of snapshot_output_width x snapshot_output_height cells
+ * whose planes are in buffer, NULL if their field is not saved.
+ * Cell (x, y) of reduced is the average of the downsample x downsample block of world cells
+ * starting at (output->x + x * downsample, output->y + y * downsample), clipped to the region.
+ *
+ * @param output Snapshot output
+ * @param world World snapshot
+ * @param buffer Buffer of snapshot_output_size(output) values
+ * @param reduced Reduced snapshot
+ */
+void snapshot_output_reduce(const snapshot_output_t *output, const ns_world_t *world, ns_real_t *buffer,
+                            ns_world_t *reduced);
+
+/**
+ * Create the binary result file at file_path and write its header.
+ * An existing file is truncated.
+ * Remember to close with snapshot_writer_close, or with snapshot_writer_close_memory if written to memory.
+ *
+ * @param file_path File location, NULL to write the file to memory
+ * @param metadata Simulation metadata, JSON text saved in the header
+ * @param layout Snapshots of the file
+ * @param error Error if something goes wrong, NULL otherwise
+ * @return Snapshot writer, NULL if something goes wrong
+ */
+snapshot_writer_t *snapshot_writer_open(const char *file_path, const char *metadata, const snapshot_layout_t *layout,
+                                        char *error);
+
+/**
+ * Append the world snapshot to the file of writer.
+ * The snapshot must have the size and the fields of the file layout.
+ *
+ * @param writer Snapshot writer
+ * @param world World snapshot
+ * @param stats Iterations used to compute the ticks since the previous snapshot
+ * @param error Error if something goes wrong, NULL otherwise
+ * @return true if written, false otherwise
+ */
+bool snapshot_writer_write(snapshot_writer_t *writer, const ns_world_t *world, ns_tick_stats_t stats, char *error);
+
+/**
+ * Flush the snapshots written so far to the storage, a file without index ends at the last one.
+ * Does nothing if written to memory.
+ *
+ * @param writer Snapshot writer
+ * @param error Error if something goes wrong, NULL otherwise
+ * @return true if flushed, false otherwise
+ */
+bool snapshot_writer_sync(snapshot_writer_t *writer, char *error);
+
+/**
+ * Write the index of the snapshot offsets, close the file of writer and free writer.
+ *
+ * @param writer Snapshot writer
+ * @param error Error if something goes wrong, NULL otherwise
+ * @return true if closed, false otherwise
+ */
+bool snapshot_writer_close(snapshot_writer_t *writer, char *error);
+
+/**
+ * Write the index of the snapshot offsets and free writer, written to memory, returning the file content.
+ * Remember to free the content with free.
+ *
+ * @param writer Snapshot writer, written to memory
+ * @param length File content length in bytes
+ * @param error Error if something goes wrong, NULL otherwise
+ * @return File content, NULL if something goes wrong
+ */
+uint8_t *snapshot_writer_close_memory(snapshot_writer_t *writer, uint64_t *length, char *error);
+
+/**
+ * Open the binary result file at file_path and read its header.
+ * The file must be saved with the field precision of this build.
+ * Remember to close with snapshot_reader_close.
+ *
+ * @param file_path File location
+ * @param error Error if something goes wrong, NULL otherwise
+ * @return Snapshot reader, NULL if something goes wrong
+ */
+snapshot_reader_t *snapshot_reader_open(const char *file_path, char *error);
+
+/**
+ * Return the snapshots layout of the file of reader.
+ *
+ * @param reader Snapshot reader
+ * @return Snapshots layout
+ */
+const snapshot_layout_t *snapshot_reader_layout(const snapshot_reader_t *reader);
+
+/**
+ * Return the simulation metadata of the file of reader, JSON text.
+ *
+ * @param reader Snapshot reader
+ * @return Simulation metadata
+ */
+const char *snapshot_reader_metadata(const snapshot_reader_t *reader);
+
+/**
+ * Return true if every snapshot of the file of reader has been read.
+ * Files without index, of interrupted simulations, end at the end of the file.
+ *
+ * @param reader Snapshot reader
+ * @return true if at the end, false otherwise
+ */
+bool snapshot_reader_end(const snapshot_reader_t *reader);
+
+/**
+ * Read the next snapshot of the file of reader.
+ * The world planes are owned by reader and valid until the next read, NULL if their field is not saved.
+ *
+ * @param reader Snapshot reader
+ * @param world Read snapshot
+ * @param stats Iterations used to compute the ticks since the previous snapshot
+ * @param error Error if something goes wrong, NULL otherwise
+ * @return true if read, false otherwise
+ */
+bool snapshot_reader_read(snapshot_reader_t *reader, ns_world_t *world, ns_tick_stats_t *stats, char *error);
+
+/**
+ * Close the file of reader and free reader.
+ *
+ * @param reader Snapshot reader
+ */
+void snapshot_reader_close(snapshot_reader_t *reader);
+
+#endif
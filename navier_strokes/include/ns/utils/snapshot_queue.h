@@ -0,0 +1,61 @@
+#ifndef _NS_UTILS_SNAPSHOT_QUEUE_H
+#define _NS_UTILS_SNAPSHOT_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ns/solver.h"
+#include "ns/utils/snapshot.h"
+
+// Bounded queue of world snapshot copies consumed by a dedicated I/O thread
+typedef struct snapshot_queue_t snapshot_queue_t;
+
+/**
+ * Task run on a queued snapshot.
+ *
+ * @param context Task context
+ * @param world Copy of the world snapshot, reduced to the queued output, NULL if the task has no snapshot
+ * @param stats Iterations used to compute the ticks since the previous snapshot
+ */
+typedef void (*snapshot_queue_task_t)(void *context, const ns_world_t *world, ns_tick_stats_t stats);
+
+/**
+ * Create a snapshot queue holding up to capacity snapshot copies and start its I/O thread.
+ * With capacity 0 no thread is started and every task runs synchronously in snapshot_queue_push,
+ * on a copy of the snapshot all the same.
+ * Remember to free with snapshot_queue_free.
+ *
+ * @param capacity Maximum number of pending tasks
+ * @return Snapshot queue, NULL if something goes wrong
+ */
+snapshot_queue_t *snapshot_queue_create(uint64_t capacity);
+
+/**
+ * Queue task on a copy of world reduced with output, waiting while the queue is full.
+ * Tasks run in the order they are queued.
+ *
+ * @param queue Snapshot queue
+ * @param task Task to run
+ * @param context Task context
+ * @param world World snapshot to copy, NULL if the task has no snapshot
+ * @param output Snapshot output applied to the copy, NULL to copy the whole world
+ * @param stats Iterations used to compute the ticks since the previous snapshot
+ * @return true if queued, false otherwise
+ */
+bool snapshot_queue_push(snapshot_queue_t *queue, snapshot_queue_task_t task, void *context, const ns_world_t *world,
+                         const snapshot_output_t *output, ns_tick_stats_t stats);
+
+/**
+ * Wait until every queued task has run.
+ *
+ * @param queue Snapshot queue
+ */
+void snapshot_queue_wait(snapshot_queue_t *queue);
+
+/**
+ * Wait until every queued task has run, stop the I/O thread and free queue.
+ *
+ * @param queue Snapshot queue
+ */
+void snapshot_queue_free(snapshot_queue_t *queue);
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef _NS_UTILS_VALIDATE_H
+#define _NS_UTILS_VALIDATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <cJSON.h>
+
+// Difference of a field from its reference, over every snapshot
+typedef struct validate_field_t {
+    // Maximum absolute difference of a cell
+    double max_error;
+    // Norm of the difference over the norm of the reference
+    double relative_error;
+} validate_field_t;
+
+// Difference of a simulation result from its reference result
+typedef struct validate_t {
+    validate_field_t density;
+    validate_field_t u;
+    validate_field_t v;
+} validate_t;
+
+/**
+ * Return the path of the result of simulation simulation_id saved in folder.
+ * Remember to free with free.
+ *
+ * @param folder Results folder
+ * @param simulation_id Simulation id
+ * @return Path of the result, NULL if not found
+ */
+char *validate_find_reference(const char *folder, uint64_t simulation_id);
+
+/**
+ * Compare the snapshots of a simulation result with the snapshots of its reference result,
+ * which must have the same world size and number of snapshots.
+ *
+ * @param result_json Simulation result
+ * @param reference_json Reference simulation result
+ * @param validation Difference of result_json from reference_json
+ * @return true if compared, false otherwise
+ */
+bool validate_result(const cJSON *result_json, const cJSON *reference_json, validate_t *validation);
+
+#endif
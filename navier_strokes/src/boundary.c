@@ -0,0 +1,183 @@
+#include "ns/boundary.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Index of cell (x, y) in a field
+#define NS_BOUNDARY_IDX(pitch, x, y) ((y) * (pitch) + (x))
+
+// Edge names
+static const char *edge_strings[] = {
+        "left", "right", "top", "bottom"
+};
+
+// Boundary type names
+static const char *type_strings[] = {
+        "wall", "periodic", "inflow", "outflow"
+};
+
+/**
+ * Private definitions
+ */
+static inline ns_real_t
+ns_boundary_ghost(const ns_boundary_t *boundary, ns_boundary_field_t field, bool normal, ns_real_t interior,
+                  ns_real_t opposite);
+/**
+ * END Private definitions
+ */
+
+/**
+ * Public
+ */
+const char *ns_boundary_edge_string(ns_boundary_edge_t edge) {
+    if (edge < NS_BOUNDARY_EDGE_LEFT || edge > NS_BOUNDARY_EDGE_BOTTOM) return NULL;
+
+    return edge_strings[edge];
+}
+
+const char *ns_boundary_type_string(ns_boundary_type_t type) {
+    if (type < NS_BOUNDARY_TYPE_WALL || type > NS_BOUNDARY_TYPE_OUTFLOW) return NULL;
+
+    return type_strings[type];
+}
+
+int ns_boundary_type_int(const char *const type) {
+    if (type == NULL) return -1;
+
+    for (int i = NS_BOUNDARY_TYPE_WALL; i <= NS_BOUNDARY_TYPE_OUTFLOW; ++i) {
+        if (strcmp(type, type_strings[i]) == 0) return i;
+    }
+
+    return -1;
+}
+
+void ns_boundaries_init(ns_boundaries_t *boundaries) {
+    if (boundaries == NULL) return;
+
+    for (int i = 0; i < NS_BOUNDARY_EDGES; ++i) {
+        boundaries->edges[i].type = NS_BOUNDARY_TYPE_WALL;
+        boundaries->edges[i].u = 0.0;
+        boundaries->edges[i].v = 0.0;
+        boundaries->edges[i].density = 0.0;
+    }
+}
+
+bool ns_boundaries_check(const ns_boundaries_t *const boundaries) {
+    if (boundaries == NULL) return false;
+
+    for (int i = 0; i < NS_BOUNDARY_EDGES; ++i) {
+        if (ns_boundary_type_string(boundaries->edges[i].type) == NULL) return false;
+    }
+
+    return (boundaries->edges[NS_BOUNDARY_EDGE_LEFT].type == NS_BOUNDARY_TYPE_PERIODIC)
+           == (boundaries->edges[NS_BOUNDARY_EDGE_RIGHT].type == NS_BOUNDARY_TYPE_PERIODIC)
+           && (boundaries->edges[NS_BOUNDARY_EDGE_TOP].type == NS_BOUNDARY_TYPE_PERIODIC)
+              == (boundaries->edges[NS_BOUNDARY_EDGE_BOTTOM].type == NS_BOUNDARY_TYPE_PERIODIC);
+}
+
+bool ns_boundaries_periodic(const ns_boundaries_t *const boundaries) {
+    for (int i = 0; i < NS_BOUNDARY_EDGES; ++i) {
+        if (boundaries->edges[i].type == NS_BOUNDARY_TYPE_PERIODIC) return true;
+    }
+
+    return false;
+}
+
+void ns_boundary_set_row(const ns_boundaries_t *const boundaries, ns_boundary_field_t field,
+                         const ns_halo_tile_t *const tile, ns_real_t *row) {
+    const uint64_t w = tile->width;
+
+    if (tile->left)
+        row[0] = ns_boundary_ghost(&boundaries->edges[NS_BOUNDARY_EDGE_LEFT], field, field == NS_BOUNDARY_FIELD_U,
+                                   row[1], row[w]);
+    if (tile->right)
+        row[w + 1] = ns_boundary_ghost(&boundaries->edges[NS_BOUNDARY_EDGE_RIGHT], field,
+                                       field == NS_BOUNDARY_FIELD_U, row[w], row[1]);
+}
+
+void ns_boundary_set_rows(const ns_boundaries_t *const boundaries, ns_boundary_field_t field,
+                          const ns_halo_tile_t *const tile, ns_real_t *target, uint64_t pitch) {
+    const uint64_t w = tile->width;
+    const uint64_t h = tile->height;
+    const bool normal = field == NS_BOUNDARY_FIELD_V;
+
+    if (tile->top) {
+        const ns_boundary_t *const top = &boundaries->edges[NS_BOUNDARY_EDGE_TOP];
+
+        for (uint64_t x = 1; x <= w; ++x) {
+            target[NS_BOUNDARY_IDX(pitch, x, 0)] = ns_boundary_ghost(top, field, normal,
+                                                                     target[NS_BOUNDARY_IDX(pitch, x, 1)],
+                                                                     target[NS_BOUNDARY_IDX(pitch, x, h)]);
+        }
+    }
+    if (tile->bottom) {
+        const ns_boundary_t *const bottom = &boundaries->edges[NS_BOUNDARY_EDGE_BOTTOM];
+
+        for (uint64_t x = 1; x <= w; ++x) {
+            target[NS_BOUNDARY_IDX(pitch, x, h + 1)] = ns_boundary_ghost(bottom, field, normal,
+                                                                         target[NS_BOUNDARY_IDX(pitch, x, h)],
+                                                                         target[NS_BOUNDARY_IDX(pitch, x, 1)]);
+        }
+    }
+
+    // Corners average their two ghost neighbours
+    if (tile->left && tile->top)
+        target[NS_BOUNDARY_IDX(pitch, 0, 0)] =
+                NS_REAL(0.5) * (target[NS_BOUNDARY_IDX(pitch, 1, 0)] + target[NS_BOUNDARY_IDX(pitch, 0, 1)]);
+    if (tile->left && tile->bottom)
+        target[NS_BOUNDARY_IDX(pitch, 0, h + 1)] =
+                NS_REAL(0.5) * (target[NS_BOUNDARY_IDX(pitch, 1, h + 1)] + target[NS_BOUNDARY_IDX(pitch, 0, h)]);
+    if (tile->right && tile->top)
+        target[NS_BOUNDARY_IDX(pitch, w + 1, 0)] =
+                NS_REAL(0.5) * (target[NS_BOUNDARY_IDX(pitch, w, 0)] + target[NS_BOUNDARY_IDX(pitch, w + 1, 1)]);
+    if (tile->right && tile->bottom)
+        target[NS_BOUNDARY_IDX(pitch, w + 1, h + 1)] =
+                NS_REAL(0.5) * (target[NS_BOUNDARY_IDX(pitch, w, h + 1)] + target[NS_BOUNDARY_IDX(pitch, w + 1, h)]);
+}
+
+void ns_boundary_set(const ns_boundaries_t *const boundaries, ns_boundary_field_t field,
+                     const ns_halo_tile_t *const tile, ns_real_t *target, uint64_t pitch) {
+    if (tile->left || tile->right) {
+        for (uint64_t y = 1; y <= tile->height; ++y) {
+            ns_boundary_set_row(boundaries, field, tile, &target[NS_BOUNDARY_IDX(pitch, 0, y)]);
+        }
+    }
+
+    ns_boundary_set_rows(boundaries, field, tile, target, pitch);
+}
+/**
+ * END Public
+ */
+
+/**
+ * Private
+ */
+static inline ns_real_t
+ns_boundary_ghost(const ns_boundary_t *const boundary, ns_boundary_field_t field, bool normal, ns_real_t interior,
+                  ns_real_t opposite) {
+    switch (boundary->type) {
+        case NS_BOUNDARY_TYPE_PERIODIC:
+            return opposite;
+        case NS_BOUNDARY_TYPE_INFLOW: {
+            switch (field) {
+                case NS_BOUNDARY_FIELD_U:
+                    return (ns_real_t) boundary->u;
+                case NS_BOUNDARY_FIELD_V:
+                    return (ns_real_t) boundary->v;
+                case NS_BOUNDARY_FIELD_DENSITY:
+                    return (ns_real_t) boundary->density;
+                case NS_BOUNDARY_FIELD_SCALAR:
+                default:
+                    return interior;
+            }
+        }
+        case NS_BOUNDARY_TYPE_OUTFLOW:
+            return interior;
+        case NS_BOUNDARY_TYPE_WALL:
+        default:
+            // The velocity component normal to the wall is reflected
+            return normal ? -interior : interior;
+    }
+}
+/**
+ * END Private
+ */
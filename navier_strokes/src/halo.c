@@ -0,0 +1,429 @@
+#include "ns/halo.h"
+#include <stdlib.h>
+#include <limits.h>
+
+// Message tags (direction of travel)
+#define NS_HALO_TAG_UP 0
+#define NS_HALO_TAG_DOWN 1
+#define NS_HALO_TAG_LEFT 2
+#define NS_HALO_TAG_RIGHT 3
+#define NS_HALO_TAG_WINDOW 4
+
+// Maximum number of pending requests of a ghost exchange
+#define NS_HALO_EXCHANGE_REQUESTS 8
+
+// Index of cell (x, y) in a field
+#define NS_HALO_IDX(pitch, x, y) ((y) * (pitch) + (x))
+
+// Halo data wrapper
+typedef struct ns_halo_t {
+    // Cartesian communicator (ranks are not reordered)
+    MPI_Comm comm;
+    int rank;
+    int size;
+
+    // World
+    uint64_t world_width;
+    uint64_t world_height;
+    // Tile of every rank
+    ns_halo_tile_t *tiles;
+
+    // Neighbour ranks (MPI_PROC_NULL on the global boundary)
+    int left;
+    int right;
+    int top;
+    int bottom;
+
+    // Pending ghost exchange
+    MPI_Request exchange_requests[NS_HALO_EXCHANGE_REQUESTS];
+    int exchange_requests_length;
+    // Packed columns {send left, send right, receive left, receive right}, tile height each
+    ns_real_t *columns;
+
+    // Window gather
+    uint64_t *boxes;
+    MPI_Request *window_requests;
+    ns_real_t *window;
+    size_t window_size;
+    ns_real_t *send_buffer;
+    size_t send_buffer_size;
+    ns_real_t *receive_buffer;
+    size_t receive_buffer_size;
+} ns_halo_t;
+
+/**
+ * Private definitions
+ */
+static void ns_halo_split(uint64_t length, int parts, int part, uint64_t *offset, uint64_t *size);
+
+static void ns_halo_owned(const ns_halo_t *halo, int rank, uint64_t owned[4]);
+
+static uint64_t ns_halo_intersect(const uint64_t a[4], const uint64_t b[4], uint64_t intersection[4]);
+
+static void ns_halo_pack(const ns_real_t *field, uint64_t pitch, uint64_t x, uint64_t y,
+                         const uint64_t box[4], ns_real_t *buffer);
+
+static void ns_halo_unpack(ns_real_t *field, uint64_t pitch, uint64_t x, uint64_t y,
+                           const uint64_t box[4], const ns_real_t *buffer);
+
+static bool ns_halo_reserve(ns_real_t **buffer, size_t *size, size_t cells);
+/**
+ * END Private definitions
+ */
+
+/**
+ * Public
+ */
+ns_halo_t *ns_halo_create(MPI_Comm comm, uint64_t world_width, uint64_t world_height, ns_halo_tile_t *tile) {
+    int dims[2] = {0, 0};
+    const int periods[2] = {0, 0};
+    int coords[2];
+    ns_halo_t *halo = NULL;
+
+    if (tile == NULL) return NULL;
+
+    halo = (ns_halo_t *) calloc(1, sizeof(ns_halo_t));
+    if (halo == NULL) return NULL;
+    halo->comm = MPI_COMM_NULL;
+    halo->world_width = world_width;
+    halo->world_height = world_height;
+
+    MPI_Comm_size(comm, &halo->size);
+
+    // Process grid {rows, columns}, more parts along the longer side
+    MPI_Dims_create(halo->size, 2, dims);
+    if (world_width > world_height) {
+        const int tmp = dims[0];
+        dims[0] = dims[1];
+        dims[1] = tmp;
+    }
+    if ((uint64_t) dims[0] > world_height || (uint64_t) dims[1] > world_width) {
+        ns_halo_free(halo);
+        return NULL;
+    }
+
+    MPI_Cart_create(comm, 2, dims, periods, 0, &halo->comm);
+    MPI_Comm_rank(halo->comm, &halo->rank);
+    MPI_Cart_shift(halo->comm, 0, 1, &halo->top, &halo->bottom);
+    MPI_Cart_shift(halo->comm, 1, 1, &halo->left, &halo->right);
+
+    halo->tiles = (ns_halo_tile_t *) calloc((size_t) halo->size, sizeof(ns_halo_tile_t));
+    halo->boxes = (uint64_t *) calloc(4 * (size_t) halo->size, sizeof(uint64_t));
+    halo->window_requests = (MPI_Request *) calloc(2 * (size_t) halo->size, sizeof(MPI_Request));
+    if (halo->tiles == NULL || halo->boxes == NULL || halo->window_requests == NULL) {
+        ns_halo_free(halo);
+        return NULL;
+    }
+
+    for (int r = 0; r < halo->size; ++r) {
+        ns_halo_tile_t *t = &halo->tiles[r];
+
+        MPI_Cart_coords(halo->comm, r, 2, coords);
+        ns_halo_split(world_height, dims[0], coords[0], &t->y, &t->height);
+        ns_halo_split(world_width, dims[1], coords[1], &t->x, &t->width);
+        t->left = coords[1] == 0;
+        t->right = coords[1] == dims[1] - 1;
+        t->top = coords[0] == 0;
+        t->bottom = coords[0] == dims[0] - 1;
+    }
+
+    *tile = halo->tiles[halo->rank];
+
+    halo->columns = (ns_real_t *) malloc(4 * tile->height * sizeof(ns_real_t));
+    if (halo->columns == NULL) {
+        ns_halo_free(halo);
+        return NULL;
+    }
+
+    return halo;
+}
+
+void ns_halo_free(ns_halo_t *halo) {
+    if (halo == NULL) return;
+
+    if (halo->comm != MPI_COMM_NULL) MPI_Comm_free(&halo->comm);
+    free(halo->tiles);
+    free(halo->columns);
+    free(halo->boxes);
+    free(halo->window_requests);
+    free(halo->window);
+    free(halo->send_buffer);
+    free(halo->receive_buffer);
+
+    free(halo);
+}
+
+bool ns_halo_is_root(const ns_halo_t *halo) {
+    return halo->rank == 0;
+}
+
+void ns_halo_exchange_start(ns_halo_t *halo, ns_real_t *field, uint64_t pitch) {
+    const ns_halo_tile_t *tile = &halo->tiles[halo->rank];
+    const uint64_t w = tile->width;
+    const uint64_t h = tile->height;
+    ns_real_t *const send_left = &halo->columns[0];
+    ns_real_t *const send_right = &halo->columns[h];
+    ns_real_t *const receive_left = &halo->columns[2 * h];
+    ns_real_t *const receive_right = &halo->columns[3 * h];
+    MPI_Request *requests = halo->exchange_requests;
+    int n = 0;
+
+    // Rows are contiguous
+    if (halo->top != MPI_PROC_NULL) {
+        MPI_Irecv(&field[NS_HALO_IDX(pitch, 1, 0)], (int) w, NS_REAL_MPI, halo->top, NS_HALO_TAG_DOWN,
+                  halo->comm, &requests[n++]);
+        MPI_Isend(&field[NS_HALO_IDX(pitch, 1, 1)], (int) w, NS_REAL_MPI, halo->top, NS_HALO_TAG_UP,
+                  halo->comm, &requests[n++]);
+    }
+    if (halo->bottom != MPI_PROC_NULL) {
+        MPI_Irecv(&field[NS_HALO_IDX(pitch, 1, h + 1)], (int) w, NS_REAL_MPI, halo->bottom, NS_HALO_TAG_UP,
+                  halo->comm, &requests[n++]);
+        MPI_Isend(&field[NS_HALO_IDX(pitch, 1, h)], (int) w, NS_REAL_MPI, halo->bottom, NS_HALO_TAG_DOWN,
+                  halo->comm, &requests[n++]);
+    }
+
+    // Columns are packed
+    if (halo->left != MPI_PROC_NULL) {
+        for (uint64_t y = 1; y <= h; ++y) send_left[y - 1] = field[NS_HALO_IDX(pitch, 1, y)];
+        MPI_Irecv(receive_left, (int) h, NS_REAL_MPI, halo->left, NS_HALO_TAG_RIGHT, halo->comm, &requests[n++]);
+        MPI_Isend(send_left, (int) h, NS_REAL_MPI, halo->left, NS_HALO_TAG_LEFT, halo->comm, &requests[n++]);
+    }
+    if (halo->right != MPI_PROC_NULL) {
+        for (uint64_t y = 1; y <= h; ++y) send_right[y - 1] = field[NS_HALO_IDX(pitch, w, y)];
+        MPI_Irecv(receive_right, (int) h, NS_REAL_MPI, halo->right, NS_HALO_TAG_LEFT, halo->comm, &requests[n++]);
+        MPI_Isend(send_right, (int) h, NS_REAL_MPI, halo->right, NS_HALO_TAG_RIGHT, halo->comm, &requests[n++]);
+    }
+
+    halo->exchange_requests_length = n;
+}
+
+void ns_halo_exchange_finish(ns_halo_t *halo, ns_real_t *field, uint64_t pitch) {
+    const ns_halo_tile_t *tile = &halo->tiles[halo->rank];
+    const uint64_t w = tile->width;
+    const uint64_t h = tile->height;
+    const ns_real_t *const receive_left = &halo->columns[2 * h];
+    const ns_real_t *const receive_right = &halo->columns[3 * h];
+
+    MPI_Waitall(halo->exchange_requests_length, halo->exchange_requests, MPI_STATUSES_IGNORE);
+    halo->exchange_requests_length = 0;
+
+    if (halo->left != MPI_PROC_NULL)
+        for (uint64_t y = 1; y <= h; ++y) field[NS_HALO_IDX(pitch, 0, y)] = receive_left[y - 1];
+    if (halo->right != MPI_PROC_NULL)
+        for (uint64_t y = 1; y <= h; ++y) field[NS_HALO_IDX(pitch, w + 1, y)] = receive_right[y - 1];
+}
+
+double ns_halo_sum(const ns_halo_t *halo, double value) {
+    double sum = 0.0;
+
+    MPI_Allreduce(&value, &sum, 1, MPI_DOUBLE, MPI_SUM, halo->comm);
+
+    return sum;
+}
+
+const ns_real_t *
+ns_halo_gather_window(ns_halo_t *halo, const ns_real_t *field, uint64_t pitch, const uint64_t box[4]) {
+    const ns_halo_tile_t *tile = &halo->tiles[halo->rank];
+    uint64_t owned[4], peer_owned[4], intersection[4];
+    size_t send_cells = 0, receive_cells = 0, offset;
+    int n = 0;
+
+    MPI_Allgather(box, 4, MPI_UINT64_T, halo->boxes, 4, MPI_UINT64_T, halo->comm);
+
+    ns_halo_owned(halo, halo->rank, owned);
+    for (int r = 0; r < halo->size; ++r) {
+        if (r == halo->rank) continue;
+        send_cells += ns_halo_intersect(&halo->boxes[4 * r], owned, intersection);
+        ns_halo_owned(halo, r, peer_owned);
+        receive_cells += ns_halo_intersect(box, peer_owned, intersection);
+    }
+
+    if (!ns_halo_reserve(&halo->window, &halo->window_size, (box[1] - box[0] + 1) * (box[3] - box[2] + 1))
+        || !ns_halo_reserve(&halo->send_buffer, &halo->send_buffer_size, send_cells)
+        || !ns_halo_reserve(&halo->receive_buffer, &halo->receive_buffer_size, receive_cells))
+        return NULL;
+
+    // Receive the parts owned by the other ranks
+    offset = 0;
+    for (int r = 0; r < halo->size; ++r) {
+        uint64_t cells;
+
+        if (r == halo->rank) continue;
+        ns_halo_owned(halo, r, peer_owned);
+        cells = ns_halo_intersect(box, peer_owned, intersection);
+        if (cells == 0) continue;
+
+        MPI_Irecv(&halo->receive_buffer[offset], (int) cells, NS_REAL_MPI, r, NS_HALO_TAG_WINDOW, halo->comm,
+                  &halo->window_requests[n++]);
+        offset += cells;
+    }
+
+    // Send the owned parts requested by the other ranks
+    offset = 0;
+    for (int r = 0; r < halo->size; ++r) {
+        uint64_t cells;
+
+        if (r == halo->rank) continue;
+        cells = ns_halo_intersect(&halo->boxes[4 * r], owned, intersection);
+        if (cells == 0) continue;
+
+        ns_halo_pack(field, pitch, tile->x, tile->y, intersection, &halo->send_buffer[offset]);
+        MPI_Isend(&halo->send_buffer[offset], (int) cells, NS_REAL_MPI, r, NS_HALO_TAG_WINDOW, halo->comm,
+                  &halo->window_requests[n++]);
+        offset += cells;
+    }
+
+    // Own part
+    if (ns_halo_intersect(box, owned, intersection) > 0) {
+        for (uint64_t y = intersection[2]; y <= intersection[3]; ++y) {
+            for (uint64_t x = intersection[0]; x <= intersection[1]; ++x) {
+                halo->window[NS_HALO_IDX(box[1] - box[0] + 1, x - box[0], y - box[2])] =
+                        field[NS_HALO_IDX(pitch, x - tile->x, y - tile->y)];
+            }
+        }
+    }
+
+    MPI_Waitall(n, halo->window_requests, MPI_STATUSES_IGNORE);
+
+    offset = 0;
+    for (int r = 0; r < halo->size; ++r) {
+        uint64_t cells;
+
+        if (r == halo->rank) continue;
+        ns_halo_owned(halo, r, peer_owned);
+        cells = ns_halo_intersect(box, peer_owned, intersection);
+        if (cells == 0) continue;
+
+        ns_halo_unpack(halo->window, box[1] - box[0] + 1, box[0], box[2], intersection,
+                       &halo->receive_buffer[offset]);
+        offset += cells;
+    }
+
+    return halo->window;
+}
+
+bool ns_halo_gather_world(ns_halo_t *halo, const ns_real_t *field, uint64_t pitch, ns_real_t *world,
+                          uint64_t world_pitch) {
+    const ns_halo_tile_t *tile = &halo->tiles[halo->rank];
+    const bool root = ns_halo_is_root(halo);
+    uint64_t owned[4];
+    int *counts = NULL, *displacements = NULL;
+    uint64_t cells, total = 0;
+    bool status = true;
+
+    ns_halo_owned(halo, halo->rank, owned);
+    cells = (owned[1] - owned[0] + 1) * (owned[3] - owned[2] + 1);
+
+    if (root) {
+        counts = (int *) malloc((size_t) halo->size * sizeof(int));
+        displacements = (int *) malloc((size_t) halo->size * sizeof(int));
+        if (counts == NULL || displacements == NULL) status = false;
+
+        for (int r = 0; status && r < halo->size; ++r) {
+            uint64_t peer_owned[4];
+
+            ns_halo_owned(halo, r, peer_owned);
+            counts[r] = (int) ((peer_owned[1] - peer_owned[0] + 1) * (peer_owned[3] - peer_owned[2] + 1));
+            displacements[r] = (int) total;
+            total += (uint64_t) counts[r];
+        }
+        if (total > INT_MAX) status = false;
+
+        if (status) status = ns_halo_reserve(&halo->receive_buffer, &halo->receive_buffer_size, total);
+    }
+    if (status) status = ns_halo_reserve(&halo->send_buffer, &halo->send_buffer_size, cells);
+
+    // Every rank must take part in the collective, agree on the outcome first
+    MPI_Allreduce(MPI_IN_PLACE, &status, 1, MPI_C_BOOL, MPI_LAND, halo->comm);
+
+    if (status) {
+        ns_halo_pack(field, pitch, tile->x, tile->y, owned, halo->send_buffer);
+        MPI_Gatherv(halo->send_buffer, (int) cells, NS_REAL_MPI,
+                    halo->receive_buffer, counts, displacements, NS_REAL_MPI, 0, halo->comm);
+
+        for (int r = 0; root && r < halo->size; ++r) {
+            uint64_t peer_owned[4];
+
+            ns_halo_owned(halo, r, peer_owned);
+            ns_halo_unpack(world, world_pitch, 0, 0, peer_owned, &halo->receive_buffer[displacements[r]]);
+        }
+    }
+
+    free(counts);
+    free(displacements);
+
+    return status;
+}
+/**
+ * END Public
+ */
+
+/**
+ * Private
+ */
+static void ns_halo_split(uint64_t length, int parts, int part, uint64_t *offset, uint64_t *size) {
+    const uint64_t base = length / (uint64_t) parts;
+    const uint64_t remainder = length % (uint64_t) parts;
+    const uint64_t p = (uint64_t) part;
+
+    *size = base + (p < remainder ? 1 : 0);
+    *offset = p * base + (p < remainder ? p : remainder);
+}
+
+static void ns_halo_owned(const ns_halo_t *halo, int rank, uint64_t owned[4]) {
+    const ns_halo_tile_t *tile = &halo->tiles[rank];
+
+    // Tiles on the global boundary also own the ghost cells there
+    owned[0] = tile->left ? 0 : tile->x + 1;
+    owned[1] = tile->right ? halo->world_width + 1 : tile->x + tile->width;
+    owned[2] = tile->top ? 0 : tile->y + 1;
+    owned[3] = tile->bottom ? halo->world_height + 1 : tile->y + tile->height;
+}
+
+static uint64_t ns_halo_intersect(const uint64_t a[4], const uint64_t b[4], uint64_t intersection[4]) {
+    intersection[0] = a[0] > b[0] ? a[0] : b[0];
+    intersection[1] = a[1] < b[1] ? a[1] : b[1];
+    intersection[2] = a[2] > b[2] ? a[2] : b[2];
+    intersection[3] = a[3] < b[3] ? a[3] : b[3];
+
+    if (intersection[0] > intersection[1] || intersection[2] > intersection[3]) return 0;
+
+    return (intersection[1] - intersection[0] + 1) * (intersection[3] - intersection[2] + 1);
+}
+
+static void ns_halo_pack(const ns_real_t *field, uint64_t pitch, uint64_t x, uint64_t y,
+                         const uint64_t box[4], ns_real_t *buffer) {
+    // (x, y) is the global position of the field origin
+    for (uint64_t gy = box[2]; gy <= box[3]; ++gy) {
+        for (uint64_t gx = box[0]; gx <= box[1]; ++gx) {
+            *buffer++ = field[NS_HALO_IDX(pitch, gx - x, gy - y)];
+        }
+    }
+}
+
+static void ns_halo_unpack(ns_real_t *field, uint64_t pitch, uint64_t x, uint64_t y,
+                           const uint64_t box[4], const ns_real_t *buffer) {
+    // (x, y) is the global position of the field origin
+    for (uint64_t gy = box[2]; gy <= box[3]; ++gy) {
+        for (uint64_t gx = box[0]; gx <= box[1]; ++gx) {
+            field[NS_HALO_IDX(pitch, gx - x, gy - y)] = *buffer++;
+        }
+    }
+}
+
+static bool ns_halo_reserve(ns_real_t **buffer, size_t *size, size_t cells) {
+    ns_real_t *tmp;
+
+    if (cells <= *size) return true;
+
+    tmp = (ns_real_t *) realloc(*buffer, cells * sizeof(ns_real_t));
+    if (tmp == NULL) return false;
+
+    *buffer = tmp;
+    *size = cells;
+    return true;
+}
+
+/**
+ * END Private
+ */
@@ -0,0 +1,641 @@
+#include "ns/kernels.h"
+#include <stdlib.h>
+#include <string.h>
+
+// The vector kernels are written for double precision fields
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && !defined(SINGLE_PRECISION)
+#define NS_KERNELS_X86 1
+#include <immintrin.h>
+#define NS_KERNELS_AVX2 __attribute__((target("avx2")))
+#define NS_KERNELS_AVX512 __attribute__((target("avx512f")))
+#else
+#define NS_KERNELS_X86 0
+#endif
+
+// Instruction set names
+static const char *isa_strings[] = {
+        "scalar", "avx2", "avx512"
+};
+
+/**
+ * Private definitions
+ */
+static inline void
+ns_kernels_advect_cell(ns_real_t *d, const ns_real_t *u, const ns_real_t *v, const ns_kernels_advect_t *advect,
+                       uint64_t x, uint64_t y, uint64_t i);
+
+static inline uint64_t ns_kernels_head(const double *cells, uint64_t alignment, uint64_t n);
+
+static void ns_kernels_scalar_add_scaled(ns_real_t *target, const ns_real_t *source, ns_real_t factor, uint64_t n);
+
+static void ns_kernels_scalar_diffuse_red_black_row(ns_real_t *row, const ns_real_t *source_row, uint64_t pitch,
+                                                    ns_real_t a, uint64_t x_first, uint64_t x_last);
+
+static void ns_kernels_scalar_project_red_black_row(ns_real_t *p, const ns_real_t *div, uint64_t pitch,
+                                                    uint64_t x_first, uint64_t x_last);
+
+static void ns_kernels_scalar_divergence_row(ns_real_t *div, ns_real_t *p, const ns_real_t *u, const ns_real_t *v,
+                                             uint64_t pitch, ns_real_t h, uint64_t width);
+
+static void ns_kernels_scalar_gradient_row(ns_real_t *u, ns_real_t *v, const ns_real_t *p, uint64_t pitch,
+                                           ns_real_t h, uint64_t width);
+
+static void ns_kernels_scalar_advect_row(ns_real_t *d, const ns_real_t *u, const ns_real_t *v,
+                                         const ns_kernels_advect_t *advect, uint64_t x, uint64_t y, uint64_t width);
+
+#if NS_KERNELS_X86
+NS_KERNELS_AVX2 static void
+ns_kernels_avx2_add_scaled(double *target, const double *source, double factor, uint64_t n);
+
+NS_KERNELS_AVX2 static void
+ns_kernels_avx2_diffuse_red_black_row(double *row, const double *source_row, uint64_t pitch, double a,
+                                      uint64_t x_first, uint64_t x_last);
+
+NS_KERNELS_AVX2 static void
+ns_kernels_avx2_project_red_black_row(double *p, const double *div, uint64_t pitch,
+                                      uint64_t x_first, uint64_t x_last);
+
+NS_KERNELS_AVX2 static void
+ns_kernels_avx2_divergence_row(double *div, double *p, const double *u, const double *v,
+                               uint64_t pitch, double h, uint64_t width);
+
+NS_KERNELS_AVX2 static void
+ns_kernels_avx2_gradient_row(double *u, double *v, const double *p, uint64_t pitch, double h, uint64_t width);
+
+NS_KERNELS_AVX2 static void
+ns_kernels_avx2_advect_row(double *d, const double *u, const double *v, const ns_kernels_advect_t *advect,
+                           uint64_t x, uint64_t y, uint64_t width);
+
+NS_KERNELS_AVX2 static inline __m256d ns_kernels_avx2_even(const double *cells);
+
+NS_KERNELS_AVX2 static inline __m256d ns_kernels_avx2_west(const double *cells, __m256d *west, __m256d *east);
+
+NS_KERNELS_AVX2 static inline void ns_kernels_avx2_store_even(double *cells, __m256d even);
+
+NS_KERNELS_AVX512 static void
+ns_kernels_avx512_add_scaled(double *target, const double *source, double factor, uint64_t n);
+
+NS_KERNELS_AVX512 static void
+ns_kernels_avx512_diffuse_red_black_row(double *row, const double *source_row, uint64_t pitch, double a,
+                                        uint64_t x_first, uint64_t x_last);
+
+NS_KERNELS_AVX512 static void
+ns_kernels_avx512_project_red_black_row(double *p, const double *div, uint64_t pitch,
+                                        uint64_t x_first, uint64_t x_last);
+
+NS_KERNELS_AVX512 static void
+ns_kernels_avx512_divergence_row(double *div, double *p, const double *u, const double *v,
+                                 uint64_t pitch, double h, uint64_t width);
+
+NS_KERNELS_AVX512 static void
+ns_kernels_avx512_gradient_row(double *u, double *v, const double *p, uint64_t pitch, double h, uint64_t width);
+
+NS_KERNELS_AVX512 static void
+ns_kernels_avx512_advect_row(double *d, const double *u, const double *v, const ns_kernels_advect_t *advect,
+                             uint64_t x, uint64_t y, uint64_t width);
+
+NS_KERNELS_AVX512 static inline __m512d ns_kernels_avx512_even(const double *cells);
+
+NS_KERNELS_AVX512 static inline __m512d ns_kernels_avx512_west(const double *cells, __m512d *west, __m512d *east);
+
+NS_KERNELS_AVX512 static inline void ns_kernels_avx512_store_even(double *cells, __m512d even);
+#endif
+/**
+ * END Private definitions
+ */
+
+// Kernels of every instruction set
+static const ns_kernels_t kernels_scalar = {
+        .isa = NS_KERNELS_ISA_SCALAR,
+        .add_scaled = ns_kernels_scalar_add_scaled,
+        .diffuse_red_black_row = ns_kernels_scalar_diffuse_red_black_row,
+        .project_red_black_row = ns_kernels_scalar_project_red_black_row,
+        .divergence_row = ns_kernels_scalar_divergence_row,
+        .gradient_row = ns_kernels_scalar_gradient_row,
+        .advect_row = ns_kernels_scalar_advect_row
+};
+
+#if NS_KERNELS_X86
+static const ns_kernels_t kernels_avx2 = {
+        .isa = NS_KERNELS_ISA_AVX2,
+        .add_scaled = ns_kernels_avx2_add_scaled,
+        .diffuse_red_black_row = ns_kernels_avx2_diffuse_red_black_row,
+        .project_red_black_row = ns_kernels_avx2_project_red_black_row,
+        .divergence_row = ns_kernels_avx2_divergence_row,
+        .gradient_row = ns_kernels_avx2_gradient_row,
+        .advect_row = ns_kernels_avx2_advect_row
+};
+
+static const ns_kernels_t kernels_avx512 = {
+        .isa = NS_KERNELS_ISA_AVX512,
+        .add_scaled = ns_kernels_avx512_add_scaled,
+        .diffuse_red_black_row = ns_kernels_avx512_diffuse_red_black_row,
+        .project_red_black_row = ns_kernels_avx512_project_red_black_row,
+        .divergence_row = ns_kernels_avx512_divergence_row,
+        .gradient_row = ns_kernels_avx512_gradient_row,
+        .advect_row = ns_kernels_avx512_advect_row
+};
+#endif
+
+/**
+ * Public
+ */
+const char *ns_kernels_isa_string(ns_kernels_isa_t isa) {
+    if (isa < NS_KERNELS_ISA_SCALAR || isa > NS_KERNELS_ISA_AVX512) return NULL;
+
+    return isa_strings[isa];
+}
+
+int ns_kernels_isa_int(const char *const isa) {
+    if (isa == NULL) return -1;
+
+    for (int i = NS_KERNELS_ISA_SCALAR; i <= NS_KERNELS_ISA_AVX512; ++i) {
+        if (strcmp(isa, isa_strings[i]) == 0) return i;
+    }
+
+    return -1;
+}
+
+const ns_kernels_t *ns_kernels_get(ns_kernels_isa_t isa) {
+#if NS_KERNELS_X86
+    __builtin_cpu_init();
+#endif
+
+    switch (isa) {
+        case NS_KERNELS_ISA_SCALAR:
+            return &kernels_scalar;
+#if NS_KERNELS_X86
+        case NS_KERNELS_ISA_AVX2:
+            return __builtin_cpu_supports("avx2") ? &kernels_avx2 : NULL;
+        case NS_KERNELS_ISA_AVX512:
+            return __builtin_cpu_supports("avx512f") ? &kernels_avx512 : NULL;
+#endif
+        default:
+            return NULL;
+    }
+}
+
+const ns_kernels_t *ns_kernels_best(void) {
+    for (int isa = NS_KERNELS_ISA_AVX512; isa > NS_KERNELS_ISA_SCALAR; --isa) {
+        const ns_kernels_t *kernels = ns_kernels_get((ns_kernels_isa_t) isa);
+
+        if (kernels != NULL) return kernels;
+    }
+
+    return &kernels_scalar;
+}
+/**
+ * END Public
+ */
+
+/**
+ * Private
+ */
+static inline void
+ns_kernels_advect_cell(ns_real_t *d, const ns_real_t *u, const ns_real_t *v, const ns_kernels_advect_t *advect,
+                       uint64_t x, uint64_t y, uint64_t i) {
+    uint64_t x0, y0;
+    ns_real_t xx, yy, s0, s1, t0, t1;
+    const ns_real_t *w0, *w1;
+
+    xx = (ns_real_t) (x + i) - advect->dt0_width * u[i];
+    yy = (ns_real_t) y - advect->dt0_height * v[i];
+
+    // Check xx
+    if (xx < NS_REAL(0.5))
+        xx = NS_REAL(0.5);
+    if (xx > (ns_real_t) advect->world_width + NS_REAL(0.5))
+        xx = (ns_real_t) advect->world_width + NS_REAL(0.5);
+    x0 = (uint64_t) xx;
+
+    // Check yy
+    if (yy < NS_REAL(0.5))
+        yy = NS_REAL(0.5);
+    if (yy > (ns_real_t) advect->world_height + NS_REAL(0.5))
+        yy = (ns_real_t) advect->world_height + NS_REAL(0.5);
+    y0 = (uint64_t) yy;
+
+    s1 = xx - (ns_real_t) x0;
+    s0 = 1 - s1;
+    t1 = yy - (ns_real_t) y0;
+    t0 = 1 - t1;
+
+    w0 = &advect->window[(y0 - advect->window_y) * advect->window_pitch + x0 - advect->window_x];
+    w1 = w0 + advect->window_pitch;
+    d[i] = s0 * (t0 * w0[0] + t1 * w1[0]) + s1 * (t0 * w0[1] + t1 * w1[1]);
+}
+
+static inline uint64_t ns_kernels_head(const double *cells, uint64_t alignment, uint64_t n) {
+    // Cells before the first one aligned to alignment bytes, so that vector stores do not split cache lines
+    const uint64_t head = (alignment - (uint64_t) (uintptr_t) cells % alignment) % alignment / sizeof(double);
+
+    return head < n ? head : n;
+}
+
+static void ns_kernels_scalar_add_scaled(ns_real_t *target, const ns_real_t *source, ns_real_t factor, uint64_t n) {
+    for (uint64_t i = 0; i < n; ++i) {
+        target[i] += factor * source[i];
+    }
+}
+
+static void ns_kernels_scalar_diffuse_red_black_row(ns_real_t *row, const ns_real_t *source_row, uint64_t pitch,
+                                                    ns_real_t a, uint64_t x_first, uint64_t x_last) {
+    for (uint64_t x = x_first; x <= x_last; x += 2) {
+        row[x] = (source_row[x] + a * (row[x - 1] + row[x + 1] + row[x - pitch] + row[x + pitch]))
+                 / (1 + 4 * a);
+    }
+}
+
+static void ns_kernels_scalar_project_red_black_row(ns_real_t *p, const ns_real_t *div, uint64_t pitch,
+                                                    uint64_t x_first, uint64_t x_last) {
+    for (uint64_t x = x_first; x <= x_last; x += 2) {
+        p[x] = (div[x] + p[x - 1] + p[x + 1] + p[x - pitch] + p[x + pitch]) / 4;
+    }
+}
+
+static void ns_kernels_scalar_divergence_row(ns_real_t *div, ns_real_t *p, const ns_real_t *u, const ns_real_t *v,
+                                             uint64_t pitch, ns_real_t h, uint64_t width) {
+    for (uint64_t x = 1; x <= width; ++x) {
+        div[x] = NS_REAL(-0.5) * h * (u[x + 1] - u[x - 1] + v[x + pitch] - v[x - pitch]);
+        p[x] = 0;
+    }
+}
+
+static void ns_kernels_scalar_gradient_row(ns_real_t *u, ns_real_t *v, const ns_real_t *p, uint64_t pitch,
+                                           ns_real_t h, uint64_t width) {
+    for (uint64_t x = 1; x <= width; ++x) {
+        u[x] -= NS_REAL(0.5) * (p[x + 1] - p[x - 1]) / h;
+        v[x] -= NS_REAL(0.5) * (p[x + pitch] - p[x - pitch]) / h;
+    }
+}
+
+static void ns_kernels_scalar_advect_row(ns_real_t *d, const ns_real_t *u, const ns_real_t *v,
+                                         const ns_kernels_advect_t *advect, uint64_t x, uint64_t y, uint64_t width) {
+    for (uint64_t i = 1; i <= width; ++i) {
+        ns_kernels_advect_cell(d, u, v, advect, x, y, i);
+    }
+}
+
+#if NS_KERNELS_X86
+NS_KERNELS_AVX2 static void
+ns_kernels_avx2_add_scaled(double *target, const double *source, double factor, uint64_t n) {
+    const __m256d f = _mm256_set1_pd(factor);
+    uint64_t i = ns_kernels_head(target, 32, n);
+
+    ns_kernels_scalar_add_scaled(target, source, factor, i);
+
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(&target[i], _mm256_add_pd(_mm256_loadu_pd(&target[i]),
+                                                   _mm256_mul_pd(f, _mm256_loadu_pd(&source[i]))));
+    }
+    for (; i < n; ++i) {
+        target[i] += factor * source[i];
+    }
+}
+
+NS_KERNELS_AVX2 static void
+ns_kernels_avx2_diffuse_red_black_row(double *row, const double *source_row, uint64_t pitch, double a,
+                                      uint64_t x_first, uint64_t x_last) {
+    const __m256d va = _mm256_set1_pd(a);
+    const __m256d denominator = _mm256_set1_pd(1 + 4 * a);
+    __m256d west = _mm256_set1_pd(row[x_first - 1]);
+    __m256d east;
+    uint64_t x = x_first;
+
+    // Four cells of the color out of eight
+    for (; x + 7 <= x_last; x += 8) {
+        const __m256d w = ns_kernels_avx2_west(&row[x], &west, &east);
+        const __m256d neighbours = _mm256_add_pd(_mm256_add_pd(
+                _mm256_add_pd(w, east), ns_kernels_avx2_even(&row[x - pitch])),
+                                                 ns_kernels_avx2_even(&row[x + pitch]));
+
+        ns_kernels_avx2_store_even(&row[x], _mm256_div_pd(
+                _mm256_add_pd(ns_kernels_avx2_even(&source_row[x]), _mm256_mul_pd(va, neighbours)), denominator));
+    }
+    ns_kernels_scalar_diffuse_red_black_row(row, source_row, pitch, a, x, x_last);
+}
+
+NS_KERNELS_AVX2 static void
+ns_kernels_avx2_project_red_black_row(double *p, const double *div, uint64_t pitch,
+                                      uint64_t x_first, uint64_t x_last) {
+    const __m256d four = _mm256_set1_pd(4);
+    __m256d west = _mm256_set1_pd(p[x_first - 1]);
+    __m256d east;
+    uint64_t x = x_first;
+
+    // Four cells of the color out of eight
+    for (; x + 7 <= x_last; x += 8) {
+        const __m256d w = ns_kernels_avx2_west(&p[x], &west, &east);
+        const __m256d sum = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(
+                _mm256_add_pd(ns_kernels_avx2_even(&div[x]), w), east),
+                                                        ns_kernels_avx2_even(&p[x - pitch])),
+                                          ns_kernels_avx2_even(&p[x + pitch]));
+
+        ns_kernels_avx2_store_even(&p[x], _mm256_div_pd(sum, four));
+    }
+    ns_kernels_scalar_project_red_black_row(p, div, pitch, x, x_last);
+}
+
+NS_KERNELS_AVX2 static void
+ns_kernels_avx2_divergence_row(double *div, double *p, const double *u, const double *v,
+                               uint64_t pitch, double h, uint64_t width) {
+    const __m256d factor = _mm256_set1_pd(-0.5 * h);
+    const __m256d zero = _mm256_setzero_pd();
+    uint64_t x = 1 + ns_kernels_head(&div[1], 32, width);
+
+    ns_kernels_scalar_divergence_row(div, p, u, v, pitch, h, x - 1);
+
+    for (; x + 3 <= width; x += 4) {
+        const __m256d difference = _mm256_sub_pd(_mm256_add_pd(
+                _mm256_sub_pd(_mm256_loadu_pd(&u[x + 1]), _mm256_loadu_pd(&u[x - 1])),
+                _mm256_loadu_pd(&v[x + pitch])), _mm256_loadu_pd(&v[x - pitch]));
+
+        _mm256_storeu_pd(&div[x], _mm256_mul_pd(factor, difference));
+        _mm256_storeu_pd(&p[x], zero);
+    }
+    ns_kernels_scalar_divergence_row(&div[x - 1], &p[x - 1], &u[x - 1], &v[x - 1], pitch, h, width + 1 - x);
+}
+
+NS_KERNELS_AVX2 static void
+ns_kernels_avx2_gradient_row(double *u, double *v, const double *p, uint64_t pitch, double h, uint64_t width) {
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d vh = _mm256_set1_pd(h);
+    uint64_t x = 1 + ns_kernels_head(&u[1], 32, width);
+
+    ns_kernels_scalar_gradient_row(u, v, p, pitch, h, x - 1);
+
+    for (; x + 3 <= width; x += 4) {
+        const __m256d gradient_x = _mm256_div_pd(_mm256_mul_pd(half, _mm256_sub_pd(
+                _mm256_loadu_pd(&p[x + 1]), _mm256_loadu_pd(&p[x - 1]))), vh);
+        const __m256d gradient_y = _mm256_div_pd(_mm256_mul_pd(half, _mm256_sub_pd(
+                _mm256_loadu_pd(&p[x + pitch]), _mm256_loadu_pd(&p[x - pitch]))), vh);
+
+        _mm256_storeu_pd(&u[x], _mm256_sub_pd(_mm256_loadu_pd(&u[x]), gradient_x));
+        _mm256_storeu_pd(&v[x], _mm256_sub_pd(_mm256_loadu_pd(&v[x]), gradient_y));
+    }
+    ns_kernels_scalar_gradient_row(&u[x - 1], &v[x - 1], &p[x - 1], pitch, h, width + 1 - x);
+}
+
+NS_KERNELS_AVX2 static void
+ns_kernels_avx2_advect_row(double *d, const double *u, const double *v, const ns_kernels_advect_t *advect,
+                           uint64_t x, uint64_t y, uint64_t width) {
+    const __m256d dt0_width = _mm256_set1_pd(advect->dt0_width);
+    const __m256d dt0_height = _mm256_set1_pd(advect->dt0_height);
+    const __m256d lanes = _mm256_setr_pd(0, 1, 2, 3);
+    const __m256d one = _mm256_set1_pd(1);
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d x_max = _mm256_set1_pd((double) advect->world_width + 0.5);
+    const __m256d y_max = _mm256_set1_pd((double) advect->world_height + 0.5);
+    const __m256d gy = _mm256_set1_pd((double) y);
+    __m128i window_x, window_y, window_pitch, one_i;
+    uint64_t i = 1;
+
+    // Gather indices are 32 bit
+    if (advect->window_size <= INT32_MAX && advect->world_width < INT32_MAX && advect->world_height < INT32_MAX) {
+        window_x = _mm_set1_epi32((int) advect->window_x);
+        window_y = _mm_set1_epi32((int) advect->window_y);
+        window_pitch = _mm_set1_epi32((int) advect->window_pitch);
+        one_i = _mm_set1_epi32(1);
+
+        for (; i + 3 <= width; i += 4) {
+            __m256d xx = _mm256_sub_pd(_mm256_add_pd(_mm256_set1_pd((double) (x + i)), lanes),
+                                       _mm256_mul_pd(dt0_width, _mm256_loadu_pd(&u[i])));
+            __m256d yy = _mm256_sub_pd(gy, _mm256_mul_pd(dt0_height, _mm256_loadu_pd(&v[i])));
+            __m128i x0, y0, i00, i01;
+            __m256d s0, s1, t0, t1, d0, d1;
+
+            xx = _mm256_min_pd(_mm256_max_pd(xx, half), x_max);
+            yy = _mm256_min_pd(_mm256_max_pd(yy, half), y_max);
+            x0 = _mm256_cvttpd_epi32(xx);
+            y0 = _mm256_cvttpd_epi32(yy);
+
+            s1 = _mm256_sub_pd(xx, _mm256_cvtepi32_pd(x0));
+            s0 = _mm256_sub_pd(one, s1);
+            t1 = _mm256_sub_pd(yy, _mm256_cvtepi32_pd(y0));
+            t0 = _mm256_sub_pd(one, t1);
+
+            i00 = _mm_add_epi32(_mm_mullo_epi32(_mm_sub_epi32(y0, window_y), window_pitch),
+                                _mm_sub_epi32(x0, window_x));
+            i01 = _mm_add_epi32(i00, window_pitch);
+
+            d0 = _mm256_add_pd(_mm256_mul_pd(t0, _mm256_i32gather_pd(advect->window, i00, 8)),
+                               _mm256_mul_pd(t1, _mm256_i32gather_pd(advect->window, i01, 8)));
+            d1 = _mm256_add_pd(_mm256_mul_pd(t0, _mm256_i32gather_pd(advect->window, _mm_add_epi32(i00, one_i), 8)),
+                               _mm256_mul_pd(t1, _mm256_i32gather_pd(advect->window, _mm_add_epi32(i01, one_i), 8)));
+            _mm256_storeu_pd(&d[i], _mm256_add_pd(_mm256_mul_pd(s0, d0), _mm256_mul_pd(s1, d1)));
+        }
+    }
+    for (; i <= width; ++i) {
+        ns_kernels_advect_cell(d, u, v, advect, x, y, i);
+    }
+}
+
+NS_KERNELS_AVX2 static inline __m256d ns_kernels_avx2_even(const double *cells) {
+    // Cells 0, 4, 2 and 6, every vector of a color is kept in this order
+    return _mm256_unpacklo_pd(_mm256_loadu_pd(cells), _mm256_loadu_pd(&cells[4]));
+}
+
+NS_KERNELS_AVX2 static inline __m256d ns_kernels_avx2_west(const double *cells, __m256d *west, __m256d *east) {
+    // East neighbours are cells 1, 5, 3 and 7, west neighbours cells -1, 3, 1 and 5
+    const __m256d odd = _mm256_unpackhi_pd(_mm256_loadu_pd(cells), _mm256_loadu_pd(&cells[4]));
+    const __m256d rotated = _mm256_permute4x64_pd(odd, _MM_SHUFFLE(1, 0, 2, 3));
+    // Cell -1 is cell 7 of the previous cells, carried in a register to avoid reloading a just stored line
+    const __m256d result = _mm256_blend_pd(rotated, *west, 0x1);
+
+    *west = rotated;
+    *east = odd;
+
+    return result;
+}
+
+NS_KERNELS_AVX2 static inline void ns_kernels_avx2_store_even(double *cells, __m256d even) {
+    // Odd cells belong to the other color and are not written
+    const __m256i mask = _mm256_setr_epi64x(-1, 0, -1, 0);
+
+    _mm256_maskstore_pd(cells, mask, _mm256_unpacklo_pd(even, even));
+    _mm256_maskstore_pd(&cells[4], mask, _mm256_unpackhi_pd(even, even));
+}
+
+NS_KERNELS_AVX512 static void
+ns_kernels_avx512_add_scaled(double *target, const double *source, double factor, uint64_t n) {
+    const __m512d f = _mm512_set1_pd(factor);
+    uint64_t i = ns_kernels_head(target, 64, n);
+
+    ns_kernels_scalar_add_scaled(target, source, factor, i);
+
+    for (; i + 8 <= n; i += 8) {
+        _mm512_storeu_pd(&target[i], _mm512_add_pd(_mm512_loadu_pd(&target[i]),
+                                                   _mm512_mul_pd(f, _mm512_loadu_pd(&source[i]))));
+    }
+    for (; i < n; ++i) {
+        target[i] += factor * source[i];
+    }
+}
+
+NS_KERNELS_AVX512 static void
+ns_kernels_avx512_diffuse_red_black_row(double *row, const double *source_row, uint64_t pitch, double a,
+                                        uint64_t x_first, uint64_t x_last) {
+    const __m512d va = _mm512_set1_pd(a);
+    const __m512d denominator = _mm512_set1_pd(1 + 4 * a);
+    __m512d west = _mm512_set1_pd(row[x_first - 1]);
+    __m512d east;
+    uint64_t x = x_first;
+
+    // Eight cells of the color out of sixteen
+    for (; x + 15 <= x_last; x += 16) {
+        const __m512d w = ns_kernels_avx512_west(&row[x], &west, &east);
+        const __m512d neighbours = _mm512_add_pd(_mm512_add_pd(
+                _mm512_add_pd(w, east), ns_kernels_avx512_even(&row[x - pitch])),
+                                                 ns_kernels_avx512_even(&row[x + pitch]));
+
+        ns_kernels_avx512_store_even(&row[x], _mm512_div_pd(
+                _mm512_add_pd(ns_kernels_avx512_even(&source_row[x]), _mm512_mul_pd(va, neighbours)), denominator));
+    }
+    ns_kernels_scalar_diffuse_red_black_row(row, source_row, pitch, a, x, x_last);
+}
+
+NS_KERNELS_AVX512 static void
+ns_kernels_avx512_project_red_black_row(double *p, const double *div, uint64_t pitch,
+                                        uint64_t x_first, uint64_t x_last) {
+    const __m512d four = _mm512_set1_pd(4);
+    __m512d west = _mm512_set1_pd(p[x_first - 1]);
+    __m512d east;
+    uint64_t x = x_first;
+
+    // Eight cells of the color out of sixteen
+    for (; x + 15 <= x_last; x += 16) {
+        const __m512d w = ns_kernels_avx512_west(&p[x], &west, &east);
+        const __m512d sum = _mm512_add_pd(_mm512_add_pd(_mm512_add_pd(
+                _mm512_add_pd(ns_kernels_avx512_even(&div[x]), w), east),
+                                                        ns_kernels_avx512_even(&p[x - pitch])),
+                                          ns_kernels_avx512_even(&p[x + pitch]));
+
+        ns_kernels_avx512_store_even(&p[x], _mm512_div_pd(sum, four));
+    }
+    ns_kernels_scalar_project_red_black_row(p, div, pitch, x, x_last);
+}
+
+NS_KERNELS_AVX512 static void
+ns_kernels_avx512_divergence_row(double *div, double *p, const double *u, const double *v,
+                                 uint64_t pitch, double h, uint64_t width) {
+    const __m512d factor = _mm512_set1_pd(-0.5 * h);
+    const __m512d zero = _mm512_setzero_pd();
+    uint64_t x = 1 + ns_kernels_head(&div[1], 64, width);
+
+    ns_kernels_scalar_divergence_row(div, p, u, v, pitch, h, x - 1);
+
+    for (; x + 7 <= width; x += 8) {
+        const __m512d difference = _mm512_sub_pd(_mm512_add_pd(
+                _mm512_sub_pd(_mm512_loadu_pd(&u[x + 1]), _mm512_loadu_pd(&u[x - 1])),
+                _mm512_loadu_pd(&v[x + pitch])), _mm512_loadu_pd(&v[x - pitch]));
+
+        _mm512_storeu_pd(&div[x], _mm512_mul_pd(factor, difference));
+        _mm512_storeu_pd(&p[x], zero);
+    }
+    ns_kernels_scalar_divergence_row(&div[x - 1], &p[x - 1], &u[x - 1], &v[x - 1], pitch, h, width + 1 - x);
+}
+
+NS_KERNELS_AVX512 static void
+ns_kernels_avx512_gradient_row(double *u, double *v, const double *p, uint64_t pitch, double h, uint64_t width) {
+    const __m512d half = _mm512_set1_pd(0.5);
+    const __m512d vh = _mm512_set1_pd(h);
+    uint64_t x = 1 + ns_kernels_head(&u[1], 64, width);
+
+    ns_kernels_scalar_gradient_row(u, v, p, pitch, h, x - 1);
+
+    for (; x + 7 <= width; x += 8) {
+        const __m512d gradient_x = _mm512_div_pd(_mm512_mul_pd(half, _mm512_sub_pd(
+                _mm512_loadu_pd(&p[x + 1]), _mm512_loadu_pd(&p[x - 1]))), vh);
+        const __m512d gradient_y = _mm512_div_pd(_mm512_mul_pd(half, _mm512_sub_pd(
+                _mm512_loadu_pd(&p[x + pitch]), _mm512_loadu_pd(&p[x - pitch]))), vh);
+
+        _mm512_storeu_pd(&u[x], _mm512_sub_pd(_mm512_loadu_pd(&u[x]), gradient_x));
+        _mm512_storeu_pd(&v[x], _mm512_sub_pd(_mm512_loadu_pd(&v[x]), gradient_y));
+    }
+    ns_kernels_scalar_gradient_row(&u[x - 1], &v[x - 1], &p[x - 1], pitch, h, width + 1 - x);
+}
+
+NS_KERNELS_AVX512 static void
+ns_kernels_avx512_advect_row(double *d, const double *u, const double *v, const ns_kernels_advect_t *advect,
+                             uint64_t x, uint64_t y, uint64_t width) {
+    const __m512d dt0_width = _mm512_set1_pd(advect->dt0_width);
+    const __m512d dt0_height = _mm512_set1_pd(advect->dt0_height);
+    const __m512d lanes = _mm512_setr_pd(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m512d one = _mm512_set1_pd(1);
+    const __m512d half = _mm512_set1_pd(0.5);
+    const __m512d x_max = _mm512_set1_pd((double) advect->world_width + 0.5);
+    const __m512d y_max = _mm512_set1_pd((double) advect->world_height + 0.5);
+    const __m512d gy = _mm512_set1_pd((double) y);
+    __m256i window_x, window_y, window_pitch, one_i;
+    uint64_t i = 1;
+
+    // Gather indices are 32 bit
+    if (advect->window_size <= INT32_MAX && advect->world_width < INT32_MAX && advect->world_height < INT32_MAX) {
+        window_x = _mm256_set1_epi32((int) advect->window_x);
+        window_y = _mm256_set1_epi32((int) advect->window_y);
+        window_pitch = _mm256_set1_epi32((int) advect->window_pitch);
+        one_i = _mm256_set1_epi32(1);
+
+        for (; i + 7 <= width; i += 8) {
+            __m512d xx = _mm512_sub_pd(_mm512_add_pd(_mm512_set1_pd((double) (x + i)), lanes),
+                                       _mm512_mul_pd(dt0_width, _mm512_loadu_pd(&u[i])));
+            __m512d yy = _mm512_sub_pd(gy, _mm512_mul_pd(dt0_height, _mm512_loadu_pd(&v[i])));
+            __m256i x0, y0, i00, i01;
+            __m512d s0, s1, t0, t1, d0, d1;
+
+            xx = _mm512_min_pd(_mm512_max_pd(xx, half), x_max);
+            yy = _mm512_min_pd(_mm512_max_pd(yy, half), y_max);
+            x0 = _mm512_cvttpd_epi32(xx);
+            y0 = _mm512_cvttpd_epi32(yy);
+
+            s1 = _mm512_sub_pd(xx, _mm512_cvtepi32_pd(x0));
+            s0 = _mm512_sub_pd(one, s1);
+            t1 = _mm512_sub_pd(yy, _mm512_cvtepi32_pd(y0));
+            t0 = _mm512_sub_pd(one, t1);
+
+            i00 = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_sub_epi32(y0, window_y), window_pitch),
+                                   _mm256_sub_epi32(x0, window_x));
+            i01 = _mm256_add_epi32(i00, window_pitch);
+
+            d0 = _mm512_add_pd(_mm512_mul_pd(t0, _mm512_i32gather_pd(i00, advect->window, 8)),
+                               _mm512_mul_pd(t1, _mm512_i32gather_pd(i01, advect->window, 8)));
+            d1 = _mm512_add_pd(
+                    _mm512_mul_pd(t0, _mm512_i32gather_pd(_mm256_add_epi32(i00, one_i), advect->window, 8)),
+                    _mm512_mul_pd(t1, _mm512_i32gather_pd(_mm256_add_epi32(i01, one_i), advect->window, 8)));
+            _mm512_storeu_pd(&d[i], _mm512_add_pd(_mm512_mul_pd(s0, d0), _mm512_mul_pd(s1, d1)));
+        }
+    }
+    for (; i <= width; ++i) {
+        ns_kernels_advect_cell(d, u, v, advect, x, y, i);
+    }
+}
+
+NS_KERNELS_AVX512 static inline __m512d ns_kernels_avx512_even(const double *cells) {
+    // Cells 0, 8, 2, 10, 4, 12, 6 and 14, every vector of a color is kept in this order
+    return _mm512_unpacklo_pd(_mm512_loadu_pd(cells), _mm512_loadu_pd(&cells[8]));
+}
+
+NS_KERNELS_AVX512 static inline __m512d ns_kernels_avx512_west(const double *cells, __m512d *west, __m512d *east) {
+    // East neighbours are cells 1, 9, 3, 11, 5, 13, 7 and 15, west neighbours cells -1, 7, 1, 9, 3, 11, 5 and 13
+    const __m512i order = _mm512_setr_epi64(7, 6, 0, 1, 2, 3, 4, 5);
+    const __m512d odd = _mm512_unpackhi_pd(_mm512_loadu_pd(cells), _mm512_loadu_pd(&cells[8]));
+    const __m512d rotated = _mm512_permutexvar_pd(order, odd);
+    // Cell -1 is cell 15 of the previous cells, carried in a register to avoid reloading a just stored line
+    const __m512d result = _mm512_mask_blend_pd(0x1, rotated, *west);
+
+    *west = rotated;
+    *east = odd;
+
+    return result;
+}
+
+NS_KERNELS_AVX512 static inline void ns_kernels_avx512_store_even(double *cells, __m512d even) {
+    // Odd cells belong to the other color and are not written
+    _mm512_mask_storeu_pd(cells, 0x55, _mm512_unpacklo_pd(even, even));
+    _mm512_mask_storeu_pd(&cells[8], 0x55, _mm512_unpackhi_pd(even, even));
+}
+#endif
+
+/**
+ * END Private
+ */
@@ -1,21 +1,49 @@
 #include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/stat.h>
 #include <mpi.h>
 #include <argparse.h>
 #include <dirent.h>
 #include "ns/config.h"
 #include "ns/nodes/master.h"
 #include "ns/nodes/worker.h"
+#include "ns/nodes/submaster.h"
+#include "ns/nodes/com/message.h"
 #include "ns/utils/logger.h"
 #include "ns/utils/time_measurement.h"
+#include "ns/utils/snapshot.h"
+
+// File name of the container in the results folder
+#define CONTAINER_FILE_NAME "results.nsc"
+// Name of the cache folder in the results folder
+#define CACHE_FOLDER_NAME "cache"
 
 static const char *description = "\n" PROJECT_DESCRIPTION "\n\tv." PROJECT_VERSION;
 static const char *epilog = "\n© Carlo Corradini & Massimiliano Fronza";
 static const char *const usage[] = {
+        "mpiexec -np 1 ./navierstokes --simulations=./simulations.json --results=./results",
         "mpiexec -np 2 ./navierstokes --simulations=./simulations.json --results=./results",
         "mpiexec -np 2 ./navierstokes --simulations=./simulations.json --results=./results --colors",
         "mpiexec -np 2 ./navierstokes --simulations=./simulations.json --results=./results --loglevel=DEBUG",
         "mpiexec -np 2 ./navierstokes --simulations=./simulations.json --results=./results --colors --loglevel=DEBUG",
+        "mpiexec -np 2 ./navierstokes --simulations=./simulations.json --results=./results --validate=./reference",
+        "mpiexec -np 2 ./navierstokes --simulations=./simulations.json --results=./results --format=binary",
+        "mpiexec -np 2 ./navierstokes --simulations=./simulations.json --results=./results --format=binary "
+        "--compression=lossy --tolerance=1e-6",
+        "mpiexec -np 2 ./navierstokes --simulations=./simulations.json --results=./results --container",
+        "mpiexec -np 8 ./navierstokes --simulations=./simulations.json --results=./results --balance-nodes",
+        "mpiexec -np 256 ./navierstokes --simulations=./simulations.json --results=./results --node-masters",
+        "mpiexec -np 64 ./navierstokes --simulations=./simulations.json --results=./results --deadline=4",
+        "mpiexec -np 64 ./navierstokes --simulations=./simulations.json --results=./results "
+        "--checkpoints=./checkpoints --checkpoint-interval=600",
+        "mpiexec -np 64 ./navierstokes --simulations=./simulations.json --results=./results "
+        "--checkpoints=./checkpoints --resume",
+        "mpiexec -np 64 ./navierstokes --simulations=./simulations.json --results=./results --cache",
+        "mpiexec -np 64 ./navierstokes --simulations=./simulations.json --results=./results --stream",
         NULL
 };
 
@@ -23,12 +51,38 @@ static const char *const usage[] = {
 static struct {
     char *simulations;
     char *results;
+    char *validate;
+    char *format;
+    char *compression;
+    char *tolerance;
+    char *deadline;
+    char *checkpoints;
+    char *checkpoint_interval;
     char *loglevel;
+    bool container;
+    bool cache;
+    bool stream;
+    bool resume;
+    bool balance_nodes;
+    bool node_masters;
     bool colors;
 } args = {
         .simulations = NULL,
         .results = NULL,
+        .validate = NULL,
+        .format = "json",
+        .compression = "none",
+        .tolerance = NULL,
+        .deadline = NULL,
+        .checkpoints = NULL,
+        .checkpoint_interval = "300",
         .loglevel = "INFO",
+        .container = false,
+        .cache = false,
+        .stream = false,
+        .resume = false,
+        .balance_nodes = false,
+        .node_masters = false,
         .colors = false,
 };
 
@@ -36,12 +90,25 @@ static void make_args(int argc, const char **argv);
 
 static bool check_args(void);
 
+static double string_double(const char *value);
+
+static char *results_file_path(const char *name);
+
 int main(int argc, const char **argv) {
     make_args(argc, argv);
     int rank;
     int size;
+    int thread_level;
+    int exit_code = EXIT_SUCCESS;
+    uint64_t job = 0;
+    char *container = NULL;
+    char *cache = NULL;
+    int *nodes = NULL;
+    MPI_Comm master_comm;
+    MPI_Comm container_comm;
 
-    MPI_Init(NULL, NULL);
+    // Workers save snapshots with an I/O thread that calls MPI, the master computes beside its dispatching thread
+    MPI_Init_thread(NULL, NULL, MPI_THREAD_MULTIPLE, &thread_level);
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
 
@@ -50,23 +117,82 @@ int main(int argc, const char **argv) {
     log_set_colors(args.colors);
 
     if (!check_args()) MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
-    if (size < 2) {
-        log_error("At least two processes are required, %d given", size);
+    if (args.node_masters && thread_level != MPI_THREAD_MULTIPLE) {
+        log_error("`node-masters` argument requires MPI multiple threads support");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    if (args.container) {
+        container = results_file_path(CONTAINER_FILE_NAME);
+        if (container == NULL) {
+            log_error("Unable to allocate container path");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+    }
+    if (args.cache) {
+        cache = results_file_path(CACHE_FOLDER_NAME);
+        if (cache == NULL) {
+            log_error("Unable to allocate cache path");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+    }
+
+    // Node of every rank, the lowest rank of a node is its sub-master
+    nodes = (int *) calloc((size_t) size, sizeof(int));
+    if (nodes == NULL) {
+        log_error("Unable to allocate nodes");
         MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
     }
+    com_gather_nodes(nodes);
+
+    // Files of the checkpoints of this job never collide with the ones of the interrupted jobs
+    if (rank == 0) job = (uint64_t) time(NULL);
+    // The cache folder exists before any rank uses it
+    if (rank == 0 && cache != NULL && mkdir(cache, 0755) != 0 && errno != EEXIST) {
+        log_error("Unable to create cache folder %s", cache);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    MPI_Bcast(&job, 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+
+    // Messages to the master travel apart, its rank receives the tasks of its own worker too.
+    // With sub-masters the ones to the master travel apart from the ones to the sub-master of its node
+    MPI_Comm_dup(MPI_COMM_WORLD, &master_comm);
+    if (args.node_masters) MPI_Comm_dup(MPI_COMM_WORLD, &container_comm);
+    else container_comm = master_comm;
+    node_worker_args_t worker_args = {.simulations_path = args.stream ? args.simulations : NULL,
+            .results_path = args.results, .validate_path = args.validate,
+            .format = (snapshot_format_t) snapshot_format_int(args.format),
+            .compression = (snapshot_compression_t) snapshot_compression_int(args.compression),
+            .tolerance = string_double(args.tolerance), .container_path = container,
+            .checkpoint_path = args.checkpoints, .checkpoint_interval = string_double(args.checkpoint_interval),
+            .resume = args.resume, .job = job, .cache_path = cache, .master_rank = args.node_masters ? nodes[rank] : 0,
+            .master_comm = master_comm, .container_comm = container_comm, .local = NULL};
 
     if (rank == 0) {
-        // Master
+        // Master, with a single process it is a local batch runner
         time_measurement_t time;
-        node_master_args_t master_args = {.simulations_path = args.simulations};
+        node_master_args_t master_args = {.simulations_path = args.simulations, .stream = args.stream,
+                .container_path = container,
+                .checkpoint_path = args.checkpoints, .resume = args.resume, .cache_path = cache,
+                .balance_nodes = args.balance_nodes,
+                .node_masters = args.node_masters, .deadline = string_double(args.deadline), .nodes = nodes,
+                .master_comm = master_comm, .container_comm = container_comm, .worker_args = &worker_args};
 
         time_measurement_start(&time);
-        do_master(&master_args);
+        if (!do_master(&master_args)) exit_code = EXIT_FAILURE;
         time_measurement_stop_and_print(&time, "Master execution time");
+    } else if (args.node_masters && nodes[rank] == rank) {
+        // Sub-master
+        time_measurement_t time;
+        node_submaster_args_t submaster_args = {.nodes = nodes, .container_path = container,
+                .master_comm = master_comm, .container_comm = container_comm, .worker_args = &worker_args,
+                .local = NULL};
+
+        time_measurement_start(&time);
+        do_submaster(&submaster_args);
+        time_measurement_stop_and_print(&time, "Sub-master execution time");
     } else {
         // Worker
         time_measurement_t time;
-        node_worker_args_t worker_args = {.results_path = args.results};
 
         time_measurement_start(&time);
         do_worker(&worker_args);
@@ -74,9 +200,14 @@ int main(int argc, const char **argv) {
     }
 
     log_info("Terminating...");
+    if (args.node_masters) MPI_Comm_free(&container_comm);
+    MPI_Comm_free(&master_comm);
+    free(nodes);
+    free(container);
+    free(cache);
     MPI_Finalize();
 
-    return EXIT_SUCCESS;
+    return exit_code;
 }
 
 static void make_args(int argc, const char **argv) {
@@ -87,6 +218,40 @@ static void make_args(int argc, const char **argv) {
             OPT_STRING(0, "simulations", &args.simulations, "Path to JSON simulations file", NULL, 0, OPT_NONEG),
             OPT_STRING(0, "results", &args.results, "Path to folder used to save JSON simulation results", NULL, 0,
                        OPT_NONEG),
+            OPT_STRING(0, "validate", &args.validate,
+                       "Path to folder of reference JSON simulation results to compare the results with", NULL, 0,
+                       OPT_NONEG),
+            OPT_STRING(0, "format", &args.format, "Format of the simulation results, `json` or `binary`. "
+                                                  "Default to `json`", NULL, 0, OPT_NONEG),
+            OPT_STRING(0, "compression", &args.compression, "Compression of the binary simulation results, `none`, "
+                                                            "`lossless` or `lossy`. Default to `none`", NULL, 0,
+                       OPT_NONEG),
+            OPT_STRING(0, "tolerance", &args.tolerance, "Absolute error tolerance of the `lossy` compression", NULL,
+                       0, OPT_NONEG),
+            OPT_BOOLEAN(0, "container", &args.container, "Save every simulation result in a single container file, "
+                                                         CONTAINER_FILE_NAME " in the results folder", NULL, 0,
+                        OPT_NONEG),
+            OPT_BOOLEAN(0, "cache", &args.cache, "Fetch the results of the simulations computed before from the cache "
+                                                 "folder " CACHE_FOLDER_NAME " in the results folder", NULL, 0,
+                        OPT_NONEG),
+            OPT_BOOLEAN(0, "stream", &args.stream, "Parse the simulations file while dispatching, the workers "
+                                                   "parse their simulations from it too", NULL, 0, OPT_NONEG),
+            OPT_BOOLEAN(0, "balance-nodes", &args.balance_nodes, "Dispatch the large simulations to the workers of "
+                                                                 "the least loaded nodes", NULL, 0, OPT_NONEG),
+            OPT_BOOLEAN(0, "node-masters", &args.node_masters, "Hand out batches of simulations to a sub-master on "
+                                                               "every node, which dispatches them to its workers",
+                        NULL, 0, OPT_NONEG),
+            OPT_STRING(0, "deadline", &args.deadline, "Dispatch again a simulation running longer than `deadline` "
+                                                      "times its predicted time, its worker is lost", NULL, 0,
+                       OPT_NONEG),
+            OPT_STRING(0, "checkpoints", &args.checkpoints, "Path to folder used to save checkpoints of the running "
+                                                            "simulations", NULL, 0, OPT_NONEG),
+            OPT_STRING(0, "checkpoint-interval", &args.checkpoint_interval, "Seconds between two checkpoints of a "
+                                                                            "simulation. Default to `300`", NULL, 0,
+                       OPT_NONEG),
+            OPT_BOOLEAN(0, "resume", &args.resume, "Skip the simulations completed by an interrupted run and "
+                                                   "restore the others from their last checkpoint", NULL, 0,
+                        OPT_NONEG),
             OPT_STRING(0, "loglevel", &args.loglevel, "Logger level. Default to `INFO`", NULL, 0, OPT_NONEG),
             OPT_BOOLEAN(0, "colors", &args.colors, "Enable logger output with colors", NULL, 0,
                         OPT_NONEG),
@@ -118,6 +283,111 @@ static bool check_args(void) {
         log_error("Results folder is invalid: %s", args.results);
         return false;
     }
+    // Validate
+    if (args.validate != NULL) {
+        if (args.validate[strlen(args.validate) - 1] == '/')
+            args.validate[strlen(args.validate) - 1] = '\0';
+        // Check if reference results directory exists
+        DIR *validate_dir = opendir(args.validate);
+        if (validate_dir) closedir(validate_dir);
+        else {
+            log_error("Reference results folder is invalid: %s", args.validate);
+            return false;
+        }
+    }
+    // Format
+    if (snapshot_format_int(args.format) == -1) {
+        log_error("`format` argument is invalid: %s", args.format);
+        return false;
+    }
+    if (args.validate != NULL && snapshot_format_int(args.format) != SNAPSHOT_FORMAT_JSON) {
+        log_error("`validate` argument requires the `%s` format", snapshot_format_string(SNAPSHOT_FORMAT_JSON));
+        return false;
+    }
+    // Compression
+    if (snapshot_compression_int(args.compression) == -1) {
+        log_error("`compression` argument is invalid: %s", args.compression);
+        return false;
+    }
+    if (snapshot_compression_int(args.compression) != SNAPSHOT_COMPRESSION_NONE
+        && snapshot_format_int(args.format) != SNAPSHOT_FORMAT_BINARY) {
+        log_error("`compression` argument requires the `%s` format", snapshot_format_string(SNAPSHOT_FORMAT_BINARY));
+        return false;
+    }
+    // Tolerance
+    if (snapshot_compression_int(args.compression) == SNAPSHOT_COMPRESSION_LOSSY
+        && !(string_double(args.tolerance) > 0)) {
+        log_error("`tolerance` argument missing or invalid, the `%s` compression requires a positive tolerance",
+                  snapshot_compression_string(SNAPSHOT_COMPRESSION_LOSSY));
+        return false;
+    }
+
+    // Deadline
+    if (args.deadline != NULL && !(string_double(args.deadline) > 0)) {
+        log_error("`deadline` argument is invalid: %s", args.deadline);
+        return false;
+    }
+    if (args.deadline != NULL && args.node_masters) {
+        log_error("`deadline` argument is not supported with sub-masters");
+        return false;
+    }
+
+    // Checkpoints
+    if (args.checkpoints != NULL) {
+        if (args.checkpoints[strlen(args.checkpoints) - 1] == '/')
+            args.checkpoints[strlen(args.checkpoints) - 1] = '\0';
+        // Check if checkpoints directory exists
+        DIR *checkpoints_dir = opendir(args.checkpoints);
+        if (checkpoints_dir) closedir(checkpoints_dir);
+        else {
+            log_error("Checkpoints folder is invalid: %s", args.checkpoints);
+            return false;
+        }
+    }
+    if (!(string_double(args.checkpoint_interval) > 0)) {
+        log_error("`checkpoint-interval` argument is invalid: %s", args.checkpoint_interval);
+        return false;
+    }
+    // Resume
+    if (args.resume && args.checkpoints == NULL) {
+        log_error("`resume` argument requires the `checkpoints` argument");
+        return false;
+    }
+    if (args.resume && args.container) {
+        log_error("`resume` argument is not supported with the container, an interrupted one has no table of "
+                  "contents");
+        return false;
+    }
+    // Cache
+    if (args.cache && args.container) {
+        log_error("`cache` argument is not supported with the container");
+        return false;
+    }
+    if (args.cache && args.validate != NULL) {
+        log_error("`cache` argument is not supported with `validate`, a validation belongs to its simulation id");
+        return false;
+    }
 
     return true;
 }
+
+static double string_double(const char *const value) {
+    char *end;
+    double number;
+
+    if (value == NULL) return 0;
+
+    number = strtod(value, &end);
+    if (end == value || *end != '\0') return 0;
+
+    return number;
+}
+
+static char *results_file_path(const char *const name) {
+    const size_t length = strlen(args.results) + 1 + strlen(name) + 1;
+    char *path = (char *) calloc(length, sizeof(char));
+    if (path == NULL) return NULL;
+
+    snprintf(path, length, "%s/%s", args.results, name);
+    return path;
+}
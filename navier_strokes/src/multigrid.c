@@ -0,0 +1,496 @@
+#include "ns/multigrid.h"
+#include "ns/config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Maximum number of levels
+#define NS_MULTIGRID_MAX_LEVELS 32
+// Minimum size of a coarse level dimension
+#define NS_MULTIGRID_COARSEST_SIZE 4
+// Smoothing sweeps before and after the coarse grid correction
+#define NS_MULTIGRID_PRE_SWEEPS 2
+#define NS_MULTIGRID_POST_SWEEPS 2
+// Relative residual reduction of the conjugate gradient solve on the coarsest level
+#define NS_MULTIGRID_COARSEST_TOLERANCE 1e-4
+// Level alignment in bytes (cache line)
+#define NS_MULTIGRID_ALIGNMENT 64
+// Level alignment in cells
+#define NS_MULTIGRID_ALIGNMENT_CELLS (NS_MULTIGRID_ALIGNMENT / sizeof(ns_real_t))
+
+// Index of cell (x, y) in a level field
+#define NS_MULTIGRID_IDX(level, x, y) ((y) * (level)->pitch + (x))
+
+// Single grid level
+typedef struct ns_multigrid_level_t {
+    uint64_t width;
+    uint64_t height;
+    uint64_t pitch;
+
+    // Solution (owned by the caller on the finest level)
+    ns_real_t *p;
+    // Right hand side (owned by the caller on the finest level)
+    const ns_real_t *rhs;
+    // Right hand side storage (coarse levels only)
+    ns_real_t *rhs_data;
+    // Residual
+    ns_real_t *residual;
+    // Conjugate gradient search direction and operator product (coarsest level only)
+    ns_real_t *direction;
+    ns_real_t *product;
+} ns_multigrid_level_t;
+
+// Multigrid data wrapper
+typedef struct ns_multigrid_t {
+    ns_multigrid_level_t levels[NS_MULTIGRID_MAX_LEVELS];
+    uint64_t levels_length;
+
+    // Mean of the finest right hand side, removed to make the system compatible
+    double rhs_mean;
+} ns_multigrid_t;
+
+// Cycle names
+static const char *cycle_strings[] = {
+        "V", "F"
+};
+
+/**
+ * Private definitions
+ */
+static void ns_multigrid_cycle(ns_multigrid_t *multigrid, uint64_t l, ns_multigrid_cycle_t cycle);
+
+static void ns_multigrid_set_bounds(const ns_multigrid_level_t *level, ns_real_t *target);
+
+static void ns_multigrid_smooth(const ns_multigrid_level_t *level, ns_real_t shift, uint64_t sweeps);
+
+static void ns_multigrid_coarsest_solve(const ns_multigrid_level_t *level, ns_real_t shift);
+
+static double ns_multigrid_residual(const ns_multigrid_level_t *level, ns_real_t shift);
+
+static double ns_multigrid_apply(const ns_multigrid_level_t *level, const ns_real_t *in, ns_real_t *out);
+
+static double ns_multigrid_remove_residual_mean(const ns_multigrid_level_t *level);
+
+static void ns_multigrid_restrict(const ns_multigrid_level_t *fine, ns_multigrid_level_t *coarse);
+
+static void ns_multigrid_prolongate(const ns_multigrid_level_t *coarse, const ns_multigrid_level_t *fine);
+
+static ns_real_t *ns_multigrid_field_alloc(const ns_multigrid_level_t *level);
+/**
+ * END Private definitions
+ */
+
+/**
+ * Public
+ */
+const char *ns_multigrid_cycle_string(ns_multigrid_cycle_t cycle) {
+    if (cycle < NS_MULTIGRID_CYCLE_V || cycle > NS_MULTIGRID_CYCLE_F) return NULL;
+
+    return cycle_strings[cycle];
+}
+
+int ns_multigrid_cycle_int(const char *const cycle) {
+    if (cycle == NULL) return -1;
+
+    for (int i = NS_MULTIGRID_CYCLE_V; i <= NS_MULTIGRID_CYCLE_F; ++i) {
+        if (strcmp(cycle, cycle_strings[i]) == 0) return i;
+    }
+
+    return -1;
+}
+
+ns_multigrid_t *ns_multigrid_create(uint64_t width, uint64_t height, uint64_t pitch) {
+    ns_multigrid_t *multigrid = NULL;
+
+    multigrid = (ns_multigrid_t *) calloc(1, sizeof(ns_multigrid_t));
+    if (multigrid == NULL) return NULL;
+
+    // Finest level
+    multigrid->levels[0].width = width;
+    multigrid->levels[0].height = height;
+    multigrid->levels[0].pitch = pitch;
+    multigrid->levels[0].residual = ns_multigrid_field_alloc(&multigrid->levels[0]);
+    multigrid->levels_length = 1;
+    if (multigrid->levels[0].residual == NULL) {
+        ns_multigrid_free(multigrid);
+        return NULL;
+    }
+
+    // Coarse levels, halving while both dimensions are even
+    while (multigrid->levels_length < NS_MULTIGRID_MAX_LEVELS) {
+        const ns_multigrid_level_t *const fine = &multigrid->levels[multigrid->levels_length - 1];
+        ns_multigrid_level_t *const coarse = &multigrid->levels[multigrid->levels_length];
+
+        if (fine->width % 2 != 0 || fine->height % 2 != 0
+            || fine->width / 2 < NS_MULTIGRID_COARSEST_SIZE || fine->height / 2 < NS_MULTIGRID_COARSEST_SIZE)
+            break;
+
+        coarse->width = fine->width / 2;
+        coarse->height = fine->height / 2;
+        coarse->pitch = (coarse->width + 2 + NS_MULTIGRID_ALIGNMENT_CELLS - 1)
+                        / NS_MULTIGRID_ALIGNMENT_CELLS * NS_MULTIGRID_ALIGNMENT_CELLS;
+        coarse->p = ns_multigrid_field_alloc(coarse);
+        coarse->rhs_data = ns_multigrid_field_alloc(coarse);
+        coarse->rhs = coarse->rhs_data;
+        coarse->residual = ns_multigrid_field_alloc(coarse);
+        multigrid->levels_length += 1;
+
+        if (coarse->p == NULL || coarse->rhs_data == NULL || coarse->residual == NULL) {
+            ns_multigrid_free(multigrid);
+            return NULL;
+        }
+    }
+
+    // Coarsest level
+    ns_multigrid_level_t *const coarsest = &multigrid->levels[multigrid->levels_length - 1];
+    coarsest->direction = ns_multigrid_field_alloc(coarsest);
+    coarsest->product = ns_multigrid_field_alloc(coarsest);
+    if (coarsest->direction == NULL || coarsest->product == NULL) {
+        ns_multigrid_free(multigrid);
+        return NULL;
+    }
+
+    return multigrid;
+}
+
+void ns_multigrid_free(ns_multigrid_t *multigrid) {
+    if (multigrid == NULL) return;
+
+    for (uint64_t l = 0; l < multigrid->levels_length; ++l) {
+        ns_multigrid_level_t *const level = &multigrid->levels[l];
+
+        // Finest solution is owned by the caller
+        if (l != 0) free(level->p);
+        free(level->rhs_data);
+        free(level->residual);
+        free(level->direction);
+        free(level->product);
+    }
+
+    free(multigrid);
+}
+
+uint64_t ns_multigrid_solve(ns_multigrid_t *multigrid, ns_real_t *p, const ns_real_t *rhs,
+                            ns_multigrid_cycle_t cycle, double tolerance, uint64_t max_cycles) {
+    if (multigrid == NULL || p == NULL || rhs == NULL) return 0;
+    uint64_t x, y;
+    uint64_t cycles = 0;
+    double rhs_sum = 0.0;
+    double rhs_norm = 0.0;
+    ns_multigrid_level_t *const finest = &multigrid->levels[0];
+
+    finest->p = p;
+    finest->rhs = rhs;
+
+    // Remove the mean of the right hand side
+#pragma omp parallel for \
+    schedule(static) \
+    default(none) private(y, x) shared(finest) reduction(+:rhs_sum)
+    for (y = 1; y <= finest->height; ++y) {
+        for (x = 1; x <= finest->width; ++x) {
+            rhs_sum += (double) finest->rhs[NS_MULTIGRID_IDX(finest, x, y)];
+        }
+    }
+    multigrid->rhs_mean = rhs_sum / (double) (finest->width * finest->height);
+
+#pragma omp parallel for \
+    schedule(static) \
+    default(none) private(y, x) shared(finest, multigrid) reduction(+:rhs_norm)
+    for (y = 1; y <= finest->height; ++y) {
+        for (x = 1; x <= finest->width; ++x) {
+            const double value = (double) finest->rhs[NS_MULTIGRID_IDX(finest, x, y)] - multigrid->rhs_mean;
+            rhs_norm += value * value;
+        }
+    }
+    rhs_norm = sqrt(rhs_norm);
+
+    ns_multigrid_set_bounds(finest, finest->p);
+    if (rhs_norm == 0.0) return 0;
+
+    while (cycles < max_cycles) {
+        ns_multigrid_cycle(multigrid, 0, cycle);
+        cycles += 1;
+
+        if (sqrt(ns_multigrid_residual(finest, (ns_real_t) multigrid->rhs_mean)) <= tolerance * rhs_norm) break;
+    }
+
+    return cycles;
+}
+/**
+ * END Public
+ */
+
+/**
+ * Private
+ */
+static void ns_multigrid_cycle(ns_multigrid_t *multigrid, uint64_t l, ns_multigrid_cycle_t cycle) {
+    ns_multigrid_level_t *const level = &multigrid->levels[l];
+    const ns_real_t shift = l == 0 ? (ns_real_t) multigrid->rhs_mean : 0;
+
+    // Coarsest level
+    if (l == multigrid->levels_length - 1) {
+        ns_multigrid_coarsest_solve(level, shift);
+        return;
+    }
+
+    ns_multigrid_level_t *const coarse = &multigrid->levels[l + 1];
+
+    ns_multigrid_smooth(level, shift, NS_MULTIGRID_PRE_SWEEPS);
+    ns_multigrid_residual(level, shift);
+    ns_multigrid_restrict(level, coarse);
+
+    ns_multigrid_cycle(multigrid, l + 1, cycle);
+    if (cycle == NS_MULTIGRID_CYCLE_F)
+        ns_multigrid_cycle(multigrid, l + 1, NS_MULTIGRID_CYCLE_V);
+
+    ns_multigrid_prolongate(coarse, level);
+    ns_multigrid_smooth(level, shift, NS_MULTIGRID_POST_SWEEPS);
+}
+
+static void ns_multigrid_set_bounds(const ns_multigrid_level_t *const level, ns_real_t *target) {
+    const uint64_t w = level->width;
+    const uint64_t h = level->height;
+
+    for (uint64_t y = 1; y <= h; ++y) {
+        target[NS_MULTIGRID_IDX(level, 0, y)] = target[NS_MULTIGRID_IDX(level, 1, y)];
+        target[NS_MULTIGRID_IDX(level, w + 1, y)] = target[NS_MULTIGRID_IDX(level, w, y)];
+    }
+    for (uint64_t x = 1; x <= w; ++x) {
+        target[NS_MULTIGRID_IDX(level, x, 0)] = target[NS_MULTIGRID_IDX(level, x, 1)];
+        target[NS_MULTIGRID_IDX(level, x, h + 1)] = target[NS_MULTIGRID_IDX(level, x, h)];
+    }
+
+    target[NS_MULTIGRID_IDX(level, 0, 0)] =
+            NS_REAL(0.5) * (target[NS_MULTIGRID_IDX(level, 1, 0)] + target[NS_MULTIGRID_IDX(level, 0, 1)]);
+    target[NS_MULTIGRID_IDX(level, 0, h + 1)] =
+            NS_REAL(0.5) * (target[NS_MULTIGRID_IDX(level, 1, h + 1)] + target[NS_MULTIGRID_IDX(level, 0, h)]);
+    target[NS_MULTIGRID_IDX(level, w + 1, 0)] =
+            NS_REAL(0.5) * (target[NS_MULTIGRID_IDX(level, w, 0)] + target[NS_MULTIGRID_IDX(level, w + 1, 1)]);
+    target[NS_MULTIGRID_IDX(level, w + 1, h + 1)] =
+            NS_REAL(0.5) * (target[NS_MULTIGRID_IDX(level, w, h + 1)] + target[NS_MULTIGRID_IDX(level, w + 1, h)]);
+}
+
+static void ns_multigrid_smooth(const ns_multigrid_level_t *const level, ns_real_t shift, uint64_t sweeps) {
+    uint64_t y;
+    const uint64_t pitch = level->pitch;
+
+    for (uint64_t k = 0; k < sweeps; ++k) {
+        // Red-black Gauss-Seidel
+        for (uint64_t color = 0; color < 2; ++color) {
+#pragma omp parallel for \
+    schedule(static) \
+    default(none) private(y) shared(level, shift, pitch, color)
+            for (y = 1; y <= level->height; ++y) {
+                ns_real_t *const p = &level->p[NS_MULTIGRID_IDX(level, 0, y)];
+                const ns_real_t *const rhs = &level->rhs[NS_MULTIGRID_IDX(level, 0, y)];
+
+                for (uint64_t x = 1 + ((1 + y + color) & 1); x <= level->width; x += 2) {
+                    p[x] = (rhs[x] - shift + p[x - 1] + p[x + 1] + p[x - pitch] + p[x + pitch]) / 4;
+                }
+            }
+        }
+
+        ns_multigrid_set_bounds(level, level->p);
+    }
+}
+
+static void ns_multigrid_coarsest_solve(const ns_multigrid_level_t *const level, ns_real_t shift) {
+    uint64_t x, y;
+    double rr, rr_target;
+    const uint64_t max_iterations = level->width * level->height;
+
+    // Conjugate gradient, the operator is symmetric positive semi-definite
+    // and the right hand side is compatible once the rounding left in its mean is removed
+    ns_multigrid_residual(level, shift);
+    rr = ns_multigrid_remove_residual_mean(level);
+    rr_target = rr * NS_MULTIGRID_COARSEST_TOLERANCE * NS_MULTIGRID_COARSEST_TOLERANCE;
+    for (y = 1; y <= level->height; ++y) {
+        for (x = 1; x <= level->width; ++x) {
+            level->direction[NS_MULTIGRID_IDX(level, x, y)] = level->residual[NS_MULTIGRID_IDX(level, x, y)];
+        }
+    }
+
+    for (uint64_t k = 0; k < max_iterations && rr > rr_target; ++k) {
+        double rr_next = 0.0;
+        double beta;
+
+        ns_multigrid_set_bounds(level, level->direction);
+        const double dq = ns_multigrid_apply(level, level->direction, level->product);
+        if (dq <= 0.0) break;
+        const double alpha = rr / dq;
+
+#pragma omp parallel for \
+    schedule(static) \
+    default(none) private(y, x) shared(level, alpha) reduction(+:rr_next)
+        for (y = 1; y <= level->height; ++y) {
+            for (x = 1; x <= level->width; ++x) {
+                const uint64_t i = NS_MULTIGRID_IDX(level, x, y);
+
+                level->p[i] += (ns_real_t) alpha * level->direction[i];
+                level->residual[i] -= (ns_real_t) alpha * level->product[i];
+                rr_next += (double) level->residual[i] * (double) level->residual[i];
+            }
+        }
+
+        beta = rr_next / rr;
+        rr = rr_next;
+
+#pragma omp parallel for \
+    schedule(static) \
+    default(none) private(y, x) shared(level, beta)
+        for (y = 1; y <= level->height; ++y) {
+            for (x = 1; x <= level->width; ++x) {
+                const uint64_t i = NS_MULTIGRID_IDX(level, x, y);
+
+                level->direction[i] = level->residual[i] + (ns_real_t) beta * level->direction[i];
+            }
+        }
+    }
+
+    ns_multigrid_set_bounds(level, level->p);
+}
+
+static double ns_multigrid_residual(const ns_multigrid_level_t *const level, ns_real_t shift) {
+    uint64_t y;
+    const uint64_t pitch = level->pitch;
+    double norm = 0.0;
+
+#pragma omp parallel for \
+    schedule(static) \
+    default(none) private(y) shared(level, shift, pitch) reduction(+:norm)
+    for (y = 1; y <= level->height; ++y) {
+        const ns_real_t *const p = &level->p[NS_MULTIGRID_IDX(level, 0, y)];
+        const ns_real_t *const rhs = &level->rhs[NS_MULTIGRID_IDX(level, 0, y)];
+        ns_real_t *const residual = &level->residual[NS_MULTIGRID_IDX(level, 0, y)];
+
+        for (uint64_t x = 1; x <= level->width; ++x) {
+            residual[x] = rhs[x] - shift - (4 * p[x] - (p[x - 1] + p[x + 1] + p[x - pitch] + p[x + pitch]));
+            norm += (double) residual[x] * (double) residual[x];
+        }
+    }
+
+    return norm;
+}
+
+static double ns_multigrid_apply(const ns_multigrid_level_t *const level, const ns_real_t *in, ns_real_t *out) {
+    uint64_t y;
+    const uint64_t pitch = level->pitch;
+    double dot = 0.0;
+
+#pragma omp parallel for \
+    schedule(static) \
+    default(none) private(y) shared(level, in, out, pitch) reduction(+:dot)
+    for (y = 1; y <= level->height; ++y) {
+        const ns_real_t *const row_in = &in[NS_MULTIGRID_IDX(level, 0, y)];
+        ns_real_t *const row_out = &out[NS_MULTIGRID_IDX(level, 0, y)];
+
+        for (uint64_t x = 1; x <= level->width; ++x) {
+            row_out[x] = 4 * row_in[x] - (row_in[x - 1] + row_in[x + 1] + row_in[x - pitch] + row_in[x + pitch]);
+            dot += (double) row_in[x] * (double) row_out[x];
+        }
+    }
+
+    return dot;
+}
+
+static double ns_multigrid_remove_residual_mean(const ns_multigrid_level_t *const level) {
+    uint64_t y;
+    double sum = 0.0;
+    double norm = 0.0;
+    ns_real_t mean;
+
+#pragma omp parallel for \
+    schedule(static) \
+    default(none) private(y) shared(level) reduction(+:sum)
+    for (y = 1; y <= level->height; ++y) {
+        const ns_real_t *const residual = &level->residual[NS_MULTIGRID_IDX(level, 0, y)];
+
+        for (uint64_t x = 1; x <= level->width; ++x) {
+            sum += (double) residual[x];
+        }
+    }
+    mean = (ns_real_t) (sum / (double) (level->width * level->height));
+
+#pragma omp parallel for \
+    schedule(static) \
+    default(none) private(y) shared(level, mean) reduction(+:norm)
+    for (y = 1; y <= level->height; ++y) {
+        ns_real_t *const residual = &level->residual[NS_MULTIGRID_IDX(level, 0, y)];
+
+        for (uint64_t x = 1; x <= level->width; ++x) {
+            residual[x] -= mean;
+            norm += (double) residual[x] * (double) residual[x];
+        }
+    }
+
+    return norm;
+}
+
+static void ns_multigrid_restrict(const ns_multigrid_level_t *const fine, ns_multigrid_level_t *coarse) {
+    uint64_t y;
+
+    // Coarse spacing is twice the fine one, hence the operator scales by 4
+#pragma omp parallel for \
+    schedule(static) \
+    default(none) private(y) shared(fine, coarse)
+    for (y = 0; y < coarse->height + 2; ++y) {
+        ns_real_t *const rhs = &coarse->rhs_data[NS_MULTIGRID_IDX(coarse, 0, y)];
+
+        memset(&coarse->p[NS_MULTIGRID_IDX(coarse, 0, y)], 0, coarse->pitch * sizeof(ns_real_t));
+        if (y == 0 || y > coarse->height) continue;
+
+        const uint64_t fy0 = 2 * y - 1;
+        const uint64_t fy1 = 2 * y;
+
+        for (uint64_t x = 1; x <= coarse->width; ++x) {
+            const uint64_t fx0 = 2 * x - 1;
+            const uint64_t fx1 = 2 * x;
+
+            rhs[x] = fine->residual[NS_MULTIGRID_IDX(fine, fx0, fy0)]
+                     + fine->residual[NS_MULTIGRID_IDX(fine, fx1, fy0)]
+                     + fine->residual[NS_MULTIGRID_IDX(fine, fx0, fy1)]
+                     + fine->residual[NS_MULTIGRID_IDX(fine, fx1, fy1)];
+        }
+    }
+}
+
+static void ns_multigrid_prolongate(const ns_multigrid_level_t *const coarse, const ns_multigrid_level_t *const fine) {
+    uint64_t y;
+
+    ns_multigrid_set_bounds(coarse, coarse->p);
+
+    // Bilinear interpolation between cell centers
+#pragma omp parallel for \
+    schedule(static) \
+    default(none) private(y) shared(fine, coarse)
+    for (y = 1; y <= fine->height; ++y) {
+        const uint64_t cy = (y + 1) / 2;
+        const uint64_t cy_near = (y & 1) ? cy - 1 : cy + 1;
+        ns_real_t *const p = &fine->p[NS_MULTIGRID_IDX(fine, 0, y)];
+
+        for (uint64_t x = 1; x <= fine->width; ++x) {
+            const uint64_t cx = (x + 1) / 2;
+            const uint64_t cx_near = (x & 1) ? cx - 1 : cx + 1;
+
+            p[x] += NS_REAL(0.5625) * coarse->p[NS_MULTIGRID_IDX(coarse, cx, cy)]
+                    + NS_REAL(0.1875) * coarse->p[NS_MULTIGRID_IDX(coarse, cx_near, cy)]
+                    + NS_REAL(0.1875) * coarse->p[NS_MULTIGRID_IDX(coarse, cx, cy_near)]
+                    + NS_REAL(0.0625) * coarse->p[NS_MULTIGRID_IDX(coarse, cx_near, cy_near)];
+        }
+    }
+
+    ns_multigrid_set_bounds(fine, fine->p);
+}
+
+static ns_real_t *ns_multigrid_field_alloc(const ns_multigrid_level_t *const level) {
+    void *field = NULL;
+    const size_t size = level->pitch * (level->height + 2) * sizeof(ns_real_t);
+
+    if (posix_memalign(&field, NS_MULTIGRID_ALIGNMENT, size) != 0) return NULL;
+    memset(field, 0, size);
+
+    return (ns_real_t *) field;
+}
+/**
+* END Private
+*/
@@ -1,17 +1,20 @@
 #include "ns/nodes/com/message.h"
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
 
 void com_message_MPI_datatype(MPI_Datatype *message_type) {
     if (message_type == NULL) return;
 
     // Number of items
-    enum { n_items = 2 };
+    enum { n_items = 8 };
 
-    // How many elements for each item
-    int block_lengths[n_items] = {1, 1};
+    // How many elements for each item, offset, length and point of the location are contiguous
+    int block_lengths[n_items] = {1, 1, 1, 1, 1, 1, 3, 1};
 
     // Type of each item
-    MPI_Datatype types[n_items] = {MPI_C_BOOL, MPI_UINT64_T};
+    MPI_Datatype types[n_items] = {MPI_C_BOOL, MPI_C_BOOL, MPI_UINT64_T, MPI_UINT64_T, MPI_DOUBLE, MPI_UINT64_T,
+                                   MPI_UINT64_T, MPI_C_BOOL};
 
     // Calculate offsets
     MPI_Aint offsets[n_items];
@@ -19,11 +22,106 @@ void com_message_MPI_datatype(MPI_Datatype *message_type) {
     MPI_Aint base_address;
     MPI_Get_address(&m, &base_address);
     MPI_Get_address(&m.terminate, &offsets[0]);
+    MPI_Get_address(&m.failed, &offsets[1]);
+    MPI_Get_address(&m.simulation_id, &offsets[2]);
+    MPI_Get_address(&m.ranks, &offsets[3]);
+    MPI_Get_address(&m.elapsed, &offsets[4]);
+    MPI_Get_address(&m.attempt, &offsets[5]);
+    MPI_Get_address(&m.location.offset, &offsets[6]);
+    MPI_Get_address(&m.location.sweep, &offsets[7]);
+    for (int i = 0; i < n_items; ++i) offsets[i] = MPI_Aint_diff(offsets[i], base_address);
+
+    // Create the struct type
+    MPI_Type_create_struct(n_items, block_lengths, offsets, types, message_type);
+    MPI_Type_commit(message_type);
+}
+
+void com_container_message_MPI_datatype(MPI_Datatype *message_type) {
+    if (message_type == NULL) return;
+
+    // Number of items
+    enum { n_items = 4 };
+
+    // How many elements for each item
+    int block_lengths[n_items] = {1, 1, 1, 1};
+
+    // Type of each item
+    MPI_Datatype types[n_items] = {MPI_C_BOOL, MPI_UINT64_T, MPI_INT, MPI_UINT64_T};
+
+    // Calculate offsets
+    MPI_Aint offsets[n_items];
+    struct com_container_message_t m = {0};
+    MPI_Aint base_address;
+    MPI_Get_address(&m, &base_address);
+    MPI_Get_address(&m.done, &offsets[0]);
     MPI_Get_address(&m.simulation_id, &offsets[1]);
-    offsets[0] = MPI_Aint_diff(offsets[0], base_address);
-    offsets[1] = MPI_Aint_diff(offsets[1], base_address);
+    MPI_Get_address(&m.format, &offsets[2]);
+    MPI_Get_address(&m.length, &offsets[3]);
+    for (int i = 0; i < n_items; ++i) offsets[i] = MPI_Aint_diff(offsets[i], base_address);
 
     // Create the struct type
     MPI_Type_create_struct(n_items, block_lengths, offsets, types, message_type);
     MPI_Type_commit(message_type);
 }
+
+void com_gather_nodes(int *nodes) {
+    MPI_Comm node_comm;
+    int rank;
+    int node;
+
+    // Ranks sharing memory are on the same node, the lowest one identifies it
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm);
+    node = rank;
+    MPI_Bcast(&node, 1, MPI_INT, 0, node_comm);
+    MPI_Comm_free(&node_comm);
+
+    MPI_Allgather(&node, 1, MPI_INT, nodes, 1, MPI_INT, MPI_COMM_WORLD);
+}
+
+const uint8_t *com_share_simulations(int root, const uint8_t *image, uint64_t *length, MPI_Win *window) {
+    MPI_Comm node_comm;
+    MPI_Comm leaders_comm;
+    int rank;
+    int node_rank;
+    int leaders_root;
+    uint8_t *shared;
+    MPI_Aint shared_length;
+    int shared_disp_unit;
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Bcast(length, 1, MPI_UINT64_T, root, MPI_COMM_WORLD);
+
+    // Ranks of a node share the copy allocated by the lowest one
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm);
+    MPI_Comm_rank(node_comm, &node_rank);
+    MPI_Win_allocate_shared(node_rank == 0 ? (MPI_Aint) *length : 0, 1, MPI_INFO_NULL, node_comm, &shared,
+                            window);
+    MPI_Win_shared_query(*window, 0, &shared_length, &shared_disp_unit, &shared);
+
+    // Only the lowest rank of every node receives the image
+    MPI_Comm_split(MPI_COMM_WORLD, node_rank == 0 ? 0 : MPI_UNDEFINED, rank, &leaders_comm);
+    MPI_Win_fence(0, *window);
+    if (leaders_comm != MPI_COMM_NULL) {
+        // Rank of root among the leaders
+        MPI_Comm_rank(leaders_comm, &leaders_root);
+        if (rank != root) leaders_root = -1;
+        MPI_Allreduce(MPI_IN_PLACE, &leaders_root, 1, MPI_INT, MPI_MAX, leaders_comm);
+        if (rank == root) memcpy(shared, image, *length);
+
+        // Broadcast in chunks, a count is an int
+        for (uint64_t offset = 0; offset < *length; offset += INT_MAX) {
+            const uint64_t chunk = *length - offset < INT_MAX ? *length - offset : INT_MAX;
+            MPI_Bcast(shared + offset, (int) chunk, MPI_BYTE, leaders_root, leaders_comm);
+        }
+        MPI_Comm_free(&leaders_comm);
+    }
+    MPI_Win_fence(0, *window);
+    MPI_Comm_free(&node_comm);
+
+    return shared;
+}
+
+void com_simulations_free(MPI_Win *window) {
+    MPI_Win_free(window);
+}
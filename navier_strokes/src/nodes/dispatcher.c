@@ -0,0 +1,339 @@
+#include "ns/nodes/dispatcher.h"
+#include <stdlib.h>
+#include "ns/utils/logger.h"
+
+// Task sent to a worker and not completed yet
+typedef struct dispatcher_task_t {
+    com_message_t message;
+    // Seconds the task may run, 0 for no limit
+    double limit;
+    // Time the worker started the task, once the previous one is completed
+    double started;
+} dispatcher_task_t;
+
+typedef struct dispatcher_worker_t {
+    int rank;
+    // Tasks sent and not completed yet, the first one is being computed
+    unsigned int tasks;
+    dispatcher_task_t running[DISPATCHER_QUEUED_TASKS + 1];
+    // Index of the node of the worker
+    unsigned int node;
+    // Worker stalled, it receives no more tasks
+    bool lost;
+    // Task the worker was computing once lost, its group peers wait it
+    com_message_t lost_message;
+} dispatcher_worker_t;
+
+// Message sent to a group of workers without waiting, its buffers are freed once every send completes
+typedef struct dispatcher_send_t {
+    com_message_t message;
+    int *group;
+    MPI_Request *requests;
+    int requests_length;
+    struct dispatcher_send_t *next;
+} dispatcher_send_t;
+
+struct dispatcher_t {
+    dispatcher_worker_t *workers;
+    unsigned int workers_length;
+    // Tasks of the workers of every node
+    unsigned int *node_loads;
+    unsigned int nodes_length;
+    dispatcher_send_t *sends;
+};
+
+/**
+ * Private definitions
+ */
+static dispatcher_worker_t *find_worker(dispatcher_t *dispatcher, int rank);
+
+static bool group_contains(const int *group, uint64_t group_length, int rank);
+
+static bool same_task(const com_message_t *message, const com_message_t *other);
+/**
+ * END Private definitions
+ */
+
+/**
+ * Public
+ */
+dispatcher_t *dispatcher_create(const int *const ranks, const int *const nodes, unsigned int workers_length) {
+    dispatcher_t *dispatcher;
+
+    dispatcher = (dispatcher_t *) calloc(1, sizeof(dispatcher_t));
+    if (dispatcher == NULL) return NULL;
+    dispatcher->workers_length = workers_length;
+    dispatcher->workers = (dispatcher_worker_t *) calloc(workers_length > 0 ? workers_length : 1,
+                                                         sizeof(dispatcher_worker_t));
+    dispatcher->node_loads = (unsigned int *) calloc(workers_length > 0 ? workers_length : 1, sizeof(unsigned int));
+    if (dispatcher->workers == NULL || dispatcher->node_loads == NULL) {
+        dispatcher_free(dispatcher);
+        return NULL;
+    }
+
+    for (unsigned int worker = 0; worker < workers_length; ++worker) {
+        unsigned int node = dispatcher->nodes_length;
+
+        // Nodes are numbered in the order of their first worker
+        for (unsigned int previous = 0; previous < worker; ++previous) {
+            if (nodes[ranks[previous]] == nodes[ranks[worker]]) {
+                node = dispatcher->workers[previous].node;
+                break;
+            }
+        }
+        if (node == dispatcher->nodes_length) dispatcher->nodes_length += 1;
+
+        dispatcher->workers[worker].rank = ranks[worker];
+        dispatcher->workers[worker].tasks = 0;
+        dispatcher->workers[worker].node = node;
+    }
+
+    return dispatcher;
+}
+
+unsigned int dispatcher_workers(const dispatcher_t *const dispatcher) {
+    unsigned int workers = 0;
+
+    for (unsigned int worker = 0; worker < dispatcher->workers_length; ++worker)
+        if (!dispatcher->workers[worker].lost) workers += 1;
+
+    return workers;
+}
+
+unsigned int dispatcher_nodes(const dispatcher_t *const dispatcher) {
+    return dispatcher->nodes_length;
+}
+
+unsigned int dispatcher_available(const dispatcher_t *const dispatcher) {
+    unsigned int available = 0;
+
+    for (unsigned int worker = 0; worker < dispatcher->workers_length; ++worker)
+        if (!dispatcher->workers[worker].lost && dispatcher->workers[worker].tasks <= DISPATCHER_QUEUED_TASKS)
+            available += 1;
+
+    return available;
+}
+
+unsigned int dispatcher_tasks(const dispatcher_t *const dispatcher) {
+    unsigned int tasks = 0;
+
+    for (unsigned int worker = 0; worker < dispatcher->workers_length; ++worker)
+        tasks += dispatcher->workers[worker].tasks;
+
+    return tasks;
+}
+
+int *dispatcher_select(dispatcher_t *dispatcher, uint64_t ranks, bool balance) {
+    int *group;
+
+    group = (int *) calloc(ranks > 0 ? ranks : 1, sizeof(int));
+    if (group == NULL) return NULL;
+
+    for (uint64_t g = 0; g < ranks; ++g) {
+        dispatcher_worker_t *selected = NULL;
+
+        // Idle workers first, then the first worker, of the least loaded node if balancing
+        for (unsigned int w = 0; w < dispatcher->workers_length; ++w) {
+            dispatcher_worker_t *const worker = &dispatcher->workers[w];
+
+            if (worker->lost || worker->tasks > DISPATCHER_QUEUED_TASKS || group_contains(group, g, worker->rank))
+                continue;
+            if (selected == NULL || worker->tasks < selected->tasks
+                || (balance && worker->tasks == selected->tasks
+                    && dispatcher->node_loads[worker->node] < dispatcher->node_loads[selected->node]))
+                selected = worker;
+            if (!balance && selected->tasks == 0) break;
+        }
+        if (selected == NULL) {
+            free(group);
+            return NULL;
+        }
+
+        // Count the task now to prevent undefined behaviour
+        selected->tasks += 1;
+        dispatcher->node_loads[selected->node] += 1;
+        group[g] = selected->rank;
+    }
+
+    return group;
+}
+
+void dispatcher_send(dispatcher_t *dispatcher, com_message_t message, int *group, uint64_t group_length,
+                     double limit, MPI_Datatype message_type) {
+    dispatcher_send_t *sent;
+
+    sent = (dispatcher_send_t *) calloc(1, sizeof(dispatcher_send_t));
+    if (sent == NULL) {
+        log_error("Unable to allocate dispatch");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    sent->message = message;
+    sent->group = group;
+    sent->requests = (MPI_Request *) calloc(2 * group_length, sizeof(MPI_Request));
+    if (sent->requests == NULL) {
+        log_error("Unable to allocate dispatch requests");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    // Message, then the ranks of the group if shared
+    for (uint64_t g = 0; g < group_length; ++g) {
+        dispatcher_worker_t *const worker = find_worker(dispatcher, group[g]);
+
+        // Task counted by dispatcher_select, the worker starts it at once if it has no other
+        if (!message.terminate && worker != NULL && worker->tasks > 0) {
+            dispatcher_task_t *const task = &worker->running[worker->tasks - 1];
+            task->message = message;
+            task->limit = limit;
+            task->started = worker->tasks == 1 ? MPI_Wtime() : 0;
+        }
+
+        MPI_Isend(&sent->message, 1, message_type, group[g], 0, MPI_COMM_WORLD,
+                  &sent->requests[sent->requests_length++]);
+        if (message.ranks > 1)
+            MPI_Isend(group, (int) message.ranks, MPI_INT, group[g], 0, MPI_COMM_WORLD,
+                      &sent->requests[sent->requests_length++]);
+    }
+
+    sent->next = dispatcher->sends;
+    dispatcher->sends = sent;
+}
+
+void dispatcher_terminate(dispatcher_t *dispatcher, MPI_Datatype message_type) {
+    int *ranks;
+    unsigned int ranks_length = 0;
+
+    ranks = (int *) calloc(dispatcher->workers_length > 0 ? dispatcher->workers_length : 1, sizeof(int));
+    if (ranks == NULL) {
+        log_error("Unable to allocate ranks of workers");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    for (unsigned int worker = 0; worker < dispatcher->workers_length; ++worker)
+        if (!dispatcher->workers[worker].lost) ranks[ranks_length++] = dispatcher->workers[worker].rank;
+
+    dispatcher_send(dispatcher, (com_message_t) {.terminate = true}, ranks, ranks_length, 0, message_type);
+}
+
+bool dispatcher_complete(dispatcher_t *dispatcher, int rank) {
+    dispatcher_worker_t *const worker = find_worker(dispatcher, rank);
+
+    if (worker == NULL || worker->lost || worker->tasks == 0) return false;
+    worker->tasks -= 1;
+    dispatcher->node_loads[worker->node] -= 1;
+
+    // The worker starts its next task
+    for (unsigned int task = 0; task < worker->tasks; ++task) worker->running[task] = worker->running[task + 1];
+    if (worker->tasks > 0) worker->running[0].started = MPI_Wtime();
+
+    return true;
+}
+
+int dispatcher_stalled(const dispatcher_t *const dispatcher) {
+    const double now = MPI_Wtime();
+
+    for (unsigned int w = 0; w < dispatcher->workers_length; ++w) {
+        const dispatcher_worker_t *const worker = &dispatcher->workers[w];
+
+        const dispatcher_task_t *const task = &worker->running[0];
+        double started = task->started;
+        uint64_t ranks = 0;
+
+        if (worker->lost || worker->tasks == 0 || task->limit <= 0) continue;
+
+        // A decomposed task starts once every rank of its group is done with its previous task
+        for (unsigned int p = 0; p < dispatcher->workers_length && task->message.ranks > 1; ++p) {
+            const dispatcher_worker_t *const peer = &dispatcher->workers[p];
+
+            if (peer->lost && same_task(&peer->lost_message, &task->message)) {
+                ranks += 1;
+            } else if (!peer->lost && peer->tasks > 0 && same_task(&peer->running[0].message, &task->message)) {
+                ranks += 1;
+                if (peer->running[0].started > started) started = peer->running[0].started;
+            }
+        }
+        if (task->message.ranks > 1 && ranks < task->message.ranks) continue;
+
+        if (now - started > task->limit) return worker->rank;
+    }
+
+    return -1;
+}
+
+unsigned int dispatcher_lose(dispatcher_t *dispatcher, int rank, com_message_t *messages) {
+    dispatcher_worker_t *const worker = find_worker(dispatcher, rank);
+    unsigned int tasks;
+
+    if (worker == NULL || worker->lost) return 0;
+    tasks = worker->tasks;
+    for (unsigned int task = 0; task < tasks; ++task) messages[task] = worker->running[task].message;
+
+    worker->lost = true;
+    if (tasks > 0) worker->lost_message = worker->running[0].message;
+    worker->tasks = 0;
+    dispatcher->node_loads[worker->node] -= tasks;
+
+    return tasks;
+}
+
+bool dispatcher_lost(const dispatcher_t *const dispatcher, int rank) {
+    for (unsigned int worker = 0; worker < dispatcher->workers_length; ++worker)
+        if (dispatcher->workers[worker].rank == rank) return dispatcher->workers[worker].lost;
+
+    return false;
+}
+
+void dispatcher_progress(dispatcher_t *dispatcher, bool wait) {
+    dispatcher_send_t **sends = &dispatcher->sends;
+
+    while (*sends != NULL) {
+        dispatcher_send_t *const sent = *sends;
+        int completed = true;
+
+        if (wait) MPI_Waitall(sent->requests_length, sent->requests, MPI_STATUSES_IGNORE);
+        else MPI_Testall(sent->requests_length, sent->requests, &completed, MPI_STATUSES_IGNORE);
+        if (!completed) {
+            sends = &sent->next;
+            continue;
+        }
+
+        *sends = sent->next;
+        free(sent->requests);
+        free(sent->group);
+        free(sent);
+    }
+}
+
+void dispatcher_free(dispatcher_t *dispatcher) {
+    if (dispatcher == NULL) return;
+
+    dispatcher_progress(dispatcher, true);
+    free(dispatcher->workers);
+    free(dispatcher->node_loads);
+    free(dispatcher);
+}
+/**
+ * END Public
+ */
+
+/**
+ * Private
+ */
+static dispatcher_worker_t *find_worker(dispatcher_t *dispatcher, int rank) {
+    for (unsigned int worker = 0; worker < dispatcher->workers_length; ++worker)
+        if (dispatcher->workers[worker].rank == rank) return &dispatcher->workers[worker];
+
+    return NULL;
+}
+
+static bool group_contains(const int *const group, uint64_t group_length, int rank) {
+    for (uint64_t g = 0; g < group_length; ++g)
+        if (group[g] == rank) return true;
+
+    return false;
+}
+
+static bool same_task(const com_message_t *const message, const com_message_t *const other) {
+    return message->simulation_id == other->simulation_id && message->attempt == other->attempt;
+}
+/**
+ * END Private
+ */
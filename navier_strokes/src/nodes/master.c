@@ -1,159 +1,874 @@
 #include "ns/nodes/master.h"
 #include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
 #include <stdint.h>
+#include <time.h>
+#include <pthread.h>
 #include <mpi.h>
 #include "ns/utils/logger.h"
 #include "ns/utils/parser.h"
-#include "ns/utils/stringify.h"
+#include "ns/utils/pack.h"
 #include "ns/utils/file.h"
+#include "ns/utils/container.h"
+#include "ns/utils/checkpoint.h"
+#include "ns/utils/cache.h"
 #include "ns/nodes/com/message.h"
+#include "ns/nodes/scheduler.h"
+#include "ns/nodes/dispatcher.h"
+#include "ns/nodes/submaster.h"
 
-typedef struct worker_t {
-    int rank;
-    bool working;
-} worker_t;
+// Initial capacity of the container table of contents
+#define CONTAINER_ENTRIES_CAPACITY 64
+// Dispatches of a simulation before giving it up
+#define MASTER_SIMULATION_ATTEMPTS 3
+// Simulations failed in a row by a worker before losing it
+#define MASTER_WORKER_FAILURES 2
+// Shortest time limit of a simulation in seconds, the predictions of the short ones are noisy
+#define MASTER_MIN_DEADLINE 10.0
+// Nanoseconds between two checks of the deadlines while waiting the workers
+#define MASTER_POLL_NANOSECONDS 1000000
+// Longest file name of a result fetched from the cache
+#define MASTER_RESULT_MAX_NAME_LENGTH 64
+// Simulations parsed ahead of the dispatched ones when streaming the simulations file
+#define MASTER_STREAM_SIMULATIONS 64
+
+// Results of the workers, the master hands out the byte ranges of the container and writes its table of contents
+typedef struct master_container_t {
+    // Container of the results, NULL if every result is saved in its own file
+    container_t *container;
+    MPI_Datatype message_type;
+    // Offset of the next result
+    uint64_t offset;
+    container_entry_t *entries;
+    uint64_t entries_length;
+    uint64_t entries_capacity;
+    // Workers that saved every result
+    uint done_workers;
+    // Workers lost by the master, by rank, their results are dropped
+    bool *lost;
+    uint lost_workers;
+} master_container_t;
+
+// Simulations of the master, parsed a few at a time if the simulations file is streamed
+typedef struct master_simulations_t {
+    ns_simulations_t *simulations;
+    // Simulations parsed so far
+    uint64_t length;
+    uint64_t capacity;
+    // Completed by an interrupted run or found in the cache, not dispatched
+    bool *done;
+    uint64_t resumed_length;
+    uint64_t cached_length;
+    // Dispatches of every simulation, and whether it completed or has been given up
+    uint64_t *attempts;
+    bool *completed;
+} master_simulations_t;
+
+// Simulations dispatched by the master, dispatched again if their worker fails or stalls
+typedef struct master_dispatch_t {
+    dispatcher_t *dispatcher;
+    scheduler_t *scheduler;
+    MPI_Datatype message_type;
+    MPI_Comm master_comm;
+    master_container_t *container;
+    // Time limit of a simulation, in multiples of its predicted time, 0 for none
+    double deadline;
+    master_simulations_t *simulations;
+    uint64_t failed_simulations;
+    // Simulations failed in a row by every rank
+    uint *failures;
+} master_dispatch_t;
+
+static void *run_local_worker(void *args);
+
+static void *run_local_submaster(void *args);
+
+static void update_simulations(const node_master_args_t *args, master_simulations_t *simulations);
+
+static void stream_simulations(const node_master_args_t *args, master_simulations_t *simulations,
+                               scheduler_t *scheduler);
+
+static void find_done_simulations(const node_master_args_t *args, master_simulations_t *simulations, uint64_t from);
+
+static void fetch_cached_simulations(const node_master_args_t *args, master_simulations_t *simulations,
+                                     uint64_t from);
+
+static uint dispatch_simulations(const node_master_args_t *args, master_simulations_t *simulations, bool compute,
+                                 MPI_Datatype message_type, master_container_t *container,
+                                 uint64_t *failed_simulations);
 
-void do_master(const node_master_args_t *const args) {
+static uint serve_submasters(const node_master_args_t *args, master_simulations_t *simulations,
+                             MPI_Datatype message_type, master_container_t *container);
+
+static void serve_batch(const node_master_args_t *args, master_simulations_t *simulations, scheduler_t *scheduler,
+                        MPI_Datatype message_type, int source);
+
+static void wait_worker(master_dispatch_t *dispatch);
+
+static void lose_worker(master_dispatch_t *dispatch, int rank);
+
+static void retry_simulation(master_dispatch_t *dispatch, const com_message_t *message);
+
+static void reserve_container_range(master_container_t *container, MPI_Comm container_comm, int source);
+
+bool do_master(const node_master_args_t *const args) {
     int rank;
     int size;
     MPI_Datatype message_type;
-    worker_t *workers = NULL;
-    uint available_workers;
-    ns_simulations_t *simulations = NULL;
+    master_simulations_t simulations = {.simulations = NULL};
     char *simulations_string = NULL;
+    const char *simulations_text = NULL;
+    uint64_t simulations_text_length = 0;
+    uint8_t *simulations_image = NULL;
+    uint64_t simulations_image_length;
+    MPI_Win simulations_window;
+    bool compute;
+    int thread_level;
+    node_worker_local_t local;
+    node_worker_args_t local_args;
+    node_submaster_args_t submaster_args;
+    pthread_t local_thread;
+    uint available_workers;
+    uint64_t failed_simulations = 0;
+    master_container_t container = {.container = NULL};
     char file_error[MPI_MAX_ERROR_STRING + 1];
 
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
     com_message_MPI_datatype(&message_type);
-    available_workers = (uint) (size - 1);
 
-    log_info("Workers available: %d", available_workers);
+    // The master computes simulations too if its rank may call MPI from two threads
+    MPI_Query_thread(&thread_level);
+    compute = args->worker_args != NULL && thread_level == MPI_THREAD_MULTIPLE;
+    if (args->node_masters && !compute) {
+        log_error("Sub-masters require MPI multiple threads support");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    if (args->worker_args != NULL && !compute) {
+        if (size < 2) {
+            log_error("MPI does not support multiple threads, at least two processes are required");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        log_warn("MPI does not support multiple threads, the master only dispatches simulations");
+    }
+
+    // Container shared with the workers, results start after its header
+    if (args->container_path != NULL) {
+        log_info("Saving results to container %s", args->container_path);
+        container.container = container_open(MPI_COMM_WORLD, args->container_path, file_error);
+        if (container.container == NULL) {
+            log_error("Error creating container %s: %s", args->container_path, file_error);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        container.offset = CONTAINER_HEADER_LENGTH;
+    }
+    com_container_message_MPI_datatype(&container.message_type);
+    container.lost = (bool *) calloc((size_t) size, sizeof(bool));
+    if (container.lost == NULL) {
+        log_error("Unable to allocate lost workers");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    if (args->stream) {
+        // Map simulations file, its pages are read as the simulations are parsed
+        log_info("Mapping simulations file at %s", args->simulations_path);
+        simulations_text = map_file(args->simulations_path, &simulations_text_length, file_error);
+        if (simulations_text == NULL) {
+            log_error("Error opening and managing simulations file: %s", file_error);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        // Parse the first simulations, the others while dispatching
+        log_info("Parsing simulations file content while dispatching");
+        simulations.simulations = ns_parse_simulations_stream(simulations_text, simulations_text_length);
+        if (simulations.simulations == NULL
+            || !ns_parse_simulations_next(simulations.simulations, MASTER_STREAM_SIMULATIONS)) {
+            log_error("Unable to parse simulations file `%s`", args->simulations_path);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+    } else {
+        // Read simulations file
+        log_info("Reading simulations file at %s", args->simulations_path);
+        simulations_string = read_file(args->simulations_path, file_error);
+        if (simulations_string == NULL) {
+            log_error("Error opening and managing simulations file: %s", file_error);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        // Parse simulation
+        log_info("Parsing simulations file content");
+        simulations.simulations = ns_parse_simulations(simulations_string);
+        if (simulations.simulations == NULL) {
+            log_error("Unable to parse simulations file `%s`", args->simulations_path);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        free(simulations_string);
+    }
+
+    // Simulations completed by an interrupted run, or found in the cache, are not dispatched
+    update_simulations(args, &simulations);
+
+    // Share the packed simulations once, tasks hold only their id. A streamed file is mapped by every worker
+    local.simulations_image = NULL;
+    local.simulations_image_length = 0;
+    local.container = container.container;
+    if (!args->stream) {
+        simulations_image = ns_pack_simulations(simulations.simulations, &simulations_image_length);
+        if (simulations_image == NULL) {
+            log_error("Unable to pack simulations");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        log_info("Sharing %ld packed simulation%s of %ld bytes", simulations.length, simulations.length > 1 ? "s" : "",
+                 simulations_image_length);
+        local.simulations_image = com_share_simulations(rank, simulations_image, &simulations_image_length,
+                                                        &simulations_window);
+        local.simulations_image_length = simulations_image_length;
+        free(simulations_image);
+    }
+
+    if (args->node_masters) {
+        // Sub-master of the node of the master, it computes while this thread hands out the batches
+        submaster_args = (node_submaster_args_t) {.nodes = args->nodes, .container_path = args->container_path,
+                .master_comm = args->master_comm, .container_comm = args->container_comm,
+                .worker_args = args->worker_args, .local = &local};
+        if (pthread_create(&local_thread, NULL, run_local_submaster, &submaster_args) != 0) {
+            log_error("Unable to start the sub-master of the master rank");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        available_workers = serve_submasters(args, &simulations, message_type, &container);
+    } else {
+        // Worker of the master rank, it computes while this thread dispatches
+        if (compute) {
+            log_info("Computing simulations on the master rank too");
+            local_args = *args->worker_args;
+            local_args.local = &local;
+            if (pthread_create(&local_thread, NULL, run_local_worker, &local_args) != 0) {
+                log_error("Unable to start the worker of the master rank");
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+            }
+        }
+
+        available_workers = dispatch_simulations(args, &simulations, compute, message_type, &container,
+                                                 &failed_simulations);
+    }
+
+    // Wait every worker not lost to save its results
+    log_info("Waiting workers to save their results...");
+    while (container.done_workers < available_workers) {
+        MPI_Status status;
+
+        MPI_Probe(MPI_ANY_SOURCE, COM_CONTAINER_TAG, args->container_comm, &status);
+        reserve_container_range(&container, args->container_comm, status.MPI_SOURCE);
+    }
+
+    // Complete the container, closing it waits the lost workers too
+    if (container.container != NULL) {
+        log_info("Writing container table of contents of %ld results", container.entries_length);
+        if (!container_write_toc(container.container, container.offset, container.entries, container.entries_length,
+                                 file_error)
+            || (container.lost_workers == 0 && !container_close(container.container, file_error))) {
+            log_error("Error saving container %s: %s", args->container_path, file_error);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        for (uint64_t i = 0; i < container.entries_length; ++i) free(container.entries[i].metadata);
+        free(container.entries);
+    }
+    MPI_Type_free(&container.message_type);
 
-    // Read simulations file
-    log_info("Reading simulations file at %s", args->simulations_path);
-    simulations_string = read_file(args->simulations_path, file_error);
-    if (simulations_string == NULL) {
-        log_error("Error opening and managing simulations file: %s", file_error);
+    // Every result is saved, a stalled worker would keep the job running until its walltime
+    if (container.lost_workers > 0) {
+        log_error("%d worker%s lost, aborting them", container.lost_workers, container.lost_workers > 1 ? "s" : "");
         MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
     }
+    free(container.lost);
+
+    // Wait the pending results of the master rank, its worker is done with the container already
+    if (compute) pthread_join(local_thread, NULL);
+
+    if (!args->stream) com_simulations_free(&simulations_window);
+    ns_parse_simulations_free(simulations.simulations);
+    unmap_file(simulations_text, simulations_text_length);
+    free(simulations.done);
+    free(simulations.attempts);
+    free(simulations.completed);
+    MPI_Type_free(&message_type);
+
+    if (failed_simulations > 0) {
+        log_error("%ld simulation%s failed", failed_simulations, failed_simulations > 1 ? "s" : "");
+        return false;
+    }
+    return true;
+}
+
+static void *run_local_worker(void *args) {
+    do_worker((const node_worker_args_t *) args);
+    return NULL;
+}
+
+static void *run_local_submaster(void *args) {
+    do_submaster((const node_submaster_args_t *) args);
+    return NULL;
+}
+
+static void update_simulations(const node_master_args_t *const args, master_simulations_t *simulations) {
+    const uint64_t from = simulations->length;
+    const uint64_t length = ns_parse_simulations_length(simulations->simulations);
+    const uint64_t listed_length = simulations->simulations->simulations_length;
+
+    // Grow the state of the simulations, never empty
+    if (length + 1 > simulations->capacity) {
+        uint64_t capacity = simulations->capacity > 0 ? simulations->capacity : MASTER_STREAM_SIMULATIONS;
+        while (capacity < length + 1) capacity *= 2;
+
+        bool *done = (bool *) realloc(simulations->done, capacity * sizeof(bool));
+        if (done != NULL) simulations->done = done;
+        uint64_t *attempts = (uint64_t *) realloc(simulations->attempts, capacity * sizeof(uint64_t));
+        if (attempts != NULL) simulations->attempts = attempts;
+        bool *completed = (bool *) realloc(simulations->completed, capacity * sizeof(bool));
+        if (completed != NULL) simulations->completed = completed;
+        if (done == NULL || attempts == NULL || completed == NULL) {
+            log_error("Unable to allocate done simulations");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        memset(simulations->done + simulations->capacity, 0, (capacity - simulations->capacity) * sizeof(bool));
+        memset(simulations->attempts + simulations->capacity, 0,
+               (capacity - simulations->capacity) * sizeof(uint64_t));
+        memset(simulations->completed + simulations->capacity, 0,
+               (capacity - simulations->capacity) * sizeof(bool));
+        simulations->capacity = capacity;
+    }
+    simulations->length = length;
+
+    // Simulations completed by an interrupted run, or found in the cache, are not dispatched
+    find_done_simulations(args, simulations, from);
+    memcpy(simulations->completed + from, simulations->done + from, (length - from) * sizeof(bool));
+
+    // Summary, once every simulation is parsed
+    if (!ns_parse_simulations_complete(simulations->simulations)) return;
+    if (args->stream)
+        log_info("Simulations file parsed, %ld simulation%s", length, length > 1 ? "s" : "");
+    if (simulations->simulations->sweeps_length > 0)
+        log_info("Expanding %ld sweep%s into %ld simulation%s on demand", simulations->simulations->sweeps_length,
+                 simulations->simulations->sweeps_length > 1 ? "s" : "", length - listed_length,
+                 length - listed_length > 1 ? "s" : "");
+    if (args->cache_path != NULL)
+        log_info("%ld of %ld simulation%s found in the cache %s", simulations->cached_length, length,
+                 length > 1 ? "s" : "", args->cache_path);
+    if (args->resume)
+        log_info("Resuming from %s, %ld of %ld simulation%s done already", args->checkpoint_path,
+                 simulations->resumed_length, length, length > 1 ? "s" : "");
+}
 
-    // Parse simulation
-    log_info("Parsing simulations file content");
-    simulations = ns_parse_simulations(simulations_string);
-    if (simulations == NULL) {
+static void stream_simulations(const node_master_args_t *const args, master_simulations_t *simulations,
+                               scheduler_t *scheduler) {
+    // Parse ahead of the dispatched simulations, so that the longest of the next ones go first
+    if (ns_parse_simulations_complete(simulations->simulations)
+        || scheduler_pending(scheduler) >= MASTER_STREAM_SIMULATIONS)
+        return;
+
+    if (!ns_parse_simulations_next(simulations->simulations, MASTER_STREAM_SIMULATIONS)) {
         log_error("Unable to parse simulations file `%s`", args->simulations_path);
         MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
     }
-    free(simulations_string);
+    update_simulations(args, simulations);
+    if (!scheduler_update(scheduler, simulations->simulations)) {
+        log_error("Unable to allocate scheduler");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+}
+
+static void find_done_simulations(const node_master_args_t *const args, master_simulations_t *simulations,
+                                  uint64_t from) {
+    if (args->cache_path != NULL) fetch_cached_simulations(args, simulations, from);
+    if (!args->resume) return;
+
+    // A done marker counts only if the simulation is unchanged
+    for (uint64_t i_s = from; i_s < simulations->length; ++i_s) {
+        ns_simulation_t simulation;
+        checkpoint_t *marker = NULL;
+        uint8_t *parameters;
+        uint64_t parameters_length;
+        char *marker_path;
+        char file_error[MPI_MAX_ERROR_STRING + 1];
+
+        if (simulations->done[i_s]) continue;
+        marker_path = checkpoint_file_path(args->checkpoint_path, CHECKPOINT_FILE_DONE, i_s, NULL, 0);
+        ns_parse_simulations_at(simulations->simulations, i_s, &simulation);
+        parameters = ns_pack_simulation(&simulation, &parameters_length);
+        if (marker_path == NULL || parameters == NULL) {
+            log_error("Unable to check simulation %ld done", i_s);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        // Not done if the marker is missing
+        marker = checkpoint_read(marker_path, file_error);
+        if (marker != NULL && checkpoint_matches(marker, parameters, parameters_length)) {
+            log_debug("Simulation %ld is done already", i_s);
+            simulations->done[i_s] = true;
+            simulations->resumed_length += 1;
+        } else if (marker != NULL) {
+            log_warn("Simulation %ld changed since it was marked done, computing it again", i_s);
+        }
+
+        checkpoint_free(marker);
+        free(parameters);
+        free(marker_path);
+    }
+}
+
+static void fetch_cached_simulations(const node_master_args_t *const args, master_simulations_t *simulations,
+                                     uint64_t from) {
+    const node_worker_args_t *const worker_args = args->worker_args;
+    const size_t result_path_length = strlen(worker_args->results_path) + 1 + MASTER_RESULT_MAX_NAME_LENGTH + 1;
+    char *result_path;
+    int rank;
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    result_path = (char *) calloc(result_path_length, sizeof(char));
+    if (result_path == NULL) {
+        log_error("Unable to allocate result location");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
 
-    // Workers
+    // A hit is saved as if the master computed it, before any simulation is dispatched
+    for (uint64_t i_s = from; i_s < simulations->length; ++i_s) {
+        ns_simulation_t simulation;
+        uint8_t *key;
+        uint64_t key_length;
+        char file_error[MPI_MAX_ERROR_STRING + 1];
+
+        ns_parse_simulations_at(simulations->simulations, i_s, &simulation);
+        key = cache_key(&simulation, false, worker_args->format, worker_args->compression,
+                        worker_args->tolerance, &key_length);
+        if (key == NULL) {
+            log_error("Unable to compute cache key of simulation %ld", i_s);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        snprintf(result_path, result_path_length, "%s/simulation_%ld_%d.%s", worker_args->results_path, i_s,
+                 rank, snapshot_format_extension(worker_args->format));
+        if (cache_fetch(args->cache_path, key, key_length, worker_args->format, i_s, result_path, file_error)) {
+            log_debug("Simulation %ld fetched from the cache", i_s);
+            simulations->done[i_s] = true;
+            simulations->cached_length += 1;
+        }
+
+        free(key);
+    }
+
+    free(result_path);
+}
+
+static uint dispatch_simulations(const node_master_args_t *const args, master_simulations_t *simulations,
+                                 bool compute, MPI_Datatype message_type, master_container_t *container,
+                                 uint64_t *failed_simulations) {
+    int rank;
+    int size;
+    int *ranks = NULL;
+    uint available_workers;
+    dispatcher_t *dispatcher = NULL;
+    scheduler_t *scheduler = NULL;
+    master_dispatch_t dispatch;
+    uint64_t i_s;
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    available_workers = (uint) (compute ? size : size - 1);
+
+    log_info("Workers available: %d", available_workers);
+
+    // Workers, the one of the master rank is the last one, it is busy dispatching too
     log_debug("Allocating workers");
-    workers = (worker_t *) calloc(available_workers, sizeof(worker_t));
-    if (workers == NULL) {
+    ranks = (int *) calloc((size_t) size, sizeof(int));
+    if (ranks == NULL) {
         log_error("Unable to allocate workers");
         MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
     }
-    for (uint worker = 0; worker < available_workers; ++worker) {
-        workers[worker].rank = (int) worker + 1;
-        workers[worker].working = false;
+    for (uint worker = 0; worker < available_workers; ++worker)
+        ranks[worker] = worker < (uint) size - 1 ? (int) worker + 1 : rank;
+    dispatcher = dispatcher_create(ranks, args->nodes, available_workers);
+    if (dispatcher == NULL) {
+        log_error("Unable to allocate workers");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
     }
+    free(ranks);
     log_debug("Workers successfully initialized");
+    log_info("Workers on %d node%s", dispatcher_nodes(dispatcher), dispatcher_nodes(dispatcher) > 1 ? "s" : "");
 
     // Show a warning message if the number of workers is more than the number of simulations
-    if (available_workers > simulations->simulations_length)
-        log_warn("%d workers available for only %ld simulation%s", available_workers, simulations->simulations_length,
-                 simulations->simulations_length > 1 ? "s" : "");
-
-    log_info("Processing %ld simulation%s", simulations->simulations_length,
-             simulations->simulations_length > 1 ? "s" : "");
-    for (uint64_t i_s = 0; i_s < simulations->simulations_length; ++i_s) {
-        worker_t *worker;
-        const ns_simulation_t *simulation = NULL;
-        char *simulation_string = NULL;
-        const com_message_t master_message = {.terminate = false, .simulation_id = i_s};
-
-        // Obtain simulation and stringify it
-        simulation = simulations->simulations[i_s];
-        simulation_string = ns_stringify_simulation(simulation);
-        if (simulation_string == NULL) {
-            log_error("Unable to stringify simulation %ld", master_message.simulation_id);
-            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    if (ns_parse_simulations_complete(simulations->simulations) && available_workers > simulations->length)
+        log_warn("%d workers available for only %ld simulation%s", available_workers, simulations->length,
+                 simulations->length > 1 ? "s" : "");
+
+    // Longest simulations first, so that none runs alone at the end
+    scheduler = scheduler_create(simulations->simulations, available_workers);
+    if (scheduler == NULL) {
+        log_error("Unable to allocate scheduler");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    // Attempts of every simulation, a failed or stalled one is dispatched again
+    dispatch = (master_dispatch_t) {.dispatcher = dispatcher, .scheduler = scheduler, .message_type = message_type,
+            .master_comm = args->master_comm, .container = container, .deadline = args->deadline,
+            .simulations = simulations};
+    dispatch.failures = (uint *) calloc((size_t) size, sizeof(uint));
+    if (dispatch.failures == NULL) {
+        log_error("Unable to allocate simulation attempts");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    if (ns_parse_simulations_complete(simulations->simulations))
+        log_info("Processing %ld simulation%s", simulations->length, simulations->length > 1 ? "s" : "");
+    else log_info("Processing simulations while parsing the simulations file");
+    while (true) {
+        ns_simulation_t simulation;
+        int *group = NULL;
+        uint64_t ranks_of_simulation;
+        double limit = 0;
+
+        // Simulations are dispatched again until every task completes, none remains once every one is parsed
+        stream_simulations(args, simulations, scheduler);
+        if (!scheduler_next(scheduler, &i_s)) {
+            if (dispatcher_tasks(dispatcher) == 0) break;
+            log_info("Waiting %d task%s to complete...", dispatcher_tasks(dispatcher),
+                     dispatcher_tasks(dispatcher) > 1 ? "s" : "");
+            wait_worker(&dispatch);
+            continue;
         }
+        if (simulations->completed[i_s]) continue;
 
-        // Obtain a worker
-        if (i_s < available_workers) {
-            // All workers can work
-            worker = &workers[i_s % available_workers];
-        } else {
-            // All workers are working. Wait for one worker to finish
-            com_message_t worker_message;
-            MPI_Status worker_status;
+        // Obtain simulation, a sweep point is expanded now
+        ns_parse_simulations_at(simulations->simulations, i_s, &simulation);
 
+        // A simulation cannot use more ranks than the workers, lost ones excluded
+        ranks_of_simulation = simulation.ranks;
+        if (ranks_of_simulation > dispatcher_workers(dispatcher)) {
+            log_warn("Simulation %ld requests %ld ranks but only %d workers are available", i_s, ranks_of_simulation,
+                     dispatcher_workers(dispatcher));
+            ranks_of_simulation = dispatcher_workers(dispatcher);
+        }
+
+        // Wait for enough workers with room for a task, a worker receives its next task while computing
+        while (dispatcher_available(dispatcher) < ranks_of_simulation) {
             log_info("Waiting a free worker...");
-            MPI_Recv(&worker_message, 1, message_type, MPI_ANY_SOURCE, 0, MPI_COMM_WORLD, &worker_status);
-            log_info("Worker %ld has successfully completed simulation %ld", worker_status.MPI_SOURCE,
-                     worker_message.simulation_id);
-            log_info("Worker %ld can work", worker_status.MPI_SOURCE);
+            wait_worker(&dispatch);
+            if (ranks_of_simulation > dispatcher_workers(dispatcher))
+                ranks_of_simulation = dispatcher_workers(dispatcher);
+        }
+        com_message_t master_message = {.terminate = false, .simulation_id = i_s,
+                .ranks = ranks_of_simulation, .attempt = simulations->attempts[i_s]++};
+        if (args->stream) ns_parse_simulations_location(simulations->simulations, i_s, &master_message.location);
 
-            worker = &workers[worker_status.MPI_SOURCE - 1];
-            // Worker is not working
-            worker->working = false;
+        // A worker running the simulation for much longer than predicted has stalled
+        if (args->deadline > 0 && scheduler_predict(scheduler, i_s) > 0) {
+            limit = args->deadline * scheduler_predict(scheduler, i_s);
+            if (limit < MASTER_MIN_DEADLINE) limit = MASTER_MIN_DEADLINE;
         }
 
-        // Check if something is wrong in the logic
-        if (worker->working) {
-            log_error("Sending a simulation to an already working node");
+        // Obtain the group of workers, large simulations go to the least loaded nodes
+        group = dispatcher_select(dispatcher, ranks_of_simulation,
+                                  args->balance_nodes && scheduler_large(scheduler, i_s));
+        if (group == NULL) {
+            log_error("Unable to allocate group of %ld workers", ranks_of_simulation);
             MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
         }
 
-        // Set worker to working to prevent undefined behaviour
-        worker->working = true;
+        // The sends complete while the master prepares the next simulations
+        log_info("Sending simulation %ld to %ld worker%s", master_message.simulation_id, ranks_of_simulation,
+                 ranks_of_simulation > 1 ? "s" : "");
+        dispatcher_send(dispatcher, master_message, group, ranks_of_simulation, limit, message_type);
+        dispatcher_progress(dispatcher, false);
+    }
+    log_info("All simulations processed");
+
+    // Send termination messages, every worker is idle
+    log_info("Sending termination message to all workers");
+    dispatcher_terminate(dispatcher, message_type);
+    dispatcher_progress(dispatcher, true);
+    log_info("Termination messages sent");
+
+    *failed_simulations = dispatch.failed_simulations;
+    available_workers = dispatcher_workers(dispatcher);
+    free(dispatch.failures);
+    dispatcher_free(dispatcher);
+    scheduler_free(scheduler);
+
+    return available_workers;
+}
+
+static uint serve_submasters(const node_master_args_t *const args, master_simulations_t *simulations,
+                             MPI_Datatype message_type, master_container_t *container) {
+    int size;
+    uint nodes_length = 0;
+    uint done_nodes = 0;
+    uint64_t node_workers = 0;
+    scheduler_t *scheduler = NULL;
 
-        // Send simulation metadata
-        log_info("Sending simulation metadata %ld to worker node %d", master_message.simulation_id, worker->rank);
-        MPI_Send(&master_message, 1, message_type, worker->rank, 0, MPI_COMM_WORLD);
-        log_info("Simulation metadata %ld sent", master_message.simulation_id);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
 
-        // Send simulation
-        log_info("Sending simulation %ld to worker node %d", master_message.simulation_id, worker->rank);
-        MPI_Send(simulation_string, (int) strlen(simulation_string) + 1, MPI_CHAR, worker->rank, 0, MPI_COMM_WORLD);
-        log_info("Simulation %ld sent", master_message.simulation_id);
+    // Every rank is a worker, the lowest one of a node is its sub-master
+    for (int r = 0; r < size; ++r) {
+        uint64_t workers = 0;
 
-        free(simulation_string);
+        if (args->nodes[r] != r) continue;
+        nodes_length += 1;
+        for (int w = r; w < size; ++w)
+            if (args->nodes[w] == r) workers += 1;
+        if (workers > node_workers) node_workers = workers;
+    }
+    log_info("Workers available: %d on %d node%s with a sub-master", size, nodes_length, nodes_length > 1 ? "s" : "");
+
+    // Longest simulations first, a simulation uses the workers of a single node
+    scheduler = scheduler_create(simulations->simulations, node_workers);
+    if (scheduler == NULL) {
+        log_error("Unable to allocate scheduler");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    // Sub-masters ask a batch whenever they run dry, then steal from the other nodes once no batch is left
+    if (ns_parse_simulations_complete(simulations->simulations))
+        log_info("Processing %ld simulation%s", simulations->length, simulations->length > 1 ? "s" : "");
+    else log_info("Processing simulations while parsing the simulations file");
+    while (done_nodes < nodes_length) {
+        MPI_Status status;
+
+        MPI_Probe(MPI_ANY_SOURCE, MPI_ANY_TAG, args->container_comm, &status);
+        switch (status.MPI_TAG) {
+            case COM_CONTAINER_TAG:
+                reserve_container_range(container, args->container_comm, status.MPI_SOURCE);
+                break;
+            case COM_BATCH_TAG:
+                serve_batch(args, simulations, scheduler, message_type, status.MPI_SOURCE);
+                break;
+            case COM_DONE_TAG:
+                MPI_Recv(NULL, 0, MPI_BYTE, status.MPI_SOURCE, COM_DONE_TAG, args->container_comm,
+                         MPI_STATUS_IGNORE);
+                log_info("Node of sub-master %d is done", status.MPI_SOURCE);
+                done_nodes += 1;
+                break;
+            default:
+                log_error("Unexpected message with tag %d from rank %d", status.MPI_TAG, status.MPI_SOURCE);
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
     }
     log_info("All simulations processed successfully");
 
-    // Send termination messages
-    log_info("Sending termination message to all workers");
-    for (uint i = 0; i < available_workers; ++i) {
-        worker_t *worker = &workers[i];
-        const com_message_t message = {.terminate = true};
+    // Sub-masters steal from each other until every node is done
+    for (int r = 0; r < size; ++r)
+        if (args->nodes[r] == r) MPI_Send(NULL, 0, MPI_BYTE, r, COM_DONE_TAG, args->master_comm);
 
-        // Check if worker is working
-        if (worker->working) {
-            // Working message not received
-            com_message_t worker_message;
+    scheduler_free(scheduler);
 
-            // Wait message from worker
-            log_info("Worker %ld is working", worker->rank);
-            log_info("Waiting worker %ld availability message...", worker->rank);
-            MPI_Recv(&worker_message, 1, message_type, worker->rank, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-            log_info("Worker %ld message received", worker->rank);
+    return (uint) size;
+}
 
-            // Worker is not working
-            worker->working = false;
+static void serve_batch(const node_master_args_t *const args, master_simulations_t *simulations,
+                        scheduler_t *scheduler, MPI_Datatype message_type, int source) {
+    int size;
+    MPI_Status status;
+    int completions_length;
+    com_message_t *completions = NULL;
+    com_message_t *batch = NULL;
+    int batch_length = 0;
+    int node_workers = 0;
+    uint64_t i_s;
+
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    // Completions of the node since its last batch
+    MPI_Probe(source, COM_BATCH_TAG, args->container_comm, &status);
+    MPI_Get_count(&status, message_type, &completions_length);
+    for (int r = source; r < size; ++r)
+        if (args->nodes[r] == source) node_workers += 1;
+    completions = (com_message_t *) calloc((size_t) completions_length + 1, sizeof(com_message_t));
+    batch = (com_message_t *) calloc((size_t) node_workers, sizeof(com_message_t));
+    if (completions == NULL || batch == NULL) {
+        log_error("Unable to allocate batch of %d simulations", node_workers);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    MPI_Recv(completions, completions_length, message_type, source, COM_BATCH_TAG, args->container_comm,
+             MPI_STATUS_IGNORE);
+
+    // Refine the predicted time of the remaining simulations
+    for (int c = 0; c < completions_length; ++c)
+        scheduler_complete(scheduler, completions[c].simulation_id, completions[c].elapsed);
+
+    // A simulation for every worker of the node, an empty batch once none is left
+    while (batch_length < node_workers) {
+        ns_simulation_t simulation;
+
+        stream_simulations(args, simulations, scheduler);
+        if (!scheduler_next(scheduler, &i_s)) break;
+        if (simulations->done[i_s]) continue;
+        ns_parse_simulations_at(simulations->simulations, i_s, &simulation);
+        batch[batch_length] = (com_message_t) {.terminate = false, .simulation_id = i_s, .ranks = simulation.ranks};
+        if (args->stream) ns_parse_simulations_location(simulations->simulations, i_s, &batch[batch_length].location);
+        batch_length += 1;
+    }
+    log_info("Sending batch of %d simulation%s to sub-master %d", batch_length, batch_length != 1 ? "s" : "",
+             source);
+    MPI_Send(batch, batch_length, message_type, source, COM_BATCH_TAG, args->master_comm);
+
+    free(completions);
+    free(batch);
+}
+
+static void wait_worker(master_dispatch_t *dispatch) {
+    const struct timespec poll = {.tv_sec = 0, .tv_nsec = MASTER_POLL_NANOSECONDS};
+    com_message_t worker_message;
+    MPI_Status worker_status;
+    int received = false;
+
+    // Wait a message, checking the deadlines of the running simulations meanwhile
+    if (dispatch->deadline > 0) {
+        while (!received) {
+            const int stalled = dispatcher_stalled(dispatch->dispatcher);
+            if (stalled >= 0) {
+                log_error("Worker %d stalled past the deadline of its simulation", stalled);
+                lose_worker(dispatch, stalled);
+                return;
+            }
+
+            MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, dispatch->master_comm, &received, &worker_status);
+            if (!received) nanosleep(&poll, NULL);
         }
+    } else {
+        MPI_Probe(MPI_ANY_SOURCE, MPI_ANY_TAG, dispatch->master_comm, &worker_status);
+    }
 
-        // Send termination message
-        log_info("Sending termination message to worker node %d", worker->rank);
-        MPI_Send(&message, 1, message_type, worker->rank, 0, MPI_COMM_WORLD);
-        log_info("Termination message sent");
+    // Reserve the container ranges requested meanwhile, a worker may wait one before completing
+    if (worker_status.MPI_TAG == COM_CONTAINER_TAG) {
+        reserve_container_range(dispatch->container, dispatch->master_comm, worker_status.MPI_SOURCE);
+        return;
     }
-    log_info("Termination messages sent");
 
-    free(workers);
-    ns_parse_simulations_free(simulations);
-    MPI_Type_free(&message_type);
+    MPI_Recv(&worker_message, 1, dispatch->message_type, worker_status.MPI_SOURCE, 0, dispatch->master_comm,
+             MPI_STATUS_IGNORE);
+
+    // Worker completed a task, a lost worker completes too late, its simulations are dispatched again already
+    if (!dispatcher_complete(dispatch->dispatcher, worker_status.MPI_SOURCE)) {
+        log_warn("Ignoring simulation %ld of lost worker %d", worker_message.simulation_id, worker_status.MPI_SOURCE);
+        return;
+    }
+
+    if (worker_message.failed) {
+        log_warn("Worker %d failed simulation %ld", worker_status.MPI_SOURCE, worker_message.simulation_id);
+        retry_simulation(dispatch, &worker_message);
+
+        // A worker failing every simulation would take the attempts of all of them
+        if (++dispatch->failures[worker_status.MPI_SOURCE] == MASTER_WORKER_FAILURES) {
+            log_error("Worker %d failed %d simulations in a row", worker_status.MPI_SOURCE, MASTER_WORKER_FAILURES);
+            lose_worker(dispatch, worker_status.MPI_SOURCE);
+        }
+        return;
+    }
+    dispatch->failures[worker_status.MPI_SOURCE] = 0;
+    log_info("Worker %ld has successfully completed simulation %ld", worker_status.MPI_SOURCE,
+             worker_message.simulation_id);
+    log_info("Worker %ld can work", worker_status.MPI_SOURCE);
+    dispatch->simulations->completed[worker_message.simulation_id] = true;
+
+    // Refine the predicted time of the remaining simulations
+    scheduler_complete(dispatch->scheduler, worker_message.simulation_id, worker_message.elapsed);
+}
+
+static void lose_worker(master_dispatch_t *dispatch, int rank) {
+    com_message_t messages[DISPATCHER_QUEUED_TASKS + 1];
+    unsigned int tasks;
+
+    // The worker may never answer, it receives no more tasks and its results are dropped
+    tasks = dispatcher_lose(dispatch->dispatcher, rank, messages);
+    log_warn("Worker %d is lost, dispatching its %d task%s again", rank, tasks, tasks != 1 ? "s" : "");
+    dispatch->container->lost[rank] = true;
+    dispatch->container->lost_workers += 1;
+    if (dispatcher_workers(dispatch->dispatcher) == 0) {
+        log_error("Every worker is lost");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    for (unsigned int task = 0; task < tasks; ++task) retry_simulation(dispatch, &messages[task]);
+}
+
+static void retry_simulation(master_dispatch_t *dispatch, const com_message_t *const message) {
+    const uint64_t simulation_id = message->simulation_id;
+
+    // A simulation of a group is dispatched again once, by the first rank of the group that fails or stalls
+    if (dispatch->simulations->completed[simulation_id]
+        || message->attempt + 1 != dispatch->simulations->attempts[simulation_id])
+        return;
+
+    if (dispatch->simulations->attempts[simulation_id] == MASTER_SIMULATION_ATTEMPTS) {
+        log_error("Simulation %ld failed %d times, giving up", simulation_id, MASTER_SIMULATION_ATTEMPTS);
+        dispatch->simulations->completed[simulation_id] = true;
+        dispatch->failed_simulations += 1;
+        return;
+    }
+
+    // Next simulation dispatched, by an idle worker first
+    log_warn("Dispatching simulation %ld again", simulation_id);
+    scheduler_retry(dispatch->scheduler, simulation_id);
+}
+
+static void reserve_container_range(master_container_t *container, MPI_Comm container_comm, int source) {
+    com_container_message_t message;
+    MPI_Status status;
+    int metadata_length;
+    char *metadata;
+    container_entry_t *entry;
+
+    MPI_Recv(&message, 1, container->message_type, source, COM_CONTAINER_TAG, container_comm, MPI_STATUS_IGNORE);
+    if (message.done) {
+        if (container->lost[source]) return;
+        log_info("Worker %d saved every result", source);
+        container->done_workers += 1;
+        return;
+    }
+
+    // Result metadata
+    MPI_Probe(source, COM_CONTAINER_TAG, container_comm, &status);
+    MPI_Get_count(&status, MPI_CHAR, &metadata_length);
+    metadata = (char *) calloc((size_t) metadata_length + 1, sizeof(char));
+    if (metadata == NULL) {
+        log_error("Unable to allocate container metadata of %d chars", metadata_length);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    MPI_Recv(metadata, metadata_length, MPI_CHAR, source, COM_CONTAINER_TAG, container_comm, MPI_STATUS_IGNORE);
+
+    // The simulations of a lost worker are dispatched again, its result is dropped without reply
+    if (container->lost[source]) {
+        log_warn("Dropping simulation %ld of lost worker %d", message.simulation_id, source);
+        free(metadata);
+        return;
+    }
+
+    // Grow the table of contents
+    if (container->entries_length == container->entries_capacity) {
+        const uint64_t capacity = container->entries_capacity > 0 ? 2 * container->entries_capacity
+                                                                  : CONTAINER_ENTRIES_CAPACITY;
+        container_entry_t *entries = (container_entry_t *) realloc(container->entries,
+                                                                   capacity * sizeof(container_entry_t));
+        if (entries == NULL) {
+            log_error("Unable to grow container table of contents");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        container->entries = entries;
+        container->entries_capacity = capacity;
+    }
+    entry = &container->entries[container->entries_length];
+
+    // Results are appended in the order they are completed
+    entry->metadata = metadata;
+    entry->simulation_id = message.simulation_id;
+    entry->rank = source;
+    entry->format = message.format;
+    entry->offset = container->offset;
+    entry->length = message.length;
+    container->offset += message.length;
+    container->entries_length += 1;
+
+    log_debug("Reserving container range [%ld, %ld) to simulation %ld of worker %d", entry->offset,
+              entry->offset + entry->length, entry->simulation_id, source);
+    MPI_Send(&entry->offset, 1, MPI_UINT64_T, source, COM_CONTAINER_TAG, MPI_COMM_WORLD);
 }
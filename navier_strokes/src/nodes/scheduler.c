@@ -0,0 +1,281 @@
+#include "ns/nodes/scheduler.h"
+#include <stdlib.h>
+
+// Advection, divergence, gradient and boundaries of a tick, in relaxation sweeps
+#define SCHEDULER_TICK_SWEEPS 8.0
+// Multigrid cycle, in relaxation sweeps of the finest level
+#define SCHEDULER_CYCLE_SWEEPS 8.0
+// Simulations are grouped by solver, each group with its own measured throughput
+#define SCHEDULER_CLASSES ((NS_RELAXATION_RED_BLACK + 1) * (NS_PRESSURE_SOLVER_MULTIGRID + 1))
+// Initial capacity of the simulations, and of the remaining simulations of a class
+#define SCHEDULER_CAPACITY 64
+
+// Simulation waiting to be dispatched
+typedef struct scheduler_item_t {
+    uint64_t simulation_id;
+    // Estimated cost of a rank
+    double cost;
+} scheduler_item_t;
+
+// Simulations with the same solver
+typedef struct scheduler_class_t {
+    // Remaining simulations, a heap with the highest cost first
+    scheduler_item_t *items;
+    uint64_t length;
+    uint64_t capacity;
+    // Seconds and estimated cost of the ranks of the completed simulations
+    double seconds;
+    double cost;
+} scheduler_class_t;
+
+struct scheduler_t {
+    uint64_t workers;
+    uint64_t simulations_length;
+    uint64_t simulations_capacity;
+    // Estimated cost of a rank and class of every simulation
+    double *costs;
+    unsigned int *classes_of;
+    double total_cost;
+    scheduler_class_t classes[SCHEDULER_CLASSES];
+};
+
+/**
+ * Private definitions
+ */
+static double estimate_cost(const ns_simulation_t *simulation, uint64_t workers);
+
+static unsigned int simulation_class(const ns_simulation_t *simulation);
+
+static double seconds_per_cost(const scheduler_t *scheduler, unsigned int class);
+
+static bool push_item(scheduler_class_t *class, scheduler_item_t item);
+
+static scheduler_item_t pop_item(scheduler_class_t *class);
+
+static bool before_item(const scheduler_item_t *a, const scheduler_item_t *b);
+/**
+ * END Private definitions
+ */
+
+/**
+ * Public
+ */
+scheduler_t *scheduler_create(const ns_simulations_t *const simulations, uint64_t workers) {
+    scheduler_t *scheduler;
+
+    scheduler = (scheduler_t *) calloc(1, sizeof(scheduler_t));
+    if (scheduler == NULL) return NULL;
+    scheduler->workers = workers;
+
+    // Estimate the cost of every simulation parsed so far
+    if (!scheduler_update(scheduler, simulations)) {
+        scheduler_free(scheduler);
+        return NULL;
+    }
+
+    return scheduler;
+}
+
+bool scheduler_update(scheduler_t *scheduler, const ns_simulations_t *const simulations) {
+    const uint64_t length = ns_parse_simulations_length(simulations);
+
+    // Grow the costs and the classes of the simulations
+    if (length > scheduler->simulations_capacity) {
+        uint64_t capacity = scheduler->simulations_capacity > 0 ? scheduler->simulations_capacity
+                                                                : SCHEDULER_CAPACITY;
+        while (capacity < length) capacity *= 2;
+
+        double *costs = (double *) realloc(scheduler->costs, capacity * sizeof(double));
+        if (costs != NULL) scheduler->costs = costs;
+        unsigned int *classes_of = (unsigned int *) realloc(scheduler->classes_of, capacity * sizeof(unsigned int));
+        if (classes_of != NULL) scheduler->classes_of = classes_of;
+        if (costs == NULL || classes_of == NULL) return false;
+
+        scheduler->simulations_capacity = capacity;
+    }
+
+    // Within a class the predicted times keep the order of the costs
+    for (uint64_t i = scheduler->simulations_length; i < length; ++i) {
+        ns_simulation_t simulation;
+
+        if (!ns_parse_simulations_at(simulations, i, &simulation)) return false;
+        scheduler->costs[i] = estimate_cost(&simulation, scheduler->workers);
+        scheduler->classes_of[i] = simulation_class(&simulation);
+        scheduler->total_cost += scheduler->costs[i];
+        if (!push_item(&scheduler->classes[scheduler->classes_of[i]],
+                       (scheduler_item_t) {.simulation_id = i, .cost = scheduler->costs[i]}))
+            return false;
+        scheduler->simulations_length = i + 1;
+    }
+
+    return true;
+}
+
+uint64_t scheduler_pending(const scheduler_t *const scheduler) {
+    uint64_t pending = 0;
+
+    for (unsigned int c = 0; c < SCHEDULER_CLASSES; ++c) pending += scheduler->classes[c].length;
+
+    return pending;
+}
+
+bool scheduler_next(scheduler_t *scheduler, uint64_t *simulation_id) {
+    scheduler_class_t *next = NULL;
+    double next_time = 0;
+
+    // The longest predicted simulation is the first of a class
+    for (unsigned int c = 0; c < SCHEDULER_CLASSES; ++c) {
+        scheduler_class_t *const class = &scheduler->classes[c];
+        if (class->length == 0) continue;
+
+        const scheduler_item_t *const item = &class->items[0];
+        const double time = item->cost * seconds_per_cost(scheduler, c);
+        if (next == NULL || time > next_time
+            || (time == next_time && item->simulation_id < next->items[0].simulation_id)) {
+            next = class;
+            next_time = time;
+        }
+    }
+    if (next == NULL) return false;
+
+    *simulation_id = pop_item(next).simulation_id;
+    return true;
+}
+
+bool scheduler_large(const scheduler_t *const scheduler, uint64_t simulation_id) {
+    if (simulation_id >= scheduler->simulations_length) return false;
+
+    return scheduler->costs[simulation_id] > scheduler->total_cost / (double) scheduler->simulations_length;
+}
+
+double scheduler_predict(const scheduler_t *const scheduler, uint64_t simulation_id) {
+    double cost = 0;
+
+    if (simulation_id >= scheduler->simulations_length) return 0;
+
+    // No throughput measured yet
+    for (unsigned int c = 0; c < SCHEDULER_CLASSES; ++c) cost += scheduler->classes[c].cost;
+    if (cost == 0) return 0;
+
+    return scheduler->costs[simulation_id] * seconds_per_cost(scheduler, scheduler->classes_of[simulation_id]);
+}
+
+void scheduler_retry(scheduler_t *scheduler, uint64_t simulation_id) {
+    if (simulation_id >= scheduler->simulations_length) return;
+
+    // The simulation was taken from its class, there is room for it
+    push_item(&scheduler->classes[scheduler->classes_of[simulation_id]],
+              (scheduler_item_t) {.simulation_id = simulation_id, .cost = scheduler->costs[simulation_id]});
+}
+
+void scheduler_complete(scheduler_t *scheduler, uint64_t simulation_id, double elapsed) {
+    if (simulation_id >= scheduler->simulations_length || elapsed <= 0) return;
+
+    scheduler_class_t *const class = &scheduler->classes[scheduler->classes_of[simulation_id]];
+    class->seconds += elapsed;
+    class->cost += scheduler->costs[simulation_id];
+}
+
+void scheduler_free(scheduler_t *scheduler) {
+    if (scheduler == NULL) return;
+
+    for (unsigned int c = 0; c < SCHEDULER_CLASSES; ++c) free(scheduler->classes[c].items);
+    free(scheduler->costs);
+    free(scheduler->classes_of);
+    free(scheduler);
+}
+/**
+ * END Public
+ */
+
+/**
+ * Private
+ */
+static double estimate_cost(const ns_simulation_t *const simulation, uint64_t workers) {
+    const ns_solver_config_t *const solver = &simulation->solver;
+    const double cells = (double) (simulation->world.width + 2) * (double) (simulation->world.height + 2);
+    uint64_t ranks = simulation->ranks < workers ? simulation->ranks : workers;
+    double sweeps;
+
+    // Three diffuse solves and two pressure solves every tick
+    sweeps = SCHEDULER_TICK_SWEEPS + 3.0 * (double) solver->max_iterations;
+    if (solver->pressure == NS_PRESSURE_SOLVER_MULTIGRID)
+        sweeps += 2.0 * SCHEDULER_CYCLE_SWEEPS * (double) solver->multigrid.max_cycles;
+    else
+        sweeps += 2.0 * (double) solver->max_iterations;
+
+    // The tiles of a decomposed world are computed together
+    if (ranks == 0) ranks = 1;
+    return cells * (double) (simulation->ticks + 1) * sweeps / (double) ranks;
+}
+
+static unsigned int simulation_class(const ns_simulation_t *const simulation) {
+    return (unsigned int) simulation->solver.relaxation * (NS_PRESSURE_SOLVER_MULTIGRID + 1)
+           + (unsigned int) simulation->solver.pressure;
+}
+
+static double seconds_per_cost(const scheduler_t *const scheduler, unsigned int class) {
+    double seconds = 0;
+    double cost = 0;
+
+    // Throughput of the class, of every class until one of its simulations completes
+    if (scheduler->classes[class].cost > 0)
+        return scheduler->classes[class].seconds / scheduler->classes[class].cost;
+
+    for (unsigned int c = 0; c < SCHEDULER_CLASSES; ++c) {
+        seconds += scheduler->classes[c].seconds;
+        cost += scheduler->classes[c].cost;
+    }
+
+    return cost > 0 ? seconds / cost : 1;
+}
+
+static bool push_item(scheduler_class_t *class, scheduler_item_t item) {
+    uint64_t i = class->length;
+
+    // Grow the heap
+    if (class->length == class->capacity) {
+        const uint64_t capacity = class->capacity > 0 ? 2 * class->capacity : SCHEDULER_CAPACITY;
+        scheduler_item_t *items = (scheduler_item_t *) realloc(class->items, capacity * sizeof(scheduler_item_t));
+        if (items == NULL) return false;
+
+        class->items = items;
+        class->capacity = capacity;
+    }
+
+    // Sift up
+    for (; i > 0 && before_item(&item, &class->items[(i - 1) / 2]); i = (i - 1) / 2)
+        class->items[i] = class->items[(i - 1) / 2];
+    class->items[i] = item;
+    class->length += 1;
+
+    return true;
+}
+
+static scheduler_item_t pop_item(scheduler_class_t *class) {
+    const scheduler_item_t first = class->items[0];
+    const scheduler_item_t last = class->items[--class->length];
+    uint64_t i = 0;
+
+    // Sift the last item down from the root
+    while (2 * i + 1 < class->length) {
+        uint64_t child = 2 * i + 1;
+        if (child + 1 < class->length && before_item(&class->items[child + 1], &class->items[child])) child += 1;
+        if (!before_item(&class->items[child], &last)) break;
+
+        class->items[i] = class->items[child];
+        i = child;
+    }
+    class->items[i] = last;
+
+    return first;
+}
+
+static bool before_item(const scheduler_item_t *const a, const scheduler_item_t *const b) {
+    // Decreasing cost, then file order
+    if (a->cost != b->cost) return a->cost > b->cost;
+    return a->simulation_id < b->simulation_id;
+}
+/**
+ * END Private
+ */
@@ -0,0 +1,289 @@
+#include "ns/nodes/submaster.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "ns/utils/logger.h"
+#include "ns/utils/container.h"
+#include "ns/nodes/com/message.h"
+#include "ns/nodes/dispatcher.h"
+
+#define MASTER_NODE_RANK 0
+
+// State of a sub-master, the simulations of its node and the batch it waits
+typedef struct submaster_t {
+    const node_submaster_args_t *args;
+    int rank;
+    MPI_Datatype message_type;
+    dispatcher_t *dispatcher;
+    // Simulations received and not dispatched yet, in dispatch order
+    com_message_t *queue;
+    int queue_head;
+    int queue_length;
+    // Completions not reported to the master yet
+    com_message_t *completions;
+    int completions_length;
+    int completions_capacity;
+    // Other sub-masters, the ones to steal from
+    int *victims;
+    int victims_length;
+    // Victims asked in a row without stealing anything
+    int victims_tried;
+    // Batch requested and not received yet
+    bool pending;
+    // Master has no batch left
+    bool master_empty;
+    // Every node is done
+    bool stopped;
+} submaster_t;
+
+static void *run_local_worker(void *args);
+
+static void request_batch(submaster_t *submaster);
+
+static void handle_message(submaster_t *submaster);
+
+static void receive_batch(submaster_t *submaster, int source, int tag);
+
+static void give_batch(submaster_t *submaster, int source);
+
+void do_submaster(const node_submaster_args_t *const args) {
+    int size;
+    submaster_t submaster = {.args = args};
+    int *ranks = NULL;
+    int workers_length = 0;
+    node_worker_local_t local;
+    node_worker_args_t local_args;
+    pthread_t local_thread;
+    MPI_Win simulations_window;
+    char file_error[MPI_MAX_ERROR_STRING + 1];
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &submaster.rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    com_message_MPI_datatype(&submaster.message_type);
+
+    // Container and simulations shared with the master, already on the rank of the master
+    if (args->local != NULL) {
+        local = *args->local;
+    } else {
+        local.container = NULL;
+        if (args->container_path != NULL) {
+            local.container = container_open(MPI_COMM_WORLD, args->container_path, file_error);
+            if (local.container == NULL) {
+                log_error("Error creating container %s: %s", args->container_path, file_error);
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+            }
+        }
+        local.simulations_image = NULL;
+        local.simulations_image_length = 0;
+        if (args->worker_args->simulations_path == NULL)
+            local.simulations_image = com_share_simulations(MASTER_NODE_RANK, NULL,
+                                                            &local.simulations_image_length, &simulations_window);
+    }
+
+    // Workers of the node, the one of the sub-master rank is the last one, it is busy dispatching too
+    ranks = (int *) calloc((size_t) size, sizeof(int));
+    submaster.victims = (int *) calloc((size_t) size, sizeof(int));
+    if (ranks == NULL || submaster.victims == NULL) {
+        log_error("Unable to allocate workers");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    for (int r = 0; r < size; ++r)
+        if (args->nodes[r] == submaster.rank && r != submaster.rank) ranks[workers_length++] = r;
+    ranks[workers_length++] = submaster.rank;
+    submaster.dispatcher = dispatcher_create(ranks, args->nodes, (unsigned int) workers_length);
+    submaster.queue = (com_message_t *) calloc((size_t) size, sizeof(com_message_t));
+    if (submaster.dispatcher == NULL || submaster.queue == NULL) {
+        log_error("Unable to allocate workers");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    free(ranks);
+    log_info("Sub-master of %d worker%s", workers_length, workers_length > 1 ? "s" : "");
+
+    // Other sub-masters, starting from the next one so that thieves spread over the nodes
+    for (int i = 1; i < size; ++i) {
+        const int r = (submaster.rank + i) % size;
+        if (args->nodes[r] == r) submaster.victims[submaster.victims_length++] = r;
+    }
+
+    // Worker of the sub-master rank, it computes while this thread dispatches
+    local_args = *args->worker_args;
+    local_args.local = &local;
+    if (pthread_create(&local_thread, NULL, run_local_worker, &local_args) != 0) {
+        log_error("Unable to start the worker of the sub-master rank");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    while (true) {
+        // Dispatch the queued simulations while the workers have room
+        while (submaster.queue_head < submaster.queue_length) {
+            const com_message_t message = submaster.queue[submaster.queue_head];
+            int *group;
+
+            if (dispatcher_available(submaster.dispatcher) < message.ranks) break;
+
+            group = dispatcher_select(submaster.dispatcher, message.ranks, false);
+            if (group == NULL) {
+                log_error("Unable to allocate group of %ld workers", message.ranks);
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+            }
+            log_info("Sending simulation %ld to %ld worker%s", message.simulation_id, message.ranks,
+                     message.ranks > 1 ? "s" : "");
+            dispatcher_send(submaster.dispatcher, message, group, message.ranks, 0, submaster.message_type);
+            submaster.queue_head += 1;
+        }
+        dispatcher_progress(submaster.dispatcher, false);
+
+        // Ask a batch to the master, then to the other sub-masters, once the queue is empty
+        if (submaster.queue_head == submaster.queue_length && !submaster.pending) {
+            if (submaster.master_empty && submaster.victims_tried == submaster.victims_length) break;
+            request_batch(&submaster);
+        }
+
+        handle_message(&submaster);
+    }
+    log_info("All simulations of the node processed successfully");
+
+    // Send termination messages, received by every worker after its last task
+    dispatcher_terminate(submaster.dispatcher, submaster.message_type);
+    while (dispatcher_tasks(submaster.dispatcher) > 0) handle_message(&submaster);
+    dispatcher_progress(submaster.dispatcher, true);
+
+    // Keep answering the thieves until every node is done
+    MPI_Send(NULL, 0, MPI_BYTE, MASTER_NODE_RANK, COM_DONE_TAG, args->container_comm);
+    while (!submaster.stopped) handle_message(&submaster);
+    log_info("Every node is done");
+
+    // Wait the pending results of the worker of the sub-master rank
+    pthread_join(local_thread, NULL);
+    if (args->local == NULL) {
+        if (local.container != NULL && !container_close(local.container, file_error)) {
+            log_error("Error saving container %s: %s", args->container_path, file_error);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        if (args->worker_args->simulations_path == NULL) com_simulations_free(&simulations_window);
+    }
+
+    dispatcher_free(submaster.dispatcher);
+    free(submaster.queue);
+    free(submaster.completions);
+    free(submaster.victims);
+    MPI_Type_free(&submaster.message_type);
+}
+
+static void *run_local_worker(void *args) {
+    do_worker((const node_worker_args_t *) args);
+    return NULL;
+}
+
+static void request_batch(submaster_t *submaster) {
+    if (!submaster->master_empty) {
+        // Completions refine the predicted time of the simulations left on the master
+        log_debug("Requesting batch to master");
+        MPI_Send(submaster->completions, submaster->completions_length, submaster->message_type, MASTER_NODE_RANK,
+                 COM_BATCH_TAG, submaster->args->container_comm);
+        submaster->completions_length = 0;
+    } else {
+        const int victim = submaster->victims[submaster->victims_tried];
+
+        log_debug("Stealing batch from sub-master %d", victim);
+        MPI_Send(NULL, 0, MPI_BYTE, victim, COM_STEAL_TAG, submaster->args->master_comm);
+    }
+    submaster->pending = true;
+}
+
+static void handle_message(submaster_t *submaster) {
+    com_message_t worker_message;
+    MPI_Status status;
+
+    MPI_Probe(MPI_ANY_SOURCE, MPI_ANY_TAG, submaster->args->master_comm, &status);
+    switch (status.MPI_TAG) {
+        case 0:
+            MPI_Recv(&worker_message, 1, submaster->message_type, status.MPI_SOURCE, 0, submaster->args->master_comm,
+                     MPI_STATUS_IGNORE);
+            // Simulations are re-dispatched only by the master without sub-masters
+            if (worker_message.failed) {
+                log_error("Worker %d failed simulation %ld", status.MPI_SOURCE, worker_message.simulation_id);
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+            }
+            log_info("Worker %d has successfully completed simulation %ld", status.MPI_SOURCE,
+                     worker_message.simulation_id);
+            dispatcher_complete(submaster->dispatcher, status.MPI_SOURCE);
+
+            // Reported with the next batch request, useless once the master has none left
+            if (submaster->master_empty) break;
+            if (submaster->completions_length == submaster->completions_capacity) {
+                const int capacity = submaster->completions_capacity > 0 ? 2 * submaster->completions_capacity : 16;
+                com_message_t *completions = (com_message_t *) realloc(submaster->completions,
+                                                                       (size_t) capacity * sizeof(com_message_t));
+                if (completions == NULL) {
+                    log_error("Unable to grow completions");
+                    MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+                }
+                submaster->completions = completions;
+                submaster->completions_capacity = capacity;
+            }
+            submaster->completions[submaster->completions_length++] = worker_message;
+            break;
+        case COM_BATCH_TAG:
+        case COM_STOLEN_TAG:
+            receive_batch(submaster, status.MPI_SOURCE, status.MPI_TAG);
+            break;
+        case COM_STEAL_TAG:
+            give_batch(submaster, status.MPI_SOURCE);
+            break;
+        case COM_DONE_TAG:
+            MPI_Recv(NULL, 0, MPI_BYTE, status.MPI_SOURCE, COM_DONE_TAG, submaster->args->master_comm,
+                     MPI_STATUS_IGNORE);
+            submaster->stopped = true;
+            break;
+        default:
+            log_error("Unexpected message with tag %d from rank %d", status.MPI_TAG, status.MPI_SOURCE);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+}
+
+static void receive_batch(submaster_t *submaster, int source, int tag) {
+    MPI_Status status;
+    int length;
+
+    // Batches are requested only once the queue is empty, the queue has room for a simulation of every rank
+    MPI_Probe(source, tag, submaster->args->master_comm, &status);
+    MPI_Get_count(&status, submaster->message_type, &length);
+    MPI_Recv(submaster->queue, length, submaster->message_type, source, tag, submaster->args->master_comm,
+             MPI_STATUS_IGNORE);
+    submaster->queue_head = 0;
+    submaster->queue_length = length;
+    submaster->pending = false;
+
+    // A simulation uses the workers of a single node
+    for (int i = 0; i < length; ++i) {
+        com_message_t *const message = &submaster->queue[i];
+
+        if (message->ranks > dispatcher_workers(submaster->dispatcher)) {
+            log_warn("Simulation %ld requests %ld ranks but only %d workers are on the node", message->simulation_id,
+                     message->ranks, dispatcher_workers(submaster->dispatcher));
+            message->ranks = dispatcher_workers(submaster->dispatcher);
+        }
+    }
+
+    if (tag == COM_BATCH_TAG) {
+        log_info("Received batch of %d simulation%s from master", length, length != 1 ? "s" : "");
+        if (length == 0) submaster->master_empty = true;
+    } else {
+        log_info("Stolen %d simulation%s from sub-master %d", length, length != 1 ? "s" : "", source);
+        // Every victim is asked again after a successful steal
+        submaster->victims_tried = length > 0 ? 0 : submaster->victims_tried + 1;
+    }
+}
+
+static void give_batch(submaster_t *submaster, int source) {
+    const int queued = submaster->queue_length - submaster->queue_head;
+    // The thief takes the last half of the queue, the shortest simulations
+    const int given = queued / 2;
+
+    MPI_Recv(NULL, 0, MPI_BYTE, source, COM_STEAL_TAG, submaster->args->master_comm, MPI_STATUS_IGNORE);
+    submaster->queue_length -= given;
+    log_info("Sub-master %d stole %d simulation%s", source, given, given != 1 ? "s" : "");
+    MPI_Send(&submaster->queue[submaster->queue_length], given, submaster->message_type, source, COM_STOLEN_TAG,
+             submaster->args->master_comm);
+}
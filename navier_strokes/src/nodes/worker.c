@@ -1,45 +1,255 @@
 #include "ns/nodes/worker.h"
 #include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
 #include <mpi.h>
 #include <cJSON.h>
 #include "ns/solver.h"
+#include "ns/kernels.h"
 #include "ns/utils/logger.h"
 #include "ns/utils/parser.h"
+#include "ns/utils/pack.h"
 #include "ns/utils/file.h"
+#include "ns/utils/validate.h"
+#include "ns/utils/snapshot.h"
+#include "ns/utils/snapshot_queue.h"
+#include "ns/utils/container.h"
+#include "ns/utils/checkpoint.h"
+#include "ns/utils/cache.h"
+#include "ns/utils/time_measurement.h"
 #include "ns/nodes/com/message.h"
 
 #define MASTER_NODE_RANK 0
 #define RESULT_FILE_MAX_NAME_LENGTH 64
+// Snapshot copies queued to the I/O thread, tick N is saved while tick N + 1 is computed
+#define SNAPSHOT_QUEUE_CAPACITY 2
+
+// Result of a simulation, saved by the I/O thread
+typedef struct worker_result_t {
+    uint64_t simulation_id;
+    char *save_location;
+    // Folder of reference results, NULL to skip validation
+    const char *validate_path;
+    // JSON result, holds only the metadata with the binary format
+    cJSON *json;
+    cJSON *snapshots;
+    cJSON *iterations;
+    // Binary file writer, NULL with the JSON format
+    snapshot_writer_t *writer;
+    // Saved snapshots
+    snapshot_output_t output;
+    snapshot_format_t format;
+    // Container of the results and its message datatype, NULL to save the result in its own file
+    container_t *container;
+    MPI_Datatype container_message_type;
+    // Communicator of the container messages sent to the master
+    MPI_Comm container_comm;
+    // Journal of the saved snapshots in the checkpoints folder, NULL without checkpoints
+    snapshot_writer_t *journal;
+    char *journal_path;
+    // Checkpoints folder and done marker of the simulation, written once the result is saved
+    const char *checkpoint_path;
+    checkpoint_t done;
+    // Cache folder and result key of the simulation, NULL if the result is not cached
+    const char *cache_path;
+    uint8_t *cache_key;
+    uint64_t cache_key_length;
+    // Cache location of the journal, moved there once the result is saved, NULL if the state is not cached
+    char *cache_journal_path;
+} worker_result_t;
+
+// Checkpoints of the simulation being computed
+typedef struct worker_checkpoints_t {
+    // Checkpoints folder, NULL without checkpoints
+    const char *directory;
+    checkpoint_run_t run;
+    uint64_t simulation_id;
+    // Ranks of the simulation and rank of the worker among them
+    uint64_t ranks;
+    uint64_t rank;
+    // Packed simulation, before it is adapted to its ranks
+    uint8_t *parameters;
+    uint64_t parameters_length;
+    // Seconds between two checkpoints and time of the last one
+    double interval;
+    double last;
+    // Restore from the checkpoints folder, not only from the cache
+    bool restore;
+    uint64_t ticks;
+    // Cache folder, NULL without cache
+    const char *cache_directory;
+    // Result and prefix keys of the simulation, NULL if not cached because its ranks are adapted to the workers
+    uint8_t *key;
+    uint64_t key_length;
+    uint8_t *prefix;
+    uint64_t prefix_length;
+} worker_checkpoints_t;
+
+// Checkpoint of a rank, written by the I/O thread after the snapshots of its ticks
+typedef struct worker_checkpoint_t {
+    checkpoint_t checkpoint;
+    char *file_path;
+    // Result of the simulation on its root, its journal is flushed first, NULL on the other ranks
+    worker_result_t *result;
+} worker_checkpoint_t;
+
+// Task received from the master, the next one is received while the current one is computed
+typedef struct worker_task_t {
+    com_message_t message;
+    // Ranks sharing the simulation, NULL if not shared
+    int *group;
+    // Rank dispatching the task
+    int master_rank;
+    // Receives of the message and of the group
+    MPI_Request requests[2];
+} worker_task_t;
+
+static void post_task(worker_task_t *task, int master_rank, MPI_Datatype message_type);
+
+static void progress_task(worker_task_t *task);
+
+static void wait_task(worker_task_t *task);
+
+static void post_task_group(worker_task_t *task);
+
+static ns_t *create_ns(const ns_simulation_t *simulation, MPI_Comm simulation_comm);
+
+static worker_result_t *create_result(const node_worker_args_t *args, const com_message_t *message,
+                                      const ns_simulation_t *simulation, container_t *container,
+                                      MPI_Datatype container_message_type, int rank,
+                                      const worker_checkpoints_t *checkpoints);
+
+static void free_result(worker_result_t *result);
+
+static uint64_t restore_checkpoint(const worker_checkpoints_t *checkpoints, ns_t *ns, MPI_Comm simulation_comm,
+                                   worker_result_t *result, snapshot_queue_t *queue, ns_tick_stats_t *stats);
+
+static bool restorable(const checkpoint_t *checkpoint, const char *journal_path, const ns_t *ns, uint64_t ticks,
+                       uint64_t every);
+
+static bool journal_complete(const char *journal_path, uint64_t tick, uint64_t every);
+
+static void replay_journal(const char *journal_path, uint64_t tick, worker_result_t *result,
+                           snapshot_queue_t *queue);
+
+static void queue_checkpoint(worker_checkpoints_t *checkpoints, const ns_t *ns, MPI_Comm simulation_comm,
+                             ns_tick_stats_t stats, worker_result_t *result, snapshot_queue_t *queue);
+
+static void push_checkpoint(const worker_checkpoints_t *checkpoints, const ns_t *ns, ns_tick_stats_t stats,
+                            worker_result_t *result, snapshot_queue_t *queue, char *file_path,
+                            const uint8_t *parameters, uint64_t parameters_length);
+
+static void report_failure(const node_worker_args_t *args, const com_message_t *message, MPI_Datatype message_type);
 
 static ns_parse_simulation_mod_t *find_mod_by_tick(const ns_simulation_t *simulation, uint64_t tick);
 
 static bool write_simulation_metadata_to_result(cJSON *result_json, const ns_simulation_t *simulation);
 
+static bool add_tick_stats_to_iterations(cJSON *iterations_json, uint64_t tick, ns_tick_stats_t stats);
+
+static bool add_validation_to_metadata(cJSON *result_json, const char *validate_path, uint64_t simulation_id);
+
+static bool add_compression_to_metadata(cJSON *result_json, const snapshot_layout_t *layout);
+
+static void save_snapshot(void *context, const ns_world_t *world, ns_tick_stats_t stats);
+
+static void journal_snapshot(worker_result_t *result, const ns_world_t *world, ns_tick_stats_t stats);
+
+static void save_result(void *context, const ns_world_t *world, ns_tick_stats_t stats);
+
+static void save_result_to_container(worker_result_t *result, void *content, uint64_t length);
+
+static void save_checkpoint(void *context, const ns_world_t *world, ns_tick_stats_t stats);
+
+static void discard_checkpoint(void *context, const ns_world_t *world, ns_tick_stats_t stats);
+
+static void mark_done(worker_result_t *result);
+
 void do_worker(const node_worker_args_t *const args) {
     int rank;
     int size;
     MPI_Datatype message_type;
     com_message_t message = {.terminate = false};
-    MPI_Status status;
-    char *simulation_string = NULL;
-    int simulation_string_length;
+    worker_task_t tasks[2];
+    uint current = 0;
+    const uint8_t *simulations_image = NULL;
+    uint64_t simulations_image_length;
+    MPI_Win simulations_window;
+    const char *simulations_text = NULL;
+    uint64_t simulations_text_length = 0;
+    int *group = NULL;
+    MPI_Comm simulation_comm = MPI_COMM_NULL;
+    bool root;
     ns_simulation_t *simulation = NULL;
     ns_t *ns = NULL;
-    ns_world_t *world = NULL;
-    cJSON *result_json = NULL;
+    ns_world_t world;
+    int thread_level;
+    snapshot_queue_t *queue = NULL;
+    container_t *container = NULL;
+    MPI_Datatype container_message_type;
+    worker_checkpoints_t checkpoints = {.directory = args->checkpoint_path,
+            .interval = args->checkpoint_interval, .cache_directory = args->cache_path};
+    time_measurement_t time;
+    char file_error[MPI_MAX_ERROR_STRING + 1];
 
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
     com_message_MPI_datatype(&message_type);
 
-    // Lifecycle
+    log_info("Solver kernels instruction set: %s", ns_kernels_isa_string(ns_kernels_best()->isa));
+    log_info("Solver fields precision: %s", NS_REAL_PRECISION);
+
+    // Snapshots are saved by an I/O thread only if it may call MPI too
+    MPI_Query_thread(&thread_level);
+    queue = snapshot_queue_create(thread_level == MPI_THREAD_MULTIPLE ? SNAPSHOT_QUEUE_CAPACITY : 0);
+    if (queue == NULL) {
+        log_error("Unable to create snapshot queue");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    if (thread_level == MPI_THREAD_MULTIPLE) log_info("Saving snapshots with an I/O thread");
+    else log_warn("MPI does not support multiple threads, saving snapshots synchronously");
+
+    // Container shared with the master and the other workers, already open on the rank of a master or sub-master
+    if (args->container_path != NULL) {
+        container = args->local != NULL ? args->local->container
+                                        : container_open(MPI_COMM_WORLD, args->container_path, file_error);
+        if (container == NULL) {
+            log_error("Error creating container %s: %s", args->container_path, file_error);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+    }
+    com_container_message_MPI_datatype(&container_message_type);
+
+    // Simulations shared by the master, a task holds only the simulation id
+    if (args->simulations_path != NULL) {
+        // A task of a streamed simulations file holds the location of its simulation too
+        simulations_text = map_file(args->simulations_path, &simulations_text_length, file_error);
+        if (simulations_text == NULL) {
+            log_error("Error opening and managing simulations file: %s", file_error);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        log_info("Mapped simulations file of %ld bytes", simulations_text_length);
+    } else if (args->local != NULL) {
+        simulations_image = args->local->simulations_image;
+        simulations_image_length = args->local->simulations_image_length;
+    } else {
+        simulations_image = com_share_simulations(MASTER_NODE_RANK, NULL, &simulations_image_length,
+                                                  &simulations_window);
+    }
+    if (simulations_image != NULL)
+        log_info("Received %ld packed simulations of %ld bytes",
+                 ns_packed_simulations_length(simulations_image, simulations_image_length),
+                 simulations_image_length);
+
+    // Lifecycle, the next task is received while the current one is computed
     log_info("Starting lifecycle");
+    post_task(&tasks[current], args->master_rank, message_type);
     while (!message.terminate) {
         log_info("Listening...");
 
-        // Wait a message from master
-        MPI_Recv(&message, 1, message_type, MASTER_NODE_RANK, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        // Wait a message from master, usually received already
+        wait_task(&tasks[current]);
+        message = tasks[current].message;
         log_info("Received message");
 
         // If message is of type terminate, terminate lifecycle
@@ -49,66 +259,131 @@ void do_worker(const node_worker_args_t *const args) {
         }
 
         log_info("Simulation id: %ld", message.simulation_id);
-        log_info("Waiting simulation...");
-        // Obtain simulation length in chars
-        MPI_Probe(0, 0, MPI_COMM_WORLD, &status);
-        MPI_Get_count(&status, MPI_CHAR, &simulation_string_length);
-
-        // Allocate buffer just big enough to hold the incoming buffer
-        simulation_string = (char *) calloc((unsigned long) simulation_string_length, sizeof(char));
-        if (simulation_string == NULL) {
-            log_error("Unable to allocate simulation string buffer of %d chars", simulation_string_length);
-            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
-        }
+        if (message.attempt > 0)
+            log_warn("Simulation %ld dispatched again, attempt %ld", message.simulation_id, message.attempt + 1);
+        time_measurement_start(&time);
 
-        // Read simulation data
-        log_info("Reading simulation %ld composed by %d chars", message.simulation_id, simulation_string_length);
-        MPI_Recv(simulation_string, simulation_string_length, MPI_CHAR, MASTER_NODE_RANK, 0, MPI_COMM_WORLD,
-                 MPI_STATUS_IGNORE);
+        // Group of ranks sharing the simulation
+        group = tasks[current].group;
+        if (message.ranks > 1) log_info("Simulation %ld shared by %ld ranks", message.simulation_id, message.ranks);
 
-        // Parse simulation
-        log_info("Parsing simulation %ld", message.simulation_id);
-        simulation = ns_parse_simulation(simulation_string);
+        // Receive the next task meanwhile
+        current = 1 - current;
+        post_task(&tasks[current], args->master_rank, message_type);
+
+        // Unpack simulation, or parse it from its location
+        log_info("Unpacking simulation %ld", message.simulation_id);
+        simulation = simulations_text != NULL
+                     ? ns_parse_simulation_at(simulations_text, simulations_text_length, &message.location)
+                     : ns_unpack_simulation_at(simulations_image, simulations_image_length, message.simulation_id);
         if (simulation == NULL) {
-            log_error("Unable to parse simulation %ld", message.simulation_id);
-            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+            log_error("Unable to unpack simulation %ld", message.simulation_id);
+            report_failure(args, &message, message_type);
+            continue;
         }
-        free(simulation_string);
 
-        // Create Navier Stokes simulation
-        ns = ns_create(simulation->world.width, simulation->world.height,
-                       simulation->fluid.viscosity, simulation->fluid.density, simulation->fluid.diffusion,
-                       simulation->time_step);
-        if (ns == NULL) {
-            log_error("Unable to allocate ns structure");
-            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        // Checkpoints of the parameters of the simulation, a run of every dispatch
+        checkpoints.run = (checkpoint_run_t) {.job = args->job, .attempt = message.attempt};
+        checkpoints.simulation_id = message.simulation_id;
+        checkpoints.ranks = message.ranks;
+        checkpoints.rank = 0;
+        checkpoints.restore = checkpoints.directory != NULL && (args->resume || message.attempt > 0);
+        checkpoints.ticks = simulation->ticks;
+        checkpoints.parameters = NULL;
+        checkpoints.key = NULL;
+        checkpoints.prefix = NULL;
+        if (checkpoints.directory != NULL)
+            checkpoints.parameters = ns_pack_simulation(simulation, &checkpoints.parameters_length);
+        // A simulation with fewer ranks than requested computes another result, it is not cached
+        if (checkpoints.cache_directory != NULL && message.ranks == simulation->ranks) {
+            checkpoints.key = cache_key(simulation, false, args->format, args->compression, args->tolerance,
+                                        &checkpoints.key_length);
+            checkpoints.prefix = cache_key(simulation, true, args->format, args->compression, args->tolerance,
+                                           &checkpoints.prefix_length);
+        }
+        if ((checkpoints.directory != NULL && checkpoints.parameters == NULL)
+            || (checkpoints.cache_directory != NULL && message.ranks == simulation->ranks
+                && (checkpoints.key == NULL || checkpoints.prefix == NULL))) {
+            log_error("Unable to pack simulation %ld", message.simulation_id);
+            report_failure(args, &message, message_type);
+            ns_parse_simulation_free(simulation);
+            free(checkpoints.parameters);
+            free(checkpoints.key);
+            free(checkpoints.prefix);
+            continue;
         }
+        simulation->ranks = message.ranks;
 
-        // Obtain Navier Stokes world snapshot
-        world = ns_get_world(ns);
-        if (world == NULL) {
-            log_error("Unable to allocate world structure");
-            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        // Create Navier Stokes simulation
+        if (message.ranks > 1) {
+            MPI_Group world_group;
+            MPI_Group simulation_group;
+            int simulation_rank;
+
+            // Only the ranks of the group take part
+            MPI_Comm_group(MPI_COMM_WORLD, &world_group);
+            MPI_Group_incl(world_group, (int) message.ranks, group, &simulation_group);
+            MPI_Comm_create_group(MPI_COMM_WORLD, simulation_group, COM_GROUP_TAG, &simulation_comm);
+            MPI_Group_free(&simulation_group);
+            MPI_Group_free(&world_group);
+            free(group);
+            group = NULL;
+
+            MPI_Comm_rank(simulation_comm, &simulation_rank);
+            root = simulation_rank == 0;
+            checkpoints.rank = (uint64_t) simulation_rank;
+
+            if (simulation->solver.relaxation != NS_RELAXATION_RED_BLACK
+                || simulation->solver.pressure != NS_PRESSURE_SOLVER_RELAXATION) {
+                if (root)
+                    log_warn("Simulation %ld is decomposed, using %s relaxation and %s pressure solver",
+                             message.simulation_id, ns_relaxation_string(NS_RELAXATION_RED_BLACK),
+                             ns_pressure_solver_string(NS_PRESSURE_SOLVER_RELAXATION));
+                simulation->solver.relaxation = NS_RELAXATION_RED_BLACK;
+                simulation->solver.pressure = NS_PRESSURE_SOLVER_RELAXATION;
+            }
+        } else {
+            root = true;
         }
+        ns = create_ns(simulation, simulation_comm);
 
-        // Populate simulation JSON with simulation data
-        result_json = cJSON_CreateObject();
-        if (cJSON_AddNumberToObject(result_json, "id", (double) message.simulation_id) == NULL
-            || !write_simulation_metadata_to_result(result_json, simulation)) {
-            log_error("Error adding metadata to JSON simulation");
-            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        // Only the root of a decomposed simulation saves the result
+        worker_result_t *result = NULL;
+        if (ns != NULL && root)
+            result = create_result(args, &message, simulation, container, container_message_type, rank,
+                                   &checkpoints);
+
+        // Report the simulation to master instead of aborting, it is dispatched again to another worker
+        if (ns == NULL || (root && result == NULL)) {
+            report_failure(args, &message, message_type);
+            ns_free(ns);
+            ns_parse_simulation_free(simulation);
+            free(checkpoints.parameters);
+            free(checkpoints.key);
+            free(checkpoints.prefix);
+            continue;
         }
 
+        // Continue a resumed simulation, or one dispatched again, from its last checkpoint,
+        // otherwise from the state cached by a simulation with the same setup
+        ns_tick_stats_t stats = {0, 0};
+        uint64_t first_tick = 0;
+        if (checkpoints.restore || checkpoints.prefix != NULL)
+            first_tick = restore_checkpoint(&checkpoints, ns, simulation_comm, result, queue, &stats);
+        checkpoints.last = MPI_Wtime();
+
         // Start simulation composed by ticks + 1 (world at tick 0)
         log_info("Starting simulation %ld composed by %ld ticks", message.simulation_id, simulation->ticks);
-        cJSON *snapshots = cJSON_AddArrayToObject(result_json, "snapshots");
-        if (snapshots == NULL) {
-            log_error("Error adding snapshots to JSON simulation");
-            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
-        }
-        for (uint64_t tick = 0; tick <= simulation->ticks; ++tick) {
+        for (uint64_t tick = first_tick; tick <= simulation->ticks; ++tick) {
             log_debug("Init tick %ld", tick);
 
+            // Let the next task arrive
+            progress_task(&tasks[current]);
+
+            // Checkpoint the ticks done so far once in a while
+            if (checkpoints.directory != NULL && tick > first_tick)
+                queue_checkpoint(&checkpoints, ns, simulation_comm, stats, result, queue);
+
             // Find a mod based on the current tick
             const ns_parse_simulation_mod_t *const mod = find_mod_by_tick(simulation, tick);
 
@@ -135,98 +410,555 @@ void do_worker(const node_worker_args_t *const args) {
             // Compute a tick if this is not the first one.
             // This is done to obtain the initial world status.
             log_debug("Computing tick %ld", tick);
-            if (tick != 0) ns_tick(ns);
+            if (tick != 0) {
+                ns_tick(ns);
+                stats.diffuse_iterations += ns_get_tick_stats(ns).diffuse_iterations;
+                stats.pressure_iterations += ns_get_tick_stats(ns).pressure_iterations;
+            }
             log_debug("Tick %ld computed", tick);
 
-            // Compute world snapshot
-            cJSON *snapshot = cJSON_CreateArray();
-            if (snapshot == NULL) {
-                log_error("Error creating JSON snapshot");
+            // Only the snapshot of every `every` ticks is saved
+            if (tick % simulation->output.every != 0) continue;
+
+            // Gather the tiles of a decomposed world on its root
+            if (!ns_gather_world(ns)) {
+                log_error("Unable to gather world on tick %ld", tick);
                 MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
             }
+            if (!root) continue;
 
-            log_debug("Saving world snapshot on tick %ld", tick);
-            for (size_t y = 0; y < world->world_height_bounds; ++y) {
-                for (size_t x = 0; x < world->world_width_bounds; ++x) {
-                    const ns_cell_t *const cell = &world->world[y][x];
-                    cJSON *cell_json = NULL;
-
-                    cell_json = cJSON_CreateObject();
-                    if (cell_json == NULL) {
-                        log_error("Error creating JSON cell");
-                        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
-                    }
-
-                    if (cJSON_AddNumberToObject(cell_json, "x", (double) x) == NULL
-                        || cJSON_AddNumberToObject(cell_json, "y", (double) y) == NULL
-                        || cJSON_AddNumberToObject(cell_json, "d", *cell->density) == NULL
-                        || cJSON_AddNumberToObject(cell_json, "u", *cell->u) == NULL
-                        || cJSON_AddNumberToObject(cell_json, "v", *cell->v) == NULL) {
-                        log_error("Unable to add data to JSON cell");
-                        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
-                    }
-
-                    if (!cJSON_AddItemToArray(snapshot, cell_json)) {
-                        log_error("Unable to add JSON cell to snapshot");
-                        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
-                    }
-                }
+            // Obtain Navier Stokes world snapshot
+            if (!ns_get_world(ns, &world)) {
+                log_error("Unable to obtain world snapshot on tick %ld", tick);
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
             }
 
-            if (!cJSON_AddItemToArray(snapshots, snapshot)) {
-                log_error("Unable to add JSON snapshot to snapshots");
+            // Queue world snapshot, the I/O thread saves it while the next ticks are computed
+            log_debug("Queueing world snapshot on tick %ld", tick);
+            if (!snapshot_queue_push(queue, save_snapshot, result, &world, &result->output, stats)) {
+                log_error("Unable to queue world snapshot on tick %ld", tick);
                 MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
             }
+            stats = (ns_tick_stats_t) {0, 0};
         }
         log_info("Simulation ticks computed");
 
-        log_info("Computing result data...");
-
-        // Transform JSON object to string
-        char *result_string = cJSON_Print(result_json);
-        if (result_string == NULL) {
-            log_error("Error transforming JSON result to string");
-            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        // The last state is cached with its journal, a simulation with the same setup and more ticks continues it
+        if (checkpoints.prefix != NULL && checkpoints.directory != NULL) {
+            char *cache_state_path = cache_file_path(checkpoints.cache_directory, CACHE_FILE_STATE, checkpoints.prefix,
+                                                     checkpoints.prefix_length, checkpoints.rank, args->format);
+            if (cache_state_path != NULL)
+                push_checkpoint(&checkpoints, ns, stats, result, queue, cache_state_path, checkpoints.prefix,
+                                checkpoints.prefix_length);
         }
 
-        // Save result to file
-        size_t result_save_location_length = strlen(args->results_path) + 1 + RESULT_FILE_MAX_NAME_LENGTH + 1;
-        char *result_save_location = (char *) calloc(result_save_location_length, sizeof(char));
-        if (result_save_location == NULL) {
-            log_error("Unable to allocate memory for save result location");
+        // Queue the completion of the result, saved after its snapshots
+        if (root && !snapshot_queue_push(queue, save_result, result, NULL, NULL, (ns_tick_stats_t) {0, 0})) {
+            log_error("Unable to queue simulation %ld result", message.simulation_id);
             MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
         }
-        snprintf(result_save_location, result_save_location_length, "%s/simulation_%ld_%d.json", args->results_path,
-                 message.simulation_id, rank);
 
-        log_info("Saving simulation %ld to file %s", message.simulation_id, result_save_location);
-        char file_error[MPI_MAX_ERROR_STRING + 1];
-        if (!write_file(result_save_location, result_string, file_error)) {
-            log_error("Error saving file %s: %s", result_save_location, file_error);
-            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        // The root drops the checkpoints of every rank once the result is saved, the others their last one
+        if (!root && checkpoints.directory != NULL) {
+            char *checkpoint_file = checkpoint_file_path(checkpoints.directory, CHECKPOINT_FILE_STATE,
+                                                         checkpoints.simulation_id, &checkpoints.run,
+                                                         checkpoints.rank);
+            if (checkpoint_file == NULL
+                || !snapshot_queue_push(queue, discard_checkpoint, checkpoint_file, NULL, NULL,
+                                        (ns_tick_stats_t) {0, 0})) {
+                log_error("Unable to queue simulation %ld checkpoint removal", message.simulation_id);
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+            }
         }
-        free(result_save_location);
-        log_info("Save to file completed");
-
-        log_info("Simulation %ld terminated", message.simulation_id);
 
-        // Inform master that I can work again
-        const com_message_t work_message = {.simulation_id = message.simulation_id, .terminate = false};
+        // Inform master that I can work again, the result is saved in background
+        time_measurement_stop(&time);
+        const com_message_t work_message = {.simulation_id = message.simulation_id, .terminate = false,
+                .elapsed = (double) time_measurement_get_difference_microsecond(&time) / 1e6,
+                .attempt = message.attempt};
         log_debug("Sending work again message to master");
-        MPI_Send(&work_message, 1, message_type, MASTER_NODE_RANK, 0, MPI_COMM_WORLD);
+        MPI_Send(&work_message, 1, message_type, args->master_rank, 0, args->master_comm);
         log_debug("Message work again sent");
 
-        cJSON_Delete(result_json);
-        free(result_string);
         ns_parse_simulation_free(simulation);
-        ns_free_world(world);
         ns_free(ns);
+        free(checkpoints.parameters);
+        free(checkpoints.key);
+        free(checkpoints.prefix);
+        if (simulation_comm != MPI_COMM_NULL) MPI_Comm_free(&simulation_comm);
     }
     log_info("Lifecycle terminated");
 
+    // Save pending results
+    log_info("Waiting pending results...");
+    snapshot_queue_free(queue);
+
+    // Inform master once every result is written, the master may abort the lost workers then
+    if (container != NULL && !container_flush(container, file_error)) {
+        log_error("Error saving container %s: %s", args->container_path, file_error);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    const com_container_message_t done_message = {.done = true};
+    MPI_Send(&done_message, 1, container_message_type, MASTER_NODE_RANK, COM_CONTAINER_TAG, args->container_comm);
+    if (container != NULL && args->local == NULL && !container_close(container, file_error)) {
+        log_error("Error saving container %s: %s", args->container_path, file_error);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    MPI_Type_free(&container_message_type);
+
+    if (args->simulations_path == NULL && args->local == NULL) com_simulations_free(&simulations_window);
+    unmap_file(simulations_text, simulations_text_length);
     MPI_Type_free(&message_type);
 }
 
+static void post_task(worker_task_t *task, int master_rank, MPI_Datatype message_type) {
+    task->group = NULL;
+    task->master_rank = master_rank;
+    task->requests[1] = MPI_REQUEST_NULL;
+    MPI_Irecv(&task->message, 1, message_type, master_rank, 0, MPI_COMM_WORLD, &task->requests[0]);
+}
+
+static void progress_task(worker_task_t *task) {
+    int received;
+
+    // Group is posted as soon as the message is received
+    if (task->requests[0] == MPI_REQUEST_NULL) return;
+    MPI_Test(&task->requests[0], &received, MPI_STATUS_IGNORE);
+    if (received) post_task_group(task);
+}
+
+static void wait_task(worker_task_t *task) {
+    if (task->requests[0] != MPI_REQUEST_NULL) {
+        MPI_Wait(&task->requests[0], MPI_STATUS_IGNORE);
+        post_task_group(task);
+    }
+    MPI_Wait(&task->requests[1], MPI_STATUS_IGNORE);
+}
+
+static void post_task_group(worker_task_t *task) {
+    // Group of ranks sharing the simulation
+    if (!task->message.terminate && task->message.ranks > 1) {
+        task->group = (int *) calloc(task->message.ranks, sizeof(int));
+        if (task->group == NULL) {
+            log_error("Unable to allocate group of %ld ranks", task->message.ranks);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        MPI_Irecv(task->group, (int) task->message.ranks, MPI_INT, task->master_rank, 0, MPI_COMM_WORLD,
+                  &task->requests[1]);
+    }
+}
+
+static ns_t *create_ns(const ns_simulation_t *const simulation, MPI_Comm simulation_comm) {
+    ns_t *ns;
+
+    if (simulation_comm != MPI_COMM_NULL)
+        ns = ns_create_distributed(simulation_comm, simulation->world.width, simulation->world.height,
+                                   simulation->fluid.viscosity, simulation->fluid.density, simulation->fluid.diffusion,
+                                   simulation->time_step);
+    else
+        ns = ns_create(simulation->world.width, simulation->world.height,
+                       simulation->fluid.viscosity, simulation->fluid.density, simulation->fluid.diffusion,
+                       simulation->time_step);
+    if (ns == NULL) {
+        log_error("Unable to allocate ns structure");
+        return NULL;
+    }
+    if (!ns_set_solver_config(ns, &simulation->solver)) {
+        log_error("Unable to configure ns solver");
+        ns_free(ns);
+        return NULL;
+    }
+    if (!ns_set_boundaries(ns, &simulation->boundaries)) {
+        log_error("Unable to configure ns boundaries");
+        ns_free(ns);
+        return NULL;
+    }
+
+    return ns;
+}
+
+static worker_result_t *create_result(const node_worker_args_t *const args, const com_message_t *const message,
+                                      const ns_simulation_t *const simulation, container_t *container,
+                                      MPI_Datatype container_message_type, int rank,
+                                      const worker_checkpoints_t *const checkpoints) {
+    worker_result_t *result;
+    char file_error[MPI_MAX_ERROR_STRING + 1];
+
+    result = (worker_result_t *) calloc(1, sizeof(worker_result_t));
+    if (result == NULL) {
+        log_error("Unable to allocate simulation result");
+        return NULL;
+    }
+    result->simulation_id = message->simulation_id;
+    result->validate_path = args->validate_path;
+    result->output = simulation->output;
+    result->format = args->format;
+    result->container = container;
+    result->container_message_type = container_message_type;
+    result->container_comm = args->container_comm;
+
+    // Populate simulation JSON with simulation data
+    result->json = cJSON_CreateObject();
+    if (cJSON_AddNumberToObject(result->json, "id", (double) message->simulation_id) == NULL
+        || !write_simulation_metadata_to_result(result->json, simulation)) {
+        log_error("Error adding metadata to JSON simulation");
+        free_result(result);
+        return NULL;
+    }
+
+    // Result file location, or the container holding the result
+    size_t result_save_location_length = strlen(args->results_path) + 1 + RESULT_FILE_MAX_NAME_LENGTH + 1;
+    result->save_location = (char *) calloc(result_save_location_length, sizeof(char));
+    if (result->save_location == NULL) {
+        log_error("Unable to allocate memory for save result location");
+        free_result(result);
+        return NULL;
+    }
+    if (container != NULL) {
+        snprintf(result->save_location, result_save_location_length, "%s", args->container_path);
+    } else {
+        snprintf(result->save_location, result_save_location_length, "%s/simulation_%ld_%d.%s",
+                 args->results_path, message->simulation_id, rank, snapshot_format_extension(args->format));
+        // A result is replaced, never written in place, the cache may hold a link to the previous one
+        MPI_File_delete(result->save_location, MPI_INFO_NULL);
+    }
+
+    if (args->format == SNAPSHOT_FORMAT_BINARY) {
+        // Snapshots are written to file as soon as they are computed, the header holds the metadata
+        const snapshot_layout_t layout = {.width = snapshot_output_width(&result->output),
+                .height = snapshot_output_height(&result->output), .fields = result->output.fields,
+                .compression = args->compression, .tolerance = args->tolerance};
+        if (!add_compression_to_metadata(result->json, &layout)) {
+            log_error("Error adding compression to JSON simulation metadata");
+            free_result(result);
+            return NULL;
+        }
+        char *metadata_string = cJSON_PrintUnformatted(result->json);
+        if (metadata_string == NULL) {
+            log_error("Error transforming JSON metadata to string");
+            free_result(result);
+            return NULL;
+        }
+        log_info("Saving simulation %ld to file %s", message->simulation_id, result->save_location);
+        // Results of the container are written to memory first, then to their range at once
+        result->writer = snapshot_writer_open(container != NULL ? NULL : result->save_location, metadata_string,
+                                              &layout, file_error);
+        free(metadata_string);
+        if (result->writer == NULL) {
+            log_error("Error creating file %s: %s", result->save_location, file_error);
+            free_result(result);
+            return NULL;
+        }
+    } else {
+        result->snapshots = cJSON_AddArrayToObject(result->json, "snapshots");
+        if (result->snapshots == NULL) {
+            log_error("Error adding snapshots to JSON simulation");
+            free_result(result);
+            return NULL;
+        }
+        result->iterations = cJSON_AddArrayToObject(cJSON_GetObjectItemCaseSensitive(result->json, "metadata"),
+                                                    "iterations");
+        if (result->iterations == NULL) {
+            log_error("Error adding iterations to JSON simulation metadata");
+            free_result(result);
+            return NULL;
+        }
+    }
+
+    // Snapshots are journaled for the checkpoints, lossless, and the simulation is marked done once saved
+    if (checkpoints->directory != NULL) {
+        const snapshot_layout_t journal_layout = {.width = snapshot_output_width(&result->output),
+                .height = snapshot_output_height(&result->output), .fields = result->output.fields,
+                .compression = SNAPSHOT_COMPRESSION_LOSSLESS, .tolerance = 0};
+        char *const journal_path = checkpoint_file_path(checkpoints->directory, CHECKPOINT_FILE_JOURNAL,
+                                                        checkpoints->simulation_id, &checkpoints->run, 0);
+        char *metadata_string = cJSON_PrintUnformatted(cJSON_GetObjectItemCaseSensitive(result->json, "metadata"));
+
+        result->checkpoint_path = checkpoints->directory;
+        result->done = (checkpoint_t) {.simulation_id = checkpoints->simulation_id, .ranks = checkpoints->ranks,
+                .tick = simulation->ticks, .parameters_length = checkpoints->parameters_length};
+        result->done.parameters = (uint8_t *) malloc(checkpoints->parameters_length);
+        if (journal_path != NULL && metadata_string != NULL && result->done.parameters != NULL) {
+            memcpy(result->done.parameters, checkpoints->parameters, checkpoints->parameters_length);
+            result->journal = snapshot_writer_open(journal_path, metadata_string, &journal_layout, file_error);
+            if (result->journal == NULL) log_error("Error creating file %s: %s", journal_path, file_error);
+        }
+        result->journal_path = journal_path;
+        free(metadata_string);
+        if (result->journal == NULL) {
+            log_error("Unable to journal simulation %ld", message->simulation_id);
+            free_result(result);
+            return NULL;
+        }
+    }
+
+    // The result is added to the cache once saved, and its journal too with the cached state
+    if (checkpoints->key != NULL) {
+        result->cache_path = checkpoints->cache_directory;
+        result->cache_key_length = checkpoints->key_length;
+        result->cache_key = (uint8_t *) malloc(checkpoints->key_length);
+        if (result->cache_key == NULL) {
+            log_error("Unable to allocate cache key");
+            free_result(result);
+            return NULL;
+        }
+        memcpy(result->cache_key, checkpoints->key, checkpoints->key_length);
+        if (result->journal != NULL) {
+            result->cache_journal_path = cache_file_path(checkpoints->cache_directory, CACHE_FILE_JOURNAL,
+                                                         checkpoints->prefix, checkpoints->prefix_length, 0,
+                                                         args->format);
+            if (result->cache_journal_path == NULL) {
+                log_error("Unable to allocate cache journal location");
+                free_result(result);
+                return NULL;
+            }
+        }
+    }
+
+    return result;
+}
+
+static void free_result(worker_result_t *result) {
+    cJSON_Delete(result->json);
+    free(result->save_location);
+    free(result->journal_path);
+    free(result->done.parameters);
+    free(result->cache_key);
+    free(result->cache_journal_path);
+    free(result);
+}
+
+static uint64_t restore_checkpoint(const worker_checkpoints_t *const checkpoints, ns_t *ns, MPI_Comm simulation_comm,
+                                   worker_result_t *result, snapshot_queue_t *queue, ns_tick_stats_t *stats) {
+    checkpoint_t *checkpoint = NULL;
+    checkpoint_run_t run = {0, 0};
+    char *journal_path = NULL;
+    // First tick to compute, job and attempt of the checkpoint of the first rank and whether it is cached,
+    // first tick 0 if none
+    uint64_t restored[4] = {0, 0, 0, 0};
+    bool valid;
+    char file_error[MPI_MAX_ERROR_STRING + 1];
+
+    if (checkpoints->rank == 0) {
+        // The first rank picks the checkpoint with the most ticks whose snapshots are all journaled
+        if (checkpoints->restore) {
+            checkpoint = checkpoint_latest(checkpoints->directory, checkpoints->simulation_id,
+                                           checkpoints->parameters, checkpoints->parameters_length,
+                                           checkpoints->ranks, &run);
+            if (checkpoint != NULL)
+                journal_path = checkpoint_file_path(checkpoints->directory, CHECKPOINT_FILE_JOURNAL,
+                                                    checkpoints->simulation_id, &run, 0);
+            if (restorable(checkpoint, journal_path, ns, checkpoints->ticks, result->output.every)) {
+                restored[0] = checkpoint->tick + 1;
+                restored[1] = run.job;
+                restored[2] = run.attempt;
+            }
+        }
+
+        // Otherwise the state cached by a simulation with the same setup and at most as many ticks
+        if (restored[0] == 0 && checkpoints->prefix != NULL) {
+            char *cache_state_path = cache_file_path(checkpoints->cache_directory, CACHE_FILE_STATE,
+                                                     checkpoints->prefix, checkpoints->prefix_length, 0,
+                                                     SNAPSHOT_FORMAT_BINARY);
+
+            checkpoint_free(checkpoint);
+            free(journal_path);
+            checkpoint = NULL;
+            journal_path = NULL;
+            if (cache_state_path != NULL) checkpoint = checkpoint_read(cache_state_path, file_error);
+            if (checkpoint != NULL && checkpoint->ranks == checkpoints->ranks
+                && checkpoint_matches(checkpoint, checkpoints->prefix, checkpoints->prefix_length))
+                journal_path = cache_file_path(checkpoints->cache_directory, CACHE_FILE_JOURNAL, checkpoints->prefix,
+                                               checkpoints->prefix_length, 0, SNAPSHOT_FORMAT_BINARY);
+            if (restorable(checkpoint, journal_path, ns, checkpoints->ticks, result->output.every)) {
+                restored[0] = checkpoint->tick + 1;
+                restored[3] = true;
+            }
+            free(cache_state_path);
+        }
+    }
+    if (simulation_comm != MPI_COMM_NULL) MPI_Bcast(restored, 4, MPI_UINT64_T, 0, simulation_comm);
+    if (restored[0] == 0) {
+        checkpoint_free(checkpoint);
+        free(journal_path);
+        return 0;
+    }
+
+    // The other ranks restore the checkpoint of the same run and tick
+    if (checkpoints->rank != 0) {
+        char *checkpoint_path;
+
+        run = (checkpoint_run_t) {.job = restored[1], .attempt = restored[2]};
+        if (restored[3])
+            checkpoint_path = cache_file_path(checkpoints->cache_directory, CACHE_FILE_STATE, checkpoints->prefix,
+                                              checkpoints->prefix_length, checkpoints->rank,
+                                              SNAPSHOT_FORMAT_BINARY);
+        else
+            checkpoint_path = checkpoint_file_path(checkpoints->directory, CHECKPOINT_FILE_STATE,
+                                                   checkpoints->simulation_id, &run, checkpoints->rank);
+        if (checkpoint_path != NULL) checkpoint = checkpoint_read(checkpoint_path, file_error);
+        if (checkpoint == NULL) log_warn("Unable to read checkpoint %s: %s", checkpoint_path, file_error);
+        free(checkpoint_path);
+    }
+    valid = checkpoint != NULL && checkpoint->tick + 1 == restored[0] && checkpoint->ranks == checkpoints->ranks
+            && checkpoint->state_length == ns_state_size(ns)
+            && (restored[3] ? checkpoint_matches(checkpoint, checkpoints->prefix, checkpoints->prefix_length)
+                            : checkpoint_matches(checkpoint, checkpoints->parameters, checkpoints->parameters_length));
+    if (simulation_comm != MPI_COMM_NULL) MPI_Allreduce(MPI_IN_PLACE, &valid, 1, MPI_C_BOOL, MPI_LAND, simulation_comm);
+    if (!valid) {
+        log_warn("Checkpoints of simulation %ld differ across its ranks, starting from tick 0",
+                 checkpoints->simulation_id);
+        checkpoint_free(checkpoint);
+        free(journal_path);
+        return 0;
+    }
+
+    // Snapshots saved up to the checkpoint, then the solver state
+    if (checkpoints->rank == 0) replay_journal(journal_path, checkpoint->tick, result, queue);
+    ns_set_state(ns, checkpoint->tick, checkpoint->state);
+    *stats = checkpoint->stats;
+    if (checkpoints->rank == 0)
+        log_info("Simulation %ld restored from %s at tick %ld", checkpoints->simulation_id,
+                 restored[3] ? "cache" : "checkpoint", checkpoint->tick);
+
+    checkpoint_free(checkpoint);
+    free(journal_path);
+    return restored[0];
+}
+
+static bool restorable(const checkpoint_t *const checkpoint, const char *const journal_path, const ns_t *ns,
+                       uint64_t ticks, uint64_t every) {
+    return checkpoint != NULL && journal_path != NULL && checkpoint->state != NULL && checkpoint->tick <= ticks
+           && checkpoint->state_length == ns_state_size(ns) && journal_complete(journal_path, checkpoint->tick, every);
+}
+
+static bool journal_complete(const char *const journal_path, uint64_t tick, uint64_t every) {
+    snapshot_reader_t *reader;
+    ns_world_t world;
+    ns_tick_stats_t stats;
+    uint64_t snapshots = 0;
+    char file_error[MPI_MAX_ERROR_STRING + 1];
+
+    // Snapshots of the ticks 0, every, 2 * every and so on up to tick, a torn one ends the journal
+    reader = snapshot_reader_open(journal_path, file_error);
+    if (reader == NULL) return false;
+    while (!snapshot_reader_end(reader) && snapshot_reader_read(reader, &world, &stats, file_error)) {
+        if (world.tick > tick) break;
+        if (world.tick != snapshots * every) break;
+        snapshots += 1;
+    }
+    snapshot_reader_close(reader);
+
+    return snapshots == tick / every + 1;
+}
+
+static void replay_journal(const char *const journal_path, uint64_t tick, worker_result_t *result,
+                           snapshot_queue_t *queue) {
+    snapshot_reader_t *reader;
+    snapshot_output_t output;
+    ns_world_t world;
+    ns_tick_stats_t stats;
+    char file_error[MPI_MAX_ERROR_STRING + 1];
+
+    reader = snapshot_reader_open(journal_path, file_error);
+    if (reader == NULL) {
+        log_error("Error opening file %s: %s", journal_path, file_error);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    // Journaled snapshots are reduced already, they are queued as they are
+    output = (snapshot_output_t) {.every = 1, .x = 0, .y = 0, .width = snapshot_reader_layout(reader)->width,
+            .height = snapshot_reader_layout(reader)->height, .fields = snapshot_reader_layout(reader)->fields,
+            .downsample = 1};
+    while (!snapshot_reader_end(reader)) {
+        if (!snapshot_reader_read(reader, &world, &stats, file_error)) {
+            log_error("Error reading file %s: %s", journal_path, file_error);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        if (world.tick > tick) break;
+
+        if (!snapshot_queue_push(queue, save_snapshot, result, &world, &output, stats)) {
+            log_error("Unable to queue world snapshot on tick %ld", world.tick);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+    }
+
+    snapshot_reader_close(reader);
+}
+
+static void queue_checkpoint(worker_checkpoints_t *checkpoints, const ns_t *ns, MPI_Comm simulation_comm,
+                             ns_tick_stats_t stats, worker_result_t *result, snapshot_queue_t *queue) {
+    char *file_path;
+    bool due = MPI_Wtime() - checkpoints->last >= checkpoints->interval;
+
+    // Every rank of a decomposed simulation checkpoints the same tick
+    if (simulation_comm != MPI_COMM_NULL) MPI_Bcast(&due, 1, MPI_C_BOOL, 0, simulation_comm);
+    if (!due) return;
+    checkpoints->last = MPI_Wtime();
+
+    file_path = checkpoint_file_path(checkpoints->directory, CHECKPOINT_FILE_STATE, checkpoints->simulation_id,
+                                     &checkpoints->run, checkpoints->rank);
+    if (file_path == NULL) {
+        log_warn("Unable to allocate checkpoint of simulation %ld", checkpoints->simulation_id);
+        return;
+    }
+    push_checkpoint(checkpoints, ns, stats, result, queue, file_path, checkpoints->parameters,
+                    checkpoints->parameters_length);
+}
+
+static void push_checkpoint(const worker_checkpoints_t *const checkpoints, const ns_t *ns, ns_tick_stats_t stats,
+                            worker_result_t *result, snapshot_queue_t *queue, char *file_path,
+                            const uint8_t *const parameters, uint64_t parameters_length) {
+    worker_checkpoint_t *job;
+
+    // The state is copied now, the I/O thread writes it while the next ticks are computed
+    job = (worker_checkpoint_t *) calloc(1, sizeof(worker_checkpoint_t));
+    if (job == NULL) {
+        log_warn("Unable to allocate checkpoint of simulation %ld", checkpoints->simulation_id);
+        free(file_path);
+        return;
+    }
+    job->result = result;
+    job->file_path = file_path;
+    job->checkpoint = (checkpoint_t) {.simulation_id = checkpoints->simulation_id, .ranks = checkpoints->ranks,
+            .rank = checkpoints->rank, .stats = stats, .parameters_length = parameters_length,
+            .state_length = ns_state_size(ns)};
+    job->checkpoint.parameters = (uint8_t *) malloc(parameters_length);
+    job->checkpoint.state = (ns_real_t *) malloc(job->checkpoint.state_length * sizeof(ns_real_t));
+    if (job->checkpoint.parameters == NULL || job->checkpoint.state == NULL) {
+        log_warn("Unable to allocate checkpoint of simulation %ld", checkpoints->simulation_id);
+        free(job->checkpoint.parameters);
+        free(job->checkpoint.state);
+        free(job->file_path);
+        free(job);
+        return;
+    }
+    memcpy(job->checkpoint.parameters, parameters, parameters_length);
+    job->checkpoint.tick = ns_get_state(ns, job->checkpoint.state);
+
+    log_debug("Queueing checkpoint of simulation %ld on tick %ld", checkpoints->simulation_id,
+              job->checkpoint.tick);
+    if (!snapshot_queue_push(queue, save_checkpoint, job, NULL, NULL, stats)) {
+        log_error("Unable to queue checkpoint on tick %ld", job->checkpoint.tick);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+}
+
+static void report_failure(const node_worker_args_t *const args, const com_message_t *const message,
+                           MPI_Datatype message_type) {
+    const com_message_t failure_message = {.simulation_id = message->simulation_id, .terminate = false,
+            .failed = true, .attempt = message->attempt};
+
+    // The other ranks of a decomposed simulation would wait this one forever
+    if (message->ranks > 1) {
+        log_error("Unable to start simulation %ld shared by %ld ranks", message->simulation_id, message->ranks);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    log_warn("Reporting failed simulation %ld to master", message->simulation_id);
+    MPI_Send(&failure_message, 1, message_type, args->master_rank, 0, args->master_comm);
+}
+
 static ns_parse_simulation_mod_t *find_mod_by_tick(const ns_simulation_t *const simulation, uint64_t tick) {
     if (simulation == NULL || simulation->mods == NULL || tick < 0 || tick > simulation->ticks)
         return NULL;
@@ -242,15 +974,24 @@ static ns_parse_simulation_mod_t *find_mod_by_tick(const ns_simulation_t *const
 
 static bool write_simulation_metadata_to_result(cJSON *result_json, const ns_simulation_t *const simulation) {
     if (result_json == NULL || simulation == NULL) return false;
+    const snapshot_output_t *const output = &simulation->output;
     cJSON *metadata_json = NULL;
     cJSON *world_json = NULL;
     cJSON *fluid_json = NULL;
+    cJSON *solver_json = NULL;
+    cJSON *multigrid_json = NULL;
+    cJSON *boundaries_json = NULL;
+    cJSON *output_json = NULL;
+    cJSON *region_json = NULL;
+    cJSON *fields_json = NULL;
 
     metadata_json = cJSON_AddObjectToObject(result_json, "metadata");
     if (metadata_json == NULL) return false;
 
     if (cJSON_AddNumberToObject(metadata_json, "time_step", simulation->time_step) == NULL
-        || cJSON_AddNumberToObject(metadata_json, "ticks", (double) simulation->ticks) == NULL)
+        || cJSON_AddNumberToObject(metadata_json, "ticks", (double) simulation->ticks) == NULL
+        || cJSON_AddNumberToObject(metadata_json, "ranks", (double) simulation->ranks) == NULL
+        || cJSON_AddStringToObject(metadata_json, "precision", NS_REAL_PRECISION) == NULL)
         return false;
 
     world_json = cJSON_AddObjectToObject(metadata_json, "world");
@@ -268,5 +1009,394 @@ static bool write_simulation_metadata_to_result(cJSON *result_json, const ns_sim
         || cJSON_AddNumberToObject(fluid_json, "diffusion", simulation->fluid.diffusion) == NULL)
         return false;
 
+    solver_json = cJSON_AddObjectToObject(metadata_json, "solver");
+    if (solver_json == NULL) return false;
+    if (cJSON_AddStringToObject(solver_json, "relaxation", ns_relaxation_string(simulation->solver.relaxation)) == NULL
+        || cJSON_AddNumberToObject(solver_json, "max_iterations", (double) simulation->solver.max_iterations) == NULL
+        || cJSON_AddNumberToObject(solver_json, "tolerance", simulation->solver.tolerance) == NULL
+        || cJSON_AddNumberToObject(solver_json, "check_every", (double) simulation->solver.check_every) == NULL
+        || cJSON_AddStringToObject(solver_json, "pressure", ns_pressure_solver_string(simulation->solver.pressure)) == NULL)
+        return false;
+
+    if (simulation->solver.pressure == NS_PRESSURE_SOLVER_MULTIGRID) {
+        multigrid_json = cJSON_AddObjectToObject(solver_json, "multigrid");
+        if (multigrid_json == NULL) return false;
+        if (cJSON_AddStringToObject(multigrid_json, "cycle",
+                                    ns_multigrid_cycle_string(simulation->solver.multigrid.cycle)) == NULL
+            || cJSON_AddNumberToObject(multigrid_json, "tolerance", simulation->solver.multigrid.tolerance) == NULL
+            || cJSON_AddNumberToObject(multigrid_json, "max_cycles",
+                                       (double) simulation->solver.multigrid.max_cycles) == NULL)
+            return false;
+    }
+
+    boundaries_json = cJSON_AddObjectToObject(metadata_json, "boundaries");
+    if (boundaries_json == NULL) return false;
+    for (int edge = NS_BOUNDARY_EDGE_LEFT; edge <= NS_BOUNDARY_EDGE_BOTTOM; ++edge) {
+        const ns_boundary_t *const boundary = &simulation->boundaries.edges[edge];
+        cJSON *boundary_json;
+
+        boundary_json = cJSON_AddObjectToObject(boundaries_json, ns_boundary_edge_string((ns_boundary_edge_t) edge));
+        if (boundary_json == NULL
+            || cJSON_AddStringToObject(boundary_json, "type", ns_boundary_type_string(boundary->type)) == NULL)
+            return false;
+
+        if (boundary->type == NS_BOUNDARY_TYPE_INFLOW
+            && (cJSON_AddNumberToObject(boundary_json, "u", boundary->u) == NULL
+                || cJSON_AddNumberToObject(boundary_json, "v", boundary->v) == NULL
+                || cJSON_AddNumberToObject(boundary_json, "density", boundary->density) == NULL))
+            return false;
+    }
+
+    output_json = cJSON_AddObjectToObject(metadata_json, "output");
+    if (output_json == NULL) return false;
+    if (cJSON_AddNumberToObject(output_json, "every", (double) output->every) == NULL
+        || cJSON_AddNumberToObject(output_json, "downsample", (double) output->downsample) == NULL)
+        return false;
+
+    region_json = cJSON_AddObjectToObject(output_json, "region");
+    if (region_json == NULL) return false;
+    if (cJSON_AddNumberToObject(region_json, "x", (double) output->x) == NULL
+        || cJSON_AddNumberToObject(region_json, "y", (double) output->y) == NULL
+        || cJSON_AddNumberToObject(region_json, "width", (double) output->width) == NULL
+        || cJSON_AddNumberToObject(region_json, "height", (double) output->height) == NULL)
+        return false;
+
+    fields_json = cJSON_AddArrayToObject(output_json, "fields");
+    if (fields_json == NULL) return false;
+    for (unsigned int field = SNAPSHOT_FIELD_U; field <= SNAPSHOT_FIELD_DENSITY; field <<= 1) {
+        if ((output->fields & field)
+            && !cJSON_AddItemToArray(fields_json, cJSON_CreateString(snapshot_field_string(field))))
+            return false;
+    }
+
+    return true;
+}
+
+static bool add_tick_stats_to_iterations(cJSON *iterations_json, uint64_t tick, ns_tick_stats_t stats) {
+    if (iterations_json == NULL) return false;
+    cJSON *tick_json = NULL;
+
+    tick_json = cJSON_CreateObject();
+    if (tick_json == NULL) return false;
+
+    if (cJSON_AddNumberToObject(tick_json, "tick", (double) tick) == NULL
+        || cJSON_AddNumberToObject(tick_json, "diffuse", (double) stats.diffuse_iterations) == NULL
+        || cJSON_AddNumberToObject(tick_json, "pressure", (double) stats.pressure_iterations) == NULL
+        || !cJSON_AddItemToArray(iterations_json, tick_json)) {
+        cJSON_Delete(tick_json);
+        return false;
+    }
+
+    return true;
+}
+
+static bool add_validation_to_metadata(cJSON *result_json, const char *const validate_path, uint64_t simulation_id) {
+    if (result_json == NULL || validate_path == NULL) return false;
+    const char *const field_names[] = {"d", "u", "v"};
+    char *reference_path = NULL;
+    char *reference_string = NULL;
+    cJSON *reference_json = NULL;
+    cJSON *validation_json = NULL;
+    char file_error[MPI_MAX_ERROR_STRING + 1];
+    validate_t validation;
+    bool compared;
+
+    // A missing or different reference is reported, it does not stop the simulations
+    reference_path = validate_find_reference(validate_path, simulation_id);
+    if (reference_path == NULL) {
+        log_warn("Reference result of simulation %ld not found in %s", simulation_id, validate_path);
+        return true;
+    }
+
+    reference_string = read_file(reference_path, file_error);
+    if (reference_string != NULL) reference_json = cJSON_Parse(reference_string);
+    free(reference_string);
+
+    compared = validate_result(result_json, reference_json, &validation);
+    cJSON_Delete(reference_json);
+    if (!compared) {
+        log_warn("Simulation %ld is not comparable with reference result %s", simulation_id, reference_path);
+        free(reference_path);
+        return true;
+    }
+
+    const validate_field_t *const fields[] = {&validation.density, &validation.u, &validation.v};
+    validation_json = cJSON_AddObjectToObject(cJSON_GetObjectItemCaseSensitive(result_json, "metadata"),
+                                              "validation");
+    if (validation_json == NULL || cJSON_AddStringToObject(validation_json, "reference", reference_path) == NULL) {
+        free(reference_path);
+        return false;
+    }
+
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); ++i) {
+        cJSON *field_json = cJSON_AddObjectToObject(validation_json, field_names[i]);
+
+        log_info("Simulation %ld %s compared with %s: max error %g, relative error %g", simulation_id,
+                 field_names[i], reference_path, fields[i]->max_error, fields[i]->relative_error);
+        if (field_json == NULL
+            || cJSON_AddNumberToObject(field_json, "max_error", fields[i]->max_error) == NULL
+            || cJSON_AddNumberToObject(field_json, "relative_error", fields[i]->relative_error) == NULL) {
+            free(reference_path);
+            return false;
+        }
+    }
+
+    free(reference_path);
+    return true;
+}
+
+static bool add_compression_to_metadata(cJSON *result_json, const snapshot_layout_t *const layout) {
+    cJSON *output_json;
+    cJSON *compression_json;
+
+    output_json = cJSON_GetObjectItemCaseSensitive(cJSON_GetObjectItemCaseSensitive(result_json, "metadata"),
+                                                   "output");
+    compression_json = cJSON_AddObjectToObject(output_json, "compression");
+    if (compression_json == NULL
+        || cJSON_AddStringToObject(compression_json, "type", snapshot_compression_string(layout->compression)) == NULL)
+        return false;
+
+    if (layout->compression == SNAPSHOT_COMPRESSION_LOSSY
+        && cJSON_AddNumberToObject(compression_json, "tolerance", layout->tolerance) == NULL)
+        return false;
+
     return true;
 }
+
+static void save_snapshot(void *context, const ns_world_t *const world, ns_tick_stats_t stats) {
+    worker_result_t *result = (worker_result_t *) context;
+    char file_error[MPI_MAX_ERROR_STRING + 1];
+    cJSON *snapshot = NULL;
+
+    journal_snapshot(result, world, stats);
+
+    // Append world snapshot to the binary file
+    if (result->writer != NULL) {
+        log_debug("Writing world snapshot on tick %ld", world->tick);
+        if (!snapshot_writer_write(result->writer, world, stats, file_error)) {
+            log_error("Error writing tick %ld to file %s: %s", world->tick, result->save_location, file_error);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        return;
+    }
+
+    if (world->tick != 0 && !add_tick_stats_to_iterations(result->iterations, world->tick, stats)) {
+        log_error("Unable to add tick %ld iterations to JSON simulation metadata", world->tick);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    // Compute world snapshot
+    snapshot = cJSON_CreateArray();
+    if (snapshot == NULL) {
+        log_error("Error creating JSON snapshot");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    // Cells are identified by the world coordinates of the first cell of their block
+    log_debug("Saving world snapshot on tick %ld", world->tick);
+    for (size_t y = 0; y < world->world_height_bounds; ++y) {
+        for (size_t x = 0; x < world->world_width_bounds; ++x) {
+            const uint64_t i = NS_WORLD_IDX(world, x, y);
+            const uint64_t world_x = result->output.x + x * result->output.downsample;
+            const uint64_t world_y = result->output.y + y * result->output.downsample;
+            cJSON *cell_json = NULL;
+
+            cell_json = cJSON_CreateObject();
+            if (cell_json == NULL) {
+                log_error("Error creating JSON cell");
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+            }
+
+            // Only the saved fields
+            if (cJSON_AddNumberToObject(cell_json, "x", (double) world_x) == NULL
+                || cJSON_AddNumberToObject(cell_json, "y", (double) world_y) == NULL
+                || (world->density != NULL
+                    && cJSON_AddNumberToObject(cell_json, "d", (double) world->density[i]) == NULL)
+                || (world->u != NULL && cJSON_AddNumberToObject(cell_json, "u", (double) world->u[i]) == NULL)
+                || (world->v != NULL && cJSON_AddNumberToObject(cell_json, "v", (double) world->v[i]) == NULL)) {
+                log_error("Unable to add data to JSON cell");
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+            }
+
+            if (!cJSON_AddItemToArray(snapshot, cell_json)) {
+                log_error("Unable to add JSON cell to snapshot");
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+            }
+        }
+    }
+
+    if (!cJSON_AddItemToArray(result->snapshots, snapshot)) {
+        log_error("Unable to add JSON snapshot to snapshots");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+}
+
+static void journal_snapshot(worker_result_t *result, const ns_world_t *const world, ns_tick_stats_t stats) {
+    char file_error[MPI_MAX_ERROR_STRING + 1];
+
+    // Without journal the next checkpoints are skipped, the result is saved all the same
+    if (result->journal == NULL) return;
+    if (!snapshot_writer_write(result->journal, world, stats, file_error)) {
+        log_warn("Error journaling tick %ld of simulation %ld, no more checkpoints: %s", world->tick,
+                 result->simulation_id, file_error);
+        snapshot_writer_close(result->journal, file_error);
+        result->journal = NULL;
+    }
+}
+
+static void save_result(void *context, const ns_world_t *const world, ns_tick_stats_t stats) {
+    (void) world;
+    (void) stats;
+    worker_result_t *result = (worker_result_t *) context;
+    char file_error[MPI_MAX_ERROR_STRING + 1];
+
+    if (result->writer != NULL && result->container != NULL) {
+        // Complete binary file in memory with the snapshot index
+        uint64_t length;
+        uint8_t *content = snapshot_writer_close_memory(result->writer, &length, file_error);
+        if (content == NULL) {
+            log_error("Error saving simulation %ld: %s", result->simulation_id, file_error);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        save_result_to_container(result, content, length);
+    } else if (result->writer != NULL) {
+        // Complete binary file with the snapshot index
+        if (!snapshot_writer_close(result->writer, file_error)) {
+            log_error("Error saving file %s: %s", result->save_location, file_error);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+    } else {
+        log_info("Computing result data...");
+
+        // Compare with the reference result
+        if (result->validate_path != NULL
+            && !add_validation_to_metadata(result->json, result->validate_path, result->simulation_id)) {
+            log_error("Error adding validation to JSON simulation metadata");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        // Transform JSON object to string
+        char *result_string = cJSON_Print(result->json);
+        if (result_string == NULL) {
+            log_error("Error transforming JSON result to string");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        // Save result to file
+        if (result->container != NULL) {
+            save_result_to_container(result, result_string, strlen(result_string));
+        } else {
+            log_info("Saving simulation %ld to file %s", result->simulation_id, result->save_location);
+            if (!write_file(result->save_location, result_string, file_error)) {
+                log_error("Error saving file %s: %s", result->save_location, file_error);
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+            }
+            free(result_string);
+        }
+    }
+    log_info("Simulation %ld saved", result->simulation_id);
+
+    // Simulations with the same result key fetch it from the cache
+    if (result->cache_key != NULL
+        && !cache_store(result->cache_path, result->cache_key, result->cache_key_length, result->format,
+                        result->simulation_id, result->save_location, file_error))
+        log_warn("Unable to cache simulation %ld: %s", result->simulation_id, file_error);
+
+    if (result->checkpoint_path != NULL) mark_done(result);
+    free_result(result);
+}
+
+static void save_result_to_container(worker_result_t *result, void *content, uint64_t length) {
+    const com_container_message_t message = {.done = false, .simulation_id = result->simulation_id,
+            .format = result->format, .length = length};
+    cJSON *metadata_json;
+    char *metadata_string;
+    uint64_t offset;
+    char file_error[MPI_MAX_ERROR_STRING + 1];
+
+    // Metadata of the table of contents, without the iterations of every tick
+    metadata_json = cJSON_Duplicate(cJSON_GetObjectItemCaseSensitive(result->json, "metadata"), true);
+    cJSON_DeleteItemFromObjectCaseSensitive(metadata_json, "iterations");
+    metadata_string = cJSON_PrintUnformatted(metadata_json);
+    cJSON_Delete(metadata_json);
+    if (metadata_string == NULL) {
+        log_error("Error transforming JSON metadata to string");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    // Reserve the range of the result from master
+    MPI_Send(&message, 1, result->container_message_type, MASTER_NODE_RANK, COM_CONTAINER_TAG,
+             result->container_comm);
+    MPI_Send(metadata_string, (int) strlen(metadata_string), MPI_CHAR, MASTER_NODE_RANK, COM_CONTAINER_TAG,
+             result->container_comm);
+    MPI_Recv(&offset, 1, MPI_UINT64_T, MASTER_NODE_RANK, COM_CONTAINER_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    free(metadata_string);
+
+    // The write completes in background, the container frees content
+    log_info("Saving simulation %ld to container %s at offset %ld", result->simulation_id, result->save_location,
+             offset);
+    if (!container_write(result->container, offset, content, length, file_error)) {
+        log_error("Error saving simulation %ld to container %s: %s", result->simulation_id, result->save_location,
+                  file_error);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+}
+
+static void save_checkpoint(void *context, const ns_world_t *const world, ns_tick_stats_t stats) {
+    (void) world;
+    (void) stats;
+    worker_checkpoint_t *job = (worker_checkpoint_t *) context;
+    char file_error[MPI_MAX_ERROR_STRING + 1];
+
+    // A checkpoint is restored only with the snapshots of its ticks on disk
+    if (job->result != NULL && job->result->journal == NULL) {
+        log_debug("Skipping checkpoint on tick %ld without journal", job->checkpoint.tick);
+    } else if (job->result != NULL && !snapshot_writer_sync(job->result->journal, file_error)) {
+        log_warn("Error flushing journal of simulation %ld: %s", job->checkpoint.simulation_id, file_error);
+    } else if (!checkpoint_write(job->file_path, &job->checkpoint, file_error)) {
+        log_warn("Error saving checkpoint %s: %s", job->file_path, file_error);
+    } else {
+        log_debug("Checkpoint of simulation %ld saved on tick %ld", job->checkpoint.simulation_id,
+                  job->checkpoint.tick);
+    }
+
+    free(job->checkpoint.parameters);
+    free(job->checkpoint.state);
+    free(job->file_path);
+    free(job);
+}
+
+static void discard_checkpoint(void *context, const ns_world_t *const world, ns_tick_stats_t stats) {
+    (void) world;
+    (void) stats;
+    char *file_path = (char *) context;
+
+    // Missing if the simulation completed before its first checkpoint
+    MPI_File_delete(file_path, MPI_INFO_NULL);
+    free(file_path);
+}
+
+static void mark_done(worker_result_t *result) {
+    char *done_path;
+    char file_error[MPI_MAX_ERROR_STRING + 1];
+
+    if (result->journal != NULL && !snapshot_writer_close(result->journal, file_error)) {
+        log_warn("Error closing journal of simulation %ld: %s", result->simulation_id, file_error);
+    } else if (result->journal != NULL && result->cache_journal_path != NULL
+               && rename(result->journal_path, result->cache_journal_path) != 0) {
+        // Kept for the cached state of the last tick
+        log_warn("Unable to move journal of simulation %ld to the cache", result->simulation_id);
+    }
+    result->journal = NULL;
+
+    // The checkpoints are useless once the simulation is marked done, a resumed run skips it
+    done_path = checkpoint_file_path(result->checkpoint_path, CHECKPOINT_FILE_DONE, result->simulation_id, NULL, 0);
+    if (done_path == NULL || !checkpoint_write(done_path, &result->done, file_error)) {
+        log_warn("Unable to mark simulation %ld done in %s", result->simulation_id, result->checkpoint_path);
+        free(done_path);
+        return;
+    }
+    free(done_path);
+
+    checkpoint_remove(result->checkpoint_path, result->simulation_id);
+}
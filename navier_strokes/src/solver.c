@@ -1,7 +1,30 @@
 #include "ns/solver.h"
+#include "ns/halo.h"
+#include "ns/kernels.h"
 #include "ns/config.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <sys/mman.h>
+
+// Field alignment in bytes (cache line)
+#define NS_FIELD_ALIGNMENT 64
+// Field alignment in cells
+#define NS_FIELD_ALIGNMENT_CELLS (NS_FIELD_ALIGNMENT / sizeof(ns_real_t))
+// Field alignment in bytes for fields eligible to be backed by huge pages
+#define NS_FIELD_HUGE_PAGE_ALIGNMENT (2 * 1024 * 1024)
+
+// Index of cell (x, y) in a field
+#define NS_IDX(ns, x, y) ((y) * (ns)->world_pitch + (x))
+// Fields of the solver state: u, u_prev, v, v_prev, density and density_prev
+#define NS_STATE_FIELDS 6
+
+// Relaxation kernels
+typedef enum ns_relax_kernel_t {
+    NS_RELAX_KERNEL_DIFFUSE,
+    NS_RELAX_KERNEL_PROJECT
+} ns_relax_kernel_t;
 
 // Data wrapper
 typedef struct ns_t {
@@ -11,6 +34,19 @@ typedef struct ns_t {
     uint64_t world_height;
     uint64_t world_height_bounds;
 
+    // Tile stored by this rank (the whole world if not decomposed)
+    ns_halo_tile_t tile;
+    // Row stride in cells of every field (>= tile width + 2)
+    uint64_t world_pitch;
+    // Halo exchange (only if decomposed)
+    ns_halo_t *halo;
+    // Gathered world data, world_width_bounds * world_height_bounds cells each (only on the decomposition root)
+    ns_real_t *world_u;
+    ns_real_t *world_v;
+    ns_real_t *world_dense;
+    // Ticks done when the world was last gathered
+    uint64_t world_tick;
+
     // Fluid
     double viscosity;
     double density;
@@ -19,18 +55,45 @@ typedef struct ns_t {
     // Time
     double time_step;
 
-    // World data
-    double **u;
-    double **u_prev;
-    double **v;
-    double **v_prev;
-    double **dense;
-    double **dense_prev;
+    // Solver configuration
+    ns_solver_config_t config;
+    // Boundaries of the world edges
+    ns_boundaries_t boundaries;
+    // Multigrid hierarchy (only with multigrid pressure solver)
+    ns_multigrid_t *multigrid;
+    // Ticks done
+    uint64_t tick;
+    // Iterations used during the last tick
+    ns_tick_stats_t stats;
+    // Row kernels of the widest instruction set supported by the CPU
+    const ns_kernels_t *kernels;
+
+    // Tile data (contiguous, world_pitch * (tile height + 2) cells each)
+    ns_real_t *u;
+    ns_real_t *u_prev;
+    ns_real_t *v;
+    ns_real_t *v_prev;
+    ns_real_t *dense;
+    ns_real_t *dense_prev;
 } ns_t;
 
+// Relaxation names
+static const char *relaxation_strings[] = {
+        "lexicographic", "red_black"
+};
+
+// Pressure solver names
+static const char *pressure_solver_strings[] = {
+        "relaxation", "multigrid"
+};
+
 /**
  * Private definitions
  */
+static ns_t *ns_create_tile(uint64_t world_width, uint64_t world_height, const ns_halo_tile_t *tile,
+                            double viscosity, double density, double diffusion,
+                            double time_step);
+
 static void ns_velocity_step(ns_t *ns);
 
 static void ns_density_step(ns_t *ns);
@@ -38,17 +101,59 @@ static void ns_density_step(ns_t *ns);
 static void ns_add_sources_to_targets(const ns_t *ns);
 
 static void
-ns_diffuse(const ns_t *ns, uint64_t bounds, double diffusion_value, double **target, const double **source);
+ns_diffuse(ns_t *ns, ns_boundary_field_t field, double diffusion_value, ns_real_t *target, const ns_real_t *source);
+
+static double ns_diffuse_residual(const ns_t *ns, ns_real_t a, const ns_real_t *target, const ns_real_t *source);
 
 static void ns_project(ns_t *ns);
 
-static void ns_advect(const ns_t *ns, uint64_t bounds, double **d, double **d0, double **u, double **v);
+static void ns_project_relax(ns_t *ns);
+
+static double ns_project_residual(const ns_t *ns);
+
+static double ns_field_norm(const ns_t *ns, const ns_real_t *field);
+
+static double ns_sum(const ns_t *ns, double value);
+
+static void ns_exchange(const ns_t *ns, ns_real_t *field);
+
+static void
+ns_advect(const ns_t *ns, ns_boundary_field_t field, ns_real_t *d, const ns_real_t *d0, const ns_real_t *u,
+          const ns_real_t *v);
+
+static void ns_set_bounds(const ns_t *ns, ns_boundary_field_t field, ns_real_t *target);
+
+static void ns_set_bounds_after_sweep(const ns_t *ns, ns_boundary_field_t field, ns_real_t *target);
+
+static inline void
+ns_advect_departure(const ns_t *ns, uint64_t x, uint64_t y, ns_real_t dt0_width, ns_real_t dt0_height,
+                    const ns_real_t *u, const ns_real_t *v, ns_real_t *xx, ns_real_t *yy);
+
+static void ns_relax_color(const ns_t *ns, ns_relax_kernel_t kernel, ns_boundary_field_t field, ns_real_t *target,
+                           const ns_real_t *source, ns_real_t a, uint64_t color);
+
+static void ns_relax_rows(const ns_t *ns, ns_relax_kernel_t kernel, ns_real_t *target, const ns_real_t *source,
+                          ns_real_t a, uint64_t color, uint64_t y_first, uint64_t y_last, uint64_t x_first,
+                          uint64_t x_last, const ns_boundary_field_t *field);
 
-static void ns_set_bounds(const ns_t *ns, uint64_t bounds, double **target);
+static inline uint64_t ns_red_black_first_x(uint64_t x, uint64_t y, uint64_t color);
 
-static void ns_swap_matrix(double ***x, double ***y);
+static inline void
+ns_diffuse_row(ns_real_t *row, const ns_real_t *source_row, uint64_t pitch, ns_real_t a, uint64_t x_first,
+               uint64_t x_last, uint64_t x_step);
+
+static inline void
+ns_project_row(ns_real_t *p, const ns_real_t *div, uint64_t pitch, uint64_t x_first, uint64_t x_last, uint64_t x_step);
+
+static void ns_swap_matrix(ns_real_t **x, ns_real_t **y);
+
+static ns_real_t *ns_field_alloc(const ns_t *ns);
+
+static void ns_field_free(ns_real_t *field);
 
 static bool is_valid_coordinate(const ns_t *ns, uint64_t x, uint64_t y);
+
+static bool is_tile_coordinate(const ns_t *ns, uint64_t x, uint64_t y);
 /**
  * END Private definitions
  */
@@ -59,64 +164,46 @@ static bool is_valid_coordinate(const ns_t *ns, uint64_t x, uint64_t y);
 ns_t *ns_create(uint64_t world_width, uint64_t world_height,
                 double viscosity, double density, double diffusion,
                 double time_step) {
-    uint64_t i;
+    const ns_halo_tile_t tile = {
+            .x = 0, .y = 0, .width = world_width, .height = world_height,
+            .left = true, .right = true, .top = true, .bottom = true
+    };
+
+    return ns_create_tile(world_width, world_height, &tile, viscosity, density, diffusion, time_step);
+}
+
+ns_t *ns_create_distributed(MPI_Comm comm, uint64_t world_width, uint64_t world_height,
+                            double viscosity, double density, double diffusion,
+                            double time_step) {
     bool error = false;
+    ns_halo_tile_t tile;
+    ns_halo_t *halo = NULL;
     ns_t *ns = NULL;
 
-    ns = (ns_t *) malloc(sizeof(ns_t));
-    if (ns == NULL) return NULL;
+    halo = ns_halo_create(comm, world_width, world_height, &tile);
+    if (halo == NULL) return NULL;
 
-    // World
-    ns->world_width = world_width;
-    ns->world_width_bounds = ns->world_width + 2;
-    ns->world_height = world_height;
-    ns->world_height_bounds = ns->world_height + 2;
-    // Fluid
-    ns->viscosity = viscosity;
-    ns->density = density;
-    ns->diffusion = diffusion;
-    // Time
-    ns->time_step = time_step;
+    ns = ns_create_tile(world_width, world_height, &tile, viscosity, density, diffusion, time_step);
+    if (ns == NULL) error = true;
+    else {
+        ns->halo = halo;
+        ns_set_solver_config(ns, &ns->config);
 
-    // Allocate world data
-    ns->u = (double **) calloc(ns->world_height_bounds, sizeof(double *));
-    ns->u_prev = (double **) calloc(ns->world_height_bounds, sizeof(double *));
-    ns->v = (double **) calloc(ns->world_height_bounds, sizeof(double *));
-    ns->v_prev = (double **) calloc(ns->world_height_bounds, sizeof(double *));
-    ns->dense = (double **) calloc(ns->world_height_bounds, sizeof(double *));
-    ns->dense_prev = (double **) calloc(ns->world_height_bounds, sizeof(double *));
+        if (ns_halo_is_root(halo)) {
+            const size_t size = ns->world_width_bounds * ns->world_height_bounds;
 
-    if (ns->u == NULL || ns->u_prev == NULL
-        || ns->v == NULL || ns->v_prev == NULL
-        || ns->dense == NULL || ns->dense_prev == NULL) {
-        error = true;
-    }
-
-    if (!error) {
-#pragma omp parallel for \
-    schedule(DEFAULT_OPEN_MP_SCHEDULE) \
-    default(none) private(i) shared(ns, error)
-        for (i = 0; i < ns->world_height_bounds; ++i) {
-            if (error) continue;
-
-            ns->u[i] = (double *) calloc(ns->world_width_bounds, sizeof(double));
-            ns->u_prev[i] = (double *) calloc(ns->world_width_bounds, sizeof(double));
-            ns->v[i] = (double *) calloc(ns->world_width_bounds, sizeof(double));
-            ns->v_prev[i] = (double *) calloc(ns->world_width_bounds, sizeof(double));
-            ns->dense[i] = (double *) calloc(ns->world_width_bounds, sizeof(double));
-            ns->dense_prev[i] = (double *) calloc(ns->world_width_bounds, sizeof(double));
-
-            if (ns->u[i] == NULL || ns->u_prev[i] == NULL
-                || ns->v[i] == NULL || ns->v_prev[i] == NULL
-                || ns->dense[i] == NULL || ns->dense_prev[i] == NULL) {
-#pragma omp critical
-                error = true;
-            }
+            ns->world_u = (ns_real_t *) calloc(size, sizeof(ns_real_t));
+            ns->world_v = (ns_real_t *) calloc(size, sizeof(ns_real_t));
+            ns->world_dense = (ns_real_t *) calloc(size, sizeof(ns_real_t));
+            if (ns->world_u == NULL || ns->world_v == NULL || ns->world_dense == NULL) error = true;
         }
     }
 
+    // Every rank must agree, the wrapper is used collectively
+    MPI_Allreduce(MPI_IN_PLACE, &error, 1, MPI_C_BOOL, MPI_LOR, comm);
     if (error) {
-        ns_free(ns);
+        if (ns != NULL) ns_free(ns);
+        else ns_halo_free(halo);
         return NULL;
     }
 
@@ -125,39 +212,114 @@ ns_t *ns_create(uint64_t world_width, uint64_t world_height,
 
 void ns_free(ns_t *ns) {
     if (ns == NULL) return;
-    uint64_t i;
 
-#pragma omp parallel for \
-    schedule(DEFAULT_OPEN_MP_SCHEDULE) \
-    default(none) private(i) shared(ns)
-    for (i = 0; i < ns->world_height_bounds; ++i) {
-        if (ns->u != NULL)
-            free(ns->u[i]);
-        if (ns->u_prev != NULL)
-            free(ns->u_prev[i]);
-        if (ns->v != NULL)
-            free(ns->v[i]);
-        if (ns->v_prev != NULL)
-            free(ns->v_prev[i]);
-        if (ns->dense != NULL)
-            free(ns->dense[i]);
-        if (ns->dense_prev != NULL)
-            free(ns->dense_prev[i]);
+    ns_field_free(ns->u);
+    ns_field_free(ns->u_prev);
+    ns_field_free(ns->v);
+    ns_field_free(ns->v_prev);
+    ns_field_free(ns->dense);
+    ns_field_free(ns->dense_prev);
+    ns_multigrid_free(ns->multigrid);
+    ns_halo_free(ns->halo);
+    free(ns->world_u);
+    free(ns->world_v);
+    free(ns->world_dense);
+
+    free(ns);
+}
+
+const char *ns_relaxation_string(ns_relaxation_t relaxation) {
+    if (relaxation < NS_RELAXATION_LEXICOGRAPHIC || relaxation > NS_RELAXATION_RED_BLACK) return NULL;
+
+    return relaxation_strings[relaxation];
+}
+
+int ns_relaxation_int(const char *const relaxation) {
+    if (relaxation == NULL) return -1;
+
+    for (int i = NS_RELAXATION_LEXICOGRAPHIC; i <= NS_RELAXATION_RED_BLACK; ++i) {
+        if (strcmp(relaxation, relaxation_strings[i]) == 0) return i;
+    }
+
+    return -1;
+}
+
+const char *ns_pressure_solver_string(ns_pressure_solver_t pressure) {
+    if (pressure < NS_PRESSURE_SOLVER_RELAXATION || pressure > NS_PRESSURE_SOLVER_MULTIGRID) return NULL;
+
+    return pressure_solver_strings[pressure];
+}
+
+int ns_pressure_solver_int(const char *const pressure) {
+    if (pressure == NULL) return -1;
+
+    for (int i = NS_PRESSURE_SOLVER_RELAXATION; i <= NS_PRESSURE_SOLVER_MULTIGRID; ++i) {
+        if (strcmp(pressure, pressure_solver_strings[i]) == 0) return i;
     }
 
-    free(ns->u);
-    free(ns->u_prev);
-    free(ns->v);
-    free(ns->v_prev);
-    free(ns->dense);
-    free(ns->dense_prev);
+    return -1;
+}
+
+void ns_solver_config_init(ns_solver_config_t *config) {
+    if (config == NULL) return;
+
+    config->relaxation = NS_RELAXATION_LEXICOGRAPHIC;
+    config->max_iterations = DEFAULT_RELAXATION_MAX_ITERATIONS;
+    config->tolerance = 0.0;
+    config->check_every = 0;
+    config->pressure = NS_PRESSURE_SOLVER_RELAXATION;
+    config->multigrid.cycle = NS_MULTIGRID_CYCLE_V;
+    config->multigrid.tolerance = DEFAULT_MULTIGRID_TOLERANCE;
+    config->multigrid.max_cycles = DEFAULT_MULTIGRID_MAX_CYCLES;
+}
+
+bool ns_set_solver_config(ns_t *ns, const ns_solver_config_t *const config) {
+    if (ns == NULL || config == NULL) return false;
+    // The multigrid levels have closed boundaries, with periodic edges they would solve another pressure
+    if (config->pressure == NS_PRESSURE_SOLVER_MULTIGRID && ns_boundaries_periodic(&ns->boundaries)) return false;
 
-    free(ns);
+    // Multigrid hierarchy is created once and kept
+    if (config->pressure == NS_PRESSURE_SOLVER_MULTIGRID && ns->halo == NULL && ns->multigrid == NULL) {
+        ns->multigrid = ns_multigrid_create(ns->world_width, ns->world_height, ns->world_pitch);
+        if (ns->multigrid == NULL) return false;
+    }
+
+    ns->config = *config;
+    // Lexicographic sweeps would serialize the tiles and the multigrid hierarchy is not decomposed
+    if (ns->halo != NULL) {
+        ns->config.relaxation = NS_RELAXATION_RED_BLACK;
+        ns->config.pressure = NS_PRESSURE_SOLVER_RELAXATION;
+    }
+    return true;
+}
+
+bool ns_set_boundaries(ns_t *ns, const ns_boundaries_t *const boundaries) {
+    if (ns == NULL || !ns_boundaries_check(boundaries)) return false;
+    if (ns->config.pressure == NS_PRESSURE_SOLVER_MULTIGRID && ns_boundaries_periodic(boundaries)) return false;
+
+    // Periodic ghost cells are copied from the opposite side, which must belong to the same tile
+    if (!(ns->tile.left && ns->tile.right)
+        && boundaries->edges[NS_BOUNDARY_EDGE_LEFT].type == NS_BOUNDARY_TYPE_PERIODIC)
+        return false;
+    if (!(ns->tile.top && ns->tile.bottom)
+        && boundaries->edges[NS_BOUNDARY_EDGE_TOP].type == NS_BOUNDARY_TYPE_PERIODIC)
+        return false;
+
+    ns->boundaries = *boundaries;
+    return true;
 }
 
 void ns_tick(ns_t *ns) {
+    ns->stats.diffuse_iterations = 0;
+    ns->stats.pressure_iterations = 0;
+
     ns_velocity_step(ns);
     ns_density_step(ns);
+    ns->tick += 1;
+}
+
+ns_tick_stats_t ns_get_tick_stats(const ns_t *ns) {
+    return ns->stats;
 }
 
 bool ns_increase_density(ns_t *ns, uint64_t x, uint64_t y) {
@@ -171,8 +333,8 @@ bool ns_increase_density(ns_t *ns, uint64_t x, uint64_t y) {
         fprintf(stderr, "Invalid increase_density coordinates {x: %ld, y: %ld}\n", x, y);
     else status = true;
 
-    if (status)
-        ns->dense[y][x] += ns->density;
+    if (status && is_tile_coordinate(ns, x, y))
+        ns->dense[NS_IDX(ns, x - ns->tile.x, y - ns->tile.y)] += (ns_real_t) ns->density;
 
     return status;
 }
@@ -190,62 +352,119 @@ bool ns_apply_force(ns_t *ns, uint64_t x, uint64_t y, double v_x, double v_y) {
         fprintf(stdout, "Invalid apply_force velocity {v_x: %lf, v_y: %lf}\n", v_x, v_y);
     else status = true;
 
-    if (status) {
-        ns->u[y][x] = v_x != 0 ? v_x : ns->u[y][x];
-        ns->v[y][x] = v_y != 0 ? v_y : ns->v[y][x];
+    if (status && is_tile_coordinate(ns, x, y)) {
+        x -= ns->tile.x;
+        y -= ns->tile.y;
+        ns->u[NS_IDX(ns, x, y)] = v_x != 0 ? (ns_real_t) v_x : ns->u[NS_IDX(ns, x, y)];
+        ns->v[NS_IDX(ns, x, y)] = v_y != 0 ? (ns_real_t) v_y : ns->v[NS_IDX(ns, x, y)];
     }
 
     return status;
 }
 
-ns_world_t *ns_get_world(const ns_t *ns) {
-    uint64_t i, x, y;
-    ns_world_t *world = (ns_world_t *) malloc(sizeof(ns_world_t));
+bool ns_gather_world(ns_t *ns) {
+    if (ns->halo == NULL) return true;
+
+    if (!(ns_halo_gather_world(ns->halo, ns->u, ns->world_pitch, ns->world_u, ns->world_width_bounds)
+          && ns_halo_gather_world(ns->halo, ns->v, ns->world_pitch, ns->world_v, ns->world_width_bounds)
+          && ns_halo_gather_world(ns->halo, ns->dense, ns->world_pitch, ns->world_dense, ns->world_width_bounds)))
+        return false;
+
+    ns->world_tick = ns->tick;
+    return true;
+}
+
+bool ns_get_world(const ns_t *ns, ns_world_t *world) {
+    if (ns == NULL || world == NULL) return false;
 
     world->world_width = ns->world_width;
     world->world_width_bounds = ns->world_width_bounds;
     world->world_height = ns->world_height;
     world->world_height_bounds = ns->world_height_bounds;
 
-    world->world = (ns_cell_t **) calloc(ns->world_height_bounds, sizeof(ns_cell_t *));
-
-#pragma omp parallel \
-default(none) private(i) shared(ns, world)
-    {
-#pragma omp for \
-        schedule(DEFAULT_OPEN_MP_SCHEDULE)
-        for (i = 0; i < ns->world_height_bounds; ++i)
-            world->world[i] = (ns_cell_t *) calloc(ns->world_width_bounds, sizeof(ns_cell_t));
-
-#pragma omp for collapse(2) \
-        schedule(DEFAULT_OPEN_MP_SCHEDULE)
-        for (y = 0; y < ns->world_height_bounds; ++y) {
-            for (x = 0; x < ns->world_width_bounds; ++x) {
-                ns_cell_t cell;
-                cell.u = &ns->u[y][x];
-                cell.v = &ns->v[y][x];
-                cell.density = &ns->dense[y][x];
-
-                world->world[y][x] = cell;
-            }
-        }
+    if (ns->halo != NULL) {
+        if (!ns_halo_is_root(ns->halo)) return false;
+
+        world->tick = ns->world_tick;
+        world->pitch = ns->world_width_bounds;
+        world->u = ns->world_u;
+        world->v = ns->world_v;
+        world->density = ns->world_dense;
+    } else {
+        // The tile is the whole world, global boundary included
+        world->tick = ns->tick;
+        world->pitch = ns->world_pitch;
+        world->u = ns->u;
+        world->v = ns->v;
+        world->density = ns->dense;
     }
 
-    return world;
+    return true;
 }
 
-void ns_free_world(ns_world_t *world) {
-    uint64_t i;
+uint64_t ns_state_size(const ns_t *ns) {
+    return NS_STATE_FIELDS * (ns->tile.width + 2) * (ns->tile.height + 2);
+}
 
+uint64_t ns_get_state(const ns_t *ns, ns_real_t *buffer) {
+    uint64_t y;
+    const ns_real_t *const fields[NS_STATE_FIELDS] = {ns->u, ns->u_prev, ns->v, ns->v_prev, ns->dense,
+                                                      ns->dense_prev};
+    const uint64_t width = ns->tile.width + 2;
+    const uint64_t height = ns->tile.height + 2;
+
+    for (uint64_t f = 0; f < NS_STATE_FIELDS; ++f) {
 #pragma omp parallel for \
-    schedule(DEFAULT_OPEN_MP_SCHEDULE) \
-    default(none) private(i) shared(world)
-    for (i = 0; i < world->world_height_bounds; ++i) {
-        free(world->world[i]);
+    schedule(static) \
+    default(none) private(y) shared(ns, buffer, fields, width, height, f)
+        for (y = 0; y < height; ++y)
+            memcpy(&buffer[(f * height + y) * width], &fields[f][NS_IDX(ns, 0, y)], width * sizeof(ns_real_t));
+    }
+
+    return ns->tick;
+}
+
+void ns_set_state(ns_t *ns, uint64_t tick, const ns_real_t *buffer) {
+    uint64_t y;
+    ns_real_t *const fields[NS_STATE_FIELDS] = {ns->u, ns->u_prev, ns->v, ns->v_prev, ns->dense, ns->dense_prev};
+    const uint64_t width = ns->tile.width + 2;
+    const uint64_t height = ns->tile.height + 2;
+
+    for (uint64_t f = 0; f < NS_STATE_FIELDS; ++f) {
+#pragma omp parallel for \
+    schedule(static) \
+    default(none) private(y) shared(ns, buffer, fields, width, height, f)
+        for (y = 0; y < height; ++y)
+            memcpy(&fields[f][NS_IDX(ns, 0, y)], &buffer[(f * height + y) * width], width * sizeof(ns_real_t));
+    }
+
+    ns->tick = tick;
+}
+
+uint64_t ns_world_copy_size(const ns_world_t *world) {
+    return 3 * world->world_width_bounds * world->world_height_bounds;
+}
+
+void ns_world_copy(const ns_world_t *world, ns_real_t *buffer, ns_world_t *copy) {
+    uint64_t y;
+    const uint64_t plane = world->world_width_bounds * world->world_height_bounds;
+    const size_t row_size = world->world_width_bounds * sizeof(ns_real_t);
+
+#pragma omp parallel for \
+    schedule(static) \
+    default(none) private(y) shared(world, buffer, plane, row_size)
+    for (y = 0; y < world->world_height_bounds; ++y) {
+        memcpy(&buffer[y * world->world_width_bounds], &world->u[NS_WORLD_IDX(world, 0, y)], row_size);
+        memcpy(&buffer[plane + y * world->world_width_bounds], &world->v[NS_WORLD_IDX(world, 0, y)], row_size);
+        memcpy(&buffer[2 * plane + y * world->world_width_bounds], &world->density[NS_WORLD_IDX(world, 0, y)],
+               row_size);
     }
 
-    free(world->world);
-    free(world);
+    *copy = *world;
+    copy->pitch = world->world_width_bounds;
+    copy->u = buffer;
+    copy->v = &buffer[plane];
+    copy->density = &buffer[2 * plane];
 }
 /**
  * END Public
@@ -254,180 +473,523 @@ void ns_free_world(ns_world_t *world) {
 /**
  * Private
  */
+static ns_t *ns_create_tile(uint64_t world_width, uint64_t world_height, const ns_halo_tile_t *tile,
+                            double viscosity, double density, double diffusion,
+                            double time_step) {
+    uint64_t i;
+    bool error = false;
+    ns_t *ns = NULL;
+
+    ns = (ns_t *) calloc(1, sizeof(ns_t));
+    if (ns == NULL) return NULL;
+
+    // World
+    ns->world_width = world_width;
+    ns->world_width_bounds = ns->world_width + 2;
+    ns->world_height = world_height;
+    ns->world_height_bounds = ns->world_height + 2;
+    // Tile
+    ns->tile = *tile;
+    ns->world_pitch = (ns->tile.width + 2 + NS_FIELD_ALIGNMENT_CELLS - 1)
+                      / NS_FIELD_ALIGNMENT_CELLS * NS_FIELD_ALIGNMENT_CELLS;
+    // Fluid
+    ns->viscosity = viscosity;
+    ns->density = density;
+    ns->diffusion = diffusion;
+    // Time
+    ns->time_step = time_step;
+    // Solver
+    ns_solver_config_init(&ns->config);
+    ns_boundaries_init(&ns->boundaries);
+    ns->kernels = ns_kernels_best();
+
+    // Allocate tile data
+    ns->u = ns_field_alloc(ns);
+    ns->u_prev = ns_field_alloc(ns);
+    ns->v = ns_field_alloc(ns);
+    ns->v_prev = ns_field_alloc(ns);
+    ns->dense = ns_field_alloc(ns);
+    ns->dense_prev = ns_field_alloc(ns);
+
+    if (ns->u == NULL || ns->u_prev == NULL
+        || ns->v == NULL || ns->v_prev == NULL
+        || ns->dense == NULL || ns->dense_prev == NULL) {
+        error = true;
+    }
+
+    if (!error) {
+        // First touch in parallel so that pages are placed near the threads that use them
+#pragma omp parallel for \
+    schedule(static) \
+    default(none) private(i) shared(ns)
+        for (i = 0; i < ns->tile.height + 2; ++i) {
+            const size_t row_size = ns->world_pitch * sizeof(ns_real_t);
+
+            memset(&ns->u[NS_IDX(ns, 0, i)], 0, row_size);
+            memset(&ns->u_prev[NS_IDX(ns, 0, i)], 0, row_size);
+            memset(&ns->v[NS_IDX(ns, 0, i)], 0, row_size);
+            memset(&ns->v_prev[NS_IDX(ns, 0, i)], 0, row_size);
+            memset(&ns->dense[NS_IDX(ns, 0, i)], 0, row_size);
+            memset(&ns->dense_prev[NS_IDX(ns, 0, i)], 0, row_size);
+        }
+    }
+
+    if (error) {
+        ns_free(ns);
+        return NULL;
+    }
+
+    return ns;
+}
+
 static void ns_velocity_step(ns_t *ns) {
     ns_add_sources_to_targets(ns);
 
     ns_swap_matrix(&ns->u_prev, &ns->u);
-    ns_diffuse(ns, 1, ns->viscosity, ns->u, (const double **) ns->u_prev);
+    ns_diffuse(ns, NS_BOUNDARY_FIELD_U, ns->viscosity, ns->u, ns->u_prev);
 
     ns_swap_matrix(&ns->v_prev, &ns->v);
-    ns_diffuse(ns, 2, ns->viscosity, ns->v, (const double **) ns->v_prev);
+    ns_diffuse(ns, NS_BOUNDARY_FIELD_V, ns->viscosity, ns->v, ns->v_prev);
     ns_project(ns);
     ns_swap_matrix(&ns->u_prev, &ns->u);
     ns_swap_matrix(&ns->v_prev, &ns->v);
-    ns_advect(ns, 1, ns->u, ns->u_prev, ns->u_prev, ns->v_prev);
-    ns_advect(ns, 2, ns->v, ns->v_prev, ns->u_prev, ns->v_prev);
+    ns_advect(ns, NS_BOUNDARY_FIELD_U, ns->u, ns->u_prev, ns->u_prev, ns->v_prev);
+    ns_advect(ns, NS_BOUNDARY_FIELD_V, ns->v, ns->v_prev, ns->u_prev, ns->v_prev);
     ns_project(ns);
 }
 
 static void ns_density_step(ns_t *ns) {
     ns_swap_matrix(&ns->dense_prev, &ns->dense);
-    ns_diffuse(ns, 0, ns->diffusion, ns->dense, (const double **) ns->dense_prev);
+    ns_diffuse(ns, NS_BOUNDARY_FIELD_DENSITY, ns->diffusion, ns->dense, ns->dense_prev);
     ns_swap_matrix(&ns->dense_prev, &ns->dense);
-    ns_advect(ns, 0, ns->dense, ns->dense_prev, ns->u, ns->v);
+    ns_advect(ns, NS_BOUNDARY_FIELD_DENSITY, ns->dense, ns->dense_prev, ns->u, ns->v);
 }
 
 static void ns_add_sources_to_targets(const ns_t *ns) {
-    uint64_t x, y;
+    uint64_t y;
 
-#pragma omp parallel for collapse(2) \
+#pragma omp parallel for \
     schedule(DEFAULT_OPEN_MP_SCHEDULE) \
-    default(none) private(y, x) shared(ns)
-    for (y = 0; y < ns->world_height_bounds; ++y) {
-        for (x = 0; x < ns->world_width_bounds; ++x) {
-            ns->u[y][x] += ns->time_step * ns->u_prev[y][x];
-            ns->v[y][x] += ns->time_step * ns->v_prev[y][x];
-        }
+    default(none) private(y) shared(ns)
+    for (y = 0; y < ns->tile.height + 2; ++y) {
+        ns->kernels->add_scaled(&ns->u[NS_IDX(ns, 0, y)], &ns->u_prev[NS_IDX(ns, 0, y)], (ns_real_t) ns->time_step,
+                                ns->world_pitch);
+        ns->kernels->add_scaled(&ns->v[NS_IDX(ns, 0, y)], &ns->v_prev[NS_IDX(ns, 0, y)], (ns_real_t) ns->time_step,
+                                ns->world_pitch);
     }
 }
 
 static void
-ns_diffuse(const ns_t *ns, uint64_t bounds, double diffusion_value, double **target, const double **source) {
-    const double a = ns->time_step * diffusion_value * (double) ns->world_width * (double) ns->world_height;
-
-    for (uint64_t k = 0; k < 20; k++) {
-        for (uint64_t y = 1; y <= ns->world_height; ++y) {
-            for (uint64_t x = 1; x <= ns->world_width; ++x) {
-                target[y][x] =
-                        (source[y][x] + a * (target[y][x - 1] + target[y][x + 1] + target[y - 1][x] + target[y + 1][x]))
-                        / (1 + 4 * a);
+ns_diffuse(ns_t *ns, ns_boundary_field_t field, double diffusion_value, ns_real_t *target, const ns_real_t *source) {
+    uint64_t y;
+    uint64_t k = 0;
+    const ns_real_t a =
+            (ns_real_t) (ns->time_step * diffusion_value * (double) ns->world_width * (double) ns->world_height);
+    const uint64_t pitch = ns->world_pitch;
+    const uint64_t check_every = ns->config.check_every;
+    const double threshold = check_every > 0 ? ns->config.tolerance * ns_field_norm(ns, source) : 0.0;
+
+    // The initial guess is read across the tile borders
+    ns_exchange(ns, target);
+
+    while (k < ns->config.max_iterations) {
+        switch (ns->config.relaxation) {
+            case NS_RELAXATION_RED_BLACK: {
+                for (uint64_t color = 0; color < 2; ++color)
+                    ns_relax_color(ns, NS_RELAX_KERNEL_DIFFUSE, field, target, source, a, color);
+                break;
+            }
+            case NS_RELAXATION_LEXICOGRAPHIC:
+            default: {
+                for (y = 1; y <= ns->tile.height; ++y) {
+                    ns_diffuse_row(&target[NS_IDX(ns, 0, y)], &source[NS_IDX(ns, 0, y)], pitch, a,
+                                   1, ns->tile.width, 1);
+                    ns_boundary_set_row(&ns->boundaries, field, &ns->tile, &target[NS_IDX(ns, 0, y)]);
+                }
+                break;
             }
         }
 
-        ns_set_bounds(ns, bounds, target);
+        ns_set_bounds_after_sweep(ns, field, target);
+        k += 1;
+
+        if (check_every > 0 && k % check_every == 0 && ns_diffuse_residual(ns, a, target, source) <= threshold)
+            break;
     }
+
+    ns->stats.diffuse_iterations += k;
+}
+
+static double ns_diffuse_residual(const ns_t *ns, ns_real_t a, const ns_real_t *target, const ns_real_t *source) {
+    uint64_t y;
+    const uint64_t pitch = ns->world_pitch;
+    double norm = 0.0;
+
+#pragma omp parallel for \
+    schedule(static) \
+    default(none) private(y) shared(ns, a, target, source, pitch) reduction(+:norm)
+    for (y = 1; y <= ns->tile.height; ++y) {
+        const ns_real_t *const row = &target[NS_IDX(ns, 0, y)];
+        const ns_real_t *const source_row = &source[NS_IDX(ns, 0, y)];
+
+        for (uint64_t x = 1; x <= ns->tile.width; ++x) {
+            const ns_real_t r = source_row[x] - ((1 + 4 * a) * row[x]
+                                                 - a * (row[x - 1] + row[x + 1] + row[x - pitch] + row[x + pitch]));
+            norm += (double) r * (double) r;
+        }
+    }
+
+    return sqrt(ns_sum(ns, norm));
 }
 
 static void ns_project(ns_t *ns) {
-    uint64_t x, y;
-    double h = 1.0 / (double) ns->world_width;
+    uint64_t y;
+    const uint64_t pitch = ns->world_pitch;
+    ns_real_t h = (ns_real_t) (1.0 / (double) ns->world_width);
+
+    // The velocity is read across the tile borders
+    ns_exchange(ns, ns->u);
+    ns_exchange(ns, ns->v);
 
-    for (y = 1; y <= ns->world_height; ++y) {
-        for (x = 1; x <= ns->world_width; ++x) {
-            ns->v_prev[y][x] = -0.5 * h
-                               * (ns->u[y][x + 1] - ns->u[y][x - 1] + ns->v[y + 1][x] - ns->v[y - 1][x]);
-            ns->u_prev[y][x] = 0;
+    for (y = 1; y <= ns->tile.height; ++y) {
+        ns->kernels->divergence_row(&ns->v_prev[NS_IDX(ns, 0, y)], &ns->u_prev[NS_IDX(ns, 0, y)],
+                                    &ns->u[NS_IDX(ns, 0, y)], &ns->v[NS_IDX(ns, 0, y)], pitch, h, ns->tile.width);
+    }
+
+    ns_set_bounds(ns, NS_BOUNDARY_FIELD_SCALAR, ns->v_prev);
+    ns_set_bounds(ns, NS_BOUNDARY_FIELD_SCALAR, ns->u_prev);
+    ns_exchange(ns, ns->u_prev);
+
+    switch (ns->config.pressure) {
+        case NS_PRESSURE_SOLVER_MULTIGRID: {
+            ns->stats.pressure_iterations += ns_multigrid_solve(ns->multigrid, ns->u_prev, ns->v_prev,
+                                                                ns->config.multigrid.cycle,
+                                                                ns->config.multigrid.tolerance,
+                                                                ns->config.multigrid.max_cycles);
+            ns_set_bounds(ns, NS_BOUNDARY_FIELD_SCALAR, ns->u_prev);
+            break;
         }
+        case NS_PRESSURE_SOLVER_RELAXATION:
+        default: {
+            ns_project_relax(ns);
+            break;
+        }
+    }
+
+#pragma omp parallel for \
+    schedule(DEFAULT_OPEN_MP_SCHEDULE) \
+    default(none) private(y) shared(ns, h, pitch)
+    for (y = 1; y <= ns->tile.height; ++y) {
+        ns->kernels->gradient_row(&ns->u[NS_IDX(ns, 0, y)], &ns->v[NS_IDX(ns, 0, y)], &ns->u_prev[NS_IDX(ns, 0, y)],
+                                  pitch, h, ns->tile.width);
     }
 
-    ns_set_bounds(ns, 0, ns->v_prev);
-    ns_set_bounds(ns, 0, ns->u_prev);
+    ns_set_bounds(ns, NS_BOUNDARY_FIELD_U, ns->u);
+    ns_set_bounds(ns, NS_BOUNDARY_FIELD_V, ns->v);
+}
 
-    for (uint64_t k = 0; k < 20; k++) {
-        for (y = 1; y <= ns->world_height; ++y) {
-            for (x = 1; x <= ns->world_width; ++x) {
-                ns->u_prev[y][x] =
-                        (ns->v_prev[y][x]
-                         + ns->u_prev[y][x - 1] + ns->u_prev[y][x + 1] + ns->u_prev[y - 1][x] + ns->u_prev[y + 1][x])
-                        / 4;
+static void ns_project_relax(ns_t *ns) {
+    uint64_t y;
+    uint64_t k = 0;
+    const uint64_t pitch = ns->world_pitch;
+    const uint64_t check_every = ns->config.check_every;
+    const double threshold = check_every > 0 ? ns->config.tolerance * ns_field_norm(ns, ns->v_prev) : 0.0;
+
+    while (k < ns->config.max_iterations) {
+        switch (ns->config.relaxation) {
+            case NS_RELAXATION_RED_BLACK: {
+                for (uint64_t color = 0; color < 2; ++color)
+                    ns_relax_color(ns, NS_RELAX_KERNEL_PROJECT, NS_BOUNDARY_FIELD_SCALAR, ns->u_prev, ns->v_prev,
+                                   0, color);
+                break;
+            }
+            case NS_RELAXATION_LEXICOGRAPHIC:
+            default: {
+                for (y = 1; y <= ns->tile.height; ++y) {
+                    ns_project_row(&ns->u_prev[NS_IDX(ns, 0, y)], &ns->v_prev[NS_IDX(ns, 0, y)], pitch,
+                                   1, ns->tile.width, 1);
+                    ns_boundary_set_row(&ns->boundaries, NS_BOUNDARY_FIELD_SCALAR, &ns->tile,
+                                        &ns->u_prev[NS_IDX(ns, 0, y)]);
+                }
+                break;
             }
         }
 
-        ns_set_bounds(ns, 0, ns->u_prev);
+        ns_set_bounds_after_sweep(ns, NS_BOUNDARY_FIELD_SCALAR, ns->u_prev);
+        k += 1;
+
+        if (check_every > 0 && k % check_every == 0 && ns_project_residual(ns) <= threshold)
+            break;
     }
 
-#pragma omp parallel for collapse(2) \
-    schedule(DEFAULT_OPEN_MP_SCHEDULE) \
-    default(none) private(y, x) shared(ns, h)
-    for (y = 1; y <= ns->world_height; ++y) {
-        for (x = 1; x <= ns->world_width; ++x) {
-            ns->u[y][x] -= 0.5 * (ns->u_prev[y][x + 1] - ns->u_prev[y][x - 1]) / h;
-            ns->v[y][x] -= 0.5 * (ns->u_prev[y + 1][x] - ns->u_prev[y - 1][x]) / h;
+    ns->stats.pressure_iterations += k;
+}
+
+static double ns_project_residual(const ns_t *ns) {
+    uint64_t y;
+    const uint64_t pitch = ns->world_pitch;
+    double norm = 0.0;
+
+#pragma omp parallel for \
+    schedule(static) \
+    default(none) private(y) shared(ns, pitch) reduction(+:norm)
+    for (y = 1; y <= ns->tile.height; ++y) {
+        const ns_real_t *const p = &ns->u_prev[NS_IDX(ns, 0, y)];
+        const ns_real_t *const div = &ns->v_prev[NS_IDX(ns, 0, y)];
+
+        for (uint64_t x = 1; x <= ns->tile.width; ++x) {
+            const ns_real_t r = div[x] - (4 * p[x] - (p[x - 1] + p[x + 1] + p[x - pitch] + p[x + pitch]));
+            norm += (double) r * (double) r;
         }
     }
 
-    ns_set_bounds(ns, 1, ns->u);
-    ns_set_bounds(ns, 2, ns->v);
+    return sqrt(ns_sum(ns, norm));
+}
+
+static double ns_field_norm(const ns_t *ns, const ns_real_t *field) {
+    uint64_t y;
+    double norm = 0.0;
+
+#pragma omp parallel for \
+    schedule(static) \
+    default(none) private(y) shared(ns, field) reduction(+:norm)
+    for (y = 1; y <= ns->tile.height; ++y) {
+        const ns_real_t *const row = &field[NS_IDX(ns, 0, y)];
+
+        for (uint64_t x = 1; x <= ns->tile.width; ++x) {
+            norm += (double) row[x] * (double) row[x];
+        }
+    }
+
+    return sqrt(ns_sum(ns, norm));
+}
+
+static double ns_sum(const ns_t *ns, double value) {
+    return ns->halo != NULL ? ns_halo_sum(ns->halo, value) : value;
+}
+
+static void ns_exchange(const ns_t *ns, ns_real_t *field) {
+    if (ns->halo == NULL) return;
+
+    ns_halo_exchange_start(ns->halo, field, ns->world_pitch);
+    ns_halo_exchange_finish(ns->halo, field, ns->world_pitch);
 }
 
-static void ns_advect(const ns_t *ns, uint64_t bounds, double **d, double **d0, double **u, double **v) {
-    uint64_t x, y, x0, x1, y0, y1;
-    double xx, yy, s0, s1, t0, t1;
-    double dt0_width = ns->time_step * (double) ns->world_width;
-    double dt0_height = ns->time_step * (double) ns->world_height;
+static void
+ns_advect(const ns_t *ns, ns_boundary_field_t field, ns_real_t *d, const ns_real_t *d0, const ns_real_t *u,
+          const ns_real_t *v) {
+    uint64_t x, y;
+    ns_real_t xx, yy;
+    ns_real_t dt0_width = (ns_real_t) (ns->time_step * (double) ns->world_width);
+    ns_real_t dt0_height = (ns_real_t) (ns->time_step * (double) ns->world_height);
+    // Cells of d0 are read from a window, whose origin is the global cell (window_x, window_y)
+    ns_kernels_advect_t advect = {
+            .dt0_width = dt0_width,
+            .dt0_height = dt0_height,
+            .world_width = ns->world_width,
+            .world_height = ns->world_height,
+            .window = d0,
+            .window_x = 0,
+            .window_y = 0,
+            .window_pitch = ns->world_pitch,
+            .window_size = ns->world_pitch * (ns->tile.height + 2)
+    };
+
+    if (ns->halo != NULL) {
+        // Departure cells may lie in other tiles, gather their bounding box
+        uint64_t x_min = UINT64_MAX, x_max = 0, y_min = UINT64_MAX, y_max = 0;
+        uint64_t box[4];
 
 #pragma omp parallel for collapse(2) \
     schedule(DEFAULT_OPEN_MP_SCHEDULE) \
-    default(none) private(y, x, yy, xx, x0, x1, y0, y1, s0, s1, t0, t1) shared(ns, dt0_width, dt0_height, u, v, d, d0)
-    for (y = 1; y <= ns->world_height; ++y) {
-        for (x = 1; x <= ns->world_width; ++x) {
-            xx = (double) x - dt0_width * u[y][x];
-            yy = (double) y - dt0_height * v[y][x];
-
-            // Check xx
-            if (xx < 0.5)
-                xx = 0.5;
-            if (xx > (double) ns->world_width + 0.5)
-                xx = (double) ns->world_width + 0.5;
-            x0 = (uint64_t) xx;
-            x1 = x0 + 1;
-
-            // Check yy
-            if (yy < 0.5)
-                yy = 0.5;
-            if (yy > (double) ns->world_height + 0.5)
-                yy = (double) ns->world_height + 0.5;
-            y0 = (uint64_t) yy;
-            y1 = y0 + 1;
-
-
-            s1 = xx - (double) x0;
-            s0 = 1 - s1;
-            t1 = yy - (double) y0;
-            t0 = 1 - t1;
-
-            d[y][x] = s0 * (t0 * d0[y0][x0] + t1 * d0[y1][x0])
-                      + s1 * (t0 * d0[y0][x1] + t1 * d0[y1][x1]);
+    default(none) private(y, x, yy, xx) shared(ns, dt0_width, dt0_height, u, v) \
+    reduction(min:x_min, y_min) reduction(max:x_max, y_max)
+        for (y = 1; y <= ns->tile.height; ++y) {
+            for (x = 1; x <= ns->tile.width; ++x) {
+                ns_advect_departure(ns, x, y, dt0_width, dt0_height, u, v, &xx, &yy);
+
+                if ((uint64_t) xx < x_min) x_min = (uint64_t) xx;
+                if ((uint64_t) xx > x_max) x_max = (uint64_t) xx;
+                if ((uint64_t) yy < y_min) y_min = (uint64_t) yy;
+                if ((uint64_t) yy > y_max) y_max = (uint64_t) yy;
+            }
+        }
+
+        box[0] = x_min;
+        box[1] = x_max + 1;
+        box[2] = y_min;
+        box[3] = y_max + 1;
+
+        advect.window = ns_halo_gather_window(ns->halo, d0, ns->world_pitch, box);
+        if (advect.window == NULL) {
+            fprintf(stderr, "Unable to gather advection window\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
         }
+        advect.window_x = box[0];
+        advect.window_y = box[2];
+        advect.window_pitch = box[1] - box[0] + 1;
+        advect.window_size = advect.window_pitch * (box[3] - box[2] + 1);
+    }
+
+#pragma omp parallel for \
+    schedule(DEFAULT_OPEN_MP_SCHEDULE) \
+    default(none) private(y) shared(ns, u, v, d, advect)
+    for (y = 1; y <= ns->tile.height; ++y) {
+        ns->kernels->advect_row(&d[NS_IDX(ns, 0, y)], &u[NS_IDX(ns, 0, y)], &v[NS_IDX(ns, 0, y)], &advect,
+                                ns->tile.x, y + ns->tile.y, ns->tile.width);
+    }
+
+    ns_set_bounds(ns, field, d);
+}
+
+static inline void
+ns_advect_departure(const ns_t *ns, uint64_t x, uint64_t y, ns_real_t dt0_width, ns_real_t dt0_height,
+                    const ns_real_t *u, const ns_real_t *v, ns_real_t *xx, ns_real_t *yy) {
+    // Trace back from the global position of tile cell (x, y)
+    *xx = (ns_real_t) (x + ns->tile.x) - dt0_width * u[NS_IDX(ns, x, y)];
+    *yy = (ns_real_t) (y + ns->tile.y) - dt0_height * v[NS_IDX(ns, x, y)];
+
+    // Check xx
+    if (*xx < NS_REAL(0.5))
+        *xx = NS_REAL(0.5);
+    if (*xx > (ns_real_t) ns->world_width + NS_REAL(0.5))
+        *xx = (ns_real_t) ns->world_width + NS_REAL(0.5);
+
+    // Check yy
+    if (*yy < NS_REAL(0.5))
+        *yy = NS_REAL(0.5);
+    if (*yy > (ns_real_t) ns->world_height + NS_REAL(0.5))
+        *yy = (ns_real_t) ns->world_height + NS_REAL(0.5);
+}
+
+static void ns_set_bounds(const ns_t *ns, ns_boundary_field_t field, ns_real_t *target) {
+    // Only the tile sides on the global boundary, the others are exchanged with the neighbour tiles
+    ns_boundary_set(&ns->boundaries, field, &ns->tile, target, ns->world_pitch);
+}
+
+static void ns_set_bounds_after_sweep(const ns_t *ns, ns_boundary_field_t field, ns_real_t *target) {
+    // Not decomposed, the sweep already set the left and right ghost cells of each row once final
+    if (ns->halo == NULL)
+        ns_boundary_set_rows(&ns->boundaries, field, &ns->tile, target, ns->world_pitch);
+    else
+        ns_set_bounds(ns, field, target);
+}
+
+static void ns_relax_color(const ns_t *ns, ns_relax_kernel_t kernel, ns_boundary_field_t field, ns_real_t *target,
+                           const ns_real_t *source, ns_real_t a, uint64_t color) {
+    const uint64_t w = ns->tile.width;
+    const uint64_t h = ns->tile.height;
+
+    if (ns->halo == NULL) {
+        // Rows are final after the last color, set their left and right ghost cells in the same pass
+        ns_relax_rows(ns, kernel, target, source, a, color, 1, h, 1, w, color == 1 ? &field : NULL);
+        return;
     }
 
-    ns_set_bounds(ns, bounds, d);
+    // Tile border first, then send it to the neighbour tiles while relaxing the interior
+    ns_relax_rows(ns, kernel, target, source, a, color, 1, 1, 1, w, NULL);
+    if (h > 1) ns_relax_rows(ns, kernel, target, source, a, color, h, h, 1, w, NULL);
+    ns_relax_rows(ns, kernel, target, source, a, color, 2, h - 1, 1, 1, NULL);
+    if (w > 1) ns_relax_rows(ns, kernel, target, source, a, color, 2, h - 1, w, w, NULL);
+
+    ns_halo_exchange_start(ns->halo, target, ns->world_pitch);
+    ns_relax_rows(ns, kernel, target, source, a, color, 2, h - 1, 2, w - 1, NULL);
+    ns_halo_exchange_finish(ns->halo, target, ns->world_pitch);
 }
 
-static void ns_set_bounds(const ns_t *ns, uint64_t bounds, double **target) {
+static void ns_relax_rows(const ns_t *ns, ns_relax_kernel_t kernel, ns_real_t *target, const ns_real_t *source,
+                          ns_real_t a, uint64_t color, uint64_t y_first, uint64_t y_last, uint64_t x_first,
+                          uint64_t x_last, const ns_boundary_field_t *field) {
     uint64_t y;
-    uint64_t x;
+    const uint64_t pitch = ns->world_pitch;
+    // Colors follow the global coordinates so that they match across tiles
+    const uint64_t parity = ns->tile.x + ns->tile.y;
 
-#pragma omp parallel for collapse(2) \
-    schedule(DEFAULT_OPEN_MP_SCHEDULE) \
-    default(none) private(y, x) shared(ns, target, bounds)
-    for (y = 1; y <= ns->world_height; ++y) {
-        for (x = 1; x <= ns->world_width; ++x) {
-            target[y][0] = (bounds == 1) ? -target[y][1] : target[y][1];
-            target[y][ns->world_width + 1] = bounds == 1 ? -target[y][ns->world_width] : target[y][ns->world_width];
-            target[0][x] = bounds == 2 ? -target[1][x] : target[1][x];
-            target[ns->world_height + 1][x] = bounds == 2 ? -target[ns->world_height][x] : target[ns->world_height][x];
+#pragma omp parallel for \
+    schedule(static) \
+    default(none) private(y) \
+    shared(ns, kernel, target, source, a, color, y_first, y_last, x_first, x_last, pitch, parity, field)
+    for (y = y_first; y <= y_last; ++y) {
+        const uint64_t x = ns_red_black_first_x(x_first, y + parity, color);
+
+        switch (kernel) {
+            case NS_RELAX_KERNEL_PROJECT: {
+                ns->kernels->project_red_black_row(&target[NS_IDX(ns, 0, y)], &source[NS_IDX(ns, 0, y)], pitch, x,
+                                                   x_last);
+                break;
+            }
+            case NS_RELAX_KERNEL_DIFFUSE:
+            default: {
+                ns->kernels->diffuse_red_black_row(&target[NS_IDX(ns, 0, y)], &source[NS_IDX(ns, 0, y)], pitch, a,
+                                                   x, x_last);
+                break;
+            }
         }
+
+        // Boundary fused into the sweep (the whole row must be final)
+        if (field != NULL)
+            ns_boundary_set_row(&ns->boundaries, *field, &ns->tile, &target[NS_IDX(ns, 0, y)]);
     }
+}
+
+static inline uint64_t ns_red_black_first_x(uint64_t x, uint64_t y, uint64_t color) {
+    // Cell (x, y) has color (x + y) % 2
+    return x + ((x + y + color) & 1);
+}
+
+static inline void
+ns_diffuse_row(ns_real_t *row, const ns_real_t *source_row, uint64_t pitch, ns_real_t a, uint64_t x_first,
+               uint64_t x_last, uint64_t x_step) {
+    for (uint64_t x = x_first; x <= x_last; x += x_step) {
+        row[x] = (source_row[x] + a * (row[x - 1] + row[x + 1] + row[x - pitch] + row[x + pitch]))
+                 / (1 + 4 * a);
+    }
+}
 
-    target[0][0] = 0.5 * (target[0][1] + target[1][0]);
-    target[ns->world_height + 1][0] = 0.5 * (target[ns->world_height + 1][1] + target[ns->world_height][0]);
-    target[0][ns->world_width + 1] = 0.5 * (target[0][ns->world_width] + target[1][ns->world_width + 1]);
-    target[ns->world_height + 1][ns->world_width + 1] =
-            0.5 * (target[ns->world_height + 1][ns->world_width] + target[ns->world_height][ns->world_width + 1]);
+static inline void
+ns_project_row(ns_real_t *p, const ns_real_t *div, uint64_t pitch, uint64_t x_first, uint64_t x_last, uint64_t x_step) {
+    for (uint64_t x = x_first; x <= x_last; x += x_step) {
+        p[x] = (div[x] + p[x - 1] + p[x + 1] + p[x - pitch] + p[x + pitch]) / 4;
+    }
 }
 
-static void ns_swap_matrix(double ***x, double ***y) {
-    double **tmp = *x;
+static void ns_swap_matrix(ns_real_t **x, ns_real_t **y) {
+    ns_real_t *tmp = *x;
     *x = *y;
     *y = tmp;
 }
 
+static ns_real_t *ns_field_alloc(const ns_t *ns) {
+    void *field = NULL;
+    const size_t size = ns->world_pitch * (ns->tile.height + 2) * sizeof(ns_real_t);
+    const size_t alignment = size >= NS_FIELD_HUGE_PAGE_ALIGNMENT ? NS_FIELD_HUGE_PAGE_ALIGNMENT : NS_FIELD_ALIGNMENT;
+
+    if (posix_memalign(&field, alignment, size) != 0) return NULL;
+#ifdef MADV_HUGEPAGE
+    // Hint only, failure is not an error
+    if (alignment == NS_FIELD_HUGE_PAGE_ALIGNMENT) madvise(field, size, MADV_HUGEPAGE);
+#endif
+
+    return (ns_real_t *) field;
+}
+
+static void ns_field_free(ns_real_t *field) {
+    free(field);
+}
+
 static bool is_valid_coordinate(const ns_t *ns, uint64_t x, uint64_t y) {
     return x >= 0 && x < ns->world_width_bounds
            && y >= 0 && y < ns->world_height_bounds;
 }
 
+static bool is_tile_coordinate(const ns_t *ns, uint64_t x, uint64_t y) {
+    // Tiles on the global boundary also store the ghost cells there
+    return (ns->tile.left || x > ns->tile.x)
+           && (ns->tile.right || x <= ns->tile.x + ns->tile.width)
+           && (ns->tile.top || y > ns->tile.y)
+           && (ns->tile.bottom || y <= ns->tile.y + ns->tile.height);
+}
+
 /**
 * END Private
 */
@@ -0,0 +1,248 @@
+#include "ns/utils/cache.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <cJSON.h>
+#include <mpi.h>
+#include "ns/utils/pack.h"
+#include "ns/utils/file.h"
+#include "ns/utils/checkpoint.h"
+
+// Longest file name of the cache folder
+#define CACHE_FILE_MAX_NAME_LENGTH 64
+// Suffix of a cache file being written, renamed once complete
+#define CACHE_TEMPORARY_SUFFIX ".tmp"
+// FNV-1a 64 bits offset basis and prime
+#define CACHE_HASH_OFFSET 0xcbf29ce484222325ULL
+#define CACHE_HASH_PRIME 0x100000001b3ULL
+
+/**
+ * Private definitions
+ */
+static uint64_t hash_key(const uint8_t *key, uint64_t key_length);
+
+static bool fetch_renumbered(const char *cached_path, snapshot_format_t format, uint64_t simulation_id,
+                             const char *result_path, char *error);
+
+static bool renumber_metadata(const char *metadata, uint64_t simulation_id, bool formatted, char **renumbered);
+/**
+ * END Private definitions
+ */
+
+/**
+ * Public
+ */
+uint8_t *cache_key(const ns_simulation_t *const simulation, bool prefix, snapshot_format_t format,
+                   snapshot_compression_t compression, double tolerance, uint64_t *length) {
+    ns_simulation_t setup = *simulation;
+    uint8_t *packed;
+    uint64_t packed_length;
+    uint8_t *key;
+    // Precision of the fields, then format, compression and tolerance of the result key
+    const uint64_t options[3] = {sizeof(ns_real_t), (uint64_t) format, (uint64_t) compression};
+    const double result_tolerance = compression == SNAPSHOT_COMPRESSION_LOSSY ? tolerance : 0;
+    const size_t options_length = prefix ? sizeof(uint64_t) : sizeof(options) + sizeof(double);
+
+    // The setup of a prefix runs any number of ticks
+    if (prefix) setup.ticks = 0;
+    packed = ns_pack_simulation(&setup, &packed_length);
+    if (packed == NULL) return NULL;
+
+    key = (uint8_t *) malloc(packed_length + options_length);
+    if (key == NULL) {
+        free(packed);
+        return NULL;
+    }
+    memcpy(key, packed, packed_length);
+    memcpy(key + packed_length, options, prefix ? sizeof(uint64_t) : sizeof(options));
+    if (!prefix) memcpy(key + packed_length + sizeof(options), &result_tolerance, sizeof(double));
+    *length = packed_length + options_length;
+
+    free(packed);
+    return key;
+}
+
+char *cache_file_path(const char *const directory, cache_file_t file, const uint8_t *const key, uint64_t key_length,
+                      uint64_t rank, snapshot_format_t format) {
+    const size_t length = strlen(directory) + 1 + CACHE_FILE_MAX_NAME_LENGTH + 1;
+    const uint64_t hash = hash_key(key, key_length);
+    char *path = (char *) calloc(length, sizeof(char));
+    if (path == NULL) return NULL;
+
+    switch (file) {
+        case CACHE_FILE_RESULT:
+            snprintf(path, length, "%s/%016lx.%s", directory, hash, snapshot_format_extension(format));
+            break;
+        case CACHE_FILE_MARKER:
+            snprintf(path, length, "%s/%016lx.done", directory, hash);
+            break;
+        case CACHE_FILE_STATE:
+            snprintf(path, length, "%s/%016lx_%ld.nsck", directory, hash, rank);
+            break;
+        case CACHE_FILE_JOURNAL:
+            snprintf(path, length, "%s/%016lx.nsj", directory, hash);
+            break;
+    }
+
+    return path;
+}
+
+bool cache_fetch(const char *const directory, const uint8_t *const key, uint64_t key_length, snapshot_format_t format,
+                 uint64_t simulation_id, const char *const result_path, char *error) {
+    char *marker_path;
+    char *cached_path;
+    checkpoint_t *marker = NULL;
+    bool fetched = false;
+
+    marker_path = cache_file_path(directory, CACHE_FILE_MARKER, key, key_length, 0, format);
+    cached_path = cache_file_path(directory, CACHE_FILE_RESULT, key, key_length, 0, format);
+    if (marker_path == NULL || cached_path == NULL) {
+        strcpy(error, "Unable to allocate cache locations");
+        free(marker_path);
+        free(cached_path);
+        return false;
+    }
+
+    // Same hash is not enough, the marker holds the whole key
+    marker = checkpoint_read(marker_path, error);
+    if (marker != NULL && !checkpoint_matches(marker, key, key_length)) {
+        strcpy(error, "Cache entry of a different simulation");
+    } else if (marker != NULL) {
+        // The result is replaced, never written in place, a linked one keeps the cache intact
+        MPI_File_delete(result_path, MPI_INFO_NULL);
+        if (marker->simulation_id == simulation_id && link(cached_path, result_path) == 0) fetched = true;
+        else fetched = fetch_renumbered(cached_path, format, simulation_id, result_path, error);
+    }
+
+    checkpoint_free(marker);
+    free(marker_path);
+    free(cached_path);
+    return fetched;
+}
+
+bool cache_store(const char *const directory, const uint8_t *const key, uint64_t key_length, snapshot_format_t format,
+                 uint64_t simulation_id, const char *const result_path, char *error) {
+    const checkpoint_t marker = {.simulation_id = simulation_id, .parameters = (uint8_t *) key,
+            .parameters_length = key_length};
+    char *marker_path;
+    char *cached_path;
+    char *temporary_path = NULL;
+    bool stored = false;
+
+    marker_path = cache_file_path(directory, CACHE_FILE_MARKER, key, key_length, 0, format);
+    cached_path = cache_file_path(directory, CACHE_FILE_RESULT, key, key_length, 0, format);
+    if (cached_path != NULL)
+        temporary_path = (char *) calloc(strlen(cached_path) + strlen(CACHE_TEMPORARY_SUFFIX) + 1, sizeof(char));
+    if (marker_path == NULL || temporary_path == NULL) {
+        strcpy(error, "Unable to allocate cache locations");
+        free(marker_path);
+        free(cached_path);
+        free(temporary_path);
+        return false;
+    }
+    sprintf(temporary_path, "%s%s", cached_path, CACHE_TEMPORARY_SUFFIX);
+
+    // The result is linked under a temporary name and renamed, a reader finds the previous entry or the new one
+    unlink(temporary_path);
+    if (link(result_path, temporary_path) != 0 || rename(temporary_path, cached_path) != 0) {
+        snprintf(error, MPI_MAX_ERROR_STRING, "Unable to link result %s to the cache", result_path);
+        unlink(temporary_path);
+    } else {
+        stored = checkpoint_write(marker_path, &marker, error);
+    }
+
+    free(marker_path);
+    free(cached_path);
+    free(temporary_path);
+    return stored;
+}
+/**
+ * END Public
+ */
+
+/**
+ * Private
+ */
+static uint64_t hash_key(const uint8_t *const key, uint64_t key_length) {
+    uint64_t hash = CACHE_HASH_OFFSET;
+
+    for (uint64_t i = 0; i < key_length; ++i) {
+        hash ^= key[i];
+        hash *= CACHE_HASH_PRIME;
+    }
+
+    return hash;
+}
+
+static bool fetch_renumbered(const char *const cached_path, snapshot_format_t format, uint64_t simulation_id,
+                             const char *const result_path, char *error) {
+    if (format == SNAPSHOT_FORMAT_JSON) {
+        char *content;
+        char *renumbered;
+        bool written;
+
+        // The id is a member of the result object
+        content = read_file(cached_path, error);
+        if (content == NULL) return false;
+        if (!renumber_metadata(content, simulation_id, true, &renumbered)) {
+            strcpy(error, "Invalid cached JSON result");
+            free(content);
+            return false;
+        }
+        written = write_file(result_path, renumbered, error);
+
+        free(content);
+        free(renumbered);
+        return written;
+    } else {
+        snapshot_reader_t *reader;
+        snapshot_writer_t *writer;
+        char *metadata;
+        ns_world_t world;
+        ns_tick_stats_t stats;
+        bool written = true;
+        char close_error[MPI_MAX_ERROR_STRING + 1];
+
+        // The id is in the metadata header, the snapshots are written again with the same layout
+        reader = snapshot_reader_open(cached_path, error);
+        if (reader == NULL) return false;
+        if (!renumber_metadata(snapshot_reader_metadata(reader), simulation_id, false, &metadata)) {
+            strcpy(error, "Invalid cached binary result metadata");
+            snapshot_reader_close(reader);
+            return false;
+        }
+        writer = snapshot_writer_open(result_path, metadata, snapshot_reader_layout(reader), error);
+        free(metadata);
+        if (writer == NULL) {
+            snapshot_reader_close(reader);
+            return false;
+        }
+        while (written && !snapshot_reader_end(reader))
+            written = snapshot_reader_read(reader, &world, &stats, error)
+                      && snapshot_writer_write(writer, &world, stats, error);
+        if (!snapshot_writer_close(writer, written ? error : close_error)) written = false;
+
+        snapshot_reader_close(reader);
+        return written;
+    }
+}
+
+static bool renumber_metadata(const char *const metadata, uint64_t simulation_id, bool formatted, char **renumbered) {
+    cJSON *json = cJSON_Parse(metadata);
+    cJSON *id_json = cJSON_GetObjectItemCaseSensitive(json, "id");
+
+    if (!cJSON_IsNumber(id_json)) {
+        cJSON_Delete(json);
+        return false;
+    }
+    cJSON_SetNumberValue(id_json, (double) simulation_id);
+
+    // Printed as the worker prints it, formatted for the JSON result
+    *renumbered = formatted ? cJSON_Print(json) : cJSON_PrintUnformatted(json);
+    cJSON_Delete(json);
+    return *renumbered != NULL;
+}
+/**
+ * END Private
+ */
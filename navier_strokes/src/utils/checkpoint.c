@@ -0,0 +1,353 @@
+#include "ns/utils/checkpoint.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <dirent.h>
+#include <mpi.h>
+
+// Number of uint64_t fields of the header, after the magic
+#define CHECKPOINT_HEADER_FIELDS 10
+// Longest file name of the checkpoints folder
+#define CHECKPOINT_FILE_MAX_NAME_LENGTH 128
+// Suffix of a checkpoint being written, renamed once complete
+#define CHECKPOINT_TEMPORARY_SUFFIX ".tmp"
+
+/**
+ * Private definitions
+ */
+static bool write_values(MPI_File fh, const void *values, uint64_t count, MPI_Datatype datatype, size_t value_size,
+                         char *error);
+
+static bool read_values(MPI_File fh, void *values, uint64_t count, MPI_Datatype datatype, size_t value_size,
+                        char *error);
+
+static bool parse_file_name(const char *name, uint64_t simulation_id, checkpoint_run_t *run, uint64_t *rank,
+                            bool *state);
+/**
+ * END Private definitions
+ */
+
+/**
+ * Public
+ */
+char *checkpoint_file_path(const char *const directory, checkpoint_file_t file, uint64_t simulation_id,
+                           const checkpoint_run_t *const run, uint64_t rank) {
+    const size_t length = strlen(directory) + 1 + CHECKPOINT_FILE_MAX_NAME_LENGTH + 1;
+    char *path = (char *) calloc(length, sizeof(char));
+    if (path == NULL) return NULL;
+
+    switch (file) {
+        case CHECKPOINT_FILE_STATE:
+            snprintf(path, length, "%s/simulation_%ld_%ld_%ld_%ld.nsck", directory, simulation_id, run->job,
+                     run->attempt, rank);
+            break;
+        case CHECKPOINT_FILE_JOURNAL:
+            snprintf(path, length, "%s/simulation_%ld_%ld_%ld.nsj", directory, simulation_id, run->job,
+                     run->attempt);
+            break;
+        case CHECKPOINT_FILE_DONE:
+            snprintf(path, length, "%s/simulation_%ld.done", directory, simulation_id);
+            break;
+    }
+
+    return path;
+}
+
+bool checkpoint_write(const char *const file_path, const checkpoint_t *const checkpoint, char *error) {
+    const size_t temporary_path_length = strlen(file_path) + strlen(CHECKPOINT_TEMPORARY_SUFFIX) + 1;
+    char *temporary_path;
+    MPI_File fh;
+    bool written;
+    int error_code;
+    int error_length;
+
+    temporary_path = (char *) calloc(temporary_path_length, sizeof(char));
+    if (temporary_path == NULL) {
+        strcpy(error, "Unable to allocate checkpoint location");
+        return false;
+    }
+    snprintf(temporary_path, temporary_path_length, "%s%s", file_path, CHECKPOINT_TEMPORARY_SUFFIX);
+
+    error_code = MPI_File_open(MPI_COMM_SELF, temporary_path, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh);
+    if (error_code == MPI_SUCCESS) error_code = MPI_File_set_size(fh, 0);
+    if (error_code != MPI_SUCCESS) {
+        MPI_Error_string(error_code, error, &error_length);
+        free(temporary_path);
+        return false;
+    }
+
+    // Header: magic, version, value size, simulation id, ranks, rank, tick, iterations, parameters length and
+    // state length, then the parameters and the state
+    const uint64_t header[CHECKPOINT_HEADER_FIELDS] = {CHECKPOINT_VERSION, sizeof(ns_real_t),
+                                                       checkpoint->simulation_id, checkpoint->ranks, checkpoint->rank,
+                                                       checkpoint->tick, checkpoint->stats.diffuse_iterations,
+                                                       checkpoint->stats.pressure_iterations,
+                                                       checkpoint->parameters_length, checkpoint->state_length};
+    written = write_values(fh, CHECKPOINT_MAGIC, CHECKPOINT_MAGIC_LENGTH, MPI_CHAR, sizeof(char), error)
+              && write_values(fh, header, CHECKPOINT_HEADER_FIELDS, MPI_UINT64_T, sizeof(uint64_t), error)
+              && write_values(fh, checkpoint->parameters, checkpoint->parameters_length, MPI_BYTE, sizeof(uint8_t),
+                              error)
+              && write_values(fh, checkpoint->state, checkpoint->state_length, NS_REAL_MPI, sizeof(ns_real_t), error);
+
+    // The previous checkpoint is replaced only by a complete one
+    if (written) {
+        error_code = MPI_File_sync(fh);
+        if (error_code != MPI_SUCCESS) {
+            MPI_Error_string(error_code, error, &error_length);
+            written = false;
+        }
+    }
+    MPI_File_close(&fh);
+    if (written && rename(temporary_path, file_path) != 0) {
+        snprintf(error, MPI_MAX_ERROR_STRING, "Unable to rename checkpoint %s", temporary_path);
+        written = false;
+    }
+    if (!written) MPI_File_delete(temporary_path, MPI_INFO_NULL);
+
+    free(temporary_path);
+    return written;
+}
+
+checkpoint_t *checkpoint_read(const char *const file_path, char *error) {
+    checkpoint_t *checkpoint;
+    char magic[CHECKPOINT_MAGIC_LENGTH];
+    uint64_t header[CHECKPOINT_HEADER_FIELDS];
+    MPI_File fh;
+    MPI_Offset size;
+    int error_code;
+    int error_length;
+
+    error_code = MPI_File_open(MPI_COMM_SELF, file_path, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh);
+    if (error_code != MPI_SUCCESS) {
+        MPI_Error_string(error_code, error, &error_length);
+        return NULL;
+    }
+
+    // Header
+    if (!read_values(fh, magic, CHECKPOINT_MAGIC_LENGTH, MPI_CHAR, sizeof(char), error)
+        || !read_values(fh, header, CHECKPOINT_HEADER_FIELDS, MPI_UINT64_T, sizeof(uint64_t), error)) {
+        MPI_File_close(&fh);
+        return NULL;
+    }
+    if (memcmp(magic, CHECKPOINT_MAGIC, CHECKPOINT_MAGIC_LENGTH) != 0 || header[0] != CHECKPOINT_VERSION) {
+        strcpy(error, "Not a checkpoint of the current version");
+        MPI_File_close(&fh);
+        return NULL;
+    }
+    if (header[1] != sizeof(ns_real_t)) {
+        strcpy(error, "Checkpoint saved with a different field precision");
+        MPI_File_close(&fh);
+        return NULL;
+    }
+    MPI_File_get_size(fh, &size);
+    if (CHECKPOINT_MAGIC_LENGTH + CHECKPOINT_HEADER_FIELDS * sizeof(uint64_t) + header[8]
+        + header[9] * sizeof(ns_real_t) != (uint64_t) size) {
+        strcpy(error, "Invalid checkpoint size");
+        MPI_File_close(&fh);
+        return NULL;
+    }
+
+    checkpoint = (checkpoint_t *) calloc(1, sizeof(checkpoint_t));
+    if (checkpoint == NULL) {
+        strcpy(error, "Unable to allocate checkpoint");
+        MPI_File_close(&fh);
+        return NULL;
+    }
+    checkpoint->simulation_id = header[2];
+    checkpoint->ranks = header[3];
+    checkpoint->rank = header[4];
+    checkpoint->tick = header[5];
+    checkpoint->stats.diffuse_iterations = header[6];
+    checkpoint->stats.pressure_iterations = header[7];
+    checkpoint->parameters_length = header[8];
+    checkpoint->state_length = header[9];
+
+    // Parameters and state
+    checkpoint->parameters = (uint8_t *) malloc(checkpoint->parameters_length > 0 ? checkpoint->parameters_length : 1);
+    if (checkpoint->state_length > 0)
+        checkpoint->state = (ns_real_t *) malloc(checkpoint->state_length * sizeof(ns_real_t));
+    if (checkpoint->parameters == NULL || (checkpoint->state_length > 0 && checkpoint->state == NULL)) {
+        strcpy(error, "Unable to allocate checkpoint buffers");
+        checkpoint_free(checkpoint);
+        MPI_File_close(&fh);
+        return NULL;
+    }
+    if (!read_values(fh, checkpoint->parameters, checkpoint->parameters_length, MPI_BYTE, sizeof(uint8_t), error)
+        || !read_values(fh, checkpoint->state, checkpoint->state_length, NS_REAL_MPI, sizeof(ns_real_t), error)) {
+        checkpoint_free(checkpoint);
+        MPI_File_close(&fh);
+        return NULL;
+    }
+
+    MPI_File_close(&fh);
+    return checkpoint;
+}
+
+bool checkpoint_matches(const checkpoint_t *const checkpoint, const uint8_t *const parameters,
+                        uint64_t parameters_length) {
+    return checkpoint->parameters_length == parameters_length
+           && memcmp(checkpoint->parameters, parameters, parameters_length) == 0;
+}
+
+checkpoint_t *checkpoint_latest(const char *const directory, uint64_t simulation_id, const uint8_t *const parameters,
+                                uint64_t parameters_length, uint64_t ranks, checkpoint_run_t *run) {
+    DIR *dir;
+    const struct dirent *entry;
+    checkpoint_t *latest = NULL;
+    char error[MPI_MAX_ERROR_STRING + 1];
+
+    dir = opendir(directory);
+    if (dir == NULL) return NULL;
+
+    // States of the first rank of every run, the other ranks restore the same run
+    while ((entry = readdir(dir)) != NULL) {
+        checkpoint_run_t entry_run;
+        uint64_t rank;
+        bool state;
+        char *path;
+        checkpoint_t *checkpoint;
+
+        if (!parse_file_name(entry->d_name, simulation_id, &entry_run, &rank, &state) || !state || rank != 0)
+            continue;
+
+        path = checkpoint_file_path(directory, CHECKPOINT_FILE_STATE, simulation_id, &entry_run, rank);
+        checkpoint = path != NULL ? checkpoint_read(path, error) : NULL;
+        free(path);
+        if (checkpoint == NULL) continue;
+
+        if (checkpoint->ranks == ranks && checkpoint->state != NULL
+            && checkpoint_matches(checkpoint, parameters, parameters_length)
+            && (latest == NULL || checkpoint->tick > latest->tick)) {
+            checkpoint_free(latest);
+            latest = checkpoint;
+            *run = entry_run;
+        } else {
+            checkpoint_free(checkpoint);
+        }
+    }
+
+    closedir(dir);
+    return latest;
+}
+
+void checkpoint_remove(const char *const directory, uint64_t simulation_id) {
+    DIR *dir;
+    const struct dirent *entry;
+    const size_t path_length = strlen(directory) + 1 + CHECKPOINT_FILE_MAX_NAME_LENGTH + 1;
+    char *path;
+
+    path = (char *) calloc(path_length, sizeof(char));
+    dir = opendir(directory);
+    if (path == NULL || dir == NULL) {
+        free(path);
+        if (dir != NULL) closedir(dir);
+        return;
+    }
+
+    while ((entry = readdir(dir)) != NULL) {
+        checkpoint_run_t run;
+        uint64_t rank;
+        bool state;
+
+        if (!parse_file_name(entry->d_name, simulation_id, &run, &rank, &state)) continue;
+        snprintf(path, path_length, "%s/%s", directory, entry->d_name);
+        MPI_File_delete(path, MPI_INFO_NULL);
+    }
+
+    closedir(dir);
+    free(path);
+}
+
+void checkpoint_free(checkpoint_t *checkpoint) {
+    if (checkpoint == NULL) return;
+
+    free(checkpoint->parameters);
+    free(checkpoint->state);
+    free(checkpoint);
+}
+/**
+ * END Public
+ */
+
+/**
+ * Private
+ */
+static bool write_values(MPI_File fh, const void *const values, uint64_t count, MPI_Datatype datatype,
+                         size_t value_size, char *error) {
+    int error_code;
+    int error_length;
+    const char *bytes = (const char *) values;
+
+    // MPI counts are int, write large buffers in chunks
+    while (count > 0) {
+        const int chunk = count > INT_MAX ? INT_MAX : (int) count;
+
+        error_code = MPI_File_write(fh, bytes, chunk, datatype, MPI_STATUS_IGNORE);
+        if (error_code != MPI_SUCCESS) {
+            MPI_Error_string(error_code, error, &error_length);
+            return false;
+        }
+
+        bytes += (size_t) chunk * value_size;
+        count -= (uint64_t) chunk;
+    }
+
+    return true;
+}
+
+static bool read_values(MPI_File fh, void *values, uint64_t count, MPI_Datatype datatype, size_t value_size,
+                        char *error) {
+    MPI_Status status;
+    int error_code;
+    int error_length;
+    int read;
+    char *bytes = (char *) values;
+
+    // MPI counts are int, read large buffers in chunks
+    while (count > 0) {
+        const int chunk = count > INT_MAX ? INT_MAX : (int) count;
+
+        error_code = MPI_File_read(fh, bytes, chunk, datatype, &status);
+        if (error_code != MPI_SUCCESS) {
+            MPI_Error_string(error_code, error, &error_length);
+            return false;
+        }
+        MPI_Get_count(&status, datatype, &read);
+        if (read != chunk) {
+            strcpy(error, "Unexpected end of checkpoint");
+            return false;
+        }
+
+        bytes += (size_t) chunk * value_size;
+        count -= (uint64_t) chunk;
+    }
+
+    return true;
+}
+
+static bool parse_file_name(const char *name, uint64_t simulation_id, checkpoint_run_t *run, uint64_t *rank,
+                            bool *state) {
+    uint64_t id;
+    int length = 0;
+
+    // States, journals and their temporary files, never the done marker
+    if (sscanf(name, "simulation_%lu_%lu_%lu%n", &id, &run->job, &run->attempt, &length) != 3 || id != simulation_id)
+        return false;
+    name += length;
+    *state = false;
+    if (sscanf(name, "_%lu%n", rank, &length) == 1) {
+        *state = true;
+        name += length;
+        if (strncmp(name, ".nsck", strlen(".nsck")) != 0) return false;
+        name += strlen(".nsck");
+    } else {
+        if (strncmp(name, ".nsj", strlen(".nsj")) != 0) return false;
+        name += strlen(".nsj");
+    }
+
+    return *name == '\0' || strcmp(name, CHECKPOINT_TEMPORARY_SUFFIX) == 0;
+}
+/**
+ * END Private
+ */
@@ -0,0 +1,185 @@
+#include "ns/utils/compress.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Bits of the match finder hash
+#define COMPRESS_HASH_BITS 16
+// Shortest back reference
+#define COMPRESS_MIN_MATCH 4
+// Farthest back reference
+#define COMPRESS_MAX_OFFSET 65535
+// Lengths stored in a token nibble, longer ones continue in extra bytes
+#define COMPRESS_NIBBLE_MAX 15
+
+/**
+ * Private definitions
+ */
+static uint32_t read_32(const uint8_t *bytes);
+
+static uint32_t hash_32(uint32_t value);
+
+static uint8_t *write_length(uint8_t *output, uint64_t length);
+
+static bool read_length(const uint8_t **input, const uint8_t *input_end, uint64_t *length);
+
+static uint8_t *write_sequence(uint8_t *output, const uint8_t *literals, uint64_t literals_length, uint64_t offset,
+                               uint64_t match_length);
+/**
+ * END Private definitions
+ */
+
+/**
+ * Public
+ */
+uint64_t compress_bound(uint64_t length) {
+    // Incompressible input costs a token and a length byte every 255 literals
+    return length + length / 255 + 16;
+}
+
+uint64_t compress_lz(const uint8_t *const input, uint64_t length, uint8_t *output) {
+    uint8_t *const output_start = output;
+    uint64_t anchor = 0;
+    uint64_t i = 0;
+    // Last position + 1 of every hash, 0 if none
+    uint64_t *table = (uint64_t *) calloc(1u << COMPRESS_HASH_BITS, sizeof(uint64_t));
+    if (table == NULL) return 0;
+
+    while (i + COMPRESS_MIN_MATCH <= length) {
+        const uint32_t sequence = read_32(&input[i]);
+        const uint32_t hash = hash_32(sequence);
+        const uint64_t candidate = table[hash];
+        table[hash] = i + 1;
+
+        if (candidate == 0 || i - (candidate - 1) > COMPRESS_MAX_OFFSET || read_32(&input[candidate - 1]) != sequence) {
+            i += 1;
+            continue;
+        }
+
+        // Extend the match as far as possible
+        const uint64_t match = candidate - 1;
+        uint64_t match_length = COMPRESS_MIN_MATCH;
+        while (i + match_length < length && input[match + match_length] == input[i + match_length]) match_length += 1;
+
+        output = write_sequence(output, &input[anchor], i - anchor, i - match, match_length);
+        i += match_length;
+        anchor = i;
+    }
+
+    // Trailing literals
+    output = write_sequence(output, &input[anchor], length - anchor, 0, 0);
+
+    free(table);
+    return (uint64_t) (output - output_start);
+}
+
+bool decompress_lz(const uint8_t *input, uint64_t length, uint8_t *output, uint64_t output_length) {
+    const uint8_t *const input_end = input + length;
+    uint64_t position = 0;
+
+    while (input < input_end) {
+        const uint8_t token = *input++;
+        uint64_t literals_length = token >> 4;
+        uint64_t match_length = token & COMPRESS_NIBBLE_MAX;
+        uint64_t offset;
+
+        // Literals
+        if (literals_length == COMPRESS_NIBBLE_MAX && !read_length(&input, input_end, &literals_length)) return false;
+        if (literals_length > (uint64_t) (input_end - input) || literals_length > output_length - position)
+            return false;
+        memcpy(&output[position], input, literals_length);
+        input += literals_length;
+        position += literals_length;
+
+        // The last sequence has no match
+        if (input == input_end) break;
+
+        // Match
+        if (input_end - input < 2) return false;
+        offset = (uint64_t) input[0] | (uint64_t) input[1] << 8;
+        input += 2;
+        if (match_length == COMPRESS_NIBBLE_MAX && !read_length(&input, input_end, &match_length)) return false;
+        match_length += COMPRESS_MIN_MATCH;
+        if (offset == 0 || offset > position || match_length > output_length - position) return false;
+
+        // Byte by byte, the match may overlap the bytes it produces
+        for (uint64_t i = 0; i < match_length; ++i) output[position + i] = output[position - offset + i];
+        position += match_length;
+    }
+
+    return position == output_length;
+}
+
+void compress_shuffle(const uint8_t *const input, uint64_t count, size_t size, uint8_t *output) {
+    for (size_t byte = 0; byte < size; ++byte) {
+        for (uint64_t i = 0; i < count; ++i) output[byte * count + i] = input[i * size + byte];
+    }
+}
+
+void compress_unshuffle(const uint8_t *const input, uint64_t count, size_t size, uint8_t *output) {
+    for (size_t byte = 0; byte < size; ++byte) {
+        for (uint64_t i = 0; i < count; ++i) output[i * size + byte] = input[byte * count + i];
+    }
+}
+/**
+ * END Public
+ */
+
+/**
+ * Private
+ */
+static uint32_t read_32(const uint8_t *const bytes) {
+    uint32_t value;
+
+    memcpy(&value, bytes, sizeof(uint32_t));
+    return value;
+}
+
+static uint32_t hash_32(uint32_t value) {
+    return (value * 2654435761u) >> (32 - COMPRESS_HASH_BITS);
+}
+
+static uint8_t *write_length(uint8_t *output, uint64_t length) {
+    while (length >= 255) {
+        *output++ = 255;
+        length -= 255;
+    }
+    *output++ = (uint8_t) length;
+
+    return output;
+}
+
+static bool read_length(const uint8_t **input, const uint8_t *const input_end, uint64_t *length) {
+    uint8_t byte;
+
+    do {
+        if (*input == input_end) return false;
+        byte = *(*input)++;
+        *length += byte;
+    } while (byte == 255);
+
+    return true;
+}
+
+static uint8_t *write_sequence(uint8_t *output, const uint8_t *const literals, uint64_t literals_length,
+                               uint64_t offset, uint64_t match_length) {
+    const uint64_t match_nibble = match_length > 0 ? match_length - COMPRESS_MIN_MATCH : 0;
+
+    // Token: literals length and match length nibbles
+    *output++ = (uint8_t) ((literals_length < COMPRESS_NIBBLE_MAX ? literals_length : COMPRESS_NIBBLE_MAX) << 4
+                           | (match_nibble < COMPRESS_NIBBLE_MAX ? match_nibble : COMPRESS_NIBBLE_MAX));
+    if (literals_length >= COMPRESS_NIBBLE_MAX) output = write_length(output, literals_length - COMPRESS_NIBBLE_MAX);
+    memcpy(output, literals, literals_length);
+    output += literals_length;
+
+    if (match_length == 0) return output;
+
+    // Offset, little endian, then the match length
+    *output++ = (uint8_t) (offset & 0xFF);
+    *output++ = (uint8_t) (offset >> 8);
+    if (match_nibble >= COMPRESS_NIBBLE_MAX) output = write_length(output, match_nibble - COMPRESS_NIBBLE_MAX);
+
+    return output;
+}
+/**
+ * END Private
+ */
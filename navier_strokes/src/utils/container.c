@@ -0,0 +1,419 @@
+#include "ns/utils/container.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+// Number of uint64_t fields of a table of contents entry, before the metadata
+#define CONTAINER_ENTRY_FIELDS 6
+// Number of uint64_t fields of the trailer, before the magic
+#define CONTAINER_TRAILER_FIELDS 1
+// Initial capacity of the pending writes
+#define CONTAINER_PENDING_CAPACITY 16
+
+// Write not yet completed
+typedef struct container_pending_t {
+    MPI_Request request;
+    // Content to free once written, NULL if freed by a later chunk
+    void *content;
+} container_pending_t;
+
+struct container_t {
+    MPI_File fh;
+    container_pending_t *pending;
+    uint64_t pending_length;
+    uint64_t pending_capacity;
+};
+
+/**
+ * Private definitions
+ */
+static bool add_pending(container_t *container, MPI_Request request, void *content, char *error);
+
+static void test_pending(container_t *container);
+
+static int wait_pending(container_t *container);
+
+static bool read_at(MPI_File fh, uint64_t offset, void *values, uint64_t length, char *error);
+/**
+ * END Private definitions
+ */
+
+/**
+ * Public
+ */
+container_t *container_open(MPI_Comm comm, const char *const file_path, char *error) {
+    container_t *container;
+    int rank;
+    int error_code;
+    int error_length;
+
+    container = (container_t *) calloc(1, sizeof(container_t));
+    if (container == NULL) {
+        strcpy(error, "Unable to allocate container");
+        return NULL;
+    }
+
+    // Open file at file_path, dropping any previous content
+    error_code = MPI_File_open(comm, file_path, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &container->fh);
+    if (error_code == MPI_SUCCESS) error_code = MPI_File_set_size(container->fh, 0);
+    if (error_code != MPI_SUCCESS) {
+        MPI_Error_string(error_code, error, &error_length);
+        if (container->fh != MPI_FILE_NULL) MPI_File_close(&container->fh);
+        free(container);
+        return NULL;
+    }
+
+    // Header: magic, version
+    MPI_Comm_rank(comm, &rank);
+    if (rank == 0) {
+        const uint64_t version = CONTAINER_VERSION;
+
+        error_code = MPI_File_write_at(container->fh, 0, CONTAINER_MAGIC, CONTAINER_MAGIC_LENGTH, MPI_CHAR,
+                                       MPI_STATUS_IGNORE);
+        if (error_code == MPI_SUCCESS)
+            error_code = MPI_File_write_at(container->fh, CONTAINER_MAGIC_LENGTH, &version, 1, MPI_UINT64_T,
+                                           MPI_STATUS_IGNORE);
+        if (error_code != MPI_SUCCESS) {
+            MPI_Error_string(error_code, error, &error_length);
+            MPI_File_close(&container->fh);
+            free(container);
+            return NULL;
+        }
+    }
+
+    return container;
+}
+
+bool container_write(container_t *container, uint64_t offset, void *content, uint64_t length, char *error) {
+    const char *bytes = (const char *) content;
+    MPI_Request request;
+    int error_code;
+    int error_length;
+
+    // Free the content of the completed writes
+    test_pending(container);
+
+    // MPI counts are int, write large contents in chunks, the last one frees content
+    do {
+        const int chunk = length > INT_MAX ? INT_MAX : (int) length;
+
+        error_code = MPI_File_iwrite_at(container->fh, (MPI_Offset) offset, bytes, chunk, MPI_BYTE, &request);
+        if (error_code != MPI_SUCCESS) {
+            MPI_Error_string(error_code, error, &error_length);
+            // The started chunks may still read content
+            wait_pending(container);
+            free(content);
+            return false;
+        }
+
+        bytes += chunk;
+        offset += (uint64_t) chunk;
+        length -= (uint64_t) chunk;
+        if (!add_pending(container, request, length == 0 ? content : NULL, error)) {
+            MPI_Wait(&request, MPI_STATUS_IGNORE);
+            wait_pending(container);
+            free(content);
+            return false;
+        }
+    } while (length > 0);
+
+    return true;
+}
+
+bool container_write_toc(container_t *container, uint64_t offset, const container_entry_t *const entries,
+                         uint64_t entries_length, char *error) {
+    uint8_t *toc;
+    uint8_t *position;
+    uint64_t toc_length;
+    int error_code;
+    int error_length;
+
+    // Table of contents: number of results, then every entry followed by its metadata, then the trailer
+    toc_length = sizeof(uint64_t) + CONTAINER_TRAILER_FIELDS * sizeof(uint64_t) + CONTAINER_MAGIC_LENGTH;
+    for (uint64_t i = 0; i < entries_length; ++i)
+        toc_length += CONTAINER_ENTRY_FIELDS * sizeof(uint64_t) + strlen(entries[i].metadata);
+    toc = (uint8_t *) malloc(toc_length);
+    if (toc == NULL) {
+        strcpy(error, "Unable to allocate container table of contents");
+        return false;
+    }
+
+    position = toc;
+    memcpy(position, &entries_length, sizeof(uint64_t));
+    position += sizeof(uint64_t);
+    for (uint64_t i = 0; i < entries_length; ++i) {
+        const container_entry_t *const entry = &entries[i];
+        const uint64_t fields[CONTAINER_ENTRY_FIELDS] = {entry->simulation_id, (uint64_t) entry->rank,
+                                                         (uint64_t) entry->format, entry->offset, entry->length,
+                                                         strlen(entry->metadata)};
+
+        memcpy(position, fields, sizeof(fields));
+        position += sizeof(fields);
+        memcpy(position, entry->metadata, fields[5]);
+        position += fields[5];
+    }
+    memcpy(position, &offset, sizeof(uint64_t));
+    position += sizeof(uint64_t);
+    memcpy(position, CONTAINER_MAGIC, CONTAINER_MAGIC_LENGTH);
+
+    // A table of contents larger than INT_MAX bytes would need millions of simulations
+    error_code = MPI_File_write_at(container->fh, (MPI_Offset) offset, toc, (int) toc_length, MPI_BYTE,
+                                   MPI_STATUS_IGNORE);
+    free(toc);
+    if (error_code != MPI_SUCCESS) {
+        MPI_Error_string(error_code, error, &error_length);
+        return false;
+    }
+
+    return true;
+}
+
+bool container_flush(container_t *container, char *error) {
+    int error_code;
+    int error_length;
+
+    error_code = wait_pending(container);
+    if (error_code != MPI_SUCCESS) {
+        MPI_Error_string(error_code, error, &error_length);
+        return false;
+    }
+
+    return true;
+}
+
+bool container_close(container_t *container, char *error) {
+    int error_code;
+    int error_length;
+
+    error_code = wait_pending(container);
+    free(container->pending);
+
+    const int close_code = MPI_File_close(&container->fh);
+    if (error_code == MPI_SUCCESS) error_code = close_code;
+    free(container);
+
+    if (error_code != MPI_SUCCESS) {
+        MPI_Error_string(error_code, error, &error_length);
+        return false;
+    }
+
+    return true;
+}
+
+container_entry_t *container_read_toc(const char *const file_path, uint64_t *entries_length, char *error) {
+    MPI_File fh;
+    MPI_Offset size;
+    char magic[CONTAINER_MAGIC_LENGTH];
+    uint64_t toc_offset;
+    uint8_t *toc;
+    const uint8_t *position;
+    const uint8_t *toc_end;
+    container_entry_t *entries;
+    int error_code;
+    int error_length;
+
+    error_code = MPI_File_open(MPI_COMM_SELF, file_path, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh);
+    if (error_code != MPI_SUCCESS) {
+        MPI_Error_string(error_code, error, &error_length);
+        return NULL;
+    }
+
+    // Header and trailer, the table of contents offset precedes the closing magic
+    MPI_File_get_size(fh, &size);
+    if ((uint64_t) size < CONTAINER_HEADER_LENGTH + 2 * sizeof(uint64_t) + CONTAINER_MAGIC_LENGTH
+        || !read_at(fh, 0, magic, CONTAINER_MAGIC_LENGTH, error)
+        || memcmp(magic, CONTAINER_MAGIC, CONTAINER_MAGIC_LENGTH) != 0
+        || !read_at(fh, (uint64_t) size - CONTAINER_MAGIC_LENGTH, magic, CONTAINER_MAGIC_LENGTH, error)
+        || memcmp(magic, CONTAINER_MAGIC, CONTAINER_MAGIC_LENGTH) != 0
+        || !read_at(fh, (uint64_t) size - CONTAINER_MAGIC_LENGTH - sizeof(uint64_t), &toc_offset, sizeof(uint64_t),
+                    error)
+        || toc_offset < CONTAINER_HEADER_LENGTH
+        || toc_offset > (uint64_t) size - CONTAINER_MAGIC_LENGTH - 2 * sizeof(uint64_t)) {
+        strcpy(error, "Not a complete container");
+        MPI_File_close(&fh);
+        return NULL;
+    }
+
+    // Table of contents, without the trailer
+    const uint64_t toc_length = (uint64_t) size - CONTAINER_MAGIC_LENGTH - sizeof(uint64_t) - toc_offset;
+    toc = (uint8_t *) malloc(toc_length);
+    if (toc == NULL) {
+        strcpy(error, "Unable to allocate container table of contents");
+        MPI_File_close(&fh);
+        return NULL;
+    }
+    if (!read_at(fh, toc_offset, toc, toc_length, error)) {
+        free(toc);
+        MPI_File_close(&fh);
+        return NULL;
+    }
+    MPI_File_close(&fh);
+
+    position = toc;
+    toc_end = toc + toc_length;
+    memcpy(entries_length, position, sizeof(uint64_t));
+    position += sizeof(uint64_t);
+    if (*entries_length > toc_length / (CONTAINER_ENTRY_FIELDS * sizeof(uint64_t))) {
+        strcpy(error, "Invalid container table of contents");
+        free(toc);
+        return NULL;
+    }
+    entries = (container_entry_t *) calloc(*entries_length > 0 ? *entries_length : 1, sizeof(container_entry_t));
+    if (entries == NULL) {
+        strcpy(error, "Unable to allocate container entries");
+        free(toc);
+        return NULL;
+    }
+
+    for (uint64_t i = 0; i < *entries_length; ++i) {
+        container_entry_t *const entry = &entries[i];
+        uint64_t fields[CONTAINER_ENTRY_FIELDS];
+
+        if ((uint64_t) (toc_end - position) < sizeof(fields)) break;
+        memcpy(fields, position, sizeof(fields));
+        position += sizeof(fields);
+        if (fields[5] > (uint64_t) (toc_end - position) || fields[2] > SNAPSHOT_FORMAT_BINARY
+            || fields[3] < CONTAINER_HEADER_LENGTH || fields[4] > toc_offset - fields[3])
+            break;
+
+        entry->simulation_id = fields[0];
+        entry->rank = (int) fields[1];
+        entry->format = (snapshot_format_t) fields[2];
+        entry->offset = fields[3];
+        entry->length = fields[4];
+        entry->metadata = (char *) calloc(fields[5] + 1, sizeof(char));
+        if (entry->metadata == NULL) break;
+        memcpy(entry->metadata, position, fields[5]);
+        position += fields[5];
+    }
+    free(toc);
+
+    // Every entry must be valid
+    if (*entries_length > 0 && entries[*entries_length - 1].metadata == NULL) {
+        strcpy(error, "Invalid container table of contents");
+        container_entries_free(entries, *entries_length);
+        return NULL;
+    }
+
+    return entries;
+}
+
+uint8_t *container_read_result(const char *const file_path, const container_entry_t *const entry, char *error) {
+    MPI_File fh;
+    uint8_t *content;
+    int error_code;
+    int error_length;
+
+    error_code = MPI_File_open(MPI_COMM_SELF, file_path, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh);
+    if (error_code != MPI_SUCCESS) {
+        MPI_Error_string(error_code, error, &error_length);
+        return NULL;
+    }
+
+    content = (uint8_t *) malloc(entry->length > 0 ? entry->length : 1);
+    if (content == NULL) {
+        strcpy(error, "Unable to allocate container result");
+        MPI_File_close(&fh);
+        return NULL;
+    }
+    if (!read_at(fh, entry->offset, content, entry->length, error)) {
+        free(content);
+        MPI_File_close(&fh);
+        return NULL;
+    }
+
+    MPI_File_close(&fh);
+    return content;
+}
+
+void container_entries_free(container_entry_t *entries, uint64_t entries_length) {
+    if (entries == NULL) return;
+
+    for (uint64_t i = 0; i < entries_length; ++i) free(entries[i].metadata);
+    free(entries);
+}
+/**
+ * END Public
+ */
+
+/**
+ * Private
+ */
+static bool add_pending(container_t *container, MPI_Request request, void *content, char *error) {
+    // Grow the pending writes
+    if (container->pending_length == container->pending_capacity) {
+        const uint64_t capacity = container->pending_capacity > 0 ? 2 * container->pending_capacity
+                                                                  : CONTAINER_PENDING_CAPACITY;
+        container_pending_t *pending = (container_pending_t *) realloc(container->pending,
+                                                                       capacity * sizeof(container_pending_t));
+        if (pending == NULL) {
+            strcpy(error, "Unable to grow container pending writes");
+            return false;
+        }
+        container->pending = pending;
+        container->pending_capacity = capacity;
+    }
+
+    container->pending[container->pending_length++] = (container_pending_t) {.request = request, .content = content};
+    return true;
+}
+
+static void test_pending(container_t *container) {
+    uint64_t length = 0;
+
+    // Keep the pending writes in order, a content is freed by its last chunk
+    for (uint64_t i = 0; i < container->pending_length; ++i) {
+        int completed;
+
+        MPI_Test(&container->pending[i].request, &completed, MPI_STATUS_IGNORE);
+        if (completed) free(container->pending[i].content);
+        else container->pending[length++] = container->pending[i];
+    }
+    container->pending_length = length;
+}
+
+static int wait_pending(container_t *container) {
+    int error_code = MPI_SUCCESS;
+
+    for (uint64_t i = 0; i < container->pending_length; ++i) {
+        const int wait_code = MPI_Wait(&container->pending[i].request, MPI_STATUS_IGNORE);
+        if (wait_code != MPI_SUCCESS) error_code = wait_code;
+        free(container->pending[i].content);
+    }
+    container->pending_length = 0;
+
+    return error_code;
+}
+
+static bool read_at(MPI_File fh, uint64_t offset, void *values, uint64_t length, char *error) {
+    MPI_Status status;
+    char *bytes = (char *) values;
+    int error_code;
+    int error_length;
+    int read;
+
+    // MPI counts are int, read large buffers in chunks
+    while (length > 0) {
+        const int chunk = length > INT_MAX ? INT_MAX : (int) length;
+
+        error_code = MPI_File_read_at(fh, (MPI_Offset) offset, bytes, chunk, MPI_BYTE, &status);
+        if (error_code != MPI_SUCCESS) {
+            MPI_Error_string(error_code, error, &error_length);
+            return false;
+        }
+        MPI_Get_count(&status, MPI_BYTE, &read);
+        if (read != chunk) {
+            strcpy(error, "Unexpected end of container");
+            return false;
+        }
+
+        bytes += chunk;
+        offset += (uint64_t) chunk;
+        length -= (uint64_t) chunk;
+    }
+
+    return true;
+}
+/**
+ * END Private
+ */
@@ -1,6 +1,11 @@
 #include "ns/utils/file.h"
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <mpi.h>
 
 char *read_file(const char *const file_path, char *error) {
@@ -23,8 +28,8 @@ char *read_file(const char *const file_path, char *error) {
     // Obtain the number of chars
     num_chars = (size_t) filesize / sizeof(char);
 
-    // Allocate string buffer
-    buffer = (char *) calloc(num_chars, sizeof(char));
+    // Allocate string buffer, terminated
+    buffer = (char *) calloc(num_chars + 1, sizeof(char));
     if (buffer == NULL) {
         error = "Unable to allocate simulations file buffer";
         return NULL;
@@ -41,6 +46,50 @@ char *read_file(const char *const file_path, char *error) {
     return buffer;
 }
 
+const char *map_file(const char *const file_path, uint64_t *length, char *error) {
+    struct stat file_stat;
+    void *content;
+    int fd;
+
+    // Open file at file_path
+    fd = open(file_path, O_RDONLY);
+    if (fd < 0) {
+        strcpy(error, strerror(errno));
+        return NULL;
+    }
+
+    // Get file size in byte
+    if (fstat(fd, &file_stat) != 0) {
+        strcpy(error, strerror(errno));
+        close(fd);
+        return NULL;
+    }
+    if (file_stat.st_size <= 0) {
+        strcpy(error, "Empty file");
+        close(fd);
+        return NULL;
+    }
+    *length = (uint64_t) file_stat.st_size;
+
+    // Map the whole file, read front to back
+    content = mmap(NULL, (size_t) *length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (content == MAP_FAILED) {
+        strcpy(error, strerror(errno));
+        return NULL;
+    }
+#ifdef MADV_SEQUENTIAL
+    // Hint only, failure is not an error
+    madvise(content, (size_t) *length, MADV_SEQUENTIAL);
+#endif
+
+    return (const char *) content;
+}
+
+void unmap_file(const char *const content, uint64_t length) {
+    if (content != NULL) munmap((void *) content, (size_t) length);
+}
+
 bool write_file(const char *const file_path, const char *const content, char *error) {
     MPI_File fh;
     int error_code;
@@ -0,0 +1,543 @@
+#include "ns/utils/pack.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+// Version, scalar fields of the simulation and lengths of the arrays, 8 bytes each
+#define PACK_HEADER_VALUES (1 + 16 + 4 * NS_BOUNDARY_EDGES + 7 + 3)
+#define PACK_HEADER_LENGTH (PACK_HEADER_VALUES * sizeof(uint64_t))
+// Mod: tick, densities length and forces length
+#define PACK_MOD_LENGTH (3 * sizeof(uint64_t))
+// Density: x and y
+#define PACK_DENSITY_LENGTH (2 * sizeof(uint64_t))
+// Force: x, y and velocity
+#define PACK_FORCE_LENGTH (2 * sizeof(uint64_t) + 2 * sizeof(double))
+// Sweep: points length, region, axes length and packed base length
+#define PACK_SWEEP_LENGTH (4 * sizeof(uint64_t))
+// Axis: parameters, values length, whether the values are listed, logarithmic, from and to
+#define PACK_AXIS_LENGTH (4 * sizeof(uint64_t) + 2 * sizeof(double))
+
+/**
+ * Private definitions
+ */
+static void pack_uint64(uint8_t *buffer, uint64_t *offset, uint64_t value);
+
+static void pack_double(uint8_t *buffer, uint64_t *offset, double value);
+
+static bool unpack_uint64(const uint8_t *buffer, uint64_t length, uint64_t *offset, uint64_t *value);
+
+static bool unpack_double(const uint8_t *buffer, uint64_t length, uint64_t *offset, double *value);
+
+static uint8_t *pack_sweep(const ns_parse_sweep_t *sweep, uint64_t *length);
+
+static ns_simulation_t *unpack_sweep_point(const uint8_t *buffer, uint64_t length, uint64_t point);
+
+static bool unpack_image_lengths(const uint8_t *image, uint64_t length, uint64_t *simulations_length,
+                                 uint64_t *sweeps_length);
+
+static bool unpack_image_entry(const uint8_t *image, uint64_t length, uint64_t entry, uint64_t *start,
+                               uint64_t *end);
+
+static void *ns_unpack_simulation_error(ns_simulation_t *simulation);
+
+static void free_buffers(uint8_t **buffers, uint64_t buffers_length);
+/**
+ * END Private definitions
+ */
+
+/**
+ * Public
+ */
+uint8_t *ns_pack_simulation(const ns_simulation_t *const simulation, uint64_t *length) {
+    if (simulation == NULL || length == NULL) return NULL;
+    uint8_t *buffer;
+    uint64_t offset = 0;
+    uint64_t densities_length = 0;
+    uint64_t forces_length = 0;
+
+    for (uint64_t i_m = 0; i_m < simulation->mods_length; ++i_m) {
+        densities_length += simulation->mods[i_m]->densities_length;
+        forces_length += simulation->mods[i_m]->forces_length;
+    }
+
+    *length = PACK_HEADER_LENGTH + simulation->mods_length * PACK_MOD_LENGTH
+              + densities_length * PACK_DENSITY_LENGTH + forces_length * PACK_FORCE_LENGTH;
+    buffer = (uint8_t *) malloc(*length);
+    if (buffer == NULL) return NULL;
+
+    // Header
+    pack_uint64(buffer, &offset, NS_PACK_VERSION);
+    pack_double(buffer, &offset, simulation->time_step);
+    pack_uint64(buffer, &offset, simulation->ticks);
+    pack_uint64(buffer, &offset, simulation->ranks);
+    pack_uint64(buffer, &offset, simulation->world.width);
+    pack_uint64(buffer, &offset, simulation->world.height);
+    pack_double(buffer, &offset, simulation->fluid.viscosity);
+    pack_double(buffer, &offset, simulation->fluid.density);
+    pack_double(buffer, &offset, simulation->fluid.diffusion);
+    pack_uint64(buffer, &offset, (uint64_t) simulation->solver.relaxation);
+    pack_uint64(buffer, &offset, simulation->solver.max_iterations);
+    pack_double(buffer, &offset, simulation->solver.tolerance);
+    pack_uint64(buffer, &offset, simulation->solver.check_every);
+    pack_uint64(buffer, &offset, (uint64_t) simulation->solver.pressure);
+    pack_uint64(buffer, &offset, (uint64_t) simulation->solver.multigrid.cycle);
+    pack_double(buffer, &offset, simulation->solver.multigrid.tolerance);
+    pack_uint64(buffer, &offset, simulation->solver.multigrid.max_cycles);
+    for (int edge = 0; edge < NS_BOUNDARY_EDGES; ++edge) {
+        const ns_boundary_t *const boundary = &simulation->boundaries.edges[edge];
+
+        pack_uint64(buffer, &offset, (uint64_t) boundary->type);
+        pack_double(buffer, &offset, boundary->u);
+        pack_double(buffer, &offset, boundary->v);
+        pack_double(buffer, &offset, boundary->density);
+    }
+    pack_uint64(buffer, &offset, simulation->output.every);
+    pack_uint64(buffer, &offset, simulation->output.x);
+    pack_uint64(buffer, &offset, simulation->output.y);
+    pack_uint64(buffer, &offset, simulation->output.width);
+    pack_uint64(buffer, &offset, simulation->output.height);
+    pack_uint64(buffer, &offset, simulation->output.fields);
+    pack_uint64(buffer, &offset, simulation->output.downsample);
+    pack_uint64(buffer, &offset, simulation->mods_length);
+    pack_uint64(buffer, &offset, densities_length);
+    pack_uint64(buffer, &offset, forces_length);
+
+    // Mods, then the densities and the forces of every mod
+    for (uint64_t i_m = 0; i_m < simulation->mods_length; ++i_m) {
+        const ns_parse_simulation_mod_t *const mod = simulation->mods[i_m];
+
+        pack_uint64(buffer, &offset, mod->tick);
+        pack_uint64(buffer, &offset, mod->densities_length);
+        pack_uint64(buffer, &offset, mod->forces_length);
+    }
+    for (uint64_t i_m = 0; i_m < simulation->mods_length; ++i_m) {
+        const ns_parse_simulation_mod_t *const mod = simulation->mods[i_m];
+
+        for (uint64_t i_d = 0; i_d < mod->densities_length; ++i_d) {
+            pack_uint64(buffer, &offset, mod->densities[i_d]->x);
+            pack_uint64(buffer, &offset, mod->densities[i_d]->y);
+        }
+    }
+    for (uint64_t i_m = 0; i_m < simulation->mods_length; ++i_m) {
+        const ns_parse_simulation_mod_t *const mod = simulation->mods[i_m];
+
+        for (uint64_t i_f = 0; i_f < mod->forces_length; ++i_f) {
+            pack_uint64(buffer, &offset, mod->forces[i_f]->x);
+            pack_uint64(buffer, &offset, mod->forces[i_f]->y);
+            pack_double(buffer, &offset, mod->forces[i_f]->velocity.x);
+            pack_double(buffer, &offset, mod->forces[i_f]->velocity.y);
+        }
+    }
+
+    return buffer;
+}
+
+ns_simulation_t *ns_unpack_simulation(const uint8_t *const buffer, uint64_t length) {
+    if (buffer == NULL) return NULL;
+    ns_simulation_t *simulation = NULL;
+    uint64_t offset = 0;
+    uint64_t version;
+    uint64_t value;
+    uint64_t densities_length;
+    uint64_t forces_length;
+
+    if (!unpack_uint64(buffer, length, &offset, &version) || version != NS_PACK_VERSION
+        || length < PACK_HEADER_LENGTH)
+        return NULL;
+
+    simulation = (ns_simulation_t *) calloc(1, sizeof(ns_simulation_t));
+    if (simulation == NULL) return NULL;
+
+    // Header, its length has been checked
+    unpack_double(buffer, length, &offset, &simulation->time_step);
+    unpack_uint64(buffer, length, &offset, &simulation->ticks);
+    unpack_uint64(buffer, length, &offset, &simulation->ranks);
+    unpack_uint64(buffer, length, &offset, &simulation->world.width);
+    unpack_uint64(buffer, length, &offset, &simulation->world.height);
+    unpack_double(buffer, length, &offset, &simulation->fluid.viscosity);
+    unpack_double(buffer, length, &offset, &simulation->fluid.density);
+    unpack_double(buffer, length, &offset, &simulation->fluid.diffusion);
+    unpack_uint64(buffer, length, &offset, &value);
+    simulation->solver.relaxation = (ns_relaxation_t) value;
+    unpack_uint64(buffer, length, &offset, &simulation->solver.max_iterations);
+    unpack_double(buffer, length, &offset, &simulation->solver.tolerance);
+    unpack_uint64(buffer, length, &offset, &simulation->solver.check_every);
+    unpack_uint64(buffer, length, &offset, &value);
+    simulation->solver.pressure = (ns_pressure_solver_t) value;
+    unpack_uint64(buffer, length, &offset, &value);
+    simulation->solver.multigrid.cycle = (ns_multigrid_cycle_t) value;
+    unpack_double(buffer, length, &offset, &simulation->solver.multigrid.tolerance);
+    unpack_uint64(buffer, length, &offset, &simulation->solver.multigrid.max_cycles);
+    for (int edge = 0; edge < NS_BOUNDARY_EDGES; ++edge) {
+        ns_boundary_t *const boundary = &simulation->boundaries.edges[edge];
+
+        unpack_uint64(buffer, length, &offset, &value);
+        boundary->type = (ns_boundary_type_t) value;
+        unpack_double(buffer, length, &offset, &boundary->u);
+        unpack_double(buffer, length, &offset, &boundary->v);
+        unpack_double(buffer, length, &offset, &boundary->density);
+    }
+    unpack_uint64(buffer, length, &offset, &simulation->output.every);
+    unpack_uint64(buffer, length, &offset, &simulation->output.x);
+    unpack_uint64(buffer, length, &offset, &simulation->output.y);
+    unpack_uint64(buffer, length, &offset, &simulation->output.width);
+    unpack_uint64(buffer, length, &offset, &simulation->output.height);
+    unpack_uint64(buffer, length, &offset, &value);
+    simulation->output.fields = (unsigned int) value;
+    unpack_uint64(buffer, length, &offset, &simulation->output.downsample);
+    unpack_uint64(buffer, length, &offset, &simulation->mods_length);
+
+    // Lengths must match the buffer before anything is allocated, arrays not allocated yet are NULL
+    if (!unpack_uint64(buffer, length, &offset, &densities_length)
+        || !unpack_uint64(buffer, length, &offset, &forces_length)
+        || simulation->mods_length > (length - offset) / PACK_MOD_LENGTH
+        || densities_length > (length - offset) / PACK_DENSITY_LENGTH
+        || forces_length > (length - offset) / PACK_FORCE_LENGTH
+        || length - offset != simulation->mods_length * PACK_MOD_LENGTH + densities_length * PACK_DENSITY_LENGTH
+                              + forces_length * PACK_FORCE_LENGTH)
+        return ns_unpack_simulation_error(simulation);
+
+    // Mods
+    if (simulation->mods_length > 0) {
+        const uint64_t mods_length = simulation->mods_length;
+
+        simulation->mods = (ns_parse_simulation_mod_t **) calloc(mods_length, sizeof(ns_parse_simulation_mod_t *));
+        if (simulation->mods == NULL) return ns_unpack_simulation_error(simulation);
+    }
+    for (uint64_t i_m = 0; i_m < simulation->mods_length; ++i_m) {
+        ns_parse_simulation_mod_t *mod;
+
+        mod = (ns_parse_simulation_mod_t *) calloc(1, sizeof(ns_parse_simulation_mod_t));
+        if (mod == NULL) return ns_unpack_simulation_error(simulation);
+        simulation->mods[i_m] = mod;
+
+        unpack_uint64(buffer, length, &offset, &mod->tick);
+        unpack_uint64(buffer, length, &offset, &mod->densities_length);
+        unpack_uint64(buffer, length, &offset, &mod->forces_length);
+        if (mod->densities_length > densities_length || mod->forces_length > forces_length)
+            return ns_unpack_simulation_error(simulation);
+        densities_length -= mod->densities_length;
+        forces_length -= mod->forces_length;
+
+        if (mod->densities_length > 0) {
+            mod->densities = (ns_parse_simulation_mods_density_t **) calloc(
+                    mod->densities_length, sizeof(ns_parse_simulation_mods_density_t *));
+            if (mod->densities == NULL) return ns_unpack_simulation_error(simulation);
+        }
+        if (mod->forces_length > 0) {
+            mod->forces = (ns_parse_simulation_mods_force_t **) calloc(mod->forces_length,
+                                                                       sizeof(ns_parse_simulation_mods_force_t *));
+            if (mod->forces == NULL) return ns_unpack_simulation_error(simulation);
+        }
+    }
+    // Every density and force is owned by a mod
+    if (densities_length != 0 || forces_length != 0) return ns_unpack_simulation_error(simulation);
+
+    // Densities and forces of every mod
+    for (uint64_t i_m = 0; i_m < simulation->mods_length; ++i_m) {
+        ns_parse_simulation_mod_t *const mod = simulation->mods[i_m];
+
+        for (uint64_t i_d = 0; i_d < mod->densities_length; ++i_d) {
+            ns_parse_simulation_mods_density_t *density;
+
+            density = (ns_parse_simulation_mods_density_t *) malloc(sizeof(ns_parse_simulation_mods_density_t));
+            if (density == NULL) return ns_unpack_simulation_error(simulation);
+            mod->densities[i_d] = density;
+
+            unpack_uint64(buffer, length, &offset, &density->x);
+            unpack_uint64(buffer, length, &offset, &density->y);
+        }
+    }
+    for (uint64_t i_m = 0; i_m < simulation->mods_length; ++i_m) {
+        ns_parse_simulation_mod_t *const mod = simulation->mods[i_m];
+
+        for (uint64_t i_f = 0; i_f < mod->forces_length; ++i_f) {
+            ns_parse_simulation_mods_force_t *force;
+
+            force = (ns_parse_simulation_mods_force_t *) malloc(sizeof(ns_parse_simulation_mods_force_t));
+            if (force == NULL) return ns_unpack_simulation_error(simulation);
+            mod->forces[i_f] = force;
+
+            unpack_uint64(buffer, length, &offset, &force->x);
+            unpack_uint64(buffer, length, &offset, &force->y);
+            unpack_double(buffer, length, &offset, &force->velocity.x);
+            unpack_double(buffer, length, &offset, &force->velocity.y);
+        }
+    }
+
+    return simulation;
+}
+uint8_t *ns_pack_simulations(const ns_simulations_t *const simulations, uint64_t *length) {
+    if (simulations == NULL || length == NULL) return NULL;
+    const uint64_t simulations_length = simulations->simulations_length;
+    const uint64_t entries_length = simulations_length + simulations->sweeps_length;
+    uint8_t **buffers = NULL;
+    uint64_t *lengths = NULL;
+    uint8_t *image = NULL;
+    uint64_t offset = 0;
+    uint64_t position;
+
+    buffers = (uint8_t **) calloc(entries_length + 1, sizeof(uint8_t *));
+    lengths = (uint64_t *) calloc(entries_length + 1, sizeof(uint64_t));
+    if (buffers == NULL || lengths == NULL) {
+        free(buffers);
+        free(lengths);
+        return NULL;
+    }
+
+    // Number of simulations and sweeps, offset of every entry, then the packed simulations and sweeps
+    *length = (2 + entries_length + 1) * sizeof(uint64_t);
+    for (uint64_t i_e = 0; i_e < entries_length; ++i_e) {
+        buffers[i_e] = i_e < simulations_length
+                       ? ns_pack_simulation(simulations->simulations[i_e], &lengths[i_e])
+                       : pack_sweep(simulations->sweeps[i_e - simulations_length], &lengths[i_e]);
+        if (buffers[i_e] == NULL) {
+            free_buffers(buffers, i_e);
+            free(lengths);
+            return NULL;
+        }
+        *length += lengths[i_e];
+    }
+
+    image = (uint8_t *) malloc(*length);
+    if (image == NULL) {
+        free_buffers(buffers, entries_length);
+        free(lengths);
+        return NULL;
+    }
+
+    pack_uint64(image, &offset, simulations_length);
+    pack_uint64(image, &offset, simulations->sweeps_length);
+    position = (2 + entries_length + 1) * sizeof(uint64_t);
+    for (uint64_t i_e = 0; i_e <= entries_length; ++i_e) {
+        pack_uint64(image, &offset, position);
+        position += lengths[i_e];
+    }
+    for (uint64_t i_e = 0; i_e < entries_length; ++i_e) {
+        memcpy(image + offset, buffers[i_e], lengths[i_e]);
+        offset += lengths[i_e];
+    }
+
+    free_buffers(buffers, entries_length);
+    free(lengths);
+    return image;
+}
+
+uint64_t ns_packed_simulations_length(const uint8_t *const image, uint64_t length) {
+    if (image == NULL) return 0;
+    uint64_t simulations_length;
+    uint64_t sweeps_length;
+    uint64_t points_length;
+    uint64_t start;
+    uint64_t end;
+
+    if (!unpack_image_lengths(image, length, &simulations_length, &sweeps_length)) return 0;
+
+    // The points length comes first in a packed sweep
+    for (uint64_t i_w = 0; i_w < sweeps_length; ++i_w) {
+        if (!unpack_image_entry(image, length, simulations_length + i_w, &start, &end)
+            || !unpack_uint64(image, end, &start, &points_length))
+            return 0;
+        simulations_length += points_length;
+    }
+
+    return simulations_length;
+}
+
+ns_simulation_t *ns_unpack_simulation_at(const uint8_t *const image, uint64_t length, uint64_t simulation_id) {
+    uint64_t simulations_length;
+    uint64_t sweeps_length;
+    uint64_t points_length;
+    uint64_t start;
+    uint64_t end;
+    uint64_t offset;
+
+    if (image == NULL || !unpack_image_lengths(image, length, &simulations_length, &sweeps_length)) return NULL;
+
+    if (simulation_id < simulations_length) {
+        if (!unpack_image_entry(image, length, simulation_id, &start, &end)) return NULL;
+        return ns_unpack_simulation(image + start, end - start);
+    }
+
+    // The points of the sweeps follow the listed simulations, expanded on demand
+    simulation_id -= simulations_length;
+    for (uint64_t i_w = 0; i_w < sweeps_length; ++i_w) {
+        if (!unpack_image_entry(image, length, simulations_length + i_w, &start, &end)) return NULL;
+        offset = start;
+        if (!unpack_uint64(image, end, &offset, &points_length)) return NULL;
+
+        if (simulation_id < points_length) return unpack_sweep_point(image + start, end - start, simulation_id);
+        simulation_id -= points_length;
+    }
+
+    return NULL;
+}
+/**
+ * END Public
+ */
+
+/**
+ * Private
+ */
+static void pack_uint64(uint8_t *buffer, uint64_t *offset, uint64_t value) {
+    memcpy(buffer + *offset, &value, sizeof(uint64_t));
+    *offset += sizeof(uint64_t);
+}
+
+static void pack_double(uint8_t *buffer, uint64_t *offset, double value) {
+    memcpy(buffer + *offset, &value, sizeof(double));
+    *offset += sizeof(double);
+}
+
+static bool unpack_uint64(const uint8_t *const buffer, uint64_t length, uint64_t *offset, uint64_t *value) {
+    if (length - *offset < sizeof(uint64_t)) return false;
+
+    memcpy(value, buffer + *offset, sizeof(uint64_t));
+    *offset += sizeof(uint64_t);
+    return true;
+}
+
+static bool unpack_double(const uint8_t *const buffer, uint64_t length, uint64_t *offset, double *value) {
+    if (length - *offset < sizeof(double)) return false;
+
+    memcpy(value, buffer + *offset, sizeof(double));
+    *offset += sizeof(double);
+    return true;
+}
+
+static uint8_t *pack_sweep(const ns_parse_sweep_t *const sweep, uint64_t *length) {
+    uint8_t *base;
+    uint64_t base_length;
+    uint8_t *buffer;
+    uint64_t offset = 0;
+
+    base = ns_pack_simulation(sweep->base, &base_length);
+    if (base == NULL) return NULL;
+
+    *length = PACK_SWEEP_LENGTH + base_length + sweep->axes_length * PACK_AXIS_LENGTH;
+    for (uint64_t i_a = 0; i_a < sweep->axes_length; ++i_a)
+        if (sweep->axes[i_a]->values != NULL) *length += sweep->axes[i_a]->values_length * sizeof(double);
+    buffer = (uint8_t *) malloc(*length);
+    if (buffer == NULL) {
+        free(base);
+        return NULL;
+    }
+
+    // Header and packed base, then every axis followed by its listed values
+    pack_uint64(buffer, &offset, sweep->points_length);
+    pack_uint64(buffer, &offset, sweep->region);
+    pack_uint64(buffer, &offset, sweep->axes_length);
+    pack_uint64(buffer, &offset, base_length);
+    memcpy(buffer + offset, base, base_length);
+    offset += base_length;
+    for (uint64_t i_a = 0; i_a < sweep->axes_length; ++i_a) {
+        const ns_parse_sweep_axis_t *const axis = sweep->axes[i_a];
+
+        pack_uint64(buffer, &offset, axis->parameters);
+        pack_uint64(buffer, &offset, axis->values_length);
+        pack_uint64(buffer, &offset, axis->values != NULL);
+        pack_uint64(buffer, &offset, axis->logarithmic);
+        pack_double(buffer, &offset, axis->from);
+        pack_double(buffer, &offset, axis->to);
+        for (uint64_t i_v = 0; axis->values != NULL && i_v < axis->values_length; ++i_v)
+            pack_double(buffer, &offset, axis->values[i_v]);
+    }
+
+    free(base);
+    return buffer;
+}
+
+static ns_simulation_t *unpack_sweep_point(const uint8_t *const buffer, uint64_t length, uint64_t point) {
+    ns_simulation_t *simulation = NULL;
+    ns_parse_sweep_t sweep = {.base = NULL};
+    ns_parse_sweep_axis_t *axes = NULL;
+    uint64_t offset = 0;
+    uint64_t region;
+    uint64_t base_length;
+    bool valid;
+
+    if (!(unpack_uint64(buffer, length, &offset, &sweep.points_length)
+          && unpack_uint64(buffer, length, &offset, &region)
+          && unpack_uint64(buffer, length, &offset, &sweep.axes_length)
+          && unpack_uint64(buffer, length, &offset, &base_length))
+        || point >= sweep.points_length || base_length > length - offset
+        || sweep.axes_length > (length - offset - base_length) / PACK_AXIS_LENGTH)
+        return NULL;
+    sweep.region = region != 0;
+
+    // The point starts from a copy of the base
+    simulation = ns_unpack_simulation(buffer + offset, base_length);
+    if (simulation == NULL) return NULL;
+    offset += base_length;
+
+    // Listed values are copied, they may not be aligned in the buffer
+    axes = (ns_parse_sweep_axis_t *) calloc(sweep.axes_length + 1, sizeof(ns_parse_sweep_axis_t));
+    sweep.axes = (ns_parse_sweep_axis_t **) calloc(sweep.axes_length + 1, sizeof(ns_parse_sweep_axis_t *));
+    valid = axes != NULL && sweep.axes != NULL;
+    for (uint64_t i_a = 0; valid && i_a < sweep.axes_length; ++i_a) {
+        ns_parse_sweep_axis_t *const axis = &axes[i_a];
+        uint64_t parameters;
+        uint64_t listed;
+        uint64_t logarithmic;
+
+        sweep.axes[i_a] = axis;
+        valid = unpack_uint64(buffer, length, &offset, &parameters)
+                && unpack_uint64(buffer, length, &offset, &axis->values_length)
+                && unpack_uint64(buffer, length, &offset, &listed)
+                && unpack_uint64(buffer, length, &offset, &logarithmic)
+                && unpack_double(buffer, length, &offset, &axis->from)
+                && unpack_double(buffer, length, &offset, &axis->to)
+                && axis->values_length > 0;
+        if (!valid) continue;
+
+        axis->parameters = (unsigned int) parameters;
+        axis->logarithmic = logarithmic != 0;
+        if (listed == 0) continue;
+
+        valid = axis->values_length <= (length - offset) / sizeof(double);
+        if (valid) axis->values = (double *) malloc(axis->values_length * sizeof(double));
+        valid = valid && axis->values != NULL;
+        if (valid) memcpy(axis->values, buffer + offset, axis->values_length * sizeof(double));
+        offset += valid ? axis->values_length * sizeof(double) : 0;
+    }
+    if (valid) ns_parse_sweep_assign(&sweep, point, simulation);
+
+    for (uint64_t i_a = 0; axes != NULL && i_a < sweep.axes_length; ++i_a) free(axes[i_a].values);
+    free(axes);
+    free(sweep.axes);
+
+    if (!valid) return ns_unpack_simulation_error(simulation);
+    return simulation;
+}
+
+static bool unpack_image_lengths(const uint8_t *const image, uint64_t length, uint64_t *simulations_length,
+                                 uint64_t *sweeps_length) {
+    uint64_t offset = 0;
+
+    // The offsets table must fit in the image
+    return unpack_uint64(image, length, &offset, simulations_length)
+           && unpack_uint64(image, length, &offset, sweeps_length)
+           && *simulations_length < length / sizeof(uint64_t) && *sweeps_length < length / sizeof(uint64_t)
+           && *simulations_length + *sweeps_length + 3 <= length / sizeof(uint64_t);
+}
+
+static bool unpack_image_entry(const uint8_t *const image, uint64_t length, uint64_t entry, uint64_t *start,
+                               uint64_t *end) {
+    uint64_t offset = (2 + entry) * sizeof(uint64_t);
+
+    return unpack_uint64(image, length, &offset, start) && unpack_uint64(image, length, &offset, end)
+           && *start <= *end && *end <= length;
+}
+
+static void *ns_unpack_simulation_error(ns_simulation_t *simulation) {
+    ns_parse_simulation_free(simulation);
+    return NULL;
+}
+
+static void free_buffers(uint8_t **buffers, uint64_t buffers_length) {
+    for (uint64_t i = 0; i < buffers_length; ++i) free(buffers[i]);
+    free(buffers);
+}
+/**
+ * END Private
+ */
@@ -1,23 +1,122 @@
 #include "ns/utils/parser.h"
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
+#include <math.h>
 #include <cJSON.h>
 
+// Initial capacity of the locations of a streamed text
+#define NS_PARSE_STREAM_CAPACITY 64
+
+// Names of the parameters a sweep axis can set, by bit of ns_parse_sweep_parameter_t
+static const char *const sweep_parameter_strings[NS_PARSE_SWEEP_PARAMETERS] = {
+        "time_step", "ticks", "ranks", "world.width", "world.height", "fluid.viscosity", "fluid.density",
+        "fluid.diffusion", "solver.max_iterations", "solver.tolerance"
+};
+
+struct ns_parse_stream_t {
+    const char *text;
+    uint64_t length;
+    // Offset of the next byte to scan
+    uint64_t offset;
+    // Members of the top-level object scanned
+    uint64_t members_length;
+    // Scanning the simulations array, found the simulations and the sweeps arrays
+    bool listing;
+    bool listed;
+    bool swept;
+    // The whole text is scanned
+    bool complete;
+    // Location of every listed simulation
+    ns_parse_location_t *locations;
+    uint64_t locations_capacity;
+    // Sweeps, added to the simulations once every listed simulation is parsed, and their locations
+    ns_parse_sweep_t **sweeps;
+    ns_parse_location_t *sweep_locations;
+    uint64_t sweeps_length;
+    uint64_t sweeps_capacity;
+    // Last listed simulation parsed, with its id
+    ns_simulation_t *simulation;
+    uint64_t simulation_id;
+};
+
 /**
  * Private definitions
  */
+static ns_simulation_t *ns_parse_simulation_json(const cJSON *simulation_json);
+
 static bool ns_parse_simulation_check_and_assign_time_step(const cJSON *time_step_json, double *time_step);
 
 static bool ns_parse_simulation_check_and_assign_ticks(const cJSON *ticks_json, uint64_t *ticks);
 
+static bool ns_parse_simulation_check_and_assign_ranks(const cJSON *ranks_json, uint64_t *ranks);
+
 static bool ns_parse_simulation_check_and_assign_world(const cJSON *world_json, ns_parse_simulation_world_t *world);
 
 static bool ns_parse_simulation_check_and_assign_fluid(const cJSON *fluid_json, ns_parse_simulation_fluid_t *fluid);
 
+static bool ns_parse_simulation_check_and_assign_solver(const cJSON *solver_json, ns_solver_config_t *solver);
+
+static bool ns_parse_simulation_check_and_assign_multigrid(const cJSON *multigrid_json,
+                                                           ns_solver_multigrid_config_t *multigrid);
+
+static bool ns_parse_simulation_check_and_assign_boundaries(const cJSON *boundaries_json,
+                                                            ns_boundaries_t *boundaries);
+
+static bool ns_parse_simulation_check_and_assign_boundary(const cJSON *boundary_json, ns_boundary_t *boundary);
+
+static bool ns_parse_simulation_check_and_assign_output(const cJSON *output_json,
+                                                        const ns_parse_simulation_world_t *world,
+                                                        snapshot_output_t *output);
+
 static bool ns_parse_simulation_check_and_assign_mod(const cJSON *mod_json, ns_parse_simulation_mod_t *mod);
 
 static bool ns_parse_simulation_check_and_assign_mods(const cJSON *mods_json, ns_simulation_t *simulation);
 
+static bool ns_parse_simulations_check_and_assign_sweeps(const cJSON *sweeps_json, ns_simulations_t *simulations);
+
+static bool ns_parse_sweep_check_and_assign(const cJSON *sweep_json, ns_parse_sweep_t *sweep);
+
+static bool ns_parse_sweep_check_and_assign_axis(const cJSON *axis_json, ns_parse_sweep_axis_t *axis);
+
+static bool ns_parse_sweep_check_and_assign_parameters(const cJSON *parameters_json, unsigned int *parameters);
+
+static unsigned int ns_parse_sweep_parameter(const cJSON *parameter_json);
+
+static bool ns_parse_sweep_check(const ns_parse_sweep_t *sweep);
+
+static bool ns_parse_simulation_check(const ns_simulation_t *simulation);
+
+static bool ns_parse_simulation_check_boundaries(const ns_simulation_t *simulation);
+
+static void ns_parse_sweep_assign_value(unsigned int parameters, double value, ns_simulation_t *simulation);
+
+static void ns_parse_sweep_assign_output(const ns_parse_sweep_t *sweep, ns_simulation_t *simulation);
+
+static uint64_t ns_parse_sweep_integer(double value);
+
+static void ns_parse_sweep_free(ns_parse_sweep_t *sweep);
+
+static bool ns_parse_stream_member(ns_parse_stream_t *stream);
+
+static bool ns_parse_stream_listed(ns_parse_stream_t *stream);
+
+static bool ns_parse_stream_sweeps(ns_parse_stream_t *stream);
+
+static bool ns_parse_stream_complete(ns_parse_stream_t *stream, ns_simulations_t *simulations);
+
+static bool ns_parse_stream_element(ns_parse_stream_t *stream, bool first, ns_parse_location_t *location);
+
+static void ns_parse_stream_skip_whitespace(ns_parse_stream_t *stream);
+
+static bool ns_parse_stream_skip_string(ns_parse_stream_t *stream);
+
+static bool ns_parse_stream_skip_value(ns_parse_stream_t *stream);
+
+static bool ns_parse_stream_expect(ns_parse_stream_t *stream, char character);
+
+static void ns_parse_stream_free(ns_parse_stream_t *stream);
+
 static void *ns_parse_simulation_error(cJSON *file_json, ns_simulation_t *simulation);
 
 static void *ns_parse_simulations_error(cJSON *file_json, ns_simulations_t *simulations);
@@ -33,29 +132,13 @@ ns_simulation_t *ns_parse_simulation(const char *const text) {
     ns_simulation_t *simulation = NULL;
     cJSON *simulation_json = NULL;
 
-    simulation = (ns_simulation_t *) malloc(sizeof(ns_simulation_t));
-    if (simulation == NULL) return ns_parse_simulation_error(simulation_json, simulation);
-
     simulation_json = cJSON_Parse(text);
-    if (simulation_json == NULL) return ns_parse_simulation_error(simulation_json, simulation);
+    if (simulation_json == NULL) return NULL;
 
-    // Check & Assign
-    if (!(ns_parse_simulation_check_and_assign_time_step(
-            cJSON_GetObjectItemCaseSensitive(simulation_json, "time_step"), &simulation->time_step)
-          && ns_parse_simulation_check_and_assign_ticks(
-            cJSON_GetObjectItemCaseSensitive(simulation_json, "ticks"), &simulation->ticks)
-          && ns_parse_simulation_check_and_assign_world(
-            cJSON_GetObjectItemCaseSensitive(simulation_json, "world"), &simulation->world)
-          && ns_parse_simulation_check_and_assign_fluid(
-            cJSON_GetObjectItemCaseSensitive(simulation_json, "fluid"), &simulation->fluid)
-          && ns_parse_simulation_check_and_assign_mods(
-            cJSON_GetObjectItemCaseSensitive(simulation_json, "mods"), simulation)
-    ))
-        return ns_parse_simulation_error(simulation_json, simulation);
+    simulation = ns_parse_simulation_json(simulation_json);
 
     cJSON_Delete(simulation_json);
     return simulation;
-
 }
 
 ns_simulations_t *ns_parse_simulations(const char *const text) {
@@ -64,26 +147,32 @@ ns_simulations_t *ns_parse_simulations(const char *const text) {
     cJSON *text_json = NULL;
     const cJSON *simulation_json = NULL;
     const cJSON *simulations_json = NULL;
+    const cJSON *sweeps_json = NULL;
 
-    simulations = (ns_simulations_t *) malloc(sizeof(ns_simulations_t));
+    simulations = (ns_simulations_t *) calloc(1, sizeof(ns_simulations_t));
     if (simulations == NULL) return ns_parse_simulations_error(text_json, simulations);
 
     text_json = cJSON_Parse(text);
     if (text_json == NULL) return ns_parse_simulations_error(text_json, simulations);
 
+    // Listed simulations, sweeps or both
     simulations_json = cJSON_GetObjectItemCaseSensitive(text_json, "simulations");
-    if (!cJSON_IsArray(simulations_json)) return ns_parse_simulations_error(text_json, simulations);
+    sweeps_json = cJSON_GetObjectItemCaseSensitive(text_json, "sweeps");
+    if (!((simulations_json == NULL || cJSON_IsArray(simulations_json))
+          && (sweeps_json == NULL || cJSON_IsArray(sweeps_json))
+          && (simulations_json != NULL || sweeps_json != NULL)
+    ))
+        return ns_parse_simulations_error(text_json, simulations);
 
     simulations->simulations_length = (uint64_t) cJSON_GetArraySize(simulations_json);
     simulations->simulations = (ns_simulation_t **) calloc(simulations->simulations_length,
                                                            sizeof(ns_simulation_t *));
-    if (simulations->simulations == NULL) return ns_parse_simulations_error(text_json, simulations);
+    if (simulations->simulations == NULL && simulations->simulations_length > 0)
+        return ns_parse_simulations_error(text_json, simulations);
 
     uint64_t index = 0;
     cJSON_ArrayForEach(simulation_json, simulations_json) {
-        char *simulation_text = cJSON_Print(simulation_json);
-        ns_simulation_t *simulation = ns_parse_simulation(simulation_text);
-        free(simulation_text);
+        ns_simulation_t *simulation = ns_parse_simulation_json(simulation_json);
 
         if (simulation == NULL)
             return ns_parse_simulations_error(text_json, simulations);
@@ -92,10 +181,209 @@ ns_simulations_t *ns_parse_simulations(const char *const text) {
         index += 1;
     }
 
+    if (!ns_parse_simulations_check_and_assign_sweeps(sweeps_json, simulations))
+        return ns_parse_simulations_error(text_json, simulations);
+
     cJSON_Delete(text_json);
     return simulations;
 }
 
+ns_simulations_t *ns_parse_simulations_stream(const char *const text, uint64_t length) {
+    if (text == NULL) return NULL;
+    ns_simulations_t *simulations = NULL;
+    ns_parse_stream_t *stream = NULL;
+
+    simulations = (ns_simulations_t *) calloc(1, sizeof(ns_simulations_t));
+    stream = (ns_parse_stream_t *) calloc(1, sizeof(ns_parse_stream_t));
+    if (simulations == NULL || stream == NULL) {
+        free(simulations);
+        free(stream);
+        return NULL;
+    }
+    simulations->stream = stream;
+    stream->text = text;
+    stream->length = length;
+
+    // The members of the top-level object are scanned while the simulations are parsed
+    ns_parse_stream_skip_whitespace(stream);
+    if (!ns_parse_stream_expect(stream, '{')) return ns_parse_simulations_error(NULL, simulations);
+
+    return simulations;
+}
+
+bool ns_parse_simulations_next(ns_simulations_t *simulations, uint64_t count) {
+    if (simulations == NULL) return false;
+    ns_parse_stream_t *const stream = simulations->stream;
+    const uint64_t simulations_length = simulations->simulations_length + count;
+
+    if (stream == NULL) return true;
+    while (!stream->complete && simulations->simulations_length < simulations_length) {
+        ns_parse_location_t location;
+
+        // Members of the object until the simulations array, then its simulations
+        if (!stream->listing) {
+            if (!ns_parse_stream_member(stream) || (stream->complete && !ns_parse_stream_complete(stream, simulations)))
+                return false;
+            continue;
+        }
+        if (!ns_parse_stream_element(stream, simulations->simulations_length == 0, &location)) return false;
+        if (!stream->listing) continue;
+
+        if (simulations->simulations_length == stream->locations_capacity) {
+            const uint64_t capacity = stream->locations_capacity > 0
+                                      ? 2 * stream->locations_capacity : NS_PARSE_STREAM_CAPACITY;
+            ns_parse_location_t *locations = (ns_parse_location_t *) realloc(
+                    stream->locations, capacity * sizeof(ns_parse_location_t));
+            if (locations == NULL) return false;
+
+            stream->locations = locations;
+            stream->locations_capacity = capacity;
+        }
+
+        // Checked once, kept as the last parsed simulation
+        ns_parse_simulation_free(stream->simulation);
+        stream->simulation = ns_parse_simulation_at(stream->text, stream->length, &location);
+        stream->simulation_id = simulations->simulations_length;
+        if (stream->simulation == NULL) return false;
+
+        stream->locations[simulations->simulations_length] = location;
+        simulations->simulations_length += 1;
+    }
+
+    return true;
+}
+
+bool ns_parse_simulations_complete(const ns_simulations_t *const simulations) {
+    return simulations->stream == NULL || simulations->stream->complete;
+}
+
+bool ns_parse_simulations_location(const ns_simulations_t *const simulations, uint64_t simulation_id,
+                                   ns_parse_location_t *location) {
+    const ns_parse_stream_t *const stream = simulations->stream;
+
+    if (stream == NULL) return false;
+    if (simulation_id < simulations->simulations_length) {
+        *location = stream->locations[simulation_id];
+        return true;
+    }
+
+    // The points of a sweep share its location
+    simulation_id -= simulations->simulations_length;
+    for (uint64_t i_s = 0; i_s < simulations->sweeps_length; ++i_s) {
+        if (simulation_id < simulations->sweeps[i_s]->points_length) {
+            *location = stream->sweep_locations[i_s];
+            location->point = simulation_id;
+            return true;
+        }
+        simulation_id -= simulations->sweeps[i_s]->points_length;
+    }
+
+    return false;
+}
+
+ns_simulation_t *ns_parse_simulation_at(const char *const text, uint64_t length,
+                                        const ns_parse_location_t *const location) {
+    if (text == NULL || location == NULL) return NULL;
+    ns_simulation_t *simulation = NULL;
+    ns_parse_sweep_t *sweep = NULL;
+    cJSON *simulation_json = NULL;
+
+    if (location->offset > length || location->length > length - location->offset) return NULL;
+
+    simulation_json = cJSON_ParseWithLength(text + location->offset, location->length);
+    if (simulation_json == NULL) return NULL;
+
+    if (!location->sweep) {
+        simulation = ns_parse_simulation_json(simulation_json);
+    } else {
+        // The point is the base of its sweep, with the values of the point
+        sweep = (ns_parse_sweep_t *) calloc(1, sizeof(ns_parse_sweep_t));
+        if (sweep != NULL && ns_parse_sweep_check_and_assign(simulation_json, sweep)
+            && location->point < sweep->points_length) {
+            simulation = sweep->base;
+            sweep->base = NULL;
+            ns_parse_sweep_assign(sweep, location->point, simulation);
+        }
+        ns_parse_sweep_free(sweep);
+    }
+
+    cJSON_Delete(simulation_json);
+    return simulation;
+}
+
+uint64_t ns_parse_simulations_length(const ns_simulations_t *const simulations) {
+    uint64_t length = simulations->simulations_length;
+
+    for (uint64_t i_s = 0; i_s < simulations->sweeps_length; ++i_s)
+        length += simulations->sweeps[i_s]->points_length;
+
+    return length;
+}
+
+bool ns_parse_simulations_at(const ns_simulations_t *const simulations, uint64_t simulation_id,
+                             ns_simulation_t *simulation) {
+    ns_parse_stream_t *const stream = simulations->stream;
+
+    if (simulation_id < simulations->simulations_length && stream == NULL) {
+        *simulation = *simulations->simulations[simulation_id];
+        return true;
+    }
+    if (simulation_id < simulations->simulations_length) {
+        if (stream->simulation == NULL || stream->simulation_id != simulation_id) {
+            ns_parse_simulation_free(stream->simulation);
+            stream->simulation = ns_parse_simulation_at(stream->text, stream->length,
+                                                        &stream->locations[simulation_id]);
+            stream->simulation_id = simulation_id;
+        }
+        if (stream->simulation == NULL) return false;
+
+        *simulation = *stream->simulation;
+        return true;
+    }
+
+    // The points of the sweeps follow the listed simulations
+    simulation_id -= simulations->simulations_length;
+    for (uint64_t i_s = 0; i_s < simulations->sweeps_length; ++i_s) {
+        const ns_parse_sweep_t *const sweep = simulations->sweeps[i_s];
+
+        if (simulation_id < sweep->points_length) {
+            *simulation = *sweep->base;
+            ns_parse_sweep_assign(sweep, simulation_id, simulation);
+            return true;
+        }
+        simulation_id -= sweep->points_length;
+    }
+
+    return false;
+}
+
+double ns_parse_sweep_value(const ns_parse_sweep_axis_t *const axis, uint64_t index) {
+    double fraction;
+
+    if (axis->values != NULL) return axis->values[index];
+
+    // Both ends are values of the range
+    if (index == 0) return axis->from;
+    if (index + 1 == axis->values_length) return axis->to;
+    fraction = (double) index / (double) (axis->values_length - 1);
+
+    return axis->logarithmic ? axis->from * pow(axis->to / axis->from, fraction)
+                             : axis->from + (axis->to - axis->from) * fraction;
+}
+
+void ns_parse_sweep_assign(const ns_parse_sweep_t *const sweep, uint64_t point, ns_simulation_t *simulation) {
+    // Mixed radix digits of the point, the last axis is the lowest one
+    for (uint64_t i_a = sweep->axes_length; i_a > 0; --i_a) {
+        const ns_parse_sweep_axis_t *const axis = sweep->axes[i_a - 1];
+
+        ns_parse_sweep_assign_value(axis->parameters, ns_parse_sweep_value(axis, point % axis->values_length),
+                                    simulation);
+        point /= axis->values_length;
+    }
+
+    ns_parse_sweep_assign_output(sweep, simulation);
+}
+
 void ns_parse_simulation_free(ns_simulation_t *simulation) {
     if (simulation != NULL && simulation->mods != NULL) {
         for (uint64_t i_m = 0; i_m < simulation->mods_length; ++i_m) {
@@ -135,6 +423,16 @@ void ns_parse_simulations_free(ns_simulations_t *simulations) {
         free(simulations->simulations);
     }
 
+    if (simulations != NULL && simulations->sweeps != NULL) {
+        for (uint64_t i_s = 0; i_s < simulations->sweeps_length; ++i_s) {
+            ns_parse_sweep_free(simulations->sweeps[i_s]);
+        }
+
+        free(simulations->sweeps);
+    }
+
+    if (simulations != NULL) ns_parse_stream_free(simulations->stream);
+
     free(simulations);
 }
 /**
@@ -144,6 +442,38 @@ void ns_parse_simulations_free(ns_simulations_t *simulations) {
 /**
  * Private
  */
+static ns_simulation_t *ns_parse_simulation_json(const cJSON *const simulation_json) {
+    ns_simulation_t *simulation = NULL;
+
+    simulation = (ns_simulation_t *) calloc(1, sizeof(ns_simulation_t));
+    if (simulation == NULL) return NULL;
+
+    // Check & Assign
+    if (!(ns_parse_simulation_check_and_assign_time_step(
+            cJSON_GetObjectItemCaseSensitive(simulation_json, "time_step"), &simulation->time_step)
+          && ns_parse_simulation_check_and_assign_ticks(
+            cJSON_GetObjectItemCaseSensitive(simulation_json, "ticks"), &simulation->ticks)
+          && ns_parse_simulation_check_and_assign_ranks(
+            cJSON_GetObjectItemCaseSensitive(simulation_json, "ranks"), &simulation->ranks)
+          && ns_parse_simulation_check_and_assign_world(
+            cJSON_GetObjectItemCaseSensitive(simulation_json, "world"), &simulation->world)
+          && ns_parse_simulation_check_and_assign_fluid(
+            cJSON_GetObjectItemCaseSensitive(simulation_json, "fluid"), &simulation->fluid)
+          && ns_parse_simulation_check_and_assign_solver(
+            cJSON_GetObjectItemCaseSensitive(simulation_json, "solver"), &simulation->solver)
+          && ns_parse_simulation_check_and_assign_boundaries(
+            cJSON_GetObjectItemCaseSensitive(simulation_json, "boundaries"), &simulation->boundaries)
+          && ns_parse_simulation_check_and_assign_output(
+            cJSON_GetObjectItemCaseSensitive(simulation_json, "output"), &simulation->world, &simulation->output)
+          && ns_parse_simulation_check_and_assign_mods(
+            cJSON_GetObjectItemCaseSensitive(simulation_json, "mods"), simulation)
+          && ns_parse_simulation_check_boundaries(simulation)
+    ))
+        return ns_parse_simulation_error(NULL, simulation);
+
+    return simulation;
+}
+
 static bool ns_parse_simulation_check_and_assign_time_step(const cJSON *const time_step_json, double *time_step) {
     if (time_step_json == NULL || time_step == NULL) return false;
 
@@ -166,6 +496,21 @@ static bool ns_parse_simulation_check_and_assign_ticks(const cJSON *const ticks_
     return true;
 }
 
+static bool ns_parse_simulation_check_and_assign_ranks(const cJSON *const ranks_json, uint64_t *ranks) {
+    if (ranks == NULL) return false;
+
+    // Optional, a single rank by default
+    *ranks = 1;
+    if (ranks_json == NULL) return true;
+
+    if (!(cJSON_IsNumber(ranks_json) && ranks_json->valueint > 0))
+        return false;
+
+    *ranks = (uint64_t) ranks_json->valueint;
+
+    return true;
+}
+
 static bool
 ns_parse_simulation_check_and_assign_world(const cJSON *const world_json, ns_parse_simulation_world_t *world) {
     if (world_json == NULL || world == NULL) return false;
@@ -212,6 +557,230 @@ ns_parse_simulation_check_and_assign_fluid(const cJSON *const fluid_json, ns_par
     return true;
 }
 
+static bool
+ns_parse_simulation_check_and_assign_solver(const cJSON *const solver_json, ns_solver_config_t *solver) {
+    if (solver == NULL) return false;
+
+    const cJSON *relaxation_json = NULL;
+    const cJSON *max_iterations_json = NULL;
+    const cJSON *tolerance_json = NULL;
+    const cJSON *check_every_json = NULL;
+    const cJSON *pressure_json = NULL;
+    const cJSON *multigrid_json = NULL;
+    int relaxation;
+    int pressure;
+
+    // Defaults
+    ns_solver_config_init(solver);
+
+    if (solver_json == NULL || cJSON_IsNull(solver_json)) return true;
+    if (!cJSON_IsObject(solver_json)) return false;
+
+    relaxation_json = cJSON_GetObjectItemCaseSensitive(solver_json, "relaxation");
+    if (relaxation_json != NULL) {
+        if (!cJSON_IsString(relaxation_json)) return false;
+
+        relaxation = ns_relaxation_int(relaxation_json->valuestring);
+        if (relaxation < 0) return false;
+
+        solver->relaxation = (ns_relaxation_t) relaxation;
+    }
+
+    max_iterations_json = cJSON_GetObjectItemCaseSensitive(solver_json, "max_iterations");
+    tolerance_json = cJSON_GetObjectItemCaseSensitive(solver_json, "tolerance");
+    check_every_json = cJSON_GetObjectItemCaseSensitive(solver_json, "check_every");
+    if (!((max_iterations_json == NULL || (cJSON_IsNumber(max_iterations_json) && max_iterations_json->valueint > 0))
+          && (tolerance_json == NULL || (cJSON_IsNumber(tolerance_json) && tolerance_json->valuedouble >= 0))
+          && (check_every_json == NULL || (cJSON_IsNumber(check_every_json) && check_every_json->valueint >= 0))
+    ))
+        return false;
+    if (max_iterations_json != NULL)
+        solver->max_iterations = (uint64_t) max_iterations_json->valueint;
+    if (tolerance_json != NULL)
+        solver->tolerance = tolerance_json->valuedouble;
+    if (check_every_json != NULL)
+        solver->check_every = (uint64_t) check_every_json->valueint;
+
+    pressure_json = cJSON_GetObjectItemCaseSensitive(solver_json, "pressure");
+    if (pressure_json != NULL) {
+        if (!cJSON_IsString(pressure_json)) return false;
+
+        pressure = ns_pressure_solver_int(pressure_json->valuestring);
+        if (pressure < 0) return false;
+
+        solver->pressure = (ns_pressure_solver_t) pressure;
+    }
+
+    multigrid_json = cJSON_GetObjectItemCaseSensitive(solver_json, "multigrid");
+    if (multigrid_json != NULL && !ns_parse_simulation_check_and_assign_multigrid(multigrid_json, &solver->multigrid))
+        return false;
+
+    return true;
+}
+
+static bool ns_parse_simulation_check_and_assign_multigrid(const cJSON *const multigrid_json,
+                                                           ns_solver_multigrid_config_t *multigrid) {
+    if (multigrid_json == NULL || multigrid == NULL) return false;
+    if (!cJSON_IsObject(multigrid_json)) return false;
+
+    const cJSON *cycle_json = NULL;
+    const cJSON *tolerance_json = NULL;
+    const cJSON *max_cycles_json = NULL;
+    int cycle;
+
+    cycle_json = cJSON_GetObjectItemCaseSensitive(multigrid_json, "cycle");
+    tolerance_json = cJSON_GetObjectItemCaseSensitive(multigrid_json, "tolerance");
+    max_cycles_json = cJSON_GetObjectItemCaseSensitive(multigrid_json, "max_cycles");
+
+    if (!((cycle_json == NULL || cJSON_IsString(cycle_json))
+          && (tolerance_json == NULL || (cJSON_IsNumber(tolerance_json) && tolerance_json->valuedouble > 0))
+          && (max_cycles_json == NULL || (cJSON_IsNumber(max_cycles_json) && max_cycles_json->valueint > 0))
+    ))
+        return false;
+
+    if (cycle_json != NULL) {
+        cycle = ns_multigrid_cycle_int(cycle_json->valuestring);
+        if (cycle < 0) return false;
+
+        multigrid->cycle = (ns_multigrid_cycle_t) cycle;
+    }
+    if (tolerance_json != NULL)
+        multigrid->tolerance = tolerance_json->valuedouble;
+    if (max_cycles_json != NULL)
+        multigrid->max_cycles = (uint64_t) max_cycles_json->valueint;
+
+    return true;
+}
+
+static bool ns_parse_simulation_check_and_assign_boundaries(const cJSON *const boundaries_json,
+                                                            ns_boundaries_t *boundaries) {
+    if (boundaries == NULL) return false;
+
+    // Defaults
+    ns_boundaries_init(boundaries);
+
+    if (boundaries_json == NULL || cJSON_IsNull(boundaries_json)) return true;
+    if (!cJSON_IsObject(boundaries_json)) return false;
+
+    for (int edge = NS_BOUNDARY_EDGE_LEFT; edge <= NS_BOUNDARY_EDGE_BOTTOM; ++edge) {
+        const cJSON *boundary_json = cJSON_GetObjectItemCaseSensitive(
+                boundaries_json, ns_boundary_edge_string((ns_boundary_edge_t) edge));
+
+        if (boundary_json != NULL
+            && !ns_parse_simulation_check_and_assign_boundary(boundary_json, &boundaries->edges[edge]))
+            return false;
+    }
+
+    return ns_boundaries_check(boundaries);
+}
+
+static bool ns_parse_simulation_check_and_assign_boundary(const cJSON *const boundary_json, ns_boundary_t *boundary) {
+    if (boundary_json == NULL || boundary == NULL) return false;
+
+    const cJSON *type_json = NULL;
+    const cJSON *u_json = NULL;
+    const cJSON *v_json = NULL;
+    const cJSON *density_json = NULL;
+    int type;
+
+    // Either the type name or an object with the type and the inflow values
+    type_json = cJSON_IsString(boundary_json)
+                ? boundary_json : cJSON_GetObjectItemCaseSensitive(boundary_json, "type");
+    if (!cJSON_IsString(type_json)) return false;
+
+    type = ns_boundary_type_int(type_json->valuestring);
+    if (type < 0) return false;
+    boundary->type = (ns_boundary_type_t) type;
+
+    if (!cJSON_IsObject(boundary_json)) return true;
+
+    u_json = cJSON_GetObjectItemCaseSensitive(boundary_json, "u");
+    v_json = cJSON_GetObjectItemCaseSensitive(boundary_json, "v");
+    density_json = cJSON_GetObjectItemCaseSensitive(boundary_json, "density");
+
+    if (!((u_json == NULL || cJSON_IsNumber(u_json))
+          && (v_json == NULL || cJSON_IsNumber(v_json))
+          && (density_json == NULL || (cJSON_IsNumber(density_json) && density_json->valuedouble >= 0))
+    ))
+        return false;
+
+    if (u_json != NULL)
+        boundary->u = u_json->valuedouble;
+    if (v_json != NULL)
+        boundary->v = v_json->valuedouble;
+    if (density_json != NULL)
+        boundary->density = density_json->valuedouble;
+
+    return true;
+}
+
+static bool ns_parse_simulation_check_and_assign_output(const cJSON *const output_json,
+                                                        const ns_parse_simulation_world_t *const world,
+                                                        snapshot_output_t *output) {
+    if (world == NULL || output == NULL) return false;
+
+    const cJSON *every_json = NULL;
+    const cJSON *region_json = NULL;
+    const cJSON *fields_json = NULL;
+    const cJSON *field_json = NULL;
+    const cJSON *downsample_json = NULL;
+
+    // Defaults
+    snapshot_output_init(output, world->width + 2, world->height + 2);
+
+    if (output_json == NULL || cJSON_IsNull(output_json)) return true;
+    if (!cJSON_IsObject(output_json)) return false;
+
+    every_json = cJSON_GetObjectItemCaseSensitive(output_json, "every");
+    downsample_json = cJSON_GetObjectItemCaseSensitive(output_json, "downsample");
+    if (!((every_json == NULL || (cJSON_IsNumber(every_json) && every_json->valueint > 0))
+          && (downsample_json == NULL || (cJSON_IsNumber(downsample_json) && downsample_json->valueint > 0))
+    ))
+        return false;
+    if (every_json != NULL)
+        output->every = (uint64_t) every_json->valueint;
+    if (downsample_json != NULL)
+        output->downsample = (uint64_t) downsample_json->valueint;
+
+    // Region of interest, in cells of the world with the global boundary
+    region_json = cJSON_GetObjectItemCaseSensitive(output_json, "region");
+    if (region_json != NULL) {
+        const cJSON *x_json = cJSON_GetObjectItemCaseSensitive(region_json, "x");
+        const cJSON *y_json = cJSON_GetObjectItemCaseSensitive(region_json, "y");
+        const cJSON *width_json = cJSON_GetObjectItemCaseSensitive(region_json, "width");
+        const cJSON *height_json = cJSON_GetObjectItemCaseSensitive(region_json, "height");
+
+        if (!(cJSON_IsNumber(x_json) && x_json->valueint >= 0
+              && cJSON_IsNumber(y_json) && y_json->valueint >= 0
+              && cJSON_IsNumber(width_json) && width_json->valueint > 0
+              && cJSON_IsNumber(height_json) && height_json->valueint > 0
+        ))
+            return false;
+
+        output->x = (uint64_t) x_json->valueint;
+        output->y = (uint64_t) y_json->valueint;
+        output->width = (uint64_t) width_json->valueint;
+        output->height = (uint64_t) height_json->valueint;
+    }
+
+    fields_json = cJSON_GetObjectItemCaseSensitive(output_json, "fields");
+    if (fields_json != NULL) {
+        if (!cJSON_IsArray(fields_json)) return false;
+
+        output->fields = 0;
+        cJSON_ArrayForEach(field_json, fields_json) {
+            if (!cJSON_IsString(field_json)) return false;
+
+            const unsigned int field = snapshot_field_int(field_json->valuestring);
+            if (field == 0) return false;
+
+            output->fields |= field;
+        }
+    }
+
+    return snapshot_output_check(output, world->width + 2, world->height + 2);
+}
+
 static bool ns_parse_simulation_check_and_assign_mod(const cJSON *const mod_json, ns_parse_simulation_mod_t *mod) {
     if (mod_json == NULL || mod == NULL) return false;
 
@@ -347,6 +916,459 @@ static bool ns_parse_simulation_check_and_assign_mods(const cJSON *const mods_js
     return true;
 }
 
+static bool ns_parse_simulations_check_and_assign_sweeps(const cJSON *const sweeps_json,
+                                                         ns_simulations_t *simulations) {
+    if (simulations == NULL) return false;
+    if (sweeps_json == NULL) return true;
+
+    const cJSON *sweep_json = NULL;
+    uint64_t length = simulations->simulations_length;
+
+    simulations->sweeps_length = (uint64_t) cJSON_GetArraySize(sweeps_json);
+    simulations->sweeps = (ns_parse_sweep_t **) calloc(simulations->sweeps_length, sizeof(ns_parse_sweep_t *));
+    if (simulations->sweeps == NULL && simulations->sweeps_length > 0) return false;
+
+    uint64_t index = 0;
+    cJSON_ArrayForEach(sweep_json, sweeps_json) {
+        ns_parse_sweep_t *sweep = NULL;
+
+        sweep = (ns_parse_sweep_t *) calloc(1, sizeof(ns_parse_sweep_t));
+        if (sweep == NULL) return false;
+
+        simulations->sweeps[index] = sweep;
+        index += 1;
+
+        if (!ns_parse_sweep_check_and_assign(sweep_json, sweep)) return false;
+
+        // Every point has an id
+        if (sweep->points_length > UINT64_MAX - length) return false;
+        length += sweep->points_length;
+    }
+
+    return true;
+}
+
+static bool ns_parse_sweep_check_and_assign(const cJSON *const sweep_json, ns_parse_sweep_t *sweep) {
+    if (sweep_json == NULL || sweep == NULL) return false;
+
+    const cJSON *base_json = NULL;
+    const cJSON *axes_json = NULL;
+    const cJSON *axis_json = NULL;
+    const cJSON *output_json = NULL;
+    unsigned int parameters = 0;
+
+    base_json = cJSON_GetObjectItemCaseSensitive(sweep_json, "base");
+    axes_json = cJSON_GetObjectItemCaseSensitive(sweep_json, "axes");
+    if (!(cJSON_IsObject(base_json) && cJSON_IsArray(axes_json) && cJSON_GetArraySize(axes_json) > 0))
+        return false;
+
+    // The base is parsed as a listed simulation
+    sweep->base = ns_parse_simulation_json(base_json);
+    if (sweep->base == NULL) return false;
+
+    output_json = cJSON_GetObjectItemCaseSensitive(base_json, "output");
+    sweep->region = cJSON_IsObject(output_json) && cJSON_GetObjectItemCaseSensitive(output_json, "region") != NULL;
+
+    sweep->axes_length = (uint64_t) cJSON_GetArraySize(axes_json);
+    sweep->axes = (ns_parse_sweep_axis_t **) calloc(sweep->axes_length, sizeof(ns_parse_sweep_axis_t *));
+    if (sweep->axes == NULL) return false;
+
+    sweep->points_length = 1;
+    uint64_t index = 0;
+    cJSON_ArrayForEach(axis_json, axes_json) {
+        ns_parse_sweep_axis_t *axis = NULL;
+
+        axis = (ns_parse_sweep_axis_t *) calloc(1, sizeof(ns_parse_sweep_axis_t));
+        if (axis == NULL) return false;
+
+        sweep->axes[index] = axis;
+        index += 1;
+
+        // A parameter is set by a single axis
+        if (!ns_parse_sweep_check_and_assign_axis(axis_json, axis) || (axis->parameters & parameters) != 0)
+            return false;
+        parameters |= axis->parameters;
+
+        if (axis->values_length > UINT64_MAX / sweep->points_length) return false;
+        sweep->points_length *= axis->values_length;
+    }
+
+    return ns_parse_sweep_check(sweep);
+}
+
+static bool ns_parse_sweep_check_and_assign_axis(const cJSON *const axis_json, ns_parse_sweep_axis_t *axis) {
+    if (axis_json == NULL || axis == NULL) return false;
+    if (!cJSON_IsObject(axis_json)) return false;
+
+    const cJSON *values_json = NULL;
+    const cJSON *range_json = NULL;
+    const cJSON *from_json = NULL;
+    const cJSON *to_json = NULL;
+    const cJSON *count_json = NULL;
+    const cJSON *scale_json = NULL;
+
+    if (!ns_parse_sweep_check_and_assign_parameters(cJSON_GetObjectItemCaseSensitive(axis_json, "parameter"),
+                                                    &axis->parameters))
+        return false;
+
+    // Either the listed values or a range
+    values_json = cJSON_GetObjectItemCaseSensitive(axis_json, "values");
+    range_json = cJSON_GetObjectItemCaseSensitive(axis_json, "range");
+    if (values_json != NULL && range_json == NULL) {
+        const cJSON *value_json = NULL;
+
+        if (!(cJSON_IsArray(values_json) && cJSON_GetArraySize(values_json) > 0)) return false;
+
+        axis->values_length = (uint64_t) cJSON_GetArraySize(values_json);
+        axis->values = (double *) calloc(axis->values_length, sizeof(double));
+        if (axis->values == NULL) return false;
+
+        uint64_t index = 0;
+        cJSON_ArrayForEach(value_json, values_json) {
+            if (!cJSON_IsNumber(value_json)) return false;
+
+            axis->values[index] = value_json->valuedouble;
+            index += 1;
+        }
+
+        return true;
+    }
+    if (!(values_json == NULL && cJSON_IsObject(range_json))) return false;
+
+    from_json = cJSON_GetObjectItemCaseSensitive(range_json, "from");
+    to_json = cJSON_GetObjectItemCaseSensitive(range_json, "to");
+    count_json = cJSON_GetObjectItemCaseSensitive(range_json, "count");
+    scale_json = cJSON_GetObjectItemCaseSensitive(range_json, "scale");
+    if (!(cJSON_IsNumber(from_json) && cJSON_IsNumber(to_json)
+          && cJSON_IsNumber(count_json) && count_json->valueint > 0
+          && (scale_json == NULL || cJSON_IsString(scale_json))
+    ))
+        return false;
+
+    axis->from = from_json->valuedouble;
+    axis->to = to_json->valuedouble;
+    axis->values_length = (uint64_t) count_json->valueint;
+    if (scale_json != NULL) {
+        if (strcmp(scale_json->valuestring, "log") == 0) axis->logarithmic = true;
+        else if (strcmp(scale_json->valuestring, "linear") != 0) return false;
+    }
+
+    // A constant ratio between positive ends
+    return !axis->logarithmic || (axis->from > 0 && axis->to > 0);
+}
+
+static bool ns_parse_sweep_check_and_assign_parameters(const cJSON *const parameters_json,
+                                                       unsigned int *parameters) {
+    if (parameters_json == NULL || parameters == NULL) return false;
+
+    const cJSON *parameter_json = NULL;
+
+    // Either a parameter name or an array of names, set to the same values
+    if (cJSON_IsString(parameters_json)) {
+        *parameters = ns_parse_sweep_parameter(parameters_json);
+        return *parameters != 0;
+    }
+    if (!cJSON_IsArray(parameters_json)) return false;
+
+    *parameters = 0;
+    cJSON_ArrayForEach(parameter_json, parameters_json) {
+        const unsigned int parameter = ns_parse_sweep_parameter(parameter_json);
+        if (parameter == 0) return false;
+
+        *parameters |= parameter;
+    }
+
+    return *parameters != 0;
+}
+
+static unsigned int ns_parse_sweep_parameter(const cJSON *const parameter_json) {
+    if (!cJSON_IsString(parameter_json)) return 0;
+
+    for (unsigned int i = 0; i < NS_PARSE_SWEEP_PARAMETERS; ++i) {
+        if (strcmp(parameter_json->valuestring, sweep_parameter_strings[i]) == 0) return 1u << i;
+    }
+
+    return 0;
+}
+
+static bool ns_parse_sweep_check(const ns_parse_sweep_t *const sweep) {
+    // A parameter is set by a single axis and checked on its own, every value of every axis covers every point
+    for (uint64_t i_a = 0; i_a < sweep->axes_length; ++i_a) {
+        const ns_parse_sweep_axis_t *const axis = sweep->axes[i_a];
+
+        for (uint64_t i_v = 0; i_v < axis->values_length; ++i_v) {
+            ns_simulation_t simulation = *sweep->base;
+
+            ns_parse_sweep_assign_value(axis->parameters, ns_parse_sweep_value(axis, i_v), &simulation);
+            ns_parse_sweep_assign_output(sweep, &simulation);
+            if (!ns_parse_simulation_check(&simulation)) return false;
+        }
+    }
+
+    return true;
+}
+
+static bool ns_parse_simulation_check(const ns_simulation_t *const simulation) {
+    return simulation->time_step > 0 && simulation->ticks > 0 && simulation->ranks > 0
+           && simulation->world.width > 0 && simulation->world.height > 0
+           && simulation->fluid.viscosity > 0 && simulation->fluid.density > 0 && simulation->fluid.diffusion > 0
+           && simulation->solver.max_iterations > 0 && simulation->solver.tolerance >= 0
+           && snapshot_output_check(&simulation->output, simulation->world.width + 2, simulation->world.height + 2)
+           && ns_parse_simulation_check_boundaries(simulation);
+}
+
+static bool ns_parse_simulation_check_boundaries(const ns_simulation_t *const simulation) {
+    // The multigrid pressure solver has closed boundaries and the tiles of a decomposed world do not wrap around
+    return !((simulation->solver.pressure == NS_PRESSURE_SOLVER_MULTIGRID || simulation->ranks > 1)
+             && ns_boundaries_periodic(&simulation->boundaries));
+}
+
+static void ns_parse_sweep_assign_value(unsigned int parameters, double value, ns_simulation_t *simulation) {
+    const uint64_t integer = ns_parse_sweep_integer(value);
+
+    if (parameters & NS_PARSE_SWEEP_TIME_STEP) simulation->time_step = value;
+    if (parameters & NS_PARSE_SWEEP_TICKS) simulation->ticks = integer;
+    if (parameters & NS_PARSE_SWEEP_RANKS) simulation->ranks = integer;
+    if (parameters & NS_PARSE_SWEEP_WORLD_WIDTH) simulation->world.width = integer;
+    if (parameters & NS_PARSE_SWEEP_WORLD_HEIGHT) simulation->world.height = integer;
+    if (parameters & NS_PARSE_SWEEP_FLUID_VISCOSITY) simulation->fluid.viscosity = value;
+    if (parameters & NS_PARSE_SWEEP_FLUID_DENSITY) simulation->fluid.density = value;
+    if (parameters & NS_PARSE_SWEEP_FLUID_DIFFUSION) simulation->fluid.diffusion = value;
+    if (parameters & NS_PARSE_SWEEP_SOLVER_MAX_ITERATIONS) simulation->solver.max_iterations = integer;
+    if (parameters & NS_PARSE_SWEEP_SOLVER_TOLERANCE) simulation->solver.tolerance = value;
+}
+
+static void ns_parse_sweep_assign_output(const ns_parse_sweep_t *const sweep, ns_simulation_t *simulation) {
+    // The default region is the whole world of the point
+    if (sweep->region) return;
+
+    simulation->output.x = 0;
+    simulation->output.y = 0;
+    simulation->output.width = simulation->world.width + 2;
+    simulation->output.height = simulation->world.height + 2;
+}
+
+static uint64_t ns_parse_sweep_integer(double value) {
+    // Nearest integer, 0 is never valid
+    return value >= 0.5 && value < 0x1p63 ? (uint64_t) llround(value) : 0;
+}
+
+static void ns_parse_sweep_free(ns_parse_sweep_t *sweep) {
+    if (sweep == NULL) return;
+
+    if (sweep->axes != NULL) {
+        for (uint64_t i_a = 0; i_a < sweep->axes_length; ++i_a) {
+            if (sweep->axes[i_a] != NULL) free(sweep->axes[i_a]->values);
+            free(sweep->axes[i_a]);
+        }
+
+        free(sweep->axes);
+    }
+
+    ns_parse_simulation_free(sweep->base);
+    free(sweep);
+}
+
+static bool ns_parse_stream_member(ns_parse_stream_t *stream) {
+    uint64_t name;
+    uint64_t name_length;
+
+    // End of the object, only whitespace may follow
+    ns_parse_stream_skip_whitespace(stream);
+    if (ns_parse_stream_expect(stream, '}')) {
+        ns_parse_stream_skip_whitespace(stream);
+        stream->complete = true;
+        return stream->offset == stream->length && (stream->listed || stream->swept);
+    }
+    if (stream->members_length > 0) {
+        if (!ns_parse_stream_expect(stream, ',')) return false;
+        ns_parse_stream_skip_whitespace(stream);
+    }
+    stream->members_length += 1;
+
+    // Name, the quotes excluded
+    name = stream->offset + 1;
+    if (stream->offset >= stream->length || stream->text[stream->offset] != '"'
+        || !ns_parse_stream_skip_string(stream))
+        return false;
+    name_length = stream->offset - 1 - name;
+    ns_parse_stream_skip_whitespace(stream);
+    if (!ns_parse_stream_expect(stream, ':')) return false;
+    ns_parse_stream_skip_whitespace(stream);
+
+    // The first simulations and sweeps arrays count, as in a text parsed at once
+    if (!stream->listed && name_length == strlen("simulations")
+        && strncmp(stream->text + name, "simulations", name_length) == 0)
+        return ns_parse_stream_listed(stream);
+    if (!stream->swept && name_length == strlen("sweeps") && strncmp(stream->text + name, "sweeps", name_length) == 0)
+        return ns_parse_stream_sweeps(stream);
+
+    return ns_parse_stream_skip_value(stream);
+}
+
+static bool ns_parse_stream_listed(ns_parse_stream_t *stream) {
+    // Listed simulations are parsed as they are needed
+    if (!ns_parse_stream_expect(stream, '[')) return false;
+
+    stream->listing = true;
+    stream->listed = true;
+    return true;
+}
+
+static bool ns_parse_stream_sweeps(ns_parse_stream_t *stream) {
+    ns_parse_location_t location;
+
+    // Sweeps are small, parsed at once and kept
+    if (!ns_parse_stream_expect(stream, '[')) return false;
+    stream->swept = true;
+    stream->listing = true;
+    while (true) {
+        ns_parse_sweep_t *sweep = NULL;
+        cJSON *sweep_json = NULL;
+
+        if (!ns_parse_stream_element(stream, stream->sweeps_length == 0, &location)) return false;
+        if (!stream->listing) return true;
+
+        if (stream->sweeps_length == stream->sweeps_capacity) {
+            const uint64_t capacity = stream->sweeps_capacity > 0 ? 2 * stream->sweeps_capacity : 1;
+            ns_parse_sweep_t **sweeps = (ns_parse_sweep_t **) realloc(stream->sweeps,
+                                                                      capacity * sizeof(ns_parse_sweep_t *));
+            if (sweeps != NULL) stream->sweeps = sweeps;
+            ns_parse_location_t *locations = (ns_parse_location_t *) realloc(
+                    stream->sweep_locations, capacity * sizeof(ns_parse_location_t));
+            if (locations != NULL) stream->sweep_locations = locations;
+            if (sweeps == NULL || locations == NULL) return false;
+
+            stream->sweeps_capacity = capacity;
+        }
+
+        sweep_json = cJSON_ParseWithLength(stream->text + location.offset, location.length);
+        sweep = (ns_parse_sweep_t *) calloc(1, sizeof(ns_parse_sweep_t));
+        stream->sweeps[stream->sweeps_length] = sweep;
+        location.sweep = true;
+        stream->sweep_locations[stream->sweeps_length] = location;
+        stream->sweeps_length += 1;
+
+        if (sweep == NULL || sweep_json == NULL || !ns_parse_sweep_check_and_assign(sweep_json, sweep)) {
+            cJSON_Delete(sweep_json);
+            return false;
+        }
+        cJSON_Delete(sweep_json);
+    }
+}
+
+static bool ns_parse_stream_complete(ns_parse_stream_t *stream, ns_simulations_t *simulations) {
+    uint64_t length = simulations->simulations_length;
+
+    // The points of the sweeps follow the listed simulations
+    for (uint64_t i_s = 0; i_s < stream->sweeps_length; ++i_s) {
+        if (stream->sweeps[i_s]->points_length > UINT64_MAX - length) return false;
+        length += stream->sweeps[i_s]->points_length;
+    }
+
+    simulations->sweeps = stream->sweeps;
+    simulations->sweeps_length = stream->sweeps_length;
+    stream->sweeps = NULL;
+    return true;
+}
+
+static bool ns_parse_stream_element(ns_parse_stream_t *stream, bool first, ns_parse_location_t *location) {
+    // End of the array, or the next element after a comma
+    ns_parse_stream_skip_whitespace(stream);
+    if (first && ns_parse_stream_expect(stream, ']')) {
+        stream->listing = false;
+        return true;
+    }
+    if (!first) {
+        if (ns_parse_stream_expect(stream, ']')) {
+            stream->listing = false;
+            return true;
+        }
+        if (!ns_parse_stream_expect(stream, ',')) return false;
+        ns_parse_stream_skip_whitespace(stream);
+    }
+
+    *location = (ns_parse_location_t) {.offset = stream->offset, .sweep = false};
+    if (!ns_parse_stream_skip_value(stream)) return false;
+    location->length = stream->offset - location->offset;
+
+    return true;
+}
+
+static void ns_parse_stream_skip_whitespace(ns_parse_stream_t *stream) {
+    while (stream->offset < stream->length
+           && (stream->text[stream->offset] == ' ' || stream->text[stream->offset] == '\t'
+               || stream->text[stream->offset] == '\n' || stream->text[stream->offset] == '\r'))
+        stream->offset += 1;
+}
+
+static bool ns_parse_stream_skip_string(ns_parse_stream_t *stream) {
+    // Opening quote, then up to the closing one, escaped characters skipped
+    for (stream->offset += 1; stream->offset < stream->length; ++stream->offset) {
+        if (stream->text[stream->offset] == '\\') stream->offset += 1;
+        else if (stream->text[stream->offset] == '"') {
+            stream->offset += 1;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool ns_parse_stream_skip_value(ns_parse_stream_t *stream) {
+    const uint64_t start = stream->offset;
+    uint64_t depth = 0;
+
+    if (stream->offset >= stream->length) return false;
+
+    // Objects and arrays up to their closing bracket, the brackets in strings excluded
+    while (stream->offset < stream->length) {
+        const char character = stream->text[stream->offset];
+
+        if (character == '"') {
+            if (!ns_parse_stream_skip_string(stream)) return false;
+            if (depth == 0) return true;
+            continue;
+        }
+        if (character == '{' || character == '[') {
+            depth += 1;
+        } else if (character == '}' || character == ']') {
+            if (depth == 0) break;
+            depth -= 1;
+            if (depth == 0) {
+                stream->offset += 1;
+                return true;
+            }
+        } else if (depth == 0 && (character == ',' || character == ' ' || character == '\t'
+                                  || character == '\n' || character == '\r')) {
+            break;
+        }
+        stream->offset += 1;
+    }
+
+    // A number or a literal ends at the next separator
+    return depth == 0 && stream->offset > start;
+}
+
+static bool ns_parse_stream_expect(ns_parse_stream_t *stream, char character) {
+    if (stream->offset >= stream->length || stream->text[stream->offset] != character) return false;
+
+    stream->offset += 1;
+    return true;
+}
+
+static void ns_parse_stream_free(ns_parse_stream_t *stream) {
+    if (stream == NULL) return;
+
+    for (uint64_t i_s = 0; stream->sweeps != NULL && i_s < stream->sweeps_length; ++i_s)
+        ns_parse_sweep_free(stream->sweeps[i_s]);
+    free(stream->sweeps);
+    free(stream->sweep_locations);
+    free(stream->locations);
+    ns_parse_simulation_free(stream->simulation);
+    free(stream);
+}
+
 static void *ns_parse_simulation_error(cJSON *file_json, ns_simulation_t *simulation) {
     cJSON_Delete(file_json);
     ns_parse_simulation_free(simulation);
@@ -0,0 +1,819 @@
+#include "ns/utils/snapshot.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <mpi.h>
+#include "ns/utils/compress.h"
+
+// Number of uint64_t fields of the header, after the magic
+#define SNAPSHOT_HEADER_FIELDS 9
+// Number of uint64_t fields of a snapshot record, before the planes
+#define SNAPSHOT_RECORD_FIELDS 3
+// Initial capacity of the snapshot offsets index
+#define SNAPSHOT_INDEX_CAPACITY 64
+// Initial capacity in bytes of a snapshot writer to memory
+#define SNAPSHOT_MEMORY_CAPACITY (1024 * 1024)
+// Largest quantized value of the lossy compression
+#define SNAPSHOT_QUANTIZED_MAX 4611686018427387904.0
+
+static const char *format_strings[] = {"json", "binary"};
+static const char *format_extensions[] = {"json", "bin"};
+static const char *compression_strings[] = {"none", "lossless", "lossy"};
+// Names of the fields, in the order of the SNAPSHOT_FIELD_* bits
+static const char *field_strings[] = {"u", "v", "d"};
+#define SNAPSHOT_FIELDS_LENGTH (sizeof(field_strings) / sizeof(field_strings[0]))
+
+// Compression state of the saved planes of a file
+typedef struct snapshot_codec_t {
+    snapshot_layout_t layout;
+    // Values of a plane
+    uint64_t plane;
+    // Previous snapshot of every saved field, raw values (lossless) or quantized values (lossy)
+    uint8_t *previous;
+    // Buffers of the compression stages, a plane each
+    uint8_t *values;
+    uint8_t *shuffled;
+    uint8_t *compressed;
+} snapshot_codec_t;
+
+struct snapshot_writer_t {
+    // File, MPI_FILE_NULL if written to memory
+    MPI_File fh;
+    // Content written to memory
+    uint8_t *memory;
+    uint64_t memory_capacity;
+    snapshot_codec_t codec;
+    // Bytes written so far
+    uint64_t offset;
+    // Packed planes of a snapshot
+    ns_real_t *planes;
+    // Offset of every written snapshot
+    uint64_t *index;
+    uint64_t index_length;
+    uint64_t index_capacity;
+};
+
+struct snapshot_reader_t {
+    MPI_File fh;
+    snapshot_codec_t codec;
+    char *metadata;
+    // Snapshots compressed without the previous one every keyframe_interval
+    uint64_t keyframe_interval;
+    // Bytes read so far and offset of the end of the snapshots
+    uint64_t offset;
+    uint64_t end;
+    // Snapshots read so far
+    uint64_t snapshots;
+    // Packed planes of a snapshot
+    ns_real_t *planes;
+};
+
+/**
+ * Private definitions
+ */
+static void reduce_plane(const snapshot_output_t *output, const ns_world_t *world, const ns_real_t *plane,
+                         ns_real_t *reduced_plane);
+
+static const ns_real_t *world_plane(const ns_world_t *world, unsigned int field);
+
+static uint64_t layout_fields(const snapshot_layout_t *layout);
+
+static bool codec_init(snapshot_codec_t *codec, const snapshot_layout_t *layout);
+
+static bool codec_encode(snapshot_codec_t *codec, uint64_t field, const ns_real_t *plane, bool keyframe,
+                         uint64_t *length, char *error);
+
+static bool codec_decode(snapshot_codec_t *codec, uint64_t field, uint64_t length, bool keyframe, ns_real_t *plane,
+                         char *error);
+
+static void codec_free(snapshot_codec_t *codec);
+
+static bool write_values(MPI_File fh, uint64_t *offset, const void *values, uint64_t count, MPI_Datatype datatype,
+                         size_t value_size, char *error);
+
+static bool read_values(MPI_File fh, uint64_t *offset, void *values, uint64_t count, MPI_Datatype datatype,
+                        size_t value_size, char *error);
+
+static bool write_writer(snapshot_writer_t *writer, const void *values, uint64_t count, MPI_Datatype datatype,
+                         size_t value_size, char *error);
+
+static bool write_index(snapshot_writer_t *writer, char *error);
+
+static void free_writer(snapshot_writer_t *writer);
+/**
+ * END Private definitions
+ */
+
+/**
+ * Public
+ */
+const char *snapshot_format_string(snapshot_format_t format) {
+    if (format < SNAPSHOT_FORMAT_JSON || format > SNAPSHOT_FORMAT_BINARY) return NULL;
+
+    return format_strings[format];
+}
+
+int snapshot_format_int(const char *const format) {
+    if (format == NULL) return -1;
+
+    for (int i = SNAPSHOT_FORMAT_JSON; i <= SNAPSHOT_FORMAT_BINARY; ++i) {
+        if (strcmp(format, format_strings[i]) == 0) return i;
+    }
+
+    return -1;
+}
+
+const char *snapshot_format_extension(snapshot_format_t format) {
+    if (format < SNAPSHOT_FORMAT_JSON || format > SNAPSHOT_FORMAT_BINARY) return NULL;
+
+    return format_extensions[format];
+}
+
+const char *snapshot_compression_string(snapshot_compression_t compression) {
+    if (compression < SNAPSHOT_COMPRESSION_NONE || compression > SNAPSHOT_COMPRESSION_LOSSY) return NULL;
+
+    return compression_strings[compression];
+}
+
+int snapshot_compression_int(const char *const compression) {
+    if (compression == NULL) return -1;
+
+    for (int i = SNAPSHOT_COMPRESSION_NONE; i <= SNAPSHOT_COMPRESSION_LOSSY; ++i) {
+        if (strcmp(compression, compression_strings[i]) == 0) return i;
+    }
+
+    return -1;
+}
+
+const char *snapshot_field_string(unsigned int field) {
+    for (unsigned int i = 0; i < SNAPSHOT_FIELDS_LENGTH; ++i) {
+        if (field == 1u << i) return field_strings[i];
+    }
+
+    return NULL;
+}
+
+unsigned int snapshot_field_int(const char *const field) {
+    if (field == NULL) return 0;
+
+    for (unsigned int i = 0; i < SNAPSHOT_FIELDS_LENGTH; ++i) {
+        if (strcmp(field, field_strings[i]) == 0) return 1u << i;
+    }
+
+    return 0;
+}
+
+void snapshot_output_init(snapshot_output_t *output, uint64_t world_width_bounds, uint64_t world_height_bounds) {
+    output->every = 1;
+    output->x = 0;
+    output->y = 0;
+    output->width = world_width_bounds;
+    output->height = world_height_bounds;
+    output->fields = SNAPSHOT_FIELDS;
+    output->downsample = 1;
+}
+
+bool snapshot_output_check(const snapshot_output_t *const output, uint64_t world_width_bounds,
+                           uint64_t world_height_bounds) {
+    return output->every > 0 && output->downsample > 0
+           && output->fields != 0 && (output->fields & ~SNAPSHOT_FIELDS) == 0
+           && output->width > 0 && output->x < world_width_bounds && output->width <= world_width_bounds - output->x
+           && output->height > 0 && output->y < world_height_bounds
+           && output->height <= world_height_bounds - output->y;
+}
+
+uint64_t snapshot_output_width(const snapshot_output_t *const output) {
+    return (output->width + output->downsample - 1) / output->downsample;
+}
+
+uint64_t snapshot_output_height(const snapshot_output_t *const output) {
+    return (output->height + output->downsample - 1) / output->downsample;
+}
+
+uint64_t snapshot_output_size(const snapshot_output_t *const output) {
+    uint64_t fields = 0;
+
+    for (unsigned int i = 0; i < SNAPSHOT_FIELDS_LENGTH; ++i) {
+        if (output->fields & (1u << i)) fields += 1;
+    }
+
+    return fields * snapshot_output_width(output) * snapshot_output_height(output);
+}
+
+void snapshot_output_reduce(const snapshot_output_t *const output, const ns_world_t *const world, ns_real_t *buffer,
+                            ns_world_t *reduced) {
+    const uint64_t plane = snapshot_output_width(output) * snapshot_output_height(output);
+    const ns_real_t **reduced_planes[] = {&reduced->u, &reduced->v, &reduced->density};
+    ns_real_t *reduced_plane = buffer;
+
+    *reduced = *world;
+    reduced->world_width = snapshot_output_width(output);
+    reduced->world_width_bounds = reduced->world_width;
+    reduced->world_height = snapshot_output_height(output);
+    reduced->world_height_bounds = reduced->world_height;
+    reduced->pitch = reduced->world_width;
+
+    // Saved fields are packed in buffer
+    for (unsigned int i = 0; i < SNAPSHOT_FIELDS_LENGTH; ++i) {
+        *reduced_planes[i] = NULL;
+        if (!(output->fields & (1u << i))) continue;
+
+        reduce_plane(output, world, world_plane(world, 1u << i), reduced_plane);
+        *reduced_planes[i] = reduced_plane;
+        reduced_plane += plane;
+    }
+}
+
+snapshot_writer_t *snapshot_writer_open(const char *const file_path, const char *const metadata,
+                                        const snapshot_layout_t *const layout, char *error) {
+    snapshot_writer_t *writer;
+    uint64_t tolerance_bits;
+    int error_code;
+    int error_length;
+
+    writer = (snapshot_writer_t *) calloc(1, sizeof(snapshot_writer_t));
+    if (writer == NULL) {
+        strcpy(error, "Unable to allocate snapshot writer");
+        return NULL;
+    }
+    writer->fh = MPI_FILE_NULL;
+    writer->planes = (ns_real_t *) malloc(layout_fields(layout) * layout->width * layout->height * sizeof(ns_real_t));
+    writer->index_capacity = SNAPSHOT_INDEX_CAPACITY;
+    writer->index = (uint64_t *) malloc(writer->index_capacity * sizeof(uint64_t));
+    if (!codec_init(&writer->codec, layout) || writer->planes == NULL || writer->index == NULL) {
+        strcpy(error, "Unable to allocate snapshot writer buffers");
+        free_writer(writer);
+        return NULL;
+    }
+
+    // Open file at file_path, dropping any previous content
+    if (file_path != NULL) {
+        error_code = MPI_File_open(MPI_COMM_SELF, file_path, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL,
+                                   &writer->fh);
+        if (error_code == MPI_SUCCESS) error_code = MPI_File_set_size(writer->fh, 0);
+        if (error_code != MPI_SUCCESS) {
+            MPI_Error_string(error_code, error, &error_length);
+            free_writer(writer);
+            return NULL;
+        }
+    }
+
+    // Header: magic, version, value size, snapshot size, fields, compression, tolerance, keyframe interval,
+    // metadata length, then the metadata
+    memcpy(&tolerance_bits, &layout->tolerance, sizeof(uint64_t));
+    const uint64_t header[SNAPSHOT_HEADER_FIELDS] = {SNAPSHOT_VERSION, sizeof(ns_real_t), layout->width,
+                                                     layout->height, layout->fields, layout->compression,
+                                                     tolerance_bits, SNAPSHOT_KEYFRAME_INTERVAL, strlen(metadata)};
+    if (!write_writer(writer, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_LENGTH, MPI_CHAR, sizeof(char), error)
+        || !write_writer(writer, header, SNAPSHOT_HEADER_FIELDS, MPI_UINT64_T, sizeof(uint64_t), error)
+        || !write_writer(writer, metadata, strlen(metadata), MPI_CHAR, sizeof(char), error)) {
+        free_writer(writer);
+        return NULL;
+    }
+
+    return writer;
+}
+
+bool snapshot_writer_write(snapshot_writer_t *writer, const ns_world_t *const world, ns_tick_stats_t stats,
+                           char *error) {
+    const snapshot_layout_t *const layout = &writer->codec.layout;
+    const uint64_t plane = writer->codec.plane;
+    const bool keyframe = writer->index_length % SNAPSHOT_KEYFRAME_INTERVAL == 0;
+    ns_real_t *packed_plane = writer->planes;
+    uint64_t field = 0;
+
+    if (world->world_width_bounds != layout->width || world->world_height_bounds != layout->height) {
+        strcpy(error, "Snapshot size differs from the file snapshot size");
+        return false;
+    }
+    for (unsigned int i = 0; i < SNAPSHOT_FIELDS_LENGTH; ++i) {
+        if ((world_plane(world, 1u << i) != NULL) != ((layout->fields & (1u << i)) != 0)) {
+            strcpy(error, "Snapshot fields differ from the file fields");
+            return false;
+        }
+    }
+
+    // Grow the index
+    if (writer->index_length == writer->index_capacity) {
+        uint64_t *index = (uint64_t *) realloc(writer->index, 2 * writer->index_capacity * sizeof(uint64_t));
+        if (index == NULL) {
+            strcpy(error, "Unable to grow snapshot index");
+            return false;
+        }
+        writer->index = index;
+        writer->index_capacity *= 2;
+    }
+    writer->index[writer->index_length++] = writer->offset;
+
+    // Record: tick, iterations, then the saved planes among u, v and density without the row padding
+    const uint64_t record[SNAPSHOT_RECORD_FIELDS] = {world->tick, stats.diffuse_iterations,
+                                                     stats.pressure_iterations};
+    if (!write_writer(writer, record, SNAPSHOT_RECORD_FIELDS, MPI_UINT64_T, sizeof(uint64_t), error)) return false;
+    for (unsigned int i = 0; i < SNAPSHOT_FIELDS_LENGTH; ++i) {
+        const ns_real_t *world_field = world_plane(world, 1u << i);
+        if (world_field == NULL) continue;
+
+        for (uint64_t y = 0; y < layout->height; ++y)
+            memcpy(&packed_plane[y * layout->width], &world_field[NS_WORLD_IDX(world, 0, y)],
+                   layout->width * sizeof(ns_real_t));
+
+        // Compressed planes are preceded by their length
+        if (layout->compression != SNAPSHOT_COMPRESSION_NONE) {
+            uint64_t length;
+
+            if (!codec_encode(&writer->codec, field, packed_plane, keyframe, &length, error)
+                || !write_writer(writer, &length, 1, MPI_UINT64_T, sizeof(uint64_t), error)
+                || !write_writer(writer, writer->codec.compressed, length, MPI_BYTE, sizeof(uint8_t), error))
+                return false;
+        }
+
+        packed_plane += plane;
+        field += 1;
+    }
+
+    if (layout->compression != SNAPSHOT_COMPRESSION_NONE) return true;
+    return write_writer(writer, writer->planes, (uint64_t) (packed_plane - writer->planes), NS_REAL_MPI,
+                        sizeof(ns_real_t), error);
+}
+
+bool snapshot_writer_sync(snapshot_writer_t *writer, char *error) {
+    int error_code;
+    int error_length;
+
+    if (writer->fh == MPI_FILE_NULL) return true;
+
+    error_code = MPI_File_sync(writer->fh);
+    if (error_code != MPI_SUCCESS) {
+        MPI_Error_string(error_code, error, &error_length);
+        return false;
+    }
+
+    return true;
+}
+
+bool snapshot_writer_close(snapshot_writer_t *writer, char *error) {
+    int error_code;
+    int error_length;
+
+    if (!write_index(writer, error)) {
+        free_writer(writer);
+        return false;
+    }
+
+    error_code = MPI_File_close(&writer->fh);
+    if (error_code != MPI_SUCCESS) {
+        MPI_Error_string(error_code, error, &error_length);
+        free_writer(writer);
+        return false;
+    }
+
+    free_writer(writer);
+    return true;
+}
+
+uint8_t *snapshot_writer_close_memory(snapshot_writer_t *writer, uint64_t *length, char *error) {
+    uint8_t *memory;
+
+    if (!write_index(writer, error)) {
+        free_writer(writer);
+        return NULL;
+    }
+
+    // The content outlives writer
+    memory = writer->memory;
+    *length = writer->offset;
+    writer->memory = NULL;
+    free_writer(writer);
+
+    return memory;
+}
+
+snapshot_reader_t *snapshot_reader_open(const char *const file_path, char *error) {
+    snapshot_reader_t *reader;
+    char magic[SNAPSHOT_MAGIC_LENGTH];
+    uint64_t header[SNAPSHOT_HEADER_FIELDS];
+    uint64_t trailer[2];
+    snapshot_layout_t layout;
+    MPI_Offset size;
+    int error_code;
+    int error_length;
+
+    reader = (snapshot_reader_t *) calloc(1, sizeof(snapshot_reader_t));
+    if (reader == NULL) {
+        strcpy(error, "Unable to allocate snapshot reader");
+        return NULL;
+    }
+
+    error_code = MPI_File_open(MPI_COMM_SELF, file_path, MPI_MODE_RDONLY, MPI_INFO_NULL, &reader->fh);
+    if (error_code != MPI_SUCCESS) {
+        MPI_Error_string(error_code, error, &error_length);
+        free(reader);
+        return NULL;
+    }
+
+    // Header
+    if (!read_values(reader->fh, &reader->offset, magic, SNAPSHOT_MAGIC_LENGTH, MPI_CHAR, sizeof(char), error)
+        || !read_values(reader->fh, &reader->offset, header, SNAPSHOT_HEADER_FIELDS, MPI_UINT64_T, sizeof(uint64_t),
+                        error)) {
+        snapshot_reader_close(reader);
+        return NULL;
+    }
+    if (memcmp(magic, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_LENGTH) != 0 || header[0] != SNAPSHOT_VERSION) {
+        strcpy(error, "Not a binary result file of the current version");
+        snapshot_reader_close(reader);
+        return NULL;
+    }
+    if (header[1] != sizeof(ns_real_t)) {
+        strcpy(error, "Binary result file saved with a different field precision");
+        snapshot_reader_close(reader);
+        return NULL;
+    }
+    layout.width = header[2];
+    layout.height = header[3];
+    layout.fields = (unsigned int) header[4];
+    layout.compression = (snapshot_compression_t) header[5];
+    memcpy(&layout.tolerance, &header[6], sizeof(double));
+    reader->keyframe_interval = header[7];
+    if (layout.width == 0 || layout.height == 0 || layout.fields == 0 || (layout.fields & ~SNAPSHOT_FIELDS) != 0
+        || header[5] > SNAPSHOT_COMPRESSION_LOSSY || reader->keyframe_interval == 0) {
+        strcpy(error, "Invalid binary result file header");
+        snapshot_reader_close(reader);
+        return NULL;
+    }
+
+    // Metadata
+    reader->metadata = (char *) calloc(header[8] + 1, sizeof(char));
+    reader->planes = (ns_real_t *) malloc(layout_fields(&layout) * layout.width * layout.height * sizeof(ns_real_t));
+    if (reader->metadata == NULL || reader->planes == NULL || !codec_init(&reader->codec, &layout)) {
+        strcpy(error, "Unable to allocate snapshot reader buffers");
+        snapshot_reader_close(reader);
+        return NULL;
+    }
+    if (!read_values(reader->fh, &reader->offset, reader->metadata, header[8], MPI_CHAR, sizeof(char), error)) {
+        snapshot_reader_close(reader);
+        return NULL;
+    }
+
+    // Snapshots end at the index, or at the end of a file without trailer
+    MPI_File_get_size(reader->fh, &size);
+    reader->end = (uint64_t) size;
+    if (reader->end >= reader->offset + sizeof(trailer)) {
+        MPI_File_read_at(reader->fh, size - (MPI_Offset) sizeof(trailer), trailer, 2, MPI_UINT64_T, MPI_STATUS_IGNORE);
+        if (memcmp(&trailer[1], SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_LENGTH) == 0 && trailer[0] >= reader->offset
+            && trailer[0] < reader->end)
+            reader->end = trailer[0];
+    }
+
+    return reader;
+}
+
+const snapshot_layout_t *snapshot_reader_layout(const snapshot_reader_t *const reader) {
+    return &reader->codec.layout;
+}
+
+const char *snapshot_reader_metadata(const snapshot_reader_t *const reader) {
+    return reader->metadata;
+}
+
+bool snapshot_reader_end(const snapshot_reader_t *const reader) {
+    return reader->offset >= reader->end;
+}
+
+bool snapshot_reader_read(snapshot_reader_t *reader, ns_world_t *world, ns_tick_stats_t *stats, char *error) {
+    const snapshot_layout_t *const layout = &reader->codec.layout;
+    const uint64_t plane = reader->codec.plane;
+    const bool keyframe = reader->snapshots % reader->keyframe_interval == 0;
+    const ns_real_t **world_planes[] = {&world->u, &world->v, &world->density};
+    ns_real_t *packed_plane = reader->planes;
+    uint64_t record[SNAPSHOT_RECORD_FIELDS];
+    uint64_t field = 0;
+
+    if (!read_values(reader->fh, &reader->offset, record, SNAPSHOT_RECORD_FIELDS, MPI_UINT64_T, sizeof(uint64_t),
+                     error))
+        return false;
+
+    for (unsigned int i = 0; i < SNAPSHOT_FIELDS_LENGTH; ++i) {
+        *world_planes[i] = NULL;
+        if (!(layout->fields & (1u << i))) continue;
+
+        if (layout->compression == SNAPSHOT_COMPRESSION_NONE) {
+            if (!read_values(reader->fh, &reader->offset, packed_plane, plane, NS_REAL_MPI, sizeof(ns_real_t), error))
+                return false;
+        } else {
+            uint64_t length;
+
+            if (!read_values(reader->fh, &reader->offset, &length, 1, MPI_UINT64_T, sizeof(uint64_t), error))
+                return false;
+            if (length > compress_bound(plane * sizeof(uint64_t))) {
+                strcpy(error, "Invalid compressed plane length");
+                return false;
+            }
+            if (!read_values(reader->fh, &reader->offset, reader->codec.compressed, length, MPI_BYTE,
+                             sizeof(uint8_t), error)
+                || !codec_decode(&reader->codec, field, length, keyframe, packed_plane, error))
+                return false;
+        }
+
+        *world_planes[i] = packed_plane;
+        packed_plane += plane;
+        field += 1;
+    }
+    reader->snapshots += 1;
+
+    world->world_width = layout->width;
+    world->world_width_bounds = layout->width;
+    world->world_height = layout->height;
+    world->world_height_bounds = layout->height;
+    world->pitch = layout->width;
+    world->tick = record[0];
+    stats->diffuse_iterations = record[1];
+    stats->pressure_iterations = record[2];
+
+    return true;
+}
+
+void snapshot_reader_close(snapshot_reader_t *reader) {
+    if (reader == NULL) return;
+
+    if (reader->fh != MPI_FILE_NULL) MPI_File_close(&reader->fh);
+    codec_free(&reader->codec);
+    free(reader->metadata);
+    free(reader->planes);
+    free(reader);
+}
+/**
+ * END Public
+ */
+
+/**
+ * Private
+ */
+static void reduce_plane(const snapshot_output_t *const output, const ns_world_t *const world,
+                         const ns_real_t *const plane, ns_real_t *reduced_plane) {
+    uint64_t y;
+    const uint64_t width = snapshot_output_width(output);
+    const uint64_t height = snapshot_output_height(output);
+    const uint64_t block = output->downsample;
+    const uint64_t x_end = output->x + output->width;
+    const uint64_t y_end = output->y + output->height;
+
+#pragma omp parallel for \
+    schedule(static) \
+    default(none) private(y) shared(output, world, plane, reduced_plane, width, height, block, x_end, y_end)
+    for (y = 0; y < height; ++y) {
+        const uint64_t y0 = output->y + y * block;
+        const uint64_t y1 = y0 + block < y_end ? y0 + block : y_end;
+
+        // Region rows are copied as they are
+        if (block == 1) {
+            memcpy(&reduced_plane[y * width], &plane[NS_WORLD_IDX(world, output->x, y0)], width * sizeof(ns_real_t));
+            continue;
+        }
+
+        for (uint64_t x = 0; x < width; ++x) {
+            const uint64_t x0 = output->x + x * block;
+            const uint64_t x1 = x0 + block < x_end ? x0 + block : x_end;
+            double sum = 0.0;
+
+            for (uint64_t block_y = y0; block_y < y1; ++block_y) {
+                for (uint64_t block_x = x0; block_x < x1; ++block_x) {
+                    sum += (double) plane[NS_WORLD_IDX(world, block_x, block_y)];
+                }
+            }
+
+            reduced_plane[y * width + x] = (ns_real_t) (sum / (double) ((x1 - x0) * (y1 - y0)));
+        }
+    }
+}
+
+static const ns_real_t *world_plane(const ns_world_t *const world, unsigned int field) {
+    switch (field) {
+        case SNAPSHOT_FIELD_U:
+            return world->u;
+        case SNAPSHOT_FIELD_V:
+            return world->v;
+        case SNAPSHOT_FIELD_DENSITY:
+            return world->density;
+        default:
+            return NULL;
+    }
+}
+
+static uint64_t layout_fields(const snapshot_layout_t *const layout) {
+    uint64_t fields = 0;
+
+    for (unsigned int i = 0; i < SNAPSHOT_FIELDS_LENGTH; ++i) {
+        if (layout->fields & (1u << i)) fields += 1;
+    }
+
+    return fields;
+}
+
+static bool codec_init(snapshot_codec_t *codec, const snapshot_layout_t *const layout) {
+    codec->layout = *layout;
+    codec->plane = layout->width * layout->height;
+    if (layout->compression == SNAPSHOT_COMPRESSION_NONE) return true;
+
+    // Quantized values are 64 bit, raw values at most
+    codec->previous = (uint8_t *) calloc(layout_fields(layout) * codec->plane, sizeof(uint64_t));
+    codec->values = (uint8_t *) malloc(codec->plane * sizeof(uint64_t));
+    codec->shuffled = (uint8_t *) malloc(codec->plane * sizeof(uint64_t));
+    codec->compressed = (uint8_t *) malloc(compress_bound(codec->plane * sizeof(uint64_t)));
+
+    return codec->previous != NULL && codec->values != NULL && codec->shuffled != NULL && codec->compressed != NULL;
+}
+
+static bool codec_encode(snapshot_codec_t *codec, uint64_t field, const ns_real_t *const plane, bool keyframe,
+                         uint64_t *length, char *error) {
+    const double step = 2.0 * codec->layout.tolerance;
+    size_t value_size;
+
+    if (codec->layout.compression == SNAPSHOT_COMPRESSION_LOSSLESS) {
+        // XOR with the previous snapshot, unchanged bits become zeros
+        const uint8_t *const bytes = (const uint8_t *) plane;
+        uint8_t *const previous = &codec->previous[field * codec->plane * sizeof(ns_real_t)];
+
+        value_size = sizeof(ns_real_t);
+        if (keyframe) memset(previous, 0, codec->plane * value_size);
+        for (uint64_t i = 0; i < codec->plane * value_size; ++i) {
+            codec->values[i] = bytes[i] ^ previous[i];
+            previous[i] = bytes[i];
+        }
+    } else {
+        // Quantize within the tolerance, then zigzag the difference with the previous snapshot
+        int64_t *const previous = (int64_t *) &codec->previous[field * codec->plane * sizeof(int64_t)];
+        uint64_t *const values = (uint64_t *) codec->values;
+
+        value_size = sizeof(uint64_t);
+        if (keyframe) memset(previous, 0, codec->plane * value_size);
+        for (uint64_t i = 0; i < codec->plane; ++i) {
+            const double scaled = (double) plane[i] / step;
+            if (!(fabs(scaled) < SNAPSHOT_QUANTIZED_MAX)) {
+                strcpy(error, "Value out of the range of the lossy compression tolerance");
+                return false;
+            }
+
+            const int64_t quantized = (int64_t) llround(scaled);
+            const uint64_t difference = (uint64_t) quantized - (uint64_t) previous[i];
+            values[i] = difference << 1 ^ (uint64_t) ((int64_t) difference >> 63);
+            previous[i] = quantized;
+        }
+    }
+
+    // Group the bytes of equal significance, then compress
+    compress_shuffle(codec->values, codec->plane, value_size, codec->shuffled);
+    *length = compress_lz(codec->shuffled, codec->plane * value_size, codec->compressed);
+    if (*length == 0) {
+        strcpy(error, "Unable to compress snapshot plane");
+        return false;
+    }
+
+    return true;
+}
+
+static bool codec_decode(snapshot_codec_t *codec, uint64_t field, uint64_t length, bool keyframe, ns_real_t *plane,
+                         char *error) {
+    const double step = 2.0 * codec->layout.tolerance;
+    const size_t value_size =
+            codec->layout.compression == SNAPSHOT_COMPRESSION_LOSSLESS ? sizeof(ns_real_t) : sizeof(uint64_t);
+
+    if (!decompress_lz(codec->compressed, length, codec->shuffled, codec->plane * value_size)) {
+        strcpy(error, "Invalid compressed snapshot plane");
+        return false;
+    }
+    compress_unshuffle(codec->shuffled, codec->plane, value_size, codec->values);
+
+    if (codec->layout.compression == SNAPSHOT_COMPRESSION_LOSSLESS) {
+        uint8_t *const bytes = (uint8_t *) plane;
+        uint8_t *const previous = &codec->previous[field * codec->plane * sizeof(ns_real_t)];
+
+        if (keyframe) memset(previous, 0, codec->plane * value_size);
+        for (uint64_t i = 0; i < codec->plane * value_size; ++i) {
+            bytes[i] = codec->values[i] ^ previous[i];
+            previous[i] = bytes[i];
+        }
+    } else {
+        int64_t *const previous = (int64_t *) &codec->previous[field * codec->plane * sizeof(int64_t)];
+        const uint64_t *const values = (const uint64_t *) codec->values;
+
+        if (keyframe) memset(previous, 0, codec->plane * value_size);
+        for (uint64_t i = 0; i < codec->plane; ++i) {
+            const uint64_t difference = values[i] >> 1 ^ (0 - (values[i] & 1));
+            previous[i] = (int64_t) ((uint64_t) previous[i] + difference);
+            plane[i] = (ns_real_t) ((double) previous[i] * step);
+        }
+    }
+
+    return true;
+}
+
+static void codec_free(snapshot_codec_t *codec) {
+    free(codec->previous);
+    free(codec->values);
+    free(codec->shuffled);
+    free(codec->compressed);
+}
+
+static bool write_values(MPI_File fh, uint64_t *offset, const void *const values, uint64_t count,
+                         MPI_Datatype datatype, size_t value_size, char *error) {
+    int error_code;
+    int error_length;
+    const char *bytes = (const char *) values;
+
+    // MPI counts are int, write large buffers in chunks
+    while (count > 0) {
+        const int chunk = count > INT_MAX ? INT_MAX : (int) count;
+
+        error_code = MPI_File_write(fh, bytes, chunk, datatype, MPI_STATUS_IGNORE);
+        if (error_code != MPI_SUCCESS) {
+            MPI_Error_string(error_code, error, &error_length);
+            return false;
+        }
+
+        bytes += (size_t) chunk * value_size;
+        *offset += (uint64_t) chunk * value_size;
+        count -= (uint64_t) chunk;
+    }
+
+    return true;
+}
+
+static bool read_values(MPI_File fh, uint64_t *offset, void *values, uint64_t count, MPI_Datatype datatype,
+                        size_t value_size, char *error) {
+    MPI_Status status;
+    int error_code;
+    int error_length;
+    int read;
+    char *bytes = (char *) values;
+
+    // MPI counts are int, read large buffers in chunks
+    while (count > 0) {
+        const int chunk = count > INT_MAX ? INT_MAX : (int) count;
+
+        error_code = MPI_File_read(fh, bytes, chunk, datatype, &status);
+        if (error_code != MPI_SUCCESS) {
+            MPI_Error_string(error_code, error, &error_length);
+            return false;
+        }
+        MPI_Get_count(&status, datatype, &read);
+        if (read != chunk) {
+            strcpy(error, "Unexpected end of binary result file");
+            return false;
+        }
+
+        bytes += (size_t) chunk * value_size;
+        *offset += (uint64_t) chunk * value_size;
+        count -= (uint64_t) chunk;
+    }
+
+    return true;
+}
+
+static bool write_writer(snapshot_writer_t *writer, const void *const values, uint64_t count, MPI_Datatype datatype,
+                         size_t value_size, char *error) {
+    const uint64_t length = count * value_size;
+
+    if (writer->fh != MPI_FILE_NULL)
+        return write_values(writer->fh, &writer->offset, values, count, datatype, value_size, error);
+
+    // Grow the memory content
+    if (writer->offset + length > writer->memory_capacity) {
+        uint64_t capacity = writer->memory_capacity > 0 ? writer->memory_capacity : SNAPSHOT_MEMORY_CAPACITY;
+        while (writer->offset + length > capacity) capacity *= 2;
+
+        uint8_t *memory = (uint8_t *) realloc(writer->memory, capacity);
+        if (memory == NULL) {
+            strcpy(error, "Unable to grow snapshot writer memory");
+            return false;
+        }
+        writer->memory = memory;
+        writer->memory_capacity = capacity;
+    }
+
+    memcpy(&writer->memory[writer->offset], values, length);
+    writer->offset += length;
+    return true;
+}
+
+static bool write_index(snapshot_writer_t *writer, char *error) {
+    const uint64_t index_offset = writer->offset;
+
+    // Index: number of snapshots and their offsets, then the index offset and the magic
+    return write_writer(writer, &writer->index_length, 1, MPI_UINT64_T, sizeof(uint64_t), error)
+           && write_writer(writer, writer->index, writer->index_length, MPI_UINT64_T, sizeof(uint64_t), error)
+           && write_writer(writer, &index_offset, 1, MPI_UINT64_T, sizeof(uint64_t), error)
+           && write_writer(writer, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_LENGTH, MPI_CHAR, sizeof(char), error);
+}
+
+static void free_writer(snapshot_writer_t *writer) {
+    if (writer->fh != MPI_FILE_NULL) MPI_File_close(&writer->fh);
+    free(writer->memory);
+    codec_free(&writer->codec);
+    free(writer->planes);
+    free(writer->index);
+    free(writer);
+}
+/**
+ * END Private
+ */
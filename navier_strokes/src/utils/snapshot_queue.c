@@ -0,0 +1,179 @@
+#include "ns/utils/snapshot_queue.h"
+#include <stdlib.h>
+#include <pthread.h>
+
+// Queued task
+typedef struct snapshot_queue_slot_t {
+    snapshot_queue_task_t task;
+    void *context;
+    ns_tick_stats_t stats;
+    bool has_world;
+    // Copy of the snapshot, planes in buffer
+    ns_world_t world;
+    ns_real_t *buffer;
+    uint64_t buffer_length;
+} snapshot_queue_slot_t;
+
+struct snapshot_queue_t {
+    uint64_t capacity;
+    // Synchronous queue, a single slot run by the caller
+    bool synchronous;
+    snapshot_queue_slot_t *slots;
+    // First pending slot and number of pending slots
+    uint64_t head;
+    uint64_t length;
+    bool stop;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    // Signaled when a slot is queued or the queue stops
+    pthread_cond_t queued;
+    // Signaled when a slot has run
+    pthread_cond_t done;
+};
+
+/**
+ * Private definitions
+ */
+static void *run_io_thread(void *arg);
+/**
+ * END Private definitions
+ */
+
+/**
+ * Public
+ */
+snapshot_queue_t *snapshot_queue_create(uint64_t capacity) {
+    snapshot_queue_t *queue = (snapshot_queue_t *) calloc(1, sizeof(snapshot_queue_t));
+    if (queue == NULL) return NULL;
+
+    queue->synchronous = capacity == 0;
+    queue->capacity = queue->synchronous ? 1 : capacity;
+    queue->slots = (snapshot_queue_slot_t *) calloc(queue->capacity, sizeof(snapshot_queue_slot_t));
+    if (queue->slots == NULL) {
+        free(queue);
+        return NULL;
+    }
+    if (queue->synchronous) return queue;
+
+    pthread_mutex_init(&queue->mutex, NULL);
+    pthread_cond_init(&queue->queued, NULL);
+    pthread_cond_init(&queue->done, NULL);
+    if (pthread_create(&queue->thread, NULL, run_io_thread, queue) != 0) {
+        pthread_cond_destroy(&queue->done);
+        pthread_cond_destroy(&queue->queued);
+        pthread_mutex_destroy(&queue->mutex);
+        free(queue->slots);
+        free(queue);
+        return NULL;
+    }
+
+    return queue;
+}
+
+bool snapshot_queue_push(snapshot_queue_t *queue, snapshot_queue_task_t task, void *context,
+                         const ns_world_t *const world, const snapshot_output_t *const output, ns_tick_stats_t stats) {
+    snapshot_queue_slot_t *slot;
+
+    if (queue->synchronous) {
+        slot = &queue->slots[0];
+    } else {
+        // Backpressure, wait a free slot
+        pthread_mutex_lock(&queue->mutex);
+        while (queue->length == queue->capacity) pthread_cond_wait(&queue->done, &queue->mutex);
+        slot = &queue->slots[(queue->head + queue->length) % queue->capacity];
+        pthread_mutex_unlock(&queue->mutex);
+    }
+
+    // The free slot is not read by the I/O thread until it is queued
+    slot->task = task;
+    slot->context = context;
+    slot->stats = stats;
+    slot->has_world = world != NULL;
+    if (world != NULL) {
+        const uint64_t buffer_length = output != NULL ? snapshot_output_size(output) : ns_world_copy_size(world);
+        if (slot->buffer_length < buffer_length) {
+            ns_real_t *buffer = (ns_real_t *) realloc(slot->buffer, buffer_length * sizeof(ns_real_t));
+            if (buffer == NULL) return false;
+            slot->buffer = buffer;
+            slot->buffer_length = buffer_length;
+        }
+        if (output != NULL) snapshot_output_reduce(output, world, slot->buffer, &slot->world);
+        else ns_world_copy(world, slot->buffer, &slot->world);
+    }
+
+    if (queue->synchronous) {
+        task(context, world != NULL ? &slot->world : NULL, stats);
+        return true;
+    }
+
+    pthread_mutex_lock(&queue->mutex);
+    queue->length += 1;
+    pthread_cond_signal(&queue->queued);
+    pthread_mutex_unlock(&queue->mutex);
+
+    return true;
+}
+
+void snapshot_queue_wait(snapshot_queue_t *queue) {
+    if (queue->synchronous) return;
+
+    pthread_mutex_lock(&queue->mutex);
+    while (queue->length > 0) pthread_cond_wait(&queue->done, &queue->mutex);
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+void snapshot_queue_free(snapshot_queue_t *queue) {
+    if (queue == NULL) return;
+
+    if (!queue->synchronous) {
+        // The I/O thread stops once the queue is empty
+        pthread_mutex_lock(&queue->mutex);
+        queue->stop = true;
+        pthread_cond_signal(&queue->queued);
+        pthread_mutex_unlock(&queue->mutex);
+        pthread_join(queue->thread, NULL);
+
+        pthread_cond_destroy(&queue->done);
+        pthread_cond_destroy(&queue->queued);
+        pthread_mutex_destroy(&queue->mutex);
+    }
+
+    for (uint64_t i = 0; i < queue->capacity; ++i) free(queue->slots[i].buffer);
+    free(queue->slots);
+    free(queue);
+}
+/**
+ * END Public
+ */
+
+/**
+ * Private
+ */
+static void *run_io_thread(void *arg) {
+    snapshot_queue_t *queue = (snapshot_queue_t *) arg;
+    const snapshot_queue_slot_t *slot;
+
+    while (true) {
+        pthread_mutex_lock(&queue->mutex);
+        while (queue->length == 0 && !queue->stop) pthread_cond_wait(&queue->queued, &queue->mutex);
+        if (queue->length == 0) {
+            pthread_mutex_unlock(&queue->mutex);
+            break;
+        }
+        slot = &queue->slots[queue->head];
+        pthread_mutex_unlock(&queue->mutex);
+
+        slot->task(slot->context, slot->has_world ? &slot->world : NULL, slot->stats);
+
+        pthread_mutex_lock(&queue->mutex);
+        queue->head = (queue->head + 1) % queue->capacity;
+        queue->length -= 1;
+        pthread_cond_broadcast(&queue->done);
+        pthread_mutex_unlock(&queue->mutex);
+    }
+
+    return NULL;
+}
+/**
+ * END Private
+ */
@@ -18,12 +18,19 @@ char *ns_stringify_simulation(const ns_simulation_t *const simulation) {
     cJSON *simulation_json = NULL;
     cJSON *world_json = NULL;
     cJSON *fluid_json = NULL;
+    cJSON *solver_json = NULL;
+    cJSON *multigrid_json = NULL;
+    cJSON *boundaries_json = NULL;
+    cJSON *output_json = NULL;
+    cJSON *region_json = NULL;
+    cJSON *fields_json = NULL;
     cJSON *mods_json = NULL;
 
     simulation_json = cJSON_CreateObject();
 
     if (cJSON_AddNumberToObject(simulation_json, "time_step", simulation->time_step) == NULL
-        || cJSON_AddNumberToObject(simulation_json, "ticks", (double) simulation->ticks) == NULL)
+        || cJSON_AddNumberToObject(simulation_json, "ticks", (double) simulation->ticks) == NULL
+        || cJSON_AddNumberToObject(simulation_json, "ranks", (double) simulation->ranks) == NULL)
         return ns_stringify_simulation_error(simulation_json);
 
     world_json = cJSON_AddObjectToObject(simulation_json, "world");
@@ -39,6 +46,62 @@ char *ns_stringify_simulation(const ns_simulation_t *const simulation) {
         || cJSON_AddNumberToObject(fluid_json, "diffusion", simulation->fluid.diffusion) == NULL)
         return ns_stringify_simulation_error(simulation_json);
 
+    solver_json = cJSON_AddObjectToObject(simulation_json, "solver");
+    if (solver_json == NULL) return ns_stringify_simulation_error(simulation_json);
+    if (cJSON_AddStringToObject(solver_json, "relaxation",
+                                ns_relaxation_string(simulation->solver.relaxation)) == NULL
+        || cJSON_AddNumberToObject(solver_json, "max_iterations", (double) simulation->solver.max_iterations) == NULL
+        || cJSON_AddNumberToObject(solver_json, "tolerance", simulation->solver.tolerance) == NULL
+        || cJSON_AddNumberToObject(solver_json, "check_every", (double) simulation->solver.check_every) == NULL
+        || cJSON_AddStringToObject(solver_json, "pressure",
+                                   ns_pressure_solver_string(simulation->solver.pressure)) == NULL)
+        return ns_stringify_simulation_error(simulation_json);
+
+    multigrid_json = cJSON_AddObjectToObject(solver_json, "multigrid");
+    if (multigrid_json == NULL) return ns_stringify_simulation_error(simulation_json);
+    if (cJSON_AddStringToObject(multigrid_json, "cycle",
+                                ns_multigrid_cycle_string(simulation->solver.multigrid.cycle)) == NULL
+        || cJSON_AddNumberToObject(multigrid_json, "tolerance", simulation->solver.multigrid.tolerance) == NULL
+        || cJSON_AddNumberToObject(multigrid_json, "max_cycles",
+                                   (double) simulation->solver.multigrid.max_cycles) == NULL)
+        return ns_stringify_simulation_error(simulation_json);
+
+    boundaries_json = cJSON_AddObjectToObject(simulation_json, "boundaries");
+    if (boundaries_json == NULL) return ns_stringify_simulation_error(simulation_json);
+    for (int edge = NS_BOUNDARY_EDGE_LEFT; edge <= NS_BOUNDARY_EDGE_BOTTOM; ++edge) {
+        const ns_boundary_t *const boundary = &simulation->boundaries.edges[edge];
+        cJSON *boundary_json;
+
+        boundary_json = cJSON_AddObjectToObject(boundaries_json, ns_boundary_edge_string((ns_boundary_edge_t) edge));
+        if (boundary_json == NULL
+            || cJSON_AddStringToObject(boundary_json, "type", ns_boundary_type_string(boundary->type)) == NULL
+            || cJSON_AddNumberToObject(boundary_json, "u", boundary->u) == NULL
+            || cJSON_AddNumberToObject(boundary_json, "v", boundary->v) == NULL
+            || cJSON_AddNumberToObject(boundary_json, "density", boundary->density) == NULL)
+            return ns_stringify_simulation_error(simulation_json);
+    }
+
+    output_json = cJSON_AddObjectToObject(simulation_json, "output");
+    if (output_json == NULL) return ns_stringify_simulation_error(simulation_json);
+    region_json = cJSON_AddObjectToObject(output_json, "region");
+    fields_json = cJSON_AddArrayToObject(output_json, "fields");
+    if (cJSON_AddNumberToObject(output_json, "every", (double) simulation->output.every) == NULL
+        || cJSON_AddNumberToObject(output_json, "downsample", (double) simulation->output.downsample) == NULL
+        || region_json == NULL
+        || cJSON_AddNumberToObject(region_json, "x", (double) simulation->output.x) == NULL
+        || cJSON_AddNumberToObject(region_json, "y", (double) simulation->output.y) == NULL
+        || cJSON_AddNumberToObject(region_json, "width", (double) simulation->output.width) == NULL
+        || cJSON_AddNumberToObject(region_json, "height", (double) simulation->output.height) == NULL
+        || fields_json == NULL)
+        return ns_stringify_simulation_error(simulation_json);
+    for (unsigned int field = 1; field <= SNAPSHOT_FIELDS; field <<= 1) {
+        if ((simulation->output.fields & field) == 0) continue;
+
+        cJSON *field_json = cJSON_CreateString(snapshot_field_string(field));
+        if (field_json == NULL) return ns_stringify_simulation_error(simulation_json);
+        cJSON_AddItemToArray(fields_json, field_json);
+    }
+
     mods_json = cJSON_AddArrayToObject(simulation_json, "mods");
     if (mods_json == NULL) return ns_stringify_simulation_error(simulation_json);
     if (simulation->mods != NULL && simulation->mods_length > 0) {
@@ -96,7 +159,7 @@ char *ns_stringify_simulation(const ns_simulation_t *const simulation) {
     }
 
     text = cJSON_Print(simulation_json);
-    if (text == NULL) return ns_stringify_simulation_error(simulation_json);
+    cJSON_Delete(simulation_json);
 
     return text;
 }
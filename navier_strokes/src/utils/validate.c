@@ -0,0 +1,135 @@
+#include "ns/utils/validate.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <dirent.h>
+
+#define VALIDATE_PREFIX_MAX_LENGTH 64
+#define VALIDATE_SUFFIX ".json"
+
+// Sums of a field over every snapshot
+typedef struct validate_sums_t {
+    double max_error;
+    double error_norm;
+    double reference_norm;
+} validate_sums_t;
+
+/**
+ * Private definitions
+ */
+static bool validate_cell(const cJSON *cell_json, const cJSON *reference_cell_json, const char *name,
+                          validate_sums_t *sums);
+
+static void validate_field(const validate_sums_t *sums, validate_field_t *field);
+/**
+ * END Private definitions
+ */
+
+/**
+ * Public
+ */
+char *validate_find_reference(const char *const folder, uint64_t simulation_id) {
+    if (folder == NULL) return NULL;
+    char prefix[VALIDATE_PREFIX_MAX_LENGTH];
+    const size_t suffix_length = strlen(VALIDATE_SUFFIX);
+    char *path = NULL;
+    DIR *dir;
+    const struct dirent *entry;
+
+    // Results are saved as simulation_<id>_<rank>.json, the rank is not known in advance
+    snprintf(prefix, VALIDATE_PREFIX_MAX_LENGTH, "simulation_%ld_", simulation_id);
+
+    dir = opendir(folder);
+    if (dir == NULL) return NULL;
+
+    while (path == NULL && (entry = readdir(dir)) != NULL) {
+        const size_t length = strlen(entry->d_name);
+
+        if (strncmp(entry->d_name, prefix, strlen(prefix)) != 0 || length < suffix_length
+            || strcmp(&entry->d_name[length - suffix_length], VALIDATE_SUFFIX) != 0)
+            continue;
+
+        const size_t path_length = strlen(folder) + 1 + length + 1;
+        path = (char *) calloc(path_length, sizeof(char));
+        if (path != NULL) snprintf(path, path_length, "%s/%s", folder, entry->d_name);
+        break;
+    }
+
+    closedir(dir);
+    return path;
+}
+
+bool validate_result(const cJSON *const result_json, const cJSON *const reference_json, validate_t *validation) {
+    if (result_json == NULL || reference_json == NULL || validation == NULL) return false;
+    validate_sums_t density = {0}, u = {0}, v = {0};
+    const cJSON *snapshots_json = cJSON_GetObjectItemCaseSensitive(result_json, "snapshots");
+    const cJSON *reference_snapshots_json = cJSON_GetObjectItemCaseSensitive(reference_json, "snapshots");
+    const cJSON *snapshot_json = NULL;
+    const cJSON *reference_snapshot_json = NULL;
+
+    if (!cJSON_IsArray(snapshots_json) || !cJSON_IsArray(reference_snapshots_json)
+        || cJSON_GetArraySize(snapshots_json) != cJSON_GetArraySize(reference_snapshots_json))
+        return false;
+
+    reference_snapshot_json = reference_snapshots_json->child;
+    cJSON_ArrayForEach(snapshot_json, snapshots_json) {
+        const cJSON *cell_json = NULL;
+        const cJSON *reference_cell_json = NULL;
+
+        if (!cJSON_IsArray(snapshot_json) || !cJSON_IsArray(reference_snapshot_json)
+            || cJSON_GetArraySize(snapshot_json) != cJSON_GetArraySize(reference_snapshot_json))
+            return false;
+
+        // Cells are saved in the same order
+        reference_cell_json = reference_snapshot_json->child;
+        cJSON_ArrayForEach(cell_json, snapshot_json) {
+            if (!validate_cell(cell_json, reference_cell_json, "d", &density)
+                || !validate_cell(cell_json, reference_cell_json, "u", &u)
+                || !validate_cell(cell_json, reference_cell_json, "v", &v))
+                return false;
+
+            reference_cell_json = reference_cell_json->next;
+        }
+
+        reference_snapshot_json = reference_snapshot_json->next;
+    }
+
+    validate_field(&density, &validation->density);
+    validate_field(&u, &validation->u);
+    validate_field(&v, &validation->v);
+
+    return true;
+}
+/**
+ * END Public
+ */
+
+/**
+ * Private
+ */
+static bool validate_cell(const cJSON *const cell_json, const cJSON *const reference_cell_json, const char *const name,
+                          validate_sums_t *sums) {
+    const cJSON *value_json = cJSON_GetObjectItemCaseSensitive(cell_json, name);
+    const cJSON *reference_value_json = cJSON_GetObjectItemCaseSensitive(reference_cell_json, name);
+    double error;
+
+    if (!cJSON_IsNumber(value_json) || !cJSON_IsNumber(reference_value_json)) return false;
+
+    error = fabs(value_json->valuedouble - reference_value_json->valuedouble);
+    if (error > sums->max_error || isnan(error)) sums->max_error = error;
+    sums->error_norm += error * error;
+    sums->reference_norm += reference_value_json->valuedouble * reference_value_json->valuedouble;
+
+    return true;
+}
+
+static void validate_field(const validate_sums_t *const sums, validate_field_t *field) {
+    field->max_error = sums->max_error;
+    // A zero reference is matched only by a zero result
+    field->relative_error = sums->reference_norm > 0.0 ? sqrt(sums->error_norm / sums->reference_norm)
+                                                       : sqrt(sums->error_norm);
+}
+/**
+ * END Private
+ */
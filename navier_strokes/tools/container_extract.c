@@ -0,0 +1,131 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <mpi.h>
+#include <argparse.h>
+#include "ns/utils/container.h"
+#include "ns/utils/snapshot.h"
+
+// Longest part of a file path in an error message, the rest of the message fits in the remaining chars
+#define ERROR_PATH_LENGTH (MPI_MAX_ERROR_STRING - 32)
+
+static const char *description = "\nList the simulation results of a container or extract one to its own file";
+static const char *const usage[] = {
+        "./container_extract --input=./results/results.nsc --list",
+        "./container_extract --input=./results/results.nsc --id=3 --output=./results",
+        NULL
+};
+
+// Arguments
+static struct {
+    char *input;
+    char *output;
+    int id;
+    bool list;
+} args = {
+        .input = NULL,
+        .output = ".",
+        .id = -1,
+        .list = false
+};
+
+static void make_args(int argc, const char **argv);
+
+static bool extract(const container_entry_t *entry, char *error);
+
+int main(int argc, const char **argv) {
+    container_entry_t *entries;
+    uint64_t entries_length;
+    bool found = false;
+    char error[MPI_MAX_ERROR_STRING + 1];
+
+    make_args(argc, argv);
+
+    // Containers are read with MPI-IO as they are written
+    MPI_Init(NULL, NULL);
+
+    // Only the table of contents and the extracted result are read
+    entries = container_read_toc(args.input, &entries_length, error);
+    if (entries == NULL) {
+        fprintf(stderr, "Error reading container %s: %s\n", args.input, error);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    for (uint64_t i = 0; i < entries_length; ++i) {
+        const container_entry_t *const entry = &entries[i];
+
+        if (args.list) {
+            printf("Simulation %lu of worker %d, %s, bytes [%lu, %lu): %s\n", entry->simulation_id, entry->rank,
+                   snapshot_format_string(entry->format), entry->offset, entry->offset + entry->length,
+                   entry->metadata);
+        } else if (entry->simulation_id == (uint64_t) args.id) {
+            found = true;
+            if (!extract(entry, error)) {
+                fprintf(stderr, "Error extracting simulation %lu: %s\n", entry->simulation_id, error);
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+            }
+        }
+    }
+    container_entries_free(entries, entries_length);
+
+    if (!args.list && !found) {
+        fprintf(stderr, "Simulation %d not found in container %s\n", args.id, args.input);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    MPI_Finalize();
+
+    return EXIT_SUCCESS;
+}
+
+static void make_args(int argc, const char **argv) {
+    struct argparse argparse;
+    struct argparse_option options[] = {
+            OPT_HELP(),
+            OPT_STRING('\0', "input", &args.input, "Path to the container", NULL, 0, 0),
+            OPT_BOOLEAN('\0', "list", &args.list, "List the simulation results of the container", NULL, 0, 0),
+            OPT_INTEGER('\0', "id", &args.id, "Id of the simulation to extract", NULL, 0, 0),
+            OPT_STRING('\0', "output", &args.output, "Path to the folder of the extracted result. Default to `.`",
+                       NULL, 0, 0),
+            OPT_END(),
+    };
+
+    argparse_init(&argparse, options, usage, 0);
+    argparse_describe(&argparse, description, NULL);
+    argparse_parse(&argparse, argc, argv);
+
+    if (args.input == NULL || (!args.list && args.id < 0)) {
+        fprintf(stderr, "Input and either list or a simulation id are required\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static bool extract(const container_entry_t *const entry, char *error) {
+    uint8_t *content;
+    FILE *file;
+    char path[FILENAME_MAX];
+    bool written;
+
+    content = container_read_result(args.input, entry, error);
+    if (content == NULL) return false;
+
+    // Same name the worker gives to its own result file
+    snprintf(path, sizeof(path), "%s/simulation_%lu_%d.%s", args.output, entry->simulation_id, entry->rank,
+             snapshot_format_extension(entry->format));
+    file = fopen(path, "wb");
+    if (file == NULL) {
+        snprintf(error, MPI_MAX_ERROR_STRING, "Unable to create file %.*s", ERROR_PATH_LENGTH, path);
+        free(content);
+        return false;
+    }
+    written = fwrite(content, 1, entry->length, file) == entry->length;
+    written = fclose(file) == 0 && written;
+    free(content);
+    if (!written) {
+        snprintf(error, MPI_MAX_ERROR_STRING, "Unable to write file %.*s", ERROR_PATH_LENGTH, path);
+        return false;
+    }
+
+    printf("Extracted simulation %lu to %s\n", entry->simulation_id, path);
+    return true;
+}
@@ -0,0 +1,146 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <mpi.h>
+#include <argparse.h>
+#include <cJSON.h>
+#include "ns/utils/snapshot.h"
+
+static const char *description = "\nDecode a compressed binary simulation result to an uncompressed binary simulation result";
+static const char *const usage[] = {
+        "./snapshot_decoder --input=./results/simulation_0_1.bin --output=./simulation_0_1.bin",
+        NULL
+};
+
+// Arguments
+static struct {
+    char *input;
+    char *output;
+} args = {
+        .input = NULL,
+        .output = NULL
+};
+
+static void make_args(int argc, const char **argv);
+
+static char *decoded_metadata(const char *metadata);
+
+static bool decode(snapshot_reader_t *reader, snapshot_writer_t *writer, uint64_t *snapshots, char *error);
+
+int main(int argc, const char **argv) {
+    snapshot_reader_t *reader;
+    snapshot_writer_t *writer;
+    snapshot_layout_t layout;
+    char *metadata;
+    uint64_t snapshots = 0;
+    MPI_File fh;
+    MPI_Offset input_size = 0;
+    MPI_Offset output_size = 0;
+    char error[MPI_MAX_ERROR_STRING + 1];
+
+    make_args(argc, argv);
+
+    // Result files are read and written with MPI-IO as in the workers
+    MPI_Init(NULL, NULL);
+
+    reader = snapshot_reader_open(args.input, error);
+    if (reader == NULL) {
+        fprintf(stderr, "Error reading file %s: %s\n", args.input, error);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    layout = *snapshot_reader_layout(reader);
+    layout.compression = SNAPSHOT_COMPRESSION_NONE;
+    layout.tolerance = 0;
+    metadata = decoded_metadata(snapshot_reader_metadata(reader));
+    writer = snapshot_writer_open(args.output, metadata != NULL ? metadata : snapshot_reader_metadata(reader), &layout,
+                                  error);
+    free(metadata);
+    if (writer == NULL) {
+        fprintf(stderr, "Error creating file %s: %s\n", args.output, error);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    if (!decode(reader, writer, &snapshots, error)) {
+        fprintf(stderr, "Error decoding file %s: %s\n", args.input, error);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    if (!snapshot_writer_close(writer, error)) {
+        fprintf(stderr, "Error closing file %s: %s\n", args.output, error);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    snapshot_reader_close(reader);
+
+    // Compression ratio
+    if (MPI_File_open(MPI_COMM_SELF, args.input, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh) == MPI_SUCCESS) {
+        MPI_File_get_size(fh, &input_size);
+        MPI_File_close(&fh);
+    }
+    if (MPI_File_open(MPI_COMM_SELF, args.output, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh) == MPI_SUCCESS) {
+        MPI_File_get_size(fh, &output_size);
+        MPI_File_close(&fh);
+    }
+    printf("Decoded %lu snapshots from %s (%lld bytes) to %s (%lld bytes), compression ratio %.2f\n",
+           snapshots, args.input, (long long) input_size, args.output, (long long) output_size,
+           input_size > 0 ? (double) output_size / (double) input_size : 0.0);
+
+    MPI_Finalize();
+
+    return EXIT_SUCCESS;
+}
+
+static void make_args(int argc, const char **argv) {
+    struct argparse argparse;
+    struct argparse_option options[] = {
+            OPT_HELP(),
+            OPT_STRING('\0', "input", &args.input, "Path to the compressed binary simulation result", NULL, 0, 0),
+            OPT_STRING('\0', "output", &args.output, "Path to the decoded binary simulation result", NULL, 0, 0),
+            OPT_END(),
+    };
+
+    argparse_init(&argparse, options, usage, 0);
+    argparse_describe(&argparse, description, NULL);
+    argparse_parse(&argparse, argc, argv);
+
+    if (args.input == NULL || args.output == NULL) {
+        fprintf(stderr, "Input and output are required\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static char *decoded_metadata(const char *metadata) {
+    cJSON *metadata_json;
+    cJSON *output_json;
+    cJSON *compression_json;
+    char *metadata_string = NULL;
+
+    // Metadata of the decoded file, without compression
+    metadata_json = cJSON_Parse(metadata);
+    output_json = cJSON_GetObjectItemCaseSensitive(cJSON_GetObjectItemCaseSensitive(metadata_json, "metadata"),
+                                                   "output");
+    if (output_json != NULL) {
+        cJSON_DeleteItemFromObjectCaseSensitive(output_json, "compression");
+        compression_json = cJSON_AddObjectToObject(output_json, "compression");
+        if (compression_json != NULL
+            && cJSON_AddStringToObject(compression_json, "type",
+                                       snapshot_compression_string(SNAPSHOT_COMPRESSION_NONE)) != NULL)
+            metadata_string = cJSON_PrintUnformatted(metadata_json);
+    }
+
+    cJSON_Delete(metadata_json);
+    return metadata_string;
+}
+
+static bool decode(snapshot_reader_t *reader, snapshot_writer_t *writer, uint64_t *snapshots, char *error) {
+    ns_world_t world;
+    ns_tick_stats_t stats;
+
+    while (!snapshot_reader_end(reader)) {
+        if (!snapshot_reader_read(reader, &world, &stats, error)
+            || !snapshot_writer_write(writer, &world, stats, error))
+            return false;
+        *snapshots += 1;
+    }
+
+    return true;
+}